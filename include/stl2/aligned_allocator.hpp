@@ -0,0 +1,139 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_ALIGNED_ALLOCATOR_HPP
+#define STL2_ALIGNED_ALLOCATOR_HPP
+
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+STL2_OPEN_NAMESPACE {
+	namespace __aligned_allocator {
+		template <class T>
+		constexpr std::size_t default_alignment =
+			alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t);
+		template <>
+		constexpr std::size_t default_alignment<void> = alignof(std::max_align_t);
+
+		inline void* allocate(std::size_t bytes, std::size_t align) {
+#ifdef __cpp_aligned_new
+			return ::operator new(bytes, std::align_val_t{align});
+#else
+			// Over-allocate and stash the distance back to the block
+			// immediately before the aligned pointer. align is at least
+			// alignof(max_align_t), so there is always room.
+			static_assert(alignof(std::max_align_t) >= sizeof(unsigned short));
+			auto const raw = static_cast<char*>(::operator new(bytes + align));
+			auto const offset = align - reinterpret_cast<std::uintptr_t>(raw) % align;
+			auto const p = raw + offset;
+			reinterpret_cast<unsigned short*>(p)[-1] = static_cast<unsigned short>(offset);
+			return p;
+#endif
+		}
+
+		inline void deallocate(void* p, std::size_t align) noexcept {
+#ifdef __cpp_aligned_new
+			::operator delete(p, std::align_val_t{align});
+#else
+			(void)align;
+			auto const cp = static_cast<char*>(p);
+			::operator delete(cp - reinterpret_cast<unsigned short*>(cp)[-1]);
+#endif
+		}
+	}
+
+	// Allocates storage aligned to Align bytes, which may exceed
+	// alignof(std::max_align_t). lane_width is the number of elements in
+	// Align bytes; vector pads its capacity to a multiple of it so that
+	// kernels can process whole SIMD registers up to the end of storage.
+	template <class T, std::size_t Align = __aligned_allocator::default_alignment<T>>
+	requires
+		(Align & (Align - 1)) == 0 &&
+		Align >= __aligned_allocator::default_alignment<T> &&
+		Align < 65536
+	class aligned_allocator {
+	public:
+		using value_type = T;
+		using is_always_equal = true_type;
+
+		template <class U>
+		struct rebind {
+			using other = aligned_allocator<U,
+				(Align > __aligned_allocator::default_alignment<U>
+					? Align : __aligned_allocator::default_alignment<U>)>;
+		};
+
+		static constexpr std::size_t alignment = Align;
+		static constexpr std::ptrdiff_t lane_width =
+			sizeof(T) <= Align && Align % sizeof(T) == 0 ? Align / sizeof(T) : 1;
+
+		aligned_allocator() = default;
+		template <class U, std::size_t A>
+		constexpr aligned_allocator(const aligned_allocator<U, A>&) noexcept {}
+
+		constexpr std::size_t max_size() const noexcept {
+			return (std::size_t(-1) - Align) / sizeof(T);
+		}
+
+		T* allocate(std::size_t n) const {
+			if (n > max_size()) {
+				throw std::bad_alloc{};
+			}
+			return static_cast<T*>(__aligned_allocator::allocate(n * sizeof(T), Align));
+		}
+
+		void deallocate(T* p, std::size_t) const noexcept {
+			__aligned_allocator::deallocate(p, Align);
+		}
+
+#ifndef __cpp_aligned_new
+		// Extension
+		// Without aligned new, every allocation is padded by Align bytes.
+		std::size_t allocation_overhead(std::size_t) const noexcept {
+			return Align;
+		}
+#endif
+	};
+
+	template <std::size_t Align>
+	class aligned_allocator<void, Align> {
+	public:
+		using value_type = void;
+		using is_always_equal = true_type;
+
+		template <class U>
+		struct rebind {
+			using other = aligned_allocator<U,
+				(Align > __aligned_allocator::default_alignment<U>
+					? Align : __aligned_allocator::default_alignment<U>)>;
+		};
+
+		static constexpr std::size_t alignment = Align;
+
+		aligned_allocator() = default;
+		template <class U, std::size_t A>
+		constexpr aligned_allocator(const aligned_allocator<U, A>&) noexcept {}
+	};
+
+	template <class T, std::size_t A, class U, std::size_t B>
+	constexpr bool operator==(const aligned_allocator<T, A>&, const aligned_allocator<U, B>&) noexcept {
+		return true;
+	}
+	template <class T, std::size_t A, class U, std::size_t B>
+	constexpr bool operator!=(const aligned_allocator<T, A>&, const aligned_allocator<U, B>&) noexcept {
+		return false;
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,537 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_BIT_VECTOR_HPP
+#define STL2_BIT_VECTOR_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+STL2_OPEN_NAMESPACE {
+	namespace __bitvec {
+		using word = std::uint64_t;
+		constexpr std::ptrdiff_t word_bits = 64;
+
+		constexpr std::ptrdiff_t words_for(std::ptrdiff_t n) noexcept {
+			return (n + word_bits - 1) / word_bits;
+		}
+
+		// The low n bits.
+		constexpr word low_mask(std::ptrdiff_t n) noexcept {
+			return n >= word_bits ? ~word{0} : (word{1} << n) - 1;
+		}
+
+		// GCC and Clang lower these builtins to popcnt/tzcnt when the
+		// target has them, and the word loops below to vector code.
+		inline int popcount(word w) noexcept {
+#if defined(__GNUC__)
+			return __builtin_popcountll(w);
+#else
+			w = w - ((w >> 1) & 0x5555555555555555u);
+			w = (w & 0x3333333333333333u) + ((w >> 2) & 0x3333333333333333u);
+			w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fu;
+			return static_cast<int>((w * 0x0101010101010101u) >> 56);
+#endif
+		}
+
+		// Requires w != 0
+		inline int countr_zero(word w) noexcept {
+			STL2_EXPECT(w != 0);
+#if defined(__GNUC__)
+			return __builtin_ctzll(w);
+#else
+			auto n = 0;
+			for (; !(w & 1); w >>= 1) {
+				++n;
+			}
+			return n;
+#endif
+		}
+
+		// The position of the k-th (from 0) set bit of w.
+		// Requires k < popcount(w)
+		inline int select_in_word(word w, int k) noexcept {
+			STL2_EXPECT(0 <= k && k < popcount(w));
+#if defined(__BMI2__)
+			return countr_zero(_pdep_u64(word{1} << k, w));
+#else
+			for (; k > 0; --k) {
+				w &= w - 1;
+			}
+			return countr_zero(w);
+#endif
+		}
+
+		// A proxy for one bit of a word.
+		class reference {
+			word* word_ = nullptr;
+			word mask_ = 0;
+		public:
+			reference() = default;
+			constexpr reference(word* w, std::ptrdiff_t bit) noexcept
+			: word_{w}, mask_{word{1} << bit} {}
+			reference(const reference&) = default;
+
+			operator bool() const noexcept {
+				return (*word_ & mask_) != 0;
+			}
+			const reference& operator=(bool b) const noexcept {
+				if (b) {
+					*word_ |= mask_;
+				} else {
+					*word_ &= ~mask_;
+				}
+				return *this;
+			}
+			const reference& operator=(const reference& that) const noexcept {
+				return *this = static_cast<bool>(that);
+			}
+			void flip() const noexcept {
+				*word_ ^= mask_;
+			}
+
+			friend void swap(reference x, reference y) noexcept {
+				bool const b = x;
+				x = static_cast<bool>(y);
+				y = b;
+			}
+		};
+
+		template <bool Const>
+		class cursor {
+			template <bool> friend class cursor;
+			using word_pointer = conditional_t<Const, const word*, word*>;
+
+			word_pointer words_ = nullptr;
+			std::ptrdiff_t pos_ = 0;
+
+		public:
+			using value_type = bool;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			constexpr cursor(word_pointer words, difference_type pos) noexcept
+			: words_{words}, pos_{pos} {}
+			template <bool C = Const>
+			requires C
+			constexpr cursor(const cursor<false>& that) noexcept
+			: words_{that.words_}, pos_{that.pos_} {}
+
+			bool read() const noexcept
+			requires Const
+			{
+				return (words_[pos_ / word_bits] >> (pos_ % word_bits)) & 1;
+			}
+			reference read() const noexcept
+			requires (!Const)
+			{
+				return {words_ + pos_ / word_bits, pos_ % word_bits};
+			}
+			void next() noexcept { ++pos_; }
+			void prev() noexcept { --pos_; }
+			void advance(difference_type n) noexcept { pos_ += n; }
+			difference_type distance_to(const cursor& that) const noexcept {
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+		};
+	}
+
+	// A sequence of bits packed 64 to a word. Storage is a vector of
+	// words, so allocation, reserve, and growth behave as they do for
+	// vector. Iterators are random access and yield proxy references.
+	// Bits past size() in the last word are always zero, which lets
+	// the counting and searching operations work a word at a time.
+	template <ProtoAllocator<__bitvec::word> PA = std::allocator<__bitvec::word>>
+	class bit_vector {
+		using word = __bitvec::word;
+		using storage_t = vector<word, PA>;
+	public:
+		using value_type = bool;
+		using word_type = word;
+		using allocator_type = typename storage_t::allocator_type;
+		using size_type = typename storage_t::size_type;
+		using reference = __bitvec::reference;
+		using const_reference = bool;
+		using iterator = __stl2::basic_iterator<__bitvec::cursor<false>>;
+		using const_iterator = __stl2::basic_iterator<__bitvec::cursor<true>>;
+
+		static constexpr size_type word_bits = __bitvec::word_bits;
+
+		bit_vector()
+			noexcept(is_nothrow_default_constructible<allocator_type>::value)
+			requires DefaultConstructible<allocator_type>() = default;
+
+		explicit bit_vector(allocator_type a) noexcept
+		: words_{std::move(a)}
+		{}
+
+		bit_vector(size_type n, bool value, allocator_type a)
+		: words_{reserve_t{}, __bitvec::words_for((STL2_EXPECT(n >= 0), n)), std::move(a)}
+		{
+			resize(n, value);
+		}
+
+		explicit bit_vector(size_type n, bool value = false)
+			requires DefaultConstructible<allocator_type>()
+		: bit_vector{n, value, allocator_type{}}
+		{}
+
+		bit_vector(std::initializer_list<bool> il)
+			requires DefaultConstructible<allocator_type>()
+		: bit_vector{static_cast<size_type>(il.size()), false, allocator_type{}}
+		{
+			auto i = size_type{0};
+			for (auto b : il) {
+				set(i++, b);
+			}
+		}
+
+		// FIXME: NYI (as for vector)
+		bit_vector(bit_vector&&) = delete;
+		bit_vector(const bit_vector&) = delete;
+		bit_vector& operator=(bit_vector&&) & = delete;
+		bit_vector& operator=(const bit_vector&) & = delete;
+
+		void swap(bit_vector& that)
+			noexcept(noexcept(declval<storage_t&>().swap(declval<storage_t&>())))
+		{
+			words_.swap(that.words_);
+			ranges::swap(size_, that.size_);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return words_.get_allocator();
+		}
+
+		iterator begin() noexcept { return __bitvec::cursor<false>{words_.begin(), 0}; }
+		iterator end() noexcept { return __bitvec::cursor<false>{words_.begin(), size_}; }
+
+		const_iterator begin() const noexcept { return __bitvec::cursor<true>{words_.begin(), 0}; }
+		const_iterator end() const noexcept { return __bitvec::cursor<true>{words_.begin(), size_}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		// The words holding the bits, least significant bit first.
+		const word* data() const noexcept { return words_.begin(); }
+		size_type word_count() const noexcept { return words_.size(); }
+
+		size_type size() const noexcept { return size_; }
+		bool empty() const noexcept { return size_ == 0; }
+		size_type capacity() const noexcept { return words_.capacity() * word_bits; }
+
+		// Extension: payload is the words holding the bits.
+		memory_stats memory_usage() const noexcept {
+			return words_.memory_usage();
+		}
+
+		reference operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return {words_.begin() + i / word_bits, i % word_bits};
+		}
+		bool operator[](size_type i) const noexcept {
+			return test(i);
+		}
+
+		reference front() noexcept { return (*this)[0]; }
+		bool front() const noexcept { return test(0); }
+		reference back() noexcept { return (*this)[size_ - 1]; }
+		bool back() const noexcept { return test(size_ - 1); }
+
+		bool test(size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return (words_.begin()[i / word_bits] >> (i % word_bits)) & 1;
+		}
+		void set(size_type i, bool value = true) noexcept {
+			(*this)[i] = value;
+		}
+		void reset(size_type i) noexcept {
+			(*this)[i] = false;
+		}
+		void flip(size_type i) noexcept {
+			(*this)[i].flip();
+		}
+
+		void set() noexcept {
+			fill_(0, size_, true);
+		}
+		void reset() noexcept {
+			fill_(0, size_, false);
+		}
+		void flip() noexcept {
+			for (auto& w : words_) {
+				w = ~w;
+			}
+			clear_padding();
+		}
+
+		// Requires n <= capacity() or *this is reallocatable
+		void reserve(size_type n) {
+			words_.reserve(__bitvec::words_for(n));
+		}
+
+		void shrink_to_fit() {
+			words_.shrink_to_fit();
+		}
+
+		void clear() noexcept {
+			words_.clear();
+			size_ = 0;
+		}
+
+		// Requires n <= capacity() or *this is reallocatable
+		void resize(size_type n, bool value = false) {
+			STL2_EXPECT(n >= 0);
+			auto const old_size = size_;
+			words_.resize(__bitvec::words_for(n));
+			size_ = n;
+			if (n < old_size) {
+				clear_padding();
+			} else if (value) {
+				fill_(old_size, n, true);
+			}
+		}
+
+		// Requires size() < capacity() or *this is reallocatable
+		void push_back(bool value) {
+			if (size_ % word_bits == 0) {
+				words_.push_back(word{0});
+			}
+			++size_;
+			set(size_ - 1, value);
+		}
+
+		void pop_back() noexcept {
+			STL2_EXPECT(size_ > 0);
+			reset(size_ - 1);
+			if (--size_ % word_bits == 0) {
+				words_.pop_back();
+			}
+		}
+
+		// The number of set bits.
+		size_type count() const noexcept {
+			size_type n = 0;
+			for (auto w : words_) {
+				n += __bitvec::popcount(w);
+			}
+			return n;
+		}
+		bool any() const noexcept {
+			for (auto w : words_) {
+				if (w) {
+					return true;
+				}
+			}
+			return false;
+		}
+		bool none() const noexcept { return !any(); }
+		bool all() const noexcept { return count() == size_; }
+
+		// The position of the first set bit, or size() if there is none.
+		size_type find_first() const noexcept {
+			return find_from(0);
+		}
+		// The position of the first set bit after pos, or size() if there
+		// is none.
+		size_type find_next(size_type pos) const noexcept {
+			STL2_EXPECT(0 <= pos && pos < size_);
+			return find_from(pos + 1);
+		}
+
+		// The number of set bits in [0, i), by a scan over the words. See
+		// rank_select for constant-time rank and select.
+		size_type rank(size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i <= size_);
+			auto const w = words_.begin();
+			size_type n = 0;
+			for (auto k = size_type{0}; k < i / word_bits; ++k) {
+				n += __bitvec::popcount(w[k]);
+			}
+			if (i % word_bits) {
+				n += __bitvec::popcount(w[i / word_bits] & __bitvec::low_mask(i % word_bits));
+			}
+			return n;
+		}
+
+		// Requires that.size() == size()
+		bit_vector& operator&=(const bit_vector& that) noexcept {
+			return combine_(that, [](word x, word y) { return x & y; });
+		}
+		// Requires that.size() == size()
+		bit_vector& operator|=(const bit_vector& that) noexcept {
+			return combine_(that, [](word x, word y) { return x | y; });
+		}
+		// Requires that.size() == size()
+		bit_vector& operator^=(const bit_vector& that) noexcept {
+			return combine_(that, [](word x, word y) { return x ^ y; });
+		}
+		// Clears every bit that is set in that.
+		// Requires that.size() == size()
+		bit_vector& and_not(const bit_vector& that) noexcept {
+			return combine_(that, [](word x, word y) { return x & ~y; });
+		}
+
+	private:
+		storage_t words_;
+		size_type size_ = 0;
+
+		void clear_padding() noexcept {
+			if (size_ % word_bits) {
+				words_.back() &= __bitvec::low_mask(size_ % word_bits);
+			}
+		}
+
+		void fill_(size_type first, size_type last, bool value) noexcept {
+			STL2_EXPECT(0 <= first && first <= last && last <= size_);
+			auto const w = words_.begin();
+			while (first < last && first % word_bits) {
+				set(first++, value);
+			}
+			auto const fill = value ? ~word{0} : word{0};
+			for (; last - first >= word_bits; first += word_bits) {
+				w[first / word_bits] = fill;
+			}
+			while (first < last) {
+				set(first++, value);
+			}
+		}
+
+		size_type find_from(size_type pos) const noexcept {
+			if (pos >= size_) {
+				return size_;
+			}
+			auto const w = words_.begin();
+			auto k = pos / word_bits;
+			auto bits = w[k] & ~__bitvec::low_mask(pos % word_bits);
+			for (;;) {
+				if (bits) {
+					return k * word_bits + __bitvec::countr_zero(bits);
+				}
+				if (++k == words_.size()) {
+					return size_;
+				}
+				bits = w[k];
+			}
+		}
+
+		template <class Op>
+		bit_vector& combine_(const bit_vector& that, Op op) noexcept {
+			STL2_EXPECT(size_ == that.size_);
+			auto const x = words_.begin();
+			auto const y = that.words_.begin();
+			auto const n = words_.size();
+			for (auto k = size_type{0}; k < n; ++k) {
+				x[k] = op(x[k], y[k]);
+			}
+			return *this;
+		}
+	};
+
+	// A directory of cumulative set-bit counts over a bit_vector, one per
+	// 512-bit block, that answers rank in constant time and select with a
+	// binary search over the blocks. The directory describes the bits as
+	// they were when it was built; it must be rebuilt after the bit_vector
+	// changes.
+	class rank_select {
+		using word = __bitvec::word;
+		static constexpr std::ptrdiff_t block_words = 8;
+		static constexpr std::ptrdiff_t block_bits = block_words * __bitvec::word_bits;
+
+		const word* words_ = nullptr;
+		std::ptrdiff_t size_ = 0;
+		std::ptrdiff_t word_count_ = 0;
+		// counts_[b] is the number of set bits before block b; the last
+		// entry is the total.
+		vector<std::ptrdiff_t> counts_;
+
+	public:
+		template <class PA>
+		explicit rank_select(const bit_vector<PA>& bits)
+		: words_{bits.data()}, size_{bits.size()}, word_count_{bits.word_count()},
+			counts_{reserve_t{}, (word_count_ + block_words - 1) / block_words + 1}
+		{
+			std::ptrdiff_t total = 0;
+			for (auto k = std::ptrdiff_t{0}; k < word_count_; ++k) {
+				if (k % block_words == 0) {
+					counts_.emplace_back_unchecked(total);
+				}
+				total += __bitvec::popcount(words_[k]);
+			}
+			counts_.emplace_back_unchecked(total);
+		}
+
+		// The number of set bits.
+		std::ptrdiff_t count() const noexcept {
+			return counts_.back();
+		}
+
+		// The number of set bits in [0, i).
+		std::ptrdiff_t rank(std::ptrdiff_t i) const noexcept {
+			STL2_EXPECT(0 <= i && i <= size_);
+			auto const k = i / __bitvec::word_bits;
+			auto n = counts_.begin()[i / block_bits];
+			for (auto j = k / block_words * block_words; j < k; ++j) {
+				n += __bitvec::popcount(words_[j]);
+			}
+			if (i % __bitvec::word_bits) {
+				n += __bitvec::popcount(words_[k] & __bitvec::low_mask(i % __bitvec::word_bits));
+			}
+			return n;
+		}
+
+		// The position of the k-th (from 0) set bit, or size() if there
+		// are no more than k set bits.
+		std::ptrdiff_t select(std::ptrdiff_t k) const noexcept {
+			STL2_EXPECT(k >= 0);
+			if (k >= count()) {
+				return size_;
+			}
+			auto const c = counts_.begin();
+			// The last block b with c[b] <= k.
+			std::ptrdiff_t lo = 0;
+			std::ptrdiff_t hi = counts_.size() - 1;
+			while (hi - lo > 1) {
+				auto const mid = lo + (hi - lo) / 2;
+				if (c[mid] <= k) {
+					lo = mid;
+				} else {
+					hi = mid;
+				}
+			}
+			k -= c[lo];
+			for (auto j = lo * block_words;; ++j) {
+				auto const n = __bitvec::popcount(words_[j]);
+				if (k < n) {
+					return j * __bitvec::word_bits +
+						__bitvec::select_in_word(words_[j], static_cast<int>(k));
+				}
+				k -= n;
+			}
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
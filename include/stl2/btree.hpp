@@ -0,0 +1,1481 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_BTREE_HPP
+#define STL2_BTREE_HPP
+
+#include <stl2/functional.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/simd_algorithm.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/utility.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+STL2_OPEN_NAMESPACE {
+	// Extension
+	// Tags for the constructors that take a range already in key order:
+	// without equivalent keys, or possibly with them.
+	struct sorted_unique_t {};
+	struct sorted_equivalent_t {};
+
+	namespace __btree {
+		// Room for N objects of type T, which the tree constructs and
+		// destroys one at a time
+		template <class T, std::ptrdiff_t N>
+		struct slots {
+			union {
+				T data[N];
+			};
+
+			slots() noexcept {}
+			~slots() {}
+		};
+
+		template <class T, std::ptrdiff_t N>
+		struct mapped_slots {
+			slots<T, N> vals;
+		};
+		template <std::ptrdiff_t N>
+		struct mapped_slots<void, N> {};
+
+		template <class T>
+		constexpr std::size_t size_of = sizeof(T);
+		template <>
+		constexpr std::size_t size_of<void> = 0;
+
+		// Keys and mapped values in separate arrays, so that a search
+		// reads only keys.
+		template <class K, class T, class VP, std::ptrdiff_t N>
+		struct leaf : mapped_slots<T, N> {
+			slots<K, N> keys;
+			std::ptrdiff_t count = 0;
+			VP parent{};
+			VP prev{};
+			VP next{};
+		};
+
+		// children[i] holds the keys that are not less than keys[i - 1]
+		// and not greater than keys[i].
+		template <class K, class VP, std::ptrdiff_t N>
+		struct inner {
+			slots<K, N> keys;
+			std::ptrdiff_t count = 0;
+			VP parent{};
+			VP children[N + 1] = {};
+		};
+
+		// As many entries of per bytes as fit in bytes after header, and
+		// at least 4
+		constexpr std::ptrdiff_t capacity(std::size_t bytes, std::size_t header, std::size_t per) noexcept {
+			return bytes > header && (bytes - header) / per > 4
+				? static_cast<std::ptrdiff_t>((bytes - header) / per) : 4;
+		}
+
+		template <class K, class T, class PA, std::size_t NodeBytes>
+		struct layout {
+			using void_pointer = proto_allocator_pointer_t<PA>;
+			static constexpr std::ptrdiff_t leaf_capacity = capacity(NodeBytes,
+				sizeof(std::ptrdiff_t) + 3 * sizeof(void_pointer), sizeof(K) + size_of<T>);
+			static constexpr std::ptrdiff_t inner_capacity = capacity(NodeBytes,
+				sizeof(std::ptrdiff_t) + 2 * sizeof(void_pointer), sizeof(K) + sizeof(void_pointer));
+			using leaf_type = leaf<K, T, void_pointer, leaf_capacity>;
+			using inner_type = inner<K, void_pointer, inner_capacity>;
+		};
+
+		// What the elements look like from outside: pairs of references
+		// into the two arrays for maps, as with flat_map, and the key
+		// itself for sets.
+		template <class K, class T>
+		struct element {
+			using value_type = std::pair<K, T>;
+			using reference = std::pair<const K&, T&>;
+			using const_reference = std::pair<const K&, const T&>;
+
+			template <class R>
+			struct arrow {
+				R r;
+				const R* operator->() const noexcept {
+					return std::addressof(r);
+				}
+			};
+
+			template <class R, class Leaf>
+			static R get(Leaf* l, std::ptrdiff_t i) noexcept {
+				return R{l->keys.data[i], l->vals.data[i]};
+			}
+			template <class R, class Leaf>
+			static arrow<R> get_arrow(Leaf* l, std::ptrdiff_t i) noexcept {
+				return arrow<R>{get<R>(l, i)};
+			}
+		};
+		template <class K>
+		struct element<K, void> {
+			using value_type = K;
+			using reference = const K&;
+			using const_reference = const K&;
+
+			template <class R, class Leaf>
+			static R get(Leaf* l, std::ptrdiff_t i) noexcept {
+				return l->keys.data[i];
+			}
+			template <class R, class Leaf>
+			static const K* get_arrow(Leaf* l, std::ptrdiff_t i) noexcept {
+				return std::addressof(l->keys.data[i]);
+			}
+		};
+
+		// Moves from[j] to the raw slot to[i], leaving from[j] raw.
+		template <class A, class T, std::ptrdiff_t N, std::ptrdiff_t M>
+		void relocate(A& a, slots<T, N>& to, std::ptrdiff_t i, slots<T, M>& from, std::ptrdiff_t j) noexcept {
+			using traits = std::allocator_traits<A>;
+			traits::construct(a, std::addressof(to.data[i]), std::move(from.data[j]));
+			traits::destroy(a, std::addressof(from.data[j]));
+		}
+
+		// Relocates from[j, j + n) to to[i, i + n), which may overlap it.
+		template <class A, class T, std::ptrdiff_t N, std::ptrdiff_t M>
+		void relocate_n(A& a, slots<T, N>& to, std::ptrdiff_t i,
+			slots<T, M>& from, std::ptrdiff_t j, std::ptrdiff_t n) noexcept
+		{
+			if (static_cast<void*>(&to) == static_cast<void*>(&from) && i > j) {
+				for (auto k = n; k-- > 0;) {
+					__btree::relocate(a, to, i + k, from, j + k);
+				}
+			} else {
+				for (auto k = std::ptrdiff_t{0}; k < n; ++k) {
+					__btree::relocate(a, to, i + k, from, j + k);
+				}
+			}
+		}
+
+		// The mapped half of a leaf's elements, which sets lack
+		template <class T>
+		struct mapped {
+			template <class A, class Leaf, class...Args>
+			static void construct(A& a, Leaf* l, std::ptrdiff_t i, Args&&...args) {
+				std::allocator_traits<A>::construct(a, std::addressof(l->vals.data[i]),
+					std::forward<Args>(args)...);
+			}
+			template <class A, class Leaf>
+			static void destroy(A& a, Leaf* l, std::ptrdiff_t i) noexcept {
+				std::allocator_traits<A>::destroy(a, std::addressof(l->vals.data[i]));
+			}
+			template <class A, class Leaf>
+			static void relocate_n(A& a, Leaf* to, std::ptrdiff_t i,
+				Leaf* from, std::ptrdiff_t j, std::ptrdiff_t n) noexcept
+			{
+				__btree::relocate_n(a, to->vals, i, from->vals, j, n);
+			}
+		};
+		template <>
+		struct mapped<void> {
+			template <class A, class Leaf>
+			static void construct(A&, Leaf*, std::ptrdiff_t) noexcept {}
+			template <class A, class Leaf>
+			static void destroy(A&, Leaf*, std::ptrdiff_t) noexcept {}
+			template <class A, class Leaf>
+			static void relocate_n(A&, Leaf*, std::ptrdiff_t, Leaf*, std::ptrdiff_t, std::ptrdiff_t) noexcept {}
+		};
+
+		// Nodes move their elements rather than copy them, and must not
+		// be left half moved.
+		template <class T>
+		concept bool Relocatable =
+			std::is_void<T>::value || std::is_nothrow_move_constructible<T>::value;
+
+		// Compare is < on an arithmetic key, which the vector kernels
+		// can evaluate a whole node at a time.
+		template <class C, class K>
+		concept bool NaturalLess =
+			__simd::Arithmetic<K> &&
+			(Same<C, less<>>() || Same<C, std::less<K>>() || Same<C, std::less<>>());
+
+		// The number of keys in sorted [keys, keys + n) that precede x or,
+		// if Upper, that x does not precede
+		template <bool Upper, class K, class C>
+		std::ptrdiff_t rank(const K* keys, std::ptrdiff_t n, const K& x, C& comp) {
+			auto lo = std::ptrdiff_t{0};
+			while (n > 0) {
+				auto const half = n / 2;
+				if (Upper ? !comp(x, keys[lo + half]) : comp(keys[lo + half], x)) {
+					lo += half + 1;
+					n -= half + 1;
+				} else {
+					n = half;
+				}
+			}
+			return lo;
+		}
+		template <bool Upper, class K, class C>
+		requires NaturalLess<C, K>
+		std::ptrdiff_t rank(const K* keys, std::ptrdiff_t n, const K& x, C&) {
+			return __simd::run<__simd::rank_fn<Upper>>(keys, keys + n, x);
+		}
+
+		// Deeper than any tree whose size fits in a ptrdiff_t
+		constexpr int max_height = 64;
+	}
+
+	// Extension
+	// An ordered associative container on a B+tree. Elements live in
+	// leaves of leaf_capacity keys, with their mapped values alongside,
+	// linked in order; inner nodes hold only separator keys and children.
+	// Nodes are about NodeBytes - by default a few cache lines - so a
+	// lookup costs one miss per level, of which there are few, and walks
+	// from leaf to leaf visit contiguous elements. A node is searched with
+	// the vector kernels when Compare is < on an arithmetic key.
+	//
+	// Nodes are allocated through PA rebound to the node types, which may
+	// use fancy pointers. Insertion and erasure invalidate iterators into
+	// the leaves they touch, as for flat containers; keys and mapped
+	// values must be nothrow move constructible. Multi permits equivalent
+	// keys, which keep the order of their insertion.
+	template <class K, class T, class Compare, ProtoAllocator PA, std::size_t NodeBytes, bool Multi>
+	requires
+		StrictWeakOrder<Compare, K>() &&
+		CopyConstructible<K>() &&
+		__btree::Relocatable<K> &&
+		__btree::Relocatable<T> &&
+		ProtoAllocator<PA, typename __btree::layout<K, T, PA, NodeBytes>::leaf_type>() &&
+		ProtoAllocator<PA, typename __btree::layout<K, T, PA, NodeBytes>::inner_type>()
+	class basic_btree
+		: detail::ebo_box<Compare>
+		, detail::ebo_box<PA>
+	{
+		using comp_box = detail::ebo_box<Compare>;
+		using alloc_box = detail::ebo_box<PA>;
+		using layout_t = __btree::layout<K, T, PA, NodeBytes>;
+		using leaf_t = typename layout_t::leaf_type;
+		using inner_t = typename layout_t::inner_type;
+		using void_pointer = typename layout_t::void_pointer;
+		using leaf_allocator = rebind_allocator_t<PA, leaf_t>;
+		using inner_allocator = rebind_allocator_t<PA, inner_t>;
+		using leaf_traits = std::allocator_traits<leaf_allocator>;
+		using inner_traits = std::allocator_traits<inner_allocator>;
+		using leaf_pointer = typename leaf_traits::pointer;
+		using inner_pointer = typename leaf_traits::template rebind_traits<inner_t>::pointer;
+		using element_t = __btree::element<K, T>;
+		using mapped_t = __btree::mapped<T>;
+
+		template <bool Const>
+		class cursor;
+
+	public:
+		using key_type = K;
+		using mapped_type = T;
+		using value_type = typename element_t::value_type;
+		using key_compare = Compare;
+		using allocator_type = PA;
+		using reference = typename element_t::reference;
+		using const_reference = typename element_t::const_reference;
+		using size_type = difference_type_t<leaf_pointer>;
+		using difference_type = size_type;
+		using iterator = basic_iterator<cursor<false>>;
+		using const_iterator = basic_iterator<cursor<true>>;
+		using reverse_iterator = __stl2::reverse_iterator<iterator>;
+		using const_reverse_iterator = __stl2::reverse_iterator<const_iterator>;
+
+		// Extension
+		static constexpr std::ptrdiff_t leaf_capacity = layout_t::leaf_capacity;
+		// Extension
+		static constexpr std::ptrdiff_t inner_capacity = layout_t::inner_capacity;
+
+	private:
+		// Walks the leaves through their sibling links; the end cursor
+		// is one past the last element of the last leaf.
+		template <bool Const>
+		class cursor {
+			friend basic_btree;
+			template <bool> friend class cursor;
+
+			using ref_t = conditional_t<Const,
+				typename basic_btree::const_reference, typename basic_btree::reference>;
+
+			leaf_t* leaf_ = nullptr;
+			std::ptrdiff_t i_ = 0;
+
+			cursor(leaf_t* l, std::ptrdiff_t i) noexcept
+			: leaf_{l}, i_{i} {}
+
+		public:
+			using value_type = typename basic_btree::value_type;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			template <bool C>
+			requires Const && !C
+			cursor(const cursor<C>& that) noexcept
+			: leaf_{that.leaf_}, i_{that.i_} {}
+
+			ref_t read() const noexcept {
+				STL2_EXPECT(leaf_ && i_ < leaf_->count);
+				return element_t::template get<ref_t>(leaf_, i_);
+			}
+			auto arrow() const noexcept {
+				STL2_EXPECT(leaf_ && i_ < leaf_->count);
+				return element_t::template get_arrow<ref_t>(leaf_, i_);
+			}
+			void next() noexcept {
+				STL2_EXPECT(leaf_ && i_ < leaf_->count);
+				if (++i_ == leaf_->count && leaf_->next) {
+					leaf_ = as_leaf_(leaf_->next);
+					i_ = 0;
+				}
+			}
+			void prev() noexcept {
+				STL2_EXPECT(leaf_);
+				if (i_ == 0) {
+					STL2_EXPECT(leaf_->prev);
+					leaf_ = as_leaf_(leaf_->prev);
+					i_ = leaf_->count;
+				}
+				--i_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return leaf_ == that.leaf_ && i_ == that.i_;
+			}
+		};
+
+	public:
+		~basic_btree() {
+			clear();
+		}
+
+		basic_btree()
+		requires
+			DefaultConstructible<Compare>() &&
+			DefaultConstructible<PA>()
+		= default;
+
+		explicit basic_btree(Compare comp, allocator_type a = allocator_type{})
+		: comp_box{std::move(comp)}, alloc_box{std::move(a)}
+		{}
+
+		explicit basic_btree(allocator_type a)
+		requires
+			DefaultConstructible<Compare>()
+		: alloc_box{std::move(a)}
+		{}
+
+		// Inserts each element of [first, last).
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			ConvertibleTo<reference_t<I>, value_type>()
+		basic_btree(I first, S last, Compare comp = Compare{}, allocator_type a = allocator_type{})
+		: basic_btree{std::move(comp), std::move(a)}
+		{
+			insert(std::move(first), std::move(last));
+		}
+
+		template <InputRange Rng>
+		requires
+			ConvertibleTo<reference_t<iterator_t<Rng>>, value_type>()
+		explicit basic_btree(Rng&& rng, Compare comp = Compare{}, allocator_type a = allocator_type{})
+		: basic_btree{__stl2::begin(rng), __stl2::end(rng), std::move(comp), std::move(a)}
+		{}
+
+		// Builds the tree from [first, last), which is in key order and
+		// has no equivalent keys, in O(N) rather than O(N log N), with
+		// every node full but those on the right edge.
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			!Multi &&
+			ConvertibleTo<reference_t<I>, value_type>()
+		basic_btree(sorted_unique_t, I first, S last,
+			Compare comp = Compare{}, allocator_type a = allocator_type{})
+		: basic_btree{std::move(comp), std::move(a)}
+		{
+			bulk_load_(std::move(first), std::move(last));
+		}
+
+		// As above, for a range that may hold equivalent keys
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			Multi &&
+			ConvertibleTo<reference_t<I>, value_type>()
+		basic_btree(sorted_equivalent_t, I first, S last,
+			Compare comp = Compare{}, allocator_type a = allocator_type{})
+		: basic_btree{std::move(comp), std::move(a)}
+		{
+			bulk_load_(std::move(first), std::move(last));
+		}
+
+		basic_btree(const basic_btree& that)
+		requires
+			CopyConstructible<T>() || std::is_void<T>::value
+		: comp_box{that.comp()}
+		, alloc_box{std::allocator_traits<PA>::select_on_container_copy_construction(that.alloc())}
+		{
+			bulk_load_(that.begin(), that.end());
+		}
+
+		basic_btree(basic_btree&& that) noexcept
+		: comp_box{std::move(that.comp())}
+		, alloc_box{std::move(that.alloc())}
+		, root_{__stl2::exchange(that.root_, {})}
+		, head_{__stl2::exchange(that.head_, {})}
+		, tail_{__stl2::exchange(that.tail_, {})}
+		, size_{__stl2::exchange(that.size_, 0)}
+		, height_{__stl2::exchange(that.height_, 0)}
+		{}
+
+		basic_btree& operator=(basic_btree&& that) &
+		noexcept(leaf_traits::is_always_equal::value ||
+			leaf_traits::propagate_on_container_move_assignment::value)
+		{
+			if (std::addressof(that) != this) {
+				if (leaf_traits::is_always_equal::value ||
+					leaf_traits::propagate_on_container_move_assignment::value ||
+					alloc() == that.alloc())
+				{
+					clear();
+					if (leaf_traits::propagate_on_container_move_assignment::value) {
+						alloc() = std::move(that.alloc());
+					}
+					comp() = that.comp();
+					take_(that);
+				} else {
+					clear();
+					comp() = that.comp();
+					move_from_(that);
+					that.clear();
+				}
+			}
+			return *this;
+		}
+
+		basic_btree& operator=(const basic_btree& that) &
+		requires
+			CopyConstructible<T>() || std::is_void<T>::value
+		{
+			if (std::addressof(that) != this) {
+				clear();
+				if (!leaf_traits::is_always_equal::value &&
+					leaf_traits::propagate_on_container_copy_assignment::value)
+				{
+					alloc() = that.alloc();
+				}
+				comp() = that.comp();
+				bulk_load_(that.begin(), that.end());
+			}
+			return *this;
+		}
+
+		void swap(basic_btree& that)
+		noexcept(leaf_traits::is_always_equal::value ||
+			leaf_traits::propagate_on_container_swap::value)
+		{
+			if (leaf_traits::propagate_on_container_swap::value) {
+				ranges::swap(alloc(), that.alloc());
+			} else if (!leaf_traits::is_always_equal::value) {
+				STL2_EXPECT(alloc() == that.alloc());
+			}
+			ranges::swap(comp(), that.comp());
+			ranges::swap(root_, that.root_);
+			ranges::swap(head_, that.head_);
+			ranges::swap(tail_, that.tail_);
+			ranges::swap(size_, that.size_);
+			ranges::swap(height_, that.height_);
+		}
+		friend void swap(basic_btree& x, basic_btree& y)
+		noexcept(noexcept(x.swap(y)))
+		{
+			x.swap(y);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return alloc();
+		}
+		key_compare key_comp() const {
+			return comp();
+		}
+
+		iterator begin() noexcept {
+			return cursor<false>{as_leaf_(head_), 0};
+		}
+		const_iterator begin() const noexcept {
+			return cursor<true>{as_leaf_(head_), 0};
+		}
+		iterator end() noexcept {
+			auto const l = as_leaf_(tail_);
+			return cursor<false>{l, l ? l->count : 0};
+		}
+		const_iterator end() const noexcept {
+			auto const l = as_leaf_(tail_);
+			return cursor<true>{l, l ? l->count : 0};
+		}
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+		reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+		const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+		reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+		const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+		bool empty() const noexcept { return size_ == 0; }
+		size_type size() const noexcept { return size_; }
+
+		// Extension
+		// The number of levels of inner nodes above the leaves
+		int height() const noexcept { return height_; }
+
+		// Extension
+		// Linear in the number of nodes. An element is its key and mapped
+		// value; inner nodes, separator keys included, are overhead.
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			if (root_) {
+				usage_(s, root_, height_);
+			}
+			return s;
+		}
+
+		void clear() noexcept {
+			if (root_) {
+				destroy_(root_, height_);
+				root_ = head_ = tail_ = void_pointer{};
+				size_ = 0;
+				height_ = 0;
+			}
+		}
+
+		iterator lower_bound(const K& k) {
+			return bound_<false>(k);
+		}
+		const_iterator lower_bound(const K& k) const {
+			return const_cast<basic_btree&>(*this).lower_bound(k);
+		}
+		iterator upper_bound(const K& k) {
+			return bound_<true>(k);
+		}
+		const_iterator upper_bound(const K& k) const {
+			return const_cast<basic_btree&>(*this).upper_bound(k);
+		}
+		std::pair<iterator, iterator> equal_range(const K& k) {
+			return {lower_bound(k), upper_bound(k)};
+		}
+		std::pair<const_iterator, const_iterator> equal_range(const K& k) const {
+			return {lower_bound(k), upper_bound(k)};
+		}
+
+		iterator find(const K& k) {
+			auto const i = lower_bound(k);
+			return i != end() && !comp()(k, key_(i)) ? i : end();
+		}
+		const_iterator find(const K& k) const {
+			return const_cast<basic_btree&>(*this).find(k);
+		}
+		bool contains(const K& k) const {
+			return find(k) != end();
+		}
+		size_type count(const K& k) const {
+			if (!Multi) {
+				return contains(k);
+			}
+			auto const r = equal_range(k);
+			return static_cast<size_type>(__stl2::distance(r.first, r.second));
+		}
+
+		// Inserts v unless an element with an equivalent key is present.
+		std::pair<iterator, bool> insert(const value_type& v)
+		requires !Multi
+		{
+			return unpack_(v, [this](auto&&...parts) {
+				return emplace_unique_(std::forward<decltype(parts)>(parts)...);
+			});
+		}
+		std::pair<iterator, bool> insert(value_type&& v)
+		requires !Multi
+		{
+			return unpack_(std::move(v), [this](auto&&...parts) {
+				return emplace_unique_(std::forward<decltype(parts)>(parts)...);
+			});
+		}
+		template <class...Args>
+		requires
+			!Multi &&
+			Constructible<value_type, Args...>()
+		std::pair<iterator, bool> emplace(Args&&...args) {
+			value_type v(std::forward<Args>(args)...);
+			return insert(std::move(v));
+		}
+
+		// Inserts v after any elements with equivalent keys.
+		iterator insert(const value_type& v)
+		requires Multi
+		{
+			return unpack_(v, [this](auto&&...parts) {
+				return emplace_equal_(std::forward<decltype(parts)>(parts)...);
+			});
+		}
+		iterator insert(value_type&& v)
+		requires Multi
+		{
+			return unpack_(std::move(v), [this](auto&&...parts) {
+				return emplace_equal_(std::forward<decltype(parts)>(parts)...);
+			});
+		}
+		template <class...Args>
+		requires
+			Multi &&
+			Constructible<value_type, Args...>()
+		iterator emplace(Args&&...args) {
+			value_type v(std::forward<Args>(args)...);
+			return insert(std::move(v));
+		}
+
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			ConvertibleTo<reference_t<I>, value_type>()
+		void insert(I first, S last) {
+			for (; first != last; ++first) {
+				insert(value_type(*first));
+			}
+		}
+		template <InputRange Rng>
+		requires
+			ConvertibleTo<reference_t<iterator_t<Rng>>, value_type>()
+		void insert(Rng&& rng) {
+			insert(__stl2::begin(rng), __stl2::end(rng));
+		}
+
+		// Map access
+		template <class...Args>
+		requires
+			!Multi && !std::is_void<T>::value &&
+			Constructible<T, Args...>()
+		std::pair<iterator, bool> try_emplace(const K& k, Args&&...args) {
+			return emplace_unique_(k, std::forward<Args>(args)...);
+		}
+		template <class...Args>
+		requires
+			!Multi && !std::is_void<T>::value &&
+			Constructible<T, Args...>()
+		std::pair<iterator, bool> try_emplace(K&& k, Args&&...args) {
+			return emplace_unique_(std::move(k), std::forward<Args>(args)...);
+		}
+
+		template <class M>
+		requires
+			!Multi && !std::is_void<T>::value &&
+			Assignable<T&, M>() && Constructible<T, M>()
+		std::pair<iterator, bool> insert_or_assign(const K& k, M&& m) {
+			auto r = emplace_unique_(k, std::forward<M>(m));
+			if (!r.second) {
+				r.first.leaf_->vals.data[r.first.i_] = std::forward<M>(m);
+			}
+			return r;
+		}
+		template <class M>
+		requires
+			!Multi && !std::is_void<T>::value &&
+			Assignable<T&, M>() && Constructible<T, M>()
+		std::pair<iterator, bool> insert_or_assign(K&& k, M&& m) {
+			auto r = emplace_unique_(std::move(k), std::forward<M>(m));
+			if (!r.second) {
+				r.first.leaf_->vals.data[r.first.i_] = std::forward<M>(m);
+			}
+			return r;
+		}
+
+		template <class U = T>
+		requires
+			!Multi && !std::is_void<U>::value &&
+			DefaultConstructible<U>()
+		U& operator[](const K& k) {
+			auto const i = emplace_unique_(k).first;
+			return i.leaf_->vals.data[i.i_];
+		}
+		template <class U = T>
+		requires
+			!Multi && !std::is_void<U>::value &&
+			DefaultConstructible<U>()
+		U& operator[](K&& k) {
+			auto const i = emplace_unique_(std::move(k)).first;
+			return i.leaf_->vals.data[i.i_];
+		}
+
+		template <class U = T>
+		requires
+			!Multi && !std::is_void<U>::value
+		U& at(const K& k) {
+			auto const i = find(k);
+			if (i == end()) {
+				throw std::out_of_range{"btree_map::at"};
+			}
+			return i.leaf_->vals.data[i.i_];
+		}
+		template <class U = T>
+		requires
+			!Multi && !std::is_void<U>::value
+		const U& at(const K& k) const {
+			return const_cast<basic_btree&>(*this).at(k);
+		}
+
+		// Returns the element after the one erased.
+		iterator erase(const_iterator pos) {
+			STL2_EXPECT(pos.leaf_ && pos.i_ < pos.leaf_->count);
+			return erase_(pos.leaf_, pos.i_);
+		}
+		iterator erase(iterator pos) {
+			return erase(const_iterator{pos});
+		}
+
+		iterator erase(const_iterator first, const_iterator last) {
+			// Each erasure may move the elements that follow, so count
+			// rather than compare positions.
+			auto n = __stl2::distance(first, last);
+			iterator i = cursor<false>{first.leaf_, first.i_};
+			for (; n > 0; --n) {
+				i = erase(i);
+			}
+			return i;
+		}
+
+		size_type erase(const K& k) {
+			auto i = lower_bound(k);
+			auto n = size_type{0};
+			while (i != end() && !comp()(k, key_(i))) {
+				i = erase(i);
+				++n;
+			}
+			return n;
+		}
+
+	private:
+		void_pointer root_{};
+		void_pointer head_{};
+		void_pointer tail_{};
+		size_type size_ = 0;
+		int height_ = 0;
+
+		// Nodes allocated before a split changes anything, so that a
+		// split cannot fail halfway
+		struct spares {
+			basic_btree& tree;
+			leaf_t* leaf = nullptr;
+			inner_t* inners[__btree::max_height];
+			int n = 0;
+
+			explicit spares(basic_btree& t) noexcept
+			: tree(t) {}
+			spares(const spares&) = delete;
+			spares& operator=(const spares&) = delete;
+			~spares() {
+				if (leaf) {
+					tree.free_(leaf);
+				}
+				while (n > 0) {
+					tree.free_(inners[--n]);
+				}
+			}
+
+			leaf_t* take_leaf() noexcept {
+				return __stl2::exchange(leaf, nullptr);
+			}
+			inner_t* take_inner() noexcept {
+				STL2_EXPECT(n > 0);
+				return inners[--n];
+			}
+		};
+
+		Compare& comp() noexcept { return comp_box::get(); }
+		const Compare& comp() const noexcept { return comp_box::get(); }
+		PA& alloc() noexcept { return alloc_box::get(); }
+		const PA& alloc() const noexcept { return alloc_box::get(); }
+
+		template <bool Const>
+		static const K& key_(basic_iterator<cursor<Const>> i) noexcept {
+			return i.leaf_->keys.data[i.i_];
+		}
+
+		// Calls f with the key of v and, for maps, its mapped value.
+		template <class V, class F>
+		decltype(auto) unpack_(V&& v, F f) {
+			return f(std::forward<V>(v));
+		}
+		template <class V, class F>
+		requires !std::is_void<T>::value
+		decltype(auto) unpack_(V&& v, F f) {
+			return f(std::forward<V>(v).first, std::forward<V>(v).second);
+		}
+
+		static leaf_t* as_leaf_(const void_pointer& p) noexcept {
+			return p ? std::addressof(*static_cast<leaf_pointer>(p)) : nullptr;
+		}
+		static inner_t* as_inner_(const void_pointer& p) noexcept {
+			return p ? std::addressof(*static_cast<inner_pointer>(p)) : nullptr;
+		}
+		static void_pointer vp_(leaf_t* l) noexcept {
+			return std::pointer_traits<leaf_pointer>::pointer_to(*l);
+		}
+		static void_pointer vp_(inner_t* n) noexcept {
+			return std::pointer_traits<inner_pointer>::pointer_to(*n);
+		}
+
+		leaf_t* new_leaf_() {
+			auto a = leaf_allocator{alloc()};
+			auto const p = leaf_traits::allocate(a, 1);
+			auto const l = std::addressof(*p);
+			leaf_traits::construct(a, l);
+			return l;
+		}
+		inner_t* new_inner_() {
+			auto a = inner_allocator{alloc()};
+			auto const p = inner_traits::allocate(a, 1);
+			auto const n = std::addressof(*p);
+			inner_traits::construct(a, n);
+			return n;
+		}
+		void free_(leaf_t* l) noexcept {
+			auto a = leaf_allocator{alloc()};
+			leaf_traits::destroy(a, l);
+			leaf_traits::deallocate(a, std::pointer_traits<leaf_pointer>::pointer_to(*l), 1);
+		}
+		void free_(inner_t* n) noexcept {
+			auto a = inner_allocator{alloc()};
+			inner_traits::destroy(a, n);
+			inner_traits::deallocate(a, std::pointer_traits<inner_pointer>::pointer_to(*n), 1);
+		}
+
+		// Destroys the subtree at p, whose root is level levels above the
+		// leaves.
+		void destroy_(const void_pointer& p, int level) noexcept {
+			if (level == 0) {
+				auto const l = as_leaf_(p);
+				destroy_elements_(l, 0, l->count);
+				free_(l);
+			} else {
+				auto const n = as_inner_(p);
+				for (auto i = std::ptrdiff_t{0}; i <= n->count; ++i) {
+					destroy_(n->children[i], level - 1);
+				}
+				destroy_keys_(n, 0, n->count);
+				free_(n);
+			}
+		}
+
+		void usage_(memory_stats& s, const void_pointer& p, int level) const noexcept {
+			constexpr auto element = sizeof(K) + __btree::size_of<T>;
+			if (level == 0) {
+				auto const l = as_leaf_(p);
+				s.payload += element * static_cast<std::size_t>(l->count);
+				s.slack += element * static_cast<std::size_t>(leaf_capacity - l->count);
+				s.overhead += sizeof(leaf_t) - element * static_cast<std::size_t>(leaf_capacity);
+				__memory_stats::allocation(s, leaf_allocator{alloc()}, 1);
+			} else {
+				auto const n = as_inner_(p);
+				s.overhead += sizeof(inner_t);
+				__memory_stats::allocation(s, inner_allocator{alloc()}, 1);
+				for (auto i = std::ptrdiff_t{0}; i <= n->count; ++i) {
+					usage_(s, n->children[i], level - 1);
+				}
+			}
+		}
+
+		void destroy_elements_(leaf_t* l, std::ptrdiff_t first, std::ptrdiff_t last) noexcept {
+			auto a = leaf_allocator{alloc()};
+			for (; first != last; ++first) {
+				leaf_traits::destroy(a, std::addressof(l->keys.data[first]));
+				mapped_t::destroy(a, l, first);
+			}
+		}
+		void destroy_keys_(inner_t* n, std::ptrdiff_t first, std::ptrdiff_t last) noexcept {
+			auto a = leaf_allocator{alloc()};
+			for (; first != last; ++first) {
+				leaf_traits::destroy(a, std::addressof(n->keys.data[first]));
+			}
+		}
+
+		// Moves the n elements at from[j] to the raw slots at to[i].
+		void relocate_elements_(leaf_t* to, std::ptrdiff_t i,
+			leaf_t* from, std::ptrdiff_t j, std::ptrdiff_t n) noexcept
+		{
+			auto a = leaf_allocator{alloc()};
+			__btree::relocate_n(a, to->keys, i, from->keys, j, n);
+			mapped_t::relocate_n(a, to, i, from, j, n);
+		}
+		void relocate_keys_(inner_t* to, std::ptrdiff_t i,
+			inner_t* from, std::ptrdiff_t j, std::ptrdiff_t n) noexcept
+		{
+			auto a = leaf_allocator{alloc()};
+			__btree::relocate_n(a, to->keys, i, from->keys, j, n);
+		}
+		void relocate_key_(inner_t* to, std::ptrdiff_t i, inner_t* from, std::ptrdiff_t j) noexcept {
+			relocate_keys_(to, i, from, j, 1);
+		}
+		void move_children_(inner_t* to, std::ptrdiff_t i,
+			inner_t* from, std::ptrdiff_t j, std::ptrdiff_t n) noexcept
+		{
+			if (to == from && i > j) {
+				for (auto k = n; k-- > 0;) {
+					to->children[i + k] = std::move(from->children[j + k]);
+				}
+			} else {
+				for (auto k = std::ptrdiff_t{0}; k < n; ++k) {
+					to->children[i + k] = std::move(from->children[j + k]);
+				}
+			}
+		}
+		// Points the parents of n's children [first, last), which are
+		// level - 1 levels above the leaves, at n.
+		void adopt_(inner_t* n, std::ptrdiff_t first, std::ptrdiff_t last, int level) noexcept {
+			auto const p = vp_(n);
+			for (; first != last; ++first) {
+				if (level == 1) {
+					as_leaf_(n->children[first])->parent = p;
+				} else {
+					as_inner_(n->children[first])->parent = p;
+				}
+			}
+		}
+
+		// Constructs the element at the raw slot l[i] from key k and the
+		// mapped value's constructor arguments.
+		template <class KK, class...Args>
+		void construct_element_(leaf_t* l, std::ptrdiff_t i, KK&& k, Args&&...args) {
+			auto a = leaf_allocator{alloc()};
+			leaf_traits::construct(a, std::addressof(l->keys.data[i]), std::forward<KK>(k));
+			try {
+				mapped_t::construct(a, l, i, std::forward<Args>(args)...);
+			} catch(...) {
+				leaf_traits::destroy(a, std::addressof(l->keys.data[i]));
+				throw;
+			}
+		}
+
+		// Where a search for k leads: the leaf, and the rank of k within
+		// it. lower_bound's position, unless Upper.
+		template <bool Upper>
+		std::pair<leaf_t*, std::ptrdiff_t> search_(const K& k) {
+			auto p = root_;
+			for (auto h = height_; h > 0; --h) {
+				auto const n = as_inner_(p);
+				p = n->children[__btree::rank<Upper>(n->keys.data, n->count, k, comp())];
+			}
+			auto const l = as_leaf_(p);
+			return {l, __btree::rank<Upper>(l->keys.data, l->count, k, comp())};
+		}
+
+		// (l, i) as an iterator, where i may be one past the last element
+		// of l.
+		iterator at_(leaf_t* l, std::ptrdiff_t i) noexcept {
+			if (i == l->count && l->next) {
+				return cursor<false>{as_leaf_(l->next), 0};
+			}
+			return cursor<false>{l, i};
+		}
+
+		template <bool Upper>
+		iterator bound_(const K& k) {
+			if (!root_) {
+				return end();
+			}
+			auto const r = search_<Upper>(k);
+			return at_(r.first, r.second);
+		}
+
+		template <class KK, class...Args>
+		std::pair<iterator, bool> emplace_unique_(KK&& k, Args&&...args) {
+			if (!root_) {
+				return {append_element_(std::forward<KK>(k), std::forward<Args>(args)...), true};
+			}
+			auto const r = search_<false>(k);
+			auto const i = at_(r.first, r.second);
+			if (i != end() && !comp()(k, key_(i))) {
+				return {i, false};
+			}
+			return {insert_(r.first, r.second, std::forward<KK>(k), std::forward<Args>(args)...), true};
+		}
+
+		template <class KK, class...Args>
+		iterator emplace_equal_(KK&& k, Args&&...args) {
+			if (!root_) {
+				return append_element_(std::forward<KK>(k), std::forward<Args>(args)...);
+			}
+			auto const r = search_<true>(k);
+			return insert_(r.first, r.second, std::forward<KK>(k), std::forward<Args>(args)...);
+		}
+
+		// Inserts at l[i], splitting l first if it is full.
+		template <class KK, class...Args>
+		iterator insert_(leaf_t* l, std::ptrdiff_t i, KK&& k, Args&&...args) {
+			if (l->count == leaf_capacity) {
+				if (i == l->count && !l->next) {
+					// Appending: a new last leaf, rather than two half-full
+					// ones, so that ascending insertions fill their leaves
+					return new_tail_<false>(l, std::forward<KK>(k), std::forward<Args>(args)...);
+				}
+				auto const r = split_(l);
+				if (i > l->count) {
+					i -= l->count;
+					l = r;
+				}
+			}
+			relocate_elements_(l, i + 1, l, i, l->count - i);
+			try {
+				construct_element_(l, i, std::forward<KK>(k), std::forward<Args>(args)...);
+			} catch(...) {
+				relocate_elements_(l, i, l, i + 1, l->count - i);
+				throw;
+			}
+			++l->count;
+			++size_;
+			return cursor<false>{l, i};
+		}
+
+		// Allocates the nodes that putting a new child beside n, and then
+		// beside each full ancestor, will need.
+		template <class Node>
+		void reserve_(spares& s, Node* n) {
+			auto p = as_inner_(n->parent);
+			for (; p && p->count == inner_capacity; p = as_inner_(p->parent)) {
+				s.inners[s.n++] = new_inner_();
+			}
+			if (!p) {
+				s.inners[s.n++] = new_inner_();
+			}
+		}
+
+		// Moves the upper half of the full leaf l to a new leaf, which it
+		// returns.
+		leaf_t* split_(leaf_t* l) {
+			spares s{*this};
+			s.leaf = new_leaf_();
+			reserve_(s, l);
+			auto const keep = l->count / 2;
+			K sep(l->keys.data[keep]);
+			auto const r = s.take_leaf();
+			relocate_elements_(r, 0, l, keep, l->count - keep);
+			r->count = l->count - keep;
+			l->count = keep;
+			link_after_(l, r);
+			insert_child_(l, std::move(sep), r, s);
+			return r;
+		}
+
+		void link_after_(leaf_t* l, leaf_t* r) noexcept {
+			r->prev = vp_(l);
+			r->next = l->next;
+			if (l->next) {
+				as_leaf_(l->next)->prev = vp_(r);
+			} else {
+				tail_ = vp_(r);
+			}
+			l->next = vp_(r);
+		}
+
+		template <class Node>
+		static std::ptrdiff_t child_index_(inner_t* p, Node* child) noexcept {
+			auto const v = vp_(child);
+			auto i = std::ptrdiff_t{0};
+			while (p->children[i] != v) {
+				++i;
+				STL2_EXPECT(i <= p->count);
+			}
+			return i;
+		}
+
+		// Makes a new root above left and right, split by sep.
+		template <class Node>
+		void grow_(Node* left, K&& sep, Node* right, spares& s) noexcept {
+			auto const root = s.take_inner();
+			auto a = leaf_allocator{alloc()};
+			leaf_traits::construct(a, std::addressof(root->keys.data[0]), std::move(sep));
+			root->count = 1;
+			root->children[0] = vp_(left);
+			root->children[1] = vp_(right);
+			left->parent = right->parent = vp_(root);
+			root_ = vp_(root);
+			++height_;
+		}
+
+		// Puts sep and right, a new node that follows left, into left's
+		// parent, splitting the parent - and so on up - if it is full.
+		template <class Node>
+		void insert_child_(Node* left, K&& sep, Node* right, spares& s) noexcept {
+			auto p = as_inner_(left->parent);
+			if (!p) {
+				grow_(left, std::move(sep), right, s);
+				return;
+			}
+			auto pos = child_index_(p, left);
+			auto a = leaf_allocator{alloc()};
+			if (p->count == inner_capacity) {
+				// p keeps the first h keys, key h moves up, and q takes
+				// the rest.
+				auto const q = s.take_inner();
+				auto const h = inner_capacity / 2;
+				auto const level = level_of_(left) + 1;
+				relocate_keys_(q, 0, p, h + 1, inner_capacity - h - 1);
+				move_children_(q, 0, p, h + 1, inner_capacity - h);
+				q->count = inner_capacity - h - 1;
+				adopt_(q, 0, q->count + 1, level);
+				K up(std::move(p->keys.data[h]));
+				leaf_traits::destroy(a, std::addressof(p->keys.data[h]));
+				p->count = h;
+				if (pos > h) {
+					pos -= h + 1;
+					put_child_(q, pos, std::move(sep), right);
+				} else {
+					put_child_(p, pos, std::move(sep), right);
+				}
+				insert_child_(p, std::move(up), q, s);
+			} else {
+				put_child_(p, pos, std::move(sep), right);
+			}
+		}
+
+		template <class Node>
+		void put_child_(inner_t* p, std::ptrdiff_t pos, K&& sep, Node* right) noexcept {
+			auto a = leaf_allocator{alloc()};
+			relocate_keys_(p, pos + 1, p, pos, p->count - pos);
+			move_children_(p, pos + 2, p, pos + 1, p->count - pos);
+			leaf_traits::construct(a, std::addressof(p->keys.data[pos]), std::move(sep));
+			p->children[pos + 1] = vp_(right);
+			right->parent = vp_(p);
+			++p->count;
+		}
+
+		int level_of_(leaf_t*) const noexcept { return 0; }
+		int level_of_(inner_t* n) const noexcept {
+			auto level = height_;
+			for (auto p = n->parent; p; p = as_inner_(p)->parent) {
+				--level;
+			}
+			return level;
+		}
+
+		// Appends an element, which must not precede any other, to the
+		// last leaf.
+		template <class KK, class...Args>
+		iterator append_element_(KK&& k, Args&&...args) {
+			auto const l = as_leaf_(tail_);
+			if (!l) {
+				auto const r = new_leaf_();
+				try {
+					construct_element_(r, 0, std::forward<KK>(k), std::forward<Args>(args)...);
+				} catch(...) {
+					free_(r);
+					throw;
+				}
+				r->count = 1;
+				root_ = head_ = tail_ = vp_(r);
+				size_ = 1;
+				return cursor<false>{r, 0};
+			}
+			if (l->count == leaf_capacity) {
+				return new_tail_<true>(l, std::forward<KK>(k), std::forward<Args>(args)...);
+			}
+			construct_element_(l, l->count, std::forward<KK>(k), std::forward<Args>(args)...);
+			++size_;
+			return cursor<false>{l, l->count++};
+		}
+
+		// Starts a new last leaf after l, which is full, with an element
+		// that must not precede any other. Full nodes on the right edge
+		// gain a new sibling rather than splitting if Fill, which leaves
+		// the edge for fill_right_edge_ to even out.
+		template <bool Fill, class KK, class...Args>
+		iterator new_tail_(leaf_t* l, KK&& k, Args&&...args) {
+			spares s{*this};
+			s.leaf = new_leaf_();
+			reserve_(s, l);
+			K sep(k);
+			construct_element_(s.leaf, 0, std::forward<KK>(k), std::forward<Args>(args)...);
+			auto const r = s.take_leaf();
+			r->count = 1;
+			link_after_(l, r);
+			if (Fill) {
+				append_child_(l, std::move(sep), r, s);
+			} else {
+				insert_child_(l, std::move(sep), r, s);
+			}
+			++size_;
+			return cursor<false>{r, 0};
+		}
+
+		void append_from_(leaf_t* l, std::ptrdiff_t i) {
+			append_element_(std::move(l->keys.data[i]));
+		}
+		void append_from_(leaf_t* l, std::ptrdiff_t i)
+		requires !std::is_void<T>::value
+		{
+			append_element_(std::move(l->keys.data[i]), std::move(l->vals.data[i]));
+		}
+
+		template <class Node>
+		void append_child_(Node* left, K&& sep, Node* right, spares& s) noexcept {
+			auto const p = as_inner_(left->parent);
+			if (!p) {
+				grow_(left, std::move(sep), right, s);
+			} else if (p->count < inner_capacity) {
+				put_child_(p, p->count, std::move(sep), right);
+			} else {
+				auto const q = s.take_inner();
+				q->children[0] = vp_(right);
+				right->parent = vp_(q);
+				append_child_(p, std::move(sep), q, s);
+			}
+		}
+
+		template <InputIterator I, Sentinel<I> S>
+		void bulk_load_(I first, S last) {
+			STL2_EXPECT(empty());
+			try {
+				for (; first != last; ++first) {
+					auto const prev = empty() ? iterator{} : --end();
+					auto const i = unpack_(*first, [this](auto&&...parts) {
+						return append_element_(std::forward<decltype(parts)>(parts)...);
+					});
+					STL2_EXPECT(prev == iterator{} || (Multi
+						? !comp()(key_(i), key_(prev))
+						: comp()(key_(prev), key_(i))));
+				}
+			} catch(...) {
+				clear();
+				throw;
+			}
+			fill_right_edge_();
+		}
+
+		// Moves the elements of that, which are in order, to this empty
+		// tree.
+		void move_from_(basic_btree& that) {
+			STL2_EXPECT(empty());
+			try {
+				for (auto l = as_leaf_(that.head_); l; l = as_leaf_(l->next)) {
+					for (auto i = std::ptrdiff_t{0}; i < l->count; ++i) {
+						append_from_(l, i);
+					}
+				}
+			} catch(...) {
+				clear();
+				throw;
+			}
+			fill_right_edge_();
+		}
+
+		// Tops up the nodes on the right edge, which appending leaves as
+		// little as one element or child, from their left siblings. Those
+		// are full, and from the top down each edge node has one.
+		void fill_right_edge_() {
+			auto p = as_inner_(root_);
+			for (auto level = height_; level > 1; --level) {
+				auto const c = p->count;
+				auto const n = as_inner_(p->children[c]);
+				auto const left = as_inner_(p->children[c - 1]);
+				while (n->count < (inner_capacity - 1) / 2) {
+					rotate_right_(left, n, p, c - 1, level - 1);
+				}
+				p = n;
+			}
+			if (height_ > 0) {
+				auto const c = p->count;
+				auto const l = as_leaf_(p->children[c]);
+				auto const left = as_leaf_(p->children[c - 1]);
+				if (l->count < leaf_capacity / 2) {
+					auto const n = (left->count + l->count) / 2 - l->count;
+					p->keys.data[c - 1] = left->keys.data[left->count - n];
+					relocate_elements_(l, n, l, 0, l->count);
+					relocate_elements_(l, 0, left, left->count - n, n);
+					left->count -= n;
+					l->count += n;
+				}
+			}
+		}
+
+		// Moves the last key and child of left through the separator at
+		// p->keys[s] to the front of right.
+		void rotate_right_(inner_t* left, inner_t* right, inner_t* p, std::ptrdiff_t s, int level) noexcept {
+			relocate_keys_(right, 1, right, 0, right->count);
+			move_children_(right, 1, right, 0, right->count + 1);
+			relocate_key_(right, 0, p, s);
+			relocate_key_(p, s, left, left->count - 1);
+			right->children[0] = std::move(left->children[left->count]);
+			++right->count;
+			--left->count;
+			adopt_(right, 0, 1, level);
+		}
+		// Moves the first key and child of right through the separator at
+		// p->keys[s] to the end of left.
+		void rotate_left_(inner_t* left, inner_t* right, inner_t* p, std::ptrdiff_t s, int level) noexcept {
+			relocate_key_(left, left->count, p, s);
+			left->children[left->count + 1] = std::move(right->children[0]);
+			++left->count;
+			adopt_(left, left->count, left->count + 1, level);
+			relocate_key_(p, s, right, 0);
+			relocate_keys_(right, 0, right, 1, right->count - 1);
+			move_children_(right, 0, right, 1, right->count);
+			--right->count;
+		}
+
+		void take_(basic_btree& that) noexcept {
+			root_ = __stl2::exchange(that.root_, {});
+			head_ = __stl2::exchange(that.head_, {});
+			tail_ = __stl2::exchange(that.tail_, {});
+			size_ = __stl2::exchange(that.size_, 0);
+			height_ = __stl2::exchange(that.height_, 0);
+		}
+
+		iterator erase_(leaf_t* l, std::ptrdiff_t i) {
+			destroy_elements_(l, i, i + 1);
+			relocate_elements_(l, i, l, i + 1, l->count - i - 1);
+			--l->count;
+			--size_;
+			if (!l->parent) {
+				if (l->count == 0) {
+					free_(l);
+					root_ = head_ = tail_ = void_pointer{};
+					return end();
+				}
+			} else if (l->count < leaf_capacity / 2) {
+				auto const r = rebalance_(l, i);
+				l = r.first;
+				i = r.second;
+			}
+			return at_(l, i);
+		}
+
+		// Refills l, which has too few elements, from a sibling, or
+		// merges it with one. Returns where the element at l[i] ends up.
+		std::pair<leaf_t*, std::ptrdiff_t> rebalance_(leaf_t* l, std::ptrdiff_t i) {
+			auto const p = as_inner_(l->parent);
+			auto const c = child_index_(p, l);
+			auto const left = c > 0 ? as_leaf_(p->children[c - 1]) : nullptr;
+			auto const right = c < p->count ? as_leaf_(p->children[c + 1]) : nullptr;
+			// Separators are copies, updated before anything moves in
+			// case the copy throws.
+			if (left && left->count > leaf_capacity / 2) {
+				p->keys.data[c - 1] = left->keys.data[left->count - 1];
+				relocate_elements_(l, 1, l, 0, l->count);
+				relocate_elements_(l, 0, left, left->count - 1, 1);
+				++l->count;
+				--left->count;
+				return {l, i + 1};
+			}
+			if (right && right->count > leaf_capacity / 2) {
+				p->keys.data[c] = right->keys.data[1];
+				relocate_elements_(l, l->count, right, 0, 1);
+				relocate_elements_(right, 0, right, 1, right->count - 1);
+				++l->count;
+				--right->count;
+				return {l, i};
+			}
+			if (left) {
+				auto const n = left->count;
+				merge_(left, l, p, c - 1);
+				return {left, n + i};
+			}
+			merge_(l, right, p, c);
+			return {l, i};
+		}
+
+		// Moves the elements of right, p's child s + 1, to the end of left,
+		// and frees right.
+		void merge_(leaf_t* left, leaf_t* right, inner_t* p, std::ptrdiff_t s) noexcept {
+			relocate_elements_(left, left->count, right, 0, right->count);
+			left->count += right->count;
+			left->next = right->next;
+			if (right->next) {
+				as_leaf_(right->next)->prev = vp_(left);
+			} else {
+				tail_ = vp_(left);
+			}
+			free_(right);
+			destroy_keys_(p, s, s + 1);
+			close_(p, s, 1);
+		}
+
+		// Removes the raw key slot s and child s + 1 from p, which is
+		// level levels above the leaves.
+		void close_(inner_t* p, std::ptrdiff_t s, int level) noexcept {
+			relocate_keys_(p, s, p, s + 1, p->count - s - 1);
+			move_children_(p, s + 1, p, s + 2, p->count - s - 1);
+			p->children[p->count] = void_pointer{};
+			--p->count;
+			if (!p->parent) {
+				if (p->count == 0) {
+					// The root has one child left, which replaces it.
+					root_ = p->children[0];
+					if (level == 1) {
+						as_leaf_(root_)->parent = void_pointer{};
+					} else {
+						as_inner_(root_)->parent = void_pointer{};
+					}
+					free_(p);
+					--height_;
+				}
+			} else if (p->count < (inner_capacity - 1) / 2) {
+				rebalance_(p, level);
+			}
+		}
+
+		void rebalance_(inner_t* n, int level) noexcept {
+			auto const p = as_inner_(n->parent);
+			auto const c = child_index_(p, n);
+			auto const left = c > 0 ? as_inner_(p->children[c - 1]) : nullptr;
+			auto const right = c < p->count ? as_inner_(p->children[c + 1]) : nullptr;
+			if (left && left->count > (inner_capacity - 1) / 2) {
+				rotate_right_(left, n, p, c - 1, level);
+			} else if (right && right->count > (inner_capacity - 1) / 2) {
+				rotate_left_(n, right, p, c, level);
+			} else if (left) {
+				merge_(left, n, p, c - 1, level);
+			} else {
+				merge_(n, right, p, c, level);
+			}
+		}
+
+		// Moves the separator p->keys[s] and then the keys and children of
+		// right, p's child s + 1, to the end of left, and frees right.
+		void merge_(inner_t* left, inner_t* right, inner_t* p, std::ptrdiff_t s, int level) noexcept {
+			auto const n = left->count;
+			relocate_key_(left, n, p, s);
+			relocate_keys_(left, n + 1, right, 0, right->count);
+			move_children_(left, n + 1, right, 0, right->count + 1);
+			left->count += right->count + 1;
+			adopt_(left, n + 1, left->count + 1, level);
+			right->count = 0;
+			free_(right);
+			close_(p, s, level + 1);
+		}
+	};
+
+	// Extension
+	template <class K, class T, class Compare = less<>,
+		ProtoAllocator PA = std::allocator<std::pair<K, T>>, std::size_t NodeBytes = 512>
+	using btree_map = basic_btree<K, T, Compare, PA, NodeBytes, false>;
+
+	// Extension
+	template <class K, class T, class Compare = less<>,
+		ProtoAllocator PA = std::allocator<std::pair<K, T>>, std::size_t NodeBytes = 512>
+	using btree_multimap = basic_btree<K, T, Compare, PA, NodeBytes, true>;
+
+	// Extension
+	template <class K, class Compare = less<>,
+		ProtoAllocator PA = std::allocator<K>, std::size_t NodeBytes = 512>
+	using btree_set = basic_btree<K, void, Compare, PA, NodeBytes, false>;
+
+	// Extension
+	template <class K, class Compare = less<>,
+		ProtoAllocator PA = std::allocator<K>, std::size_t NodeBytes = 512>
+	using btree_multiset = basic_btree<K, void, Compare, PA, NodeBytes, true>;
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,344 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_CACHING_ALLOCATOR_HPP
+#define STL2_CACHING_ALLOCATOR_HPP
+
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+STL2_OPEN_NAMESPACE {
+	namespace __caching {
+		constexpr std::size_t slab_bytes = std::size_t{1} << 16;
+		constexpr std::size_t granule = 16;
+		constexpr int size_classes = 16;
+		constexpr std::size_t max_block = granule * size_classes;
+		constexpr int batch_size = 32;
+		constexpr int outboxes = 8;
+
+		// The unit of upstream allocation. Slabs are aligned to their
+		// size, so the header of the slab holding a block is found by
+		// masking the block's address.
+		struct alignas(slab_bytes) slab {
+			unsigned char bytes[slab_bytes];
+		};
+
+		struct block {
+			block* next;
+		};
+
+		struct cache;
+
+		// Every block in a slab has the slab's size class and owner.
+		struct alignas(granule * 4) slab_header {
+			cache* owner;
+			int size_class;
+		};
+
+		inline slab_header* header_of(void* p) noexcept {
+			return reinterpret_cast<slab_header*>(
+				reinterpret_cast<std::uintptr_t>(p) & ~(slab_bytes - 1));
+		}
+
+		constexpr int size_class(std::size_t bytes) noexcept {
+			return bytes == 0 ? 0 : static_cast<int>((bytes + granule - 1) / granule) - 1;
+		}
+
+		constexpr std::ptrdiff_t block_size(int k) noexcept {
+			return static_cast<std::ptrdiff_t>((k + 1) * granule);
+		}
+
+		// Blocks freed by this thread that belong to another, collected
+		// so that they can be handed over with one atomic operation.
+		struct batch {
+			cache* owner = nullptr;
+			block* head = nullptr;
+			block* tail = nullptr;
+			int count = 0;
+		};
+
+		// One thread's magazines: a free list of blocks per size class,
+		// and the unused end of the slab most recently carved for each.
+		// Only the owning thread touches anything but inbox, through
+		// which other threads return blocks in batches.
+		struct cache {
+			block* free[size_classes] = {};
+			unsigned char* bump[size_classes] = {};
+			unsigned char* bump_end[size_classes] = {};
+			std::atomic<block*> inbox{nullptr};
+			batch outbox[outboxes];
+			cache* next_orphan = nullptr;
+
+			void receive(block* head, block* tail) noexcept {
+				auto old = inbox.load(std::memory_order_relaxed);
+				do {
+					tail->next = old;
+				} while (!inbox.compare_exchange_weak(old, head,
+					std::memory_order_release, std::memory_order_relaxed));
+			}
+
+			void drain() noexcept {
+				auto b = inbox.exchange(nullptr, std::memory_order_acquire);
+				while (b) {
+					auto const next = b->next;
+					auto& list = free[header_of(b)->size_class];
+					b->next = list;
+					list = b;
+					b = next;
+				}
+			}
+
+			void release(block* b, int k) noexcept {
+				b->next = free[k];
+				free[k] = b;
+			}
+
+			void send(cache* owner, block* b) noexcept {
+				auto& out = outbox[reinterpret_cast<std::uintptr_t>(owner) / alignof(cache) % outboxes];
+				if (out.owner != owner) {
+					flush(out);
+					out.owner = owner;
+				}
+				b->next = out.head;
+				out.head = b;
+				if (!out.tail) {
+					out.tail = b;
+				}
+				if (++out.count == batch_size) {
+					flush(out);
+				}
+			}
+
+			void flush(batch& out) noexcept {
+				if (out.head) {
+					out.owner->receive(out.head, out.tail);
+				}
+				out = batch{};
+			}
+
+			void flush_all() noexcept {
+				for (auto& out : outbox) {
+					flush(out);
+				}
+			}
+		};
+
+		// The caches drawing slabs from one upstream allocator type: one
+		// for each live thread that has used it, plus those of exited
+		// threads, which wait - with their slabs and free blocks - to be
+		// adopted by the next thread that needs a cache. Slabs are never
+		// returned upstream, so each cache holds its owner's peak use.
+		template <class Upstream>
+		class heap {
+			using slab_allocator = rebind_allocator_t<Upstream, slab>;
+			using slab_traits = std::allocator_traits<slab_allocator>;
+			using cache_allocator = rebind_allocator_t<Upstream, cache>;
+			using cache_traits = std::allocator_traits<cache_allocator>;
+
+			struct registry {
+				std::mutex mtx;
+				cache* orphans = nullptr;
+			};
+			static registry& shared() {
+				static registry r;
+				return r;
+			}
+
+			struct holder {
+				cache* c = nullptr;
+				~holder() {
+					if (c) {
+						retire(c);
+						c = nullptr;
+					}
+				}
+			};
+			static holder& this_thread() {
+				static thread_local holder h;
+				return h;
+			}
+
+			static void retire(cache* c) noexcept {
+				c->flush_all();
+				auto& r = shared();
+				std::lock_guard<std::mutex> lock{r.mtx};
+				c->next_orphan = r.orphans;
+				r.orphans = c;
+			}
+
+			static cache* adopt() {
+				{
+					auto& r = shared();
+					std::lock_guard<std::mutex> lock{r.mtx};
+					if (auto const c = r.orphans) {
+						r.orphans = c->next_orphan;
+						c->next_orphan = nullptr;
+						return c;
+					}
+				}
+				auto a = cache_allocator{};
+				auto const c = std::addressof(*cache_traits::allocate(a, 1));
+				::new (static_cast<void*>(c)) cache;
+				return c;
+			}
+
+			static void* carve(cache& c, int k) {
+				auto const size = block_size(k);
+				if (c.bump_end[k] - c.bump[k] < size) {
+					auto a = slab_allocator{};
+					auto const s = std::addressof(*slab_traits::allocate(a, 1));
+					::new (static_cast<void*>(s)) slab_header{std::addressof(c), k};
+					c.bump[k] = s->bytes + sizeof(slab_header);
+					c.bump_end[k] = s->bytes + slab_bytes;
+				}
+				auto const p = c.bump[k];
+				c.bump[k] += size;
+				return p;
+			}
+
+		public:
+			// Requires bytes <= max_block
+			static void* allocate(std::size_t bytes) {
+				STL2_EXPECT(bytes <= max_block);
+				auto const k = size_class(bytes);
+				auto& h = this_thread();
+				if (!h.c) {
+					h.c = adopt();
+				}
+				auto& c = *h.c;
+				if (!c.free[k]) {
+					c.drain();
+				}
+				if (auto const b = c.free[k]) {
+					c.free[k] = b->next;
+					return b;
+				}
+				return carve(c, k);
+			}
+
+			static void deallocate(void* p) noexcept {
+				auto const header = header_of(p);
+				auto const b = ::new (p) block;
+				auto const c = this_thread().c;
+				if (c == header->owner) {
+					c->release(b, header->size_class);
+				} else if (c) {
+					c->send(header->owner, b);
+				} else {
+					header->owner->receive(b, b);
+				}
+			}
+		};
+	}
+
+	// An allocator adaptor that serves small allocations from per-thread,
+	// per-size-class caches of free blocks, and goes to Upstream only for
+	// 64 KiB slabs, for large requests, and for over-aligned types. A
+	// block freed by a thread other than the one that allocated it is
+	// queued, and returned to its owner together with up to 31 others in
+	// a single atomic operation.
+	//
+	// caching_allocator is empty and all instances compare equal, so
+	// containers swap and move-assign in O(1) regardless of propagation
+	// traits. Upstream must be likewise stateless.
+	template <class T, ProtoAllocator Upstream = std::allocator<T>>
+	requires
+		DefaultConstructible<Upstream>() &&
+		std::allocator_traits<Upstream>::is_always_equal::value
+	class caching_allocator {
+		using heap = __caching::heap<rebind_allocator_t<Upstream, __caching::slab>>;
+		using upstream_type = rebind_allocator_t<Upstream, T>;
+		using upstream_traits = std::allocator_traits<upstream_type>;
+
+		static constexpr bool cached(std::size_t n) noexcept {
+			return alignof(T) <= __caching::granule &&
+				n <= __caching::max_block / sizeof(T);
+		}
+
+	public:
+		using value_type = T;
+		using is_always_equal = true_type;
+
+		template <class U>
+		struct rebind {
+			using other = caching_allocator<U, rebind_allocator_t<Upstream, U>>;
+		};
+
+		caching_allocator() = default;
+		template <class U, class V>
+		constexpr caching_allocator(const caching_allocator<U, V>&) noexcept {}
+
+		T* allocate(std::size_t n) const {
+			if (cached(n)) {
+				return static_cast<T*>(heap::allocate(n * sizeof(T)));
+			}
+			auto a = upstream_type{};
+			return std::addressof(*upstream_traits::allocate(a, n));
+		}
+
+		void deallocate(T* p, std::size_t n) const noexcept {
+			if (cached(n)) {
+				heap::deallocate(p);
+			} else {
+				auto a = upstream_type{};
+				upstream_traits::deallocate(a,
+					std::pointer_traits<typename upstream_traits::pointer>::pointer_to(*p), n);
+			}
+		}
+
+		// Extension
+		// The bytes lost to rounding a cached request up to its size
+		// class; for others, whatever Upstream reports.
+		std::size_t allocation_overhead(std::size_t n) const noexcept {
+			if (cached(n)) {
+				return static_cast<std::size_t>(
+					__caching::block_size(__caching::size_class(n * sizeof(T)))) - n * sizeof(T);
+			}
+			return __memory_stats::allocator_overhead(upstream_type{}, n);
+		}
+	};
+
+	template <class Upstream>
+	class caching_allocator<void, Upstream> {
+	public:
+		using value_type = void;
+		using is_always_equal = true_type;
+
+		template <class U>
+		struct rebind {
+			using other = caching_allocator<U, rebind_allocator_t<Upstream, U>>;
+		};
+
+		caching_allocator() = default;
+		template <class U, class V>
+		constexpr caching_allocator(const caching_allocator<U, V>&) noexcept {}
+	};
+
+	template <class T, class A, class U, class B>
+	constexpr bool operator==(const caching_allocator<T, A>&, const caching_allocator<U, B>&) noexcept {
+		return true;
+	}
+	template <class T, class A, class U, class B>
+	constexpr bool operator!=(const caching_allocator<T, A>&, const caching_allocator<U, B>&) noexcept {
+		return false;
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,502 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_COLONY_HPP
+#define STL2_COLONY_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstdint>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __colony {
+		using skip_t = std::uint16_t;
+		constexpr skip_t none = skip_t(-1);
+		constexpr skip_t min_capacity = 8;
+		constexpr skip_t max_capacity = 8192;
+
+		template <class T>
+		struct slot {
+			// An erased slot that begins a run of erased slots is linked
+			// into its group's list of such runs.
+			struct links {
+				skip_t prev_;
+				skip_t next_;
+			};
+
+			T& get() & noexcept { return reinterpret_cast<T&>(storage_); }
+			const T& get() const& noexcept { return reinterpret_cast<const T&>(storage_); }
+			links& free() & noexcept { return reinterpret_cast<links&>(storage_); }
+
+			aligned_storage_t<
+				(sizeof(T) < sizeof(links) ? sizeof(links) : sizeof(T)),
+				(alignof(T) < alignof(links) ? alignof(links) : alignof(T))> storage_;
+		};
+
+		template <class T, PointerTo<void> VoidPointer>
+		struct group {
+			using pointer = rebind_pointer_t<VoidPointer, group>;
+			using slot_pointer = rebind_pointer_t<VoidPointer, slot<T>>;
+			using skip_pointer = rebind_pointer_t<VoidPointer, skip_t>;
+
+			slot_pointer slots_ = nullptr;
+			// A jump-counting skip field: skip_[i] is zero iff slot i holds
+			// an element, and the first and last entries of each maximal
+			// run of erased slots hold the length of the run.
+			skip_pointer skip_ = nullptr;
+			// The chain of all groups, in iteration order.
+			pointer next_ = nullptr;
+			pointer prev_ = nullptr;
+			// The chain of groups with erased slots to reuse.
+			pointer next_free_ = nullptr;
+			pointer prev_free_ = nullptr;
+			skip_t capacity_ = 0;
+			// Slots [high_water_, capacity_) have never held an element.
+			skip_t high_water_ = 0;
+			skip_t size_ = 0;
+			// The first slot of some run of erased slots, or none.
+			skip_t free_head_ = none;
+
+			// Requires: i == 0 or slot i - 1 holds an element.
+			// Returns: the index of the first element at or after i, or
+			// high_water_ if there is none.
+			skip_t skip_forward(skip_t i) const noexcept {
+				if (i < high_water_) {
+					i += skip_[i];
+				}
+				return i;
+			}
+		};
+
+		template <class T, PointerTo<void> VoidPointer>
+		class cursor {
+			using group_t = group<remove_cv_t<T>, VoidPointer>;
+			using group_pointer = typename group_t::pointer;
+			template <class, PointerTo<void>> friend class cursor;
+
+			group_pointer group_ = nullptr;
+			skip_t index_ = 0;
+
+		public:
+			using value_type = remove_cv_t<T>;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			constexpr cursor(default_sentinel) noexcept {}
+			constexpr cursor(group_pointer g, skip_t i) noexcept
+			: group_{std::move(g)}, index_{i} {}
+			template <class U>
+			requires
+				std::is_const<T>::value &&
+				Same<U, remove_const_t<T>>()
+			constexpr cursor(const cursor<U, VoidPointer>& that) noexcept
+			: group_{that.group_}, index_{that.index_} {}
+
+			T& read() const noexcept {
+				STL2_EXPECT(group_);
+				return group_->slots_[index_].get();
+			}
+			void next() noexcept {
+				STL2_EXPECT(group_);
+				index_ = group_->skip_forward(index_ + 1);
+				if (index_ == group_->high_water_) {
+					group_ = group_->next_;
+					index_ = group_ ? group_->skip_forward(0) : 0;
+				}
+			}
+			constexpr bool equal(const cursor& that) const noexcept {
+				return group_ == that.group_ && index_ == that.index_;
+			}
+			constexpr bool done() const noexcept {
+				return group_ == nullptr;
+			}
+
+			const group_pointer& group_ptr() const noexcept { return group_; }
+			skip_t index() const noexcept { return index_; }
+		};
+	}
+
+	// An unordered container whose elements never move: storage is a chain
+	// of blocks of geometrically increasing size, erased slots are marked in
+	// a skip field so that iteration jumps over them in O(1), and new
+	// elements reuse erased slots before any block is grown. Blocks that
+	// become empty are released.
+	template <class T, ProtoAllocator A = std::allocator<T>>
+	requires
+		ProtoAllocator<A, __colony::group<T, proto_allocator_pointer_t<A>>>() &&
+		ProtoAllocator<A, __colony::slot<T>>() &&
+		ProtoAllocator<A, __colony::skip_t>()
+	class colony : detail::ebo_box<A> {
+		using skip_t = __colony::skip_t;
+		using slot_t = __colony::slot<T>;
+		using group_t = __colony::group<T, proto_allocator_pointer_t<A>>;
+		using group_allocator_type = rebind_allocator_t<A, group_t>;
+		using slot_allocator_type = rebind_allocator_t<A, slot_t>;
+		using skip_allocator_type = rebind_allocator_t<A, skip_t>;
+		using group_traits = std::allocator_traits<group_allocator_type>;
+		using slot_traits = std::allocator_traits<slot_allocator_type>;
+		using skip_traits = std::allocator_traits<skip_allocator_type>;
+		using group_pointer = typename group_t::pointer;
+		using cursor = __colony::cursor<T, proto_allocator_pointer_t<A>>;
+		using const_cursor = __colony::cursor<const T, proto_allocator_pointer_t<A>>;
+
+	public:
+		using value_type = T;
+		using allocator_type = A;
+		using size_type = std::ptrdiff_t;
+		using iterator = __stl2::basic_iterator<cursor>;
+		using const_iterator = __stl2::basic_iterator<const_cursor>;
+
+		~colony()
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorDestructible<slot_allocator_type, T>()
+		{ clear(); }
+
+		colony()
+		requires
+			DefaultConstructible<A>() = default;
+
+		constexpr explicit colony(allocator_type a) noexcept
+		: detail::ebo_box<A>(std::move(a)) {}
+
+		colony(colony&& that) noexcept
+		: detail::ebo_box<A>{std::move(that.detail::ebo_box<A>::get())},
+			first_group_{__stl2::exchange(that.first_group_, nullptr)},
+			last_group_{__stl2::exchange(that.last_group_, nullptr)},
+			free_groups_{__stl2::exchange(that.free_groups_, nullptr)},
+			size_{__stl2::exchange(that.size_, 0)},
+			capacity_{__stl2::exchange(that.capacity_, 0)}
+		{}
+
+		colony(const colony& that)
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorCopyConstructible<slot_allocator_type, T>()
+		: colony{std::allocator_traits<A>::select_on_container_copy_construction(
+			that.detail::ebo_box<A>::get())}
+		{
+			for (auto&& e : that) {
+				emplace(e);
+			}
+		}
+
+		// FIXME: NYI
+		colony& operator=(colony&&) & = delete;
+		colony& operator=(const colony&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return detail::ebo_box<A>::get();
+		}
+
+		iterator begin() noexcept {
+			return cursor{first_group_, first_group_ ? first_group_->skip_forward(0) : skip_t{0}};
+		}
+		const_iterator begin() const noexcept {
+			return const_cursor{first_group_, first_group_ ? first_group_->skip_forward(0) : skip_t{0}};
+		}
+		const_iterator cbegin() const noexcept {
+			return begin();
+		}
+
+		default_sentinel end() const noexcept {
+			return {};
+		}
+		default_sentinel cend() const noexcept {
+			return {};
+		}
+
+		size_type size() const noexcept {
+			return size_;
+		}
+		bool empty() const noexcept {
+			return size_ == 0;
+		}
+		size_type capacity() const noexcept {
+			return capacity_;
+		}
+
+		// Extension: each group's header and skip field, and any padding
+		// of slots to hold free-list links, count as overhead.
+		memory_stats memory_usage() const noexcept {
+			auto const ga = group_allocator_type{detail::ebo_box<A>::get()};
+			auto const sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			auto const ka = skip_allocator_type{detail::ebo_box<A>::get()};
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(size_);
+			s.slack = __memory_stats::bytes<T>(capacity_ - size_);
+			for (group_pointer g = first_group_; g; g = g->next_) {
+				s.overhead += sizeof(group_t) +
+					(sizeof(slot_t) - sizeof(T) + sizeof(skip_t)) * g->capacity_;
+				__memory_stats::allocation(s, ga, 1);
+				__memory_stats::allocation(s, sa, g->capacity_);
+				__memory_stats::allocation(s, ka, g->capacity_);
+			}
+			return s;
+		}
+
+		template <class...Args>
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorConstructible<slot_allocator_type, T, Args...>()
+		iterator emplace(Args&&...args) {
+			auto sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			if (free_groups_) {
+				group_pointer g = free_groups_;
+				auto const i = g->free_head_;
+				take_erased(*g, i);
+				try {
+					slot_traits::construct(sa, std::addressof(g->slots_[i].get()),
+						__stl2::forward<Args>(args)...);
+				} catch(...) {
+					release(*g, i);
+					throw;
+				}
+				++g->size_;
+				++size_;
+				return cursor{g, i};
+			}
+
+			if (!last_group_ || last_group_->high_water_ == last_group_->capacity_) {
+				append_group();
+			}
+			group_pointer g = last_group_;
+			auto const i = g->high_water_;
+			try {
+				slot_traits::construct(sa, std::addressof(g->slots_[i].get()),
+					__stl2::forward<Args>(args)...);
+			} catch(...) {
+				if (g->size_ == 0) {
+					remove_group(g);
+				}
+				throw;
+			}
+			++g->high_water_;
+			++g->size_;
+			++size_;
+			return cursor{g, i};
+		}
+
+		iterator insert(const T& t)
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorCopyConstructible<slot_allocator_type, T>()
+		{
+			return emplace(t);
+		}
+		iterator insert(T&& t)
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorMoveConstructible<slot_allocator_type, T>()
+		{
+			return emplace(std::move(t));
+		}
+
+		// Invalidates only iterators and references to the erased element.
+		iterator erase(const_iterator where) noexcept
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorDestructible<slot_allocator_type, T>()
+		{
+			group_pointer g = where.group_ptr();
+			auto const i = where.index();
+			iterator next = cursor{g, i};
+			++next;
+			auto sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			slot_traits::destroy(sa, std::addressof(g->slots_[i].get()));
+			--size_;
+			if (--g->size_ == 0) {
+				remove_group(g);
+			} else {
+				release(*g, i);
+			}
+			return next;
+		}
+
+		void clear() noexcept
+		requires
+			Allocator<group_allocator_type, group_t>() &&
+			AllocatorDestructible<slot_allocator_type, T>()
+		{
+			auto sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			while (first_group_) {
+				group_pointer g = first_group_;
+				for (auto i = g->skip_forward(0); i != g->high_water_; i = g->skip_forward(i + 1)) {
+					slot_traits::destroy(sa, std::addressof(g->slots_[i].get()));
+				}
+				remove_group(g);
+			}
+			size_ = 0;
+		}
+
+	private:
+		group_pointer first_group_ = nullptr;
+		group_pointer last_group_ = nullptr;
+		group_pointer free_groups_ = nullptr;
+		size_type size_ = 0;
+		size_type capacity_ = 0;
+
+		static void link(group_t& g, skip_t i) noexcept {
+			auto& l = g.slots_[i].free();
+			l.prev_ = __colony::none;
+			l.next_ = g.free_head_;
+			if (g.free_head_ != __colony::none) {
+				g.slots_[g.free_head_].free().prev_ = i;
+			}
+			g.free_head_ = i;
+		}
+
+		static void unlink(group_t& g, skip_t i) noexcept {
+			auto& l = g.slots_[i].free();
+			if (l.prev_ != __colony::none) {
+				g.slots_[l.prev_].free().next_ = l.next_;
+			} else {
+				g.free_head_ = l.next_;
+			}
+			if (l.next_ != __colony::none) {
+				g.slots_[l.next_].free().prev_ = l.prev_;
+			}
+		}
+
+		// Requires: i is the first slot of a run of erased slots in g.
+		// Ensures: i is no longer marked erased.
+		void take_erased(group_t& g, skip_t i) noexcept {
+			auto const len = g.skip_[i];
+			unlink(g, i);
+			g.skip_[i] = 0;
+			if (len > 1) {
+				g.skip_[i + 1] = len - 1;
+				g.skip_[i + len - 1] = len - 1;
+				link(g, i + 1);
+			}
+			if (g.free_head_ == __colony::none) {
+				unlink_free_group(g);
+			}
+		}
+
+		// Requires: slot i of g holds no element.
+		// Ensures: i is marked erased, merged with any adjacent runs.
+		void release(group_t& g, skip_t i) noexcept {
+			auto const was_free = g.free_head_ != __colony::none;
+			auto const left = i > 0 ? g.skip_[i - 1] : skip_t{0};
+			auto const right = i + 1 < g.high_water_ ? g.skip_[i + 1] : skip_t{0};
+			auto const len = static_cast<skip_t>(left + right + 1);
+			if (right != 0) {
+				unlink(g, i + 1);
+				g.skip_[i + right] = len;
+			}
+			g.skip_[i] = len;
+			if (left != 0) {
+				g.skip_[i - left] = len;
+			} else {
+				link(g, i);
+			}
+			if (!was_free) {
+				g.prev_free_ = nullptr;
+				g.next_free_ = free_groups_;
+				if (free_groups_) {
+					free_groups_->prev_free_ = group_pointer_to(g);
+				}
+				free_groups_ = group_pointer_to(g);
+			}
+		}
+
+		void unlink_free_group(group_t& g) noexcept {
+			if (g.prev_free_) {
+				g.prev_free_->next_free_ = g.next_free_;
+			} else {
+				free_groups_ = g.next_free_;
+			}
+			if (g.next_free_) {
+				g.next_free_->prev_free_ = g.prev_free_;
+			}
+			g.next_free_ = g.prev_free_ = nullptr;
+		}
+
+		group_pointer group_pointer_to(group_t& g) const noexcept {
+			return g.prev_ ? g.prev_->next_ : first_group_;
+		}
+
+		void append_group()
+		requires
+			Allocator<group_allocator_type, group_t>()
+		{
+			auto const cap = static_cast<skip_t>(__stl2::min(
+				size_type{__colony::max_capacity},
+				__stl2::max(size_type{__colony::min_capacity}, size_)));
+			auto ga = group_allocator_type{detail::ebo_box<A>::get()};
+			auto sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			auto ka = skip_allocator_type{detail::ebo_box<A>::get()};
+			group_pointer g = group_traits::allocate(ga, 1);
+			group_traits::construct(ga, std::addressof(*g));
+			try {
+				g->slots_ = slot_traits::allocate(sa, cap);
+				try {
+					g->skip_ = skip_traits::allocate(ka, cap);
+				} catch(...) {
+					slot_traits::deallocate(sa, g->slots_, cap);
+					throw;
+				}
+			} catch(...) {
+				group_traits::destroy(ga, std::addressof(*g));
+				group_traits::deallocate(ga, g, 1);
+				throw;
+			}
+			for (auto i = skip_t{0}; i != cap; ++i) {
+				g->skip_[i] = 0;
+			}
+			g->capacity_ = cap;
+			g->prev_ = last_group_;
+			if (last_group_) {
+				last_group_->next_ = g;
+			} else {
+				first_group_ = g;
+			}
+			last_group_ = g;
+			capacity_ += cap;
+		}
+
+		void remove_group(group_pointer g) noexcept
+		requires
+			Allocator<group_allocator_type, group_t>()
+		{
+			if (g->free_head_ != __colony::none) {
+				unlink_free_group(*g);
+			}
+			if (g->prev_) {
+				g->prev_->next_ = g->next_;
+			} else {
+				first_group_ = g->next_;
+			}
+			if (g->next_) {
+				g->next_->prev_ = g->prev_;
+			} else {
+				last_group_ = g->prev_;
+			}
+			capacity_ -= g->capacity_;
+			auto ga = group_allocator_type{detail::ebo_box<A>::get()};
+			auto sa = slot_allocator_type{detail::ebo_box<A>::get()};
+			auto ka = skip_allocator_type{detail::ebo_box<A>::get()};
+			skip_traits::deallocate(ka, g->skip_, g->capacity_);
+			slot_traits::deallocate(sa, g->slots_, g->capacity_);
+			group_traits::destroy(ga, std::addressof(*g));
+			group_traits::deallocate(ga, g, 1);
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
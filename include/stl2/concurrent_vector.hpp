@@ -0,0 +1,527 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_CONCURRENT_VECTOR_HPP
+#define STL2_CONCURRENT_VECTOR_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+STL2_OPEN_NAMESPACE {
+	namespace __concurrent_vector {
+		// Assumed destructive interference size; the size counter, which
+		// every appending thread modifies, is kept this far from the
+		// segment table that every reader loads.
+		constexpr std::size_t cache_line = 64;
+
+		// Elements per block; each block carries one bit per element
+		// saying whether it has been published.
+		constexpr int block_log2 = 6;
+		constexpr std::ptrdiff_t block_size = std::ptrdiff_t{1} << block_log2;
+
+		// Segment k holds block_size << k elements, so the segments
+		// together cover indices up to 2^62.
+		constexpr int max_segments = 62 - block_log2;
+
+		constexpr std::ptrdiff_t segment_begin(int k) noexcept {
+			return (block_size << k) - block_size;
+		}
+		constexpr std::ptrdiff_t segment_size(int k) noexcept {
+			return block_size << k;
+		}
+
+		// The segment holding index i, and i's offset therein.
+		struct place {
+			int segment;
+			std::ptrdiff_t offset;
+		};
+		inline place locate(std::ptrdiff_t i) noexcept {
+			auto const j = static_cast<std::uint64_t>(i) + block_size;
+			auto const k = 63 - __builtin_clzll(j) - block_log2;
+			return {k, static_cast<std::ptrdiff_t>(j) - segment_size(k)};
+		}
+
+		template <class T>
+		struct block {
+			std::atomic<std::uint64_t> ready_;
+			aligned_storage_t<sizeof(T), alignof(T)> storage_[block_size];
+
+			T& get(std::ptrdiff_t i) & noexcept {
+				return reinterpret_cast<T&>(storage_[i]);
+			}
+		};
+	}
+
+	// A vector that any number of threads may append to concurrently
+	// while others read it. Storage grows by segments of doubling size
+	// that are never moved or freed before clear, so references to
+	// elements remain valid as the vector grows. Appending reserves
+	// indices with a single fetch_add and is lock-free; reading a
+	// published element is wait-free.
+	//
+	// An element is published - visible to, and safe to read from, other
+	// threads - once the push_back or grow_by that appended it returns;
+	// published(i) reports whether it has been. size() counts indices
+	// reserved, which may include elements still under construction and
+	// holes left by appends that threw.
+	template <class T, ProtoAllocator PA = std::allocator<T>>
+	requires
+		ProtoAllocator<PA, __concurrent_vector::block<T>>()
+	class concurrent_vector
+	: detail::ebo_box<rebind_allocator_t<PA, __concurrent_vector::block<T>>> {
+		using block_t = __concurrent_vector::block<T>;
+		using block_allocator_type = rebind_allocator_t<PA, block_t>;
+		using base_t = detail::ebo_box<block_allocator_type>;
+		using traits = std::allocator_traits<block_allocator_type>;
+		using block_pointer = typename traits::pointer;
+	public:
+		using value_type = T;
+		using allocator_type = PA;
+		using size_type = difference_type_t<block_pointer>;
+		using difference_type = size_type;
+		using reference = T&;
+		using const_reference = const T&;
+
+	private:
+		// An index into the vector; reading through it is subject to the
+		// same publication rules as operator[].
+		template <bool Const>
+		class cursor {
+			friend concurrent_vector;
+			template <bool> friend class cursor;
+
+			using vector_t = conditional_t<Const, const concurrent_vector, concurrent_vector>;
+
+			vector_t* vec_ = nullptr;
+			size_type pos_ = 0;
+
+			cursor(vector_t& vec, size_type pos) noexcept
+			: vec_{std::addressof(vec)}, pos_{pos} {}
+
+		public:
+			using value_type = T;
+			using difference_type = size_type;
+
+			cursor() = default;
+			template <bool C>
+			requires Const && !C
+			cursor(const cursor<C>& that) noexcept
+			: vec_{that.vec_}, pos_{that.pos_} {}
+
+			conditional_t<Const, const T&, T&> read() const noexcept {
+				return (*vec_)[pos_];
+			}
+			void next() noexcept { ++pos_; }
+			void prev() noexcept { --pos_; }
+			void advance(difference_type n) noexcept { pos_ += n; }
+			difference_type distance_to(const cursor& that) const noexcept {
+				STL2_EXPECT(vec_ == that.vec_);
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return vec_ == that.vec_ && pos_ == that.pos_;
+			}
+		};
+
+	public:
+		using iterator = basic_iterator<cursor<false>>;
+		using const_iterator = basic_iterator<cursor<true>>;
+
+		~concurrent_vector()
+			requires Allocator<block_allocator_type, block_t>() &&
+				AllocatorDestructible<block_allocator_type, T>()
+		{
+			clear();
+		}
+
+		concurrent_vector()
+			requires Allocator<block_allocator_type, block_t>() &&
+				DefaultConstructible<allocator_type>()
+		= default;
+
+		explicit concurrent_vector(allocator_type a)
+			requires Allocator<block_allocator_type, block_t>()
+		: base_t{block_allocator_type{std::move(a)}}
+		{}
+
+		// Extension
+		concurrent_vector(reserve_t, size_type n, allocator_type a)
+			requires Allocator<block_allocator_type, block_t>()
+		: concurrent_vector{std::move(a)}
+		{
+			reserve(n);
+		}
+
+		// Extension
+		concurrent_vector(reserve_t, size_type n)
+			requires Allocator<block_allocator_type, block_t>() &&
+				DefaultConstructible<allocator_type>()
+		: concurrent_vector{reserve_t{}, n, allocator_type{}}
+		{}
+
+		// Not thread-safe.
+		concurrent_vector(concurrent_vector&& that) noexcept
+		: base_t{std::move(that.alloc())}
+		{
+			steal_(that);
+		}
+
+		concurrent_vector(const concurrent_vector&) = delete;
+		concurrent_vector& operator=(const concurrent_vector&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return allocator_type{alloc()};
+		}
+
+		// The number of indices reserved by appends, including those whose
+		// elements are still under construction.
+		size_type size() const noexcept {
+			return size_.load(std::memory_order_acquire);
+		}
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		// The number of elements the vector can hold before it next
+		// allocates a segment.
+		size_type capacity() const noexcept {
+			auto k = 0;
+			while (k < __concurrent_vector::max_segments &&
+				segments_[k].load(std::memory_order_acquire)) {
+				++k;
+			}
+			return __concurrent_vector::segment_begin(k);
+		}
+
+		// Extension
+		// A snapshot when appends are in flight. Only published elements
+		// count as payload; holes and reserved slots still under
+		// construction count as slack. Each block's publication mask
+		// counts as overhead.
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			auto capacity = size_type{0};
+			auto ready = size_type{0};
+			for (auto k = 0; k < __concurrent_vector::max_segments; ++k) {
+				auto const seg = segments_[k].load(std::memory_order_acquire);
+				if (!seg) {
+					continue;
+				}
+				auto const blocks = __concurrent_vector::segment_size(k) >>
+					__concurrent_vector::block_log2;
+				for (auto i = size_type{0}; i < blocks; ++i) {
+					ready += __builtin_popcountll(
+						seg[i].ready_.load(std::memory_order_relaxed));
+				}
+				capacity += __concurrent_vector::segment_size(k);
+				s.overhead += (sizeof(block_t) -
+					__memory_stats::bytes<T>(__concurrent_vector::block_size)) *
+					static_cast<std::size_t>(blocks);
+				__memory_stats::allocation(s, alloc(), blocks);
+			}
+			s.payload = __memory_stats::bytes<T>(ready);
+			s.slack = __memory_stats::bytes<T>(capacity - ready);
+			return s;
+		}
+
+		// Allocates every segment needed to hold n elements. Thread-safe.
+		void reserve(size_type n) {
+			STL2_EXPECT(n >= 0);
+			if (n > 0) {
+				ensure_(0, n);
+			}
+		}
+
+		// Whether element i has been fully constructed and published.
+		// Wait-free.
+		bool published(size_type i) const noexcept {
+			if (i < 0 || i >= size()) {
+				return false;
+			}
+			auto const p = __concurrent_vector::locate(i);
+			auto const s = segments_[p.segment].load(std::memory_order_acquire);
+			if (!s) {
+				return false;
+			}
+			auto const& b = s[p.offset >> __concurrent_vector::block_log2];
+			return (b.ready_.load(std::memory_order_acquire) >>
+				(p.offset & (__concurrent_vector::block_size - 1))) & 1;
+		}
+
+		// Element i, which must be published - or have been appended by
+		// this thread - for the access not to race. Wait-free.
+		//
+		// An append whose constructor threw leaves its index reserved but
+		// never published: a hole in [0, size()) that holds no object.
+		// Unless no append has ever thrown, check published(i) first.
+		reference operator[](size_type i) noexcept {
+			STL2_EXPECT(i >= 0 && i < size());
+			return slot_(i);
+		}
+		const_reference operator[](size_type i) const noexcept {
+			STL2_EXPECT(i >= 0 && i < size());
+			return slot_(i);
+		}
+
+		reference at(size_type i) {
+			if (!published(i)) {
+				throw std::out_of_range{"concurrent_vector::at"};
+			}
+			return slot_(i);
+		}
+		const_reference at(size_type i) const {
+			if (!published(i)) {
+				throw std::out_of_range{"concurrent_vector::at"};
+			}
+			return slot_(i);
+		}
+
+		// Iteration covers [0, size()), and so must not overlap appends
+		// whose elements it would reach. It visits every index, holes left
+		// by throwing appends included; see operator[].
+		iterator begin() noexcept { return cursor<false>{*this, 0}; }
+		iterator end() noexcept { return cursor<false>{*this, size()}; }
+		const_iterator begin() const noexcept { return cursor<true>{*this, 0}; }
+		const_iterator end() const noexcept { return cursor<true>{*this, size()}; }
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		// Thread-safe. Returns a reference to the new element, which
+		// remains valid until clear or destruction.
+		template <class...Args>
+		requires
+			AllocatorConstructible<block_allocator_type, T, Args...>()
+		reference emplace_back(Args&&...args) {
+			auto const i = size_.fetch_add(1, std::memory_order_relaxed);
+			STL2_EXPECT(i < max_size());
+			auto const p = __concurrent_vector::locate(i);
+			auto s = segments_[p.segment].load(std::memory_order_acquire);
+			if (!s) {
+				s = allocate_segment_(p.segment);
+			}
+			auto& b = s[p.offset >> __concurrent_vector::block_log2];
+			auto const bit = p.offset & (__concurrent_vector::block_size - 1);
+			auto& t = b.get(bit);
+			// A throwing constructor leaves a hole that is never published.
+			traits::construct(alloc(), std::addressof(t), __stl2::forward<Args>(args)...);
+			b.ready_.fetch_or(std::uint64_t{1} << bit, std::memory_order_release);
+			return t;
+		}
+		reference push_back(const T& t)
+		requires
+			AllocatorCopyConstructible<block_allocator_type, T>()
+		{
+			return emplace_back(t);
+		}
+		reference push_back(T&& t)
+		requires
+			AllocatorMoveConstructible<block_allocator_type, T>()
+		{
+			return emplace_back(std::move(t));
+		}
+
+		// Thread-safe. Appends n value-initialized elements with a single
+		// reservation, publishing each block's worth with a single
+		// fetch_or, and returns an iterator to the first. If a
+		// constructor throws, the elements of the blocks already filled
+		// remain published and the rest of the range is never published.
+		iterator grow_by(size_type n)
+		requires
+			AllocatorConstructible<block_allocator_type, T>()
+		{
+			return grow_by_(n, [](T* p, block_allocator_type& a) { traits::construct(a, p); });
+		}
+		iterator grow_by(size_type n, const T& value)
+		requires
+			AllocatorCopyConstructible<block_allocator_type, T>()
+		{
+			return grow_by_(n, [&value](T* p, block_allocator_type& a) {
+				traits::construct(a, p, value);
+			});
+		}
+
+		// Destroys every published element and frees all storage. Not
+		// thread-safe.
+		void clear() noexcept
+		requires
+			AllocatorDestructible<block_allocator_type, T>()
+		{
+			for (auto k = 0; k < __concurrent_vector::max_segments; ++k) {
+				// Segments need not be installed in order: an append whose
+				// allocation failed may leave a gap below later ones.
+				auto const s = segments_[k].load(std::memory_order_relaxed);
+				if (!s) {
+					continue;
+				}
+				auto const blocks = __concurrent_vector::segment_size(k) >>
+					__concurrent_vector::block_log2;
+				for (auto i = size_type{0}; i < blocks; ++i) {
+					auto& b = s[i];
+					for (auto ready = b.ready_.load(std::memory_order_relaxed); ready != 0;
+						ready &= ready - 1) {
+						traits::destroy(alloc(), std::addressof(b.get(__builtin_ctzll(ready))));
+					}
+				}
+				free_segment_(k, s);
+				segments_[k].store(nullptr, std::memory_order_relaxed);
+			}
+			size_.store(0, std::memory_order_relaxed);
+		}
+
+		// Not thread-safe.
+		void swap(concurrent_vector& that) noexcept
+		requires
+			Swappable<block_allocator_type&>()
+		{
+			if (this == &that) {
+				return;
+			}
+			STL2_EXPECT(traits::propagate_on_container_swap::value || alloc() == that.alloc());
+			if (traits::propagate_on_container_swap::value) {
+				__stl2::swap(alloc(), that.alloc());
+			}
+			for (auto k = 0; k < __concurrent_vector::max_segments; ++k) {
+				auto const s = segments_[k].load(std::memory_order_relaxed);
+				segments_[k].store(that.segments_[k].load(std::memory_order_relaxed),
+					std::memory_order_relaxed);
+				that.segments_[k].store(s, std::memory_order_relaxed);
+			}
+			auto const n = size_.load(std::memory_order_relaxed);
+			size_.store(that.size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			that.size_.store(n, std::memory_order_relaxed);
+		}
+		friend void swap(concurrent_vector& x, concurrent_vector& y) noexcept
+		requires
+			Swappable<block_allocator_type&>()
+		{
+			x.swap(y);
+		}
+
+		static constexpr size_type max_size() noexcept {
+			return __concurrent_vector::segment_begin(__concurrent_vector::max_segments);
+		}
+
+	private:
+		// Read by every access; written only when a segment is installed.
+		std::atomic<block_t*> segments_[__concurrent_vector::max_segments] = {};
+
+		alignas(__concurrent_vector::cache_line) std::atomic<size_type> size_{0};
+		alignas(__concurrent_vector::cache_line) char pad_[1] = {};
+
+		block_allocator_type& alloc() noexcept { return base_t::get(); }
+		const block_allocator_type& alloc() const noexcept { return base_t::get(); }
+
+		T& slot_(size_type i) const noexcept {
+			auto const p = __concurrent_vector::locate(i);
+			auto const s = segments_[p.segment].load(std::memory_order_acquire);
+			STL2_EXPECT(s);
+			return s[p.offset >> __concurrent_vector::block_log2].get(
+				p.offset & (__concurrent_vector::block_size - 1));
+		}
+
+		// Installs segment k, unless another thread beats us to it, and
+		// returns whichever segment won.
+		block_t* allocate_segment_(int k) {
+			auto const blocks = __concurrent_vector::segment_size(k) >>
+				__concurrent_vector::block_log2;
+			auto const fancy = traits::allocate(alloc(), blocks);
+			auto const s = std::addressof(*fancy);
+			for (auto i = size_type{0}; i < blocks; ++i) {
+				traits::construct(alloc(), std::addressof(s[i].ready_), std::uint64_t{0});
+			}
+			block_t* expected = nullptr;
+			if (segments_[k].compare_exchange_strong(expected, s,
+				std::memory_order_acq_rel, std::memory_order_acquire)) {
+				return s;
+			}
+			free_segment_(k, s);
+			return expected;
+		}
+
+		void free_segment_(int k, block_t* s) noexcept {
+			auto const blocks = __concurrent_vector::segment_size(k) >>
+				__concurrent_vector::block_log2;
+			for (auto i = size_type{0}; i < blocks; ++i) {
+				traits::destroy(alloc(), std::addressof(s[i].ready_));
+			}
+			traits::deallocate(alloc(), std::pointer_traits<block_pointer>::pointer_to(*s), blocks);
+		}
+
+		// Installs the segments covering [first, last).
+		void ensure_(size_type first, size_type last) {
+			STL2_EXPECT(last <= max_size());
+			auto const lo = __concurrent_vector::locate(first).segment;
+			auto const hi = __concurrent_vector::locate(last - 1).segment;
+			for (auto k = lo; k <= hi; ++k) {
+				if (!segments_[k].load(std::memory_order_acquire)) {
+					allocate_segment_(k);
+				}
+			}
+		}
+
+		template <class Construct>
+		iterator grow_by_(size_type n, Construct construct) {
+			STL2_EXPECT(n >= 0);
+			auto const first = size_.fetch_add(n, std::memory_order_relaxed);
+			if (n == 0) {
+				return cursor<false>{*this, first};
+			}
+			ensure_(first, first + n);
+			for (auto i = first, last = first + n; i < last;) {
+				auto const p = __concurrent_vector::locate(i);
+				auto& b = segments_[p.segment].load(std::memory_order_relaxed)[
+					p.offset >> __concurrent_vector::block_log2];
+				auto const lo = p.offset & (__concurrent_vector::block_size - 1);
+				auto const hi = __stl2::min(__concurrent_vector::block_size, lo + (last - i));
+				auto bit = lo;
+				try {
+					for (; bit < hi; ++bit) {
+						construct(std::addressof(b.get(bit)), alloc());
+					}
+				} catch(...) {
+					while (bit > lo) {
+						traits::destroy(alloc(), std::addressof(b.get(--bit)));
+					}
+					throw;
+				}
+				auto const mask = hi - lo == __concurrent_vector::block_size
+					? ~std::uint64_t{0}
+					: ((std::uint64_t{1} << (hi - lo)) - 1) << lo;
+				b.ready_.fetch_or(mask, std::memory_order_release);
+				i += hi - lo;
+			}
+			return cursor<false>{*this, first};
+		}
+
+		void steal_(concurrent_vector& that) noexcept {
+			for (auto k = 0; k < __concurrent_vector::max_segments; ++k) {
+				segments_[k].store(that.segments_[k].load(std::memory_order_relaxed),
+					std::memory_order_relaxed);
+				that.segments_[k].store(nullptr, std::memory_order_relaxed);
+			}
+			size_.store(that.size_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			that.size_.store(0, std::memory_order_relaxed);
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
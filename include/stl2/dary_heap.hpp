@@ -0,0 +1,528 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_DARY_HEAP_HPP
+#define STL2_DARY_HEAP_HPP
+
+#include <stl2/functional.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/utility.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __dary {
+		template <std::ptrdiff_t D>
+		concept bool Arity = D >= 2;
+
+		struct no_place {
+			template <class T>
+			void operator()(T*, std::ptrdiff_t) const noexcept {}
+		};
+
+		// The heap algorithms on [first, first + n), where the children of
+		// i are D * i + 1 through D * i + D. place(first, i) is called
+		// whenever an element comes to rest at i, so that the indexed heap
+		// can track positions.
+		template <std::ptrdiff_t D, class T, class Comp, class Place>
+		void sift_up(T* first, std::ptrdiff_t i, Comp& comp, Place& place) {
+			if (i == 0 || !comp(first[(i - 1) / D], first[i])) {
+				return;
+			}
+			T x = std::move(first[i]);
+			do {
+				auto const p = (i - 1) / D;
+				first[i] = std::move(first[p]);
+				place(first, i);
+				i = p;
+			} while (i > 0 && comp(first[(i - 1) / D], x));
+			first[i] = std::move(x);
+			place(first, i);
+		}
+
+		// The greatest of the children starting at c, of which there are
+		// D unless the heap ends first.
+		template <std::ptrdiff_t D, class T, class Comp>
+		std::ptrdiff_t greatest_child(T* first, std::ptrdiff_t c, std::ptrdiff_t n, Comp& comp) {
+			auto best = c;
+			if (c + D <= n) {
+				// A whole family, with a trip count the compiler can see,
+				// and selects it can make branch-free
+				for (auto j = c + 1; j < c + D; ++j) {
+					best = comp(first[best], first[j]) ? j : best;
+				}
+			} else {
+				for (auto j = c + 1; j < n; ++j) {
+					if (comp(first[best], first[j])) {
+						best = j;
+					}
+				}
+			}
+			return best;
+		}
+
+		template <std::ptrdiff_t D, class T, class Comp, class Place>
+		void sift_down(T* first, std::ptrdiff_t i, std::ptrdiff_t n, Comp& comp, Place& place) {
+			auto c = D * i + 1;
+			if (c >= n) {
+				return;
+			}
+			auto best = greatest_child<D>(first, c, n, comp);
+			if (!comp(first[i], first[best])) {
+				return;
+			}
+			T x = std::move(first[i]);
+			do {
+				first[i] = std::move(first[best]);
+				place(first, i);
+				i = best;
+				c = D * i + 1;
+				if (c >= n) {
+					break;
+				}
+				best = greatest_child<D>(first, c, n, comp);
+			} while (comp(x, first[best]));
+			first[i] = std::move(x);
+			place(first, i);
+		}
+
+		// Floyd's method: sift down every parent, last first, in O(n).
+		template <std::ptrdiff_t D, class T, class Comp, class Place>
+		void make_heap(T* first, std::ptrdiff_t n, Comp& comp, Place& place) {
+			for (auto i = n > 1 ? (n - 2) / D + 1 : 0; i-- > 0;) {
+				sift_down<D>(first, i, n, comp, place);
+			}
+		}
+
+		// Makes [first, first + n) a heap, given that [first, first + k)
+		// is one: by sifting up each of the n - k new elements when they
+		// are few, and by rebuilding the whole heap when sifting them up
+		// would cost more.
+		template <std::ptrdiff_t D, class T, class Comp, class Place>
+		void extend_heap(T* first, std::ptrdiff_t k, std::ptrdiff_t n, Comp& comp, Place& place) {
+			auto depth = std::ptrdiff_t{0};
+			for (auto m = n; m > 0; m /= D) {
+				++depth;
+			}
+			if ((n - k) * depth > n) {
+				make_heap<D>(first, n, comp, place);
+			} else {
+				for (auto i = k; i < n; ++i) {
+					sift_up<D>(first, i, comp, place);
+				}
+			}
+		}
+	}
+
+	// Extension
+	// A priority queue on a D-ary heap in a vector. The heap is log2(D)
+	// times shallower than a binary heap, and the D children of an
+	// element are adjacent, so each level a sift visits costs about one
+	// cache miss: 4 children of 8 to 16 bytes, or 8 of 4 to 8 bytes, fill
+	// a cache line. top() is the greatest element per Compare, as with
+	// std::priority_queue; greater<> makes it the least.
+	template <class T, std::ptrdiff_t D = 4, class Compare = less<>,
+		ProtoAllocator<T> PA = std::allocator<T>>
+	requires
+		__dary::Arity<D> &&
+		StrictWeakOrder<Compare, T>()
+	class dary_heap : detail::ebo_box<Compare> {
+		using base_t = detail::ebo_box<Compare>;
+	public:
+		using container_type = vector<T, PA>;
+		using value_type = T;
+		using value_compare = Compare;
+		using allocator_type = typename container_type::allocator_type;
+		using size_type = typename container_type::size_type;
+
+		static constexpr std::ptrdiff_t arity = D;
+
+		dary_heap() = default;
+
+		explicit dary_heap(Compare comp)
+		: base_t{std::move(comp)}
+		{}
+
+		explicit dary_heap(allocator_type a)
+		: heap_{std::move(a)}
+		{}
+
+		dary_heap(Compare comp, allocator_type a)
+		: base_t{std::move(comp)}, heap_{std::move(a)}
+		{}
+
+		// Heapifies [first, last) in O(N).
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			ConvertibleTo<reference_t<I>, T>()
+		dary_heap(I first, S last, Compare comp = Compare{})
+		: base_t{std::move(comp)}
+		{
+			push_range(std::move(first), std::move(last));
+		}
+
+		const T& top() const noexcept {
+			STL2_EXPECT(!empty());
+			return heap_.front();
+		}
+
+		bool empty() const noexcept { return heap_.empty(); }
+		size_type size() const noexcept { return heap_.size(); }
+		size_type capacity() const noexcept { return heap_.capacity(); }
+
+		// Extension
+		memory_stats memory_usage() const noexcept {
+			return heap_.memory_usage();
+		}
+
+		value_compare value_comp() const {
+			return comp();
+		}
+		allocator_type get_allocator() const noexcept {
+			return heap_.get_allocator();
+		}
+
+		// The elements, in heap order
+		const container_type& container() const noexcept {
+			return heap_;
+		}
+
+		void reserve(size_type n) {
+			heap_.reserve(n);
+		}
+
+		void clear() noexcept {
+			heap_.clear();
+		}
+
+		void push(const T& t) {
+			emplace(t);
+		}
+		void push(T&& t) {
+			emplace(std::move(t));
+		}
+
+		template <class...Args>
+		requires
+			Constructible<T, Args...>()
+		void emplace(Args&&...args) {
+			heap_.emplace_back(std::forward<Args>(args)...);
+			auto place = __dary::no_place{};
+			__dary::sift_up<D>(data_(), heap_.size() - 1, comp(), place);
+		}
+
+		// Pushes every element of [first, last), in O(N + M) when there are
+		// M elements already and N is not much less than M. If appending
+		// an element throws, those appended before it are removed again.
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			ConvertibleTo<reference_t<I>, T>()
+		void push_range(I first, S last) {
+			auto const k = heap_.size();
+			try {
+				for (; first != last; ++first) {
+					heap_.emplace_back(*first);
+				}
+			} catch(...) {
+				while (heap_.size() > k) {
+					heap_.pop_back();
+				}
+				throw;
+			}
+			auto place = __dary::no_place{};
+			__dary::extend_heap<D>(data_(), k, heap_.size(), comp(), place);
+		}
+
+		template <InputRange Rng>
+		requires
+			ConvertibleTo<reference_t<iterator_t<Rng>>, T>()
+		void push_range(Rng&& rng) {
+			push_range(__stl2::begin(rng), __stl2::end(rng));
+		}
+
+		void pop() {
+			STL2_EXPECT(!empty());
+			auto const first = data_();
+			auto const n = heap_.size() - 1;
+			if (n > 0) {
+				first[0] = std::move(first[n]);
+			}
+			heap_.pop_back();
+			auto place = __dary::no_place{};
+			__dary::sift_down<D>(first, 0, n, comp(), place);
+		}
+
+		// Replaces the top with t: pop() then push(t), with one sift
+		// instead of two.
+		void pop_push(T t) {
+			STL2_EXPECT(!empty());
+			auto const first = data_();
+			first[0] = std::move(t);
+			auto place = __dary::no_place{};
+			__dary::sift_down<D>(first, 0, heap_.size(), comp(), place);
+		}
+
+		void swap(dary_heap& that) noexcept(is_nothrow_swappable<Compare&, Compare&>::value &&
+			noexcept(std::declval<container_type&>().swap(std::declval<container_type&>())))
+		{
+			ranges::swap(comp(), that.comp());
+			heap_.swap(that.heap_);
+		}
+
+	private:
+		container_type heap_;
+
+		Compare& comp() noexcept { return base_t::get(); }
+		const Compare& comp() const noexcept { return base_t::get(); }
+
+		T* data_() noexcept {
+			return heap_.empty() ? nullptr : std::addressof(*heap_.begin());
+		}
+	};
+
+	// Extension
+	template <class T, class Compare = less<>, ProtoAllocator<T> PA = std::allocator<T>>
+	using priority_queue = dary_heap<T, 4, Compare, PA>;
+
+	// Extension
+	// A dary_heap whose elements can be reprioritized or removed wherever
+	// they are. push returns a handle that identifies the element until
+	// it is popped or erased, after which the handle may be reused.
+	template <class T, std::ptrdiff_t D = 4, class Compare = less<>,
+		ProtoAllocator<T> PA = std::allocator<T>>
+	requires
+		__dary::Arity<D> &&
+		StrictWeakOrder<Compare, T>()
+	class indexed_dary_heap : detail::ebo_box<Compare> {
+		using base_t = detail::ebo_box<Compare>;
+		using index_type = difference_type_t<typename vector<T, PA>::pointer>;
+
+		struct entry {
+			T value;
+			index_type handle;
+		};
+
+		// Orders entries by value
+		struct entry_compare {
+			Compare& comp;
+			bool operator()(const entry& a, const entry& b) {
+				return comp(a.value, b.value);
+			}
+		};
+
+		// Records where each entry lands.
+		struct tracker {
+			index_type* pos;
+			void operator()(entry* first, index_type i) const noexcept {
+				pos[first[i].handle] = i;
+			}
+		};
+
+	public:
+		using value_type = T;
+		using value_compare = Compare;
+		using allocator_type = rebind_allocator_t<PA, T>;
+		using size_type = index_type;
+		using handle_type = index_type;
+
+		static constexpr std::ptrdiff_t arity = D;
+
+		indexed_dary_heap() = default;
+
+		explicit indexed_dary_heap(Compare comp)
+		: base_t{std::move(comp)}
+		{}
+
+		explicit indexed_dary_heap(allocator_type a)
+		: heap_{a}, pos_{a}, free_{a}
+		{}
+
+		indexed_dary_heap(Compare comp, allocator_type a)
+		: base_t{std::move(comp)}, heap_{a}, pos_{a}, free_{a}
+		{}
+
+		const T& top() const noexcept {
+			STL2_EXPECT(!empty());
+			return heap_.front().value;
+		}
+		handle_type top_handle() const noexcept {
+			STL2_EXPECT(!empty());
+			return heap_.front().handle;
+		}
+
+		bool empty() const noexcept { return heap_.empty(); }
+		size_type size() const noexcept { return heap_.size(); }
+
+		// Extension: each entry's handle, the position table and the free
+		// handles count as overhead.
+		memory_stats memory_usage() const noexcept {
+			auto s = heap_.memory_usage();
+			auto const payload = __memory_stats::bytes<T>(size());
+			s.overhead += s.payload - payload;
+			s.payload = payload;
+			return s + __memory_stats::as_overhead(pos_.memory_usage()) +
+				__memory_stats::as_overhead(free_.memory_usage());
+		}
+
+		value_compare value_comp() const {
+			return comp();
+		}
+		allocator_type get_allocator() const noexcept {
+			return heap_.get_allocator();
+		}
+
+		// True if h identifies an element in the heap
+		bool contains(handle_type h) const noexcept {
+			return 0 <= h && h < pos_.size() && pos_.begin()[h] >= 0;
+		}
+
+		// Requires contains(h)
+		const T& operator[](handle_type h) const noexcept {
+			STL2_EXPECT(contains(h));
+			return heap_.begin()[pos_.begin()[h]].value;
+		}
+
+		void reserve(size_type n) {
+			heap_.reserve(n);
+			pos_.reserve(n);
+		}
+
+		void clear() noexcept {
+			while (!heap_.empty()) {
+				release_(heap_.back().handle);
+				heap_.pop_back();
+			}
+		}
+
+		handle_type push(const T& t) {
+			return emplace(t);
+		}
+		handle_type push(T&& t) {
+			return emplace(std::move(t));
+		}
+
+		template <class...Args>
+		requires
+			Constructible<T, Args...>()
+		handle_type emplace(Args&&...args) {
+			auto const h = acquire_();
+			try {
+				heap_.emplace_back(entry{T(std::forward<Args>(args)...), h});
+			} catch(...) {
+				release_(h);
+				throw;
+			}
+			auto const i = heap_.size() - 1;
+			pos_.begin()[h] = i;
+			auto c = entry_compare{comp()};
+			auto t = tracker_();
+			__dary::sift_up<D>(data_(), i, c, t);
+			return h;
+		}
+
+		void pop() {
+			STL2_EXPECT(!empty());
+			erase(top_handle());
+		}
+
+		// Removes the element h identifies.
+		void erase(handle_type h) {
+			STL2_EXPECT(contains(h));
+			auto const first = data_();
+			auto const i = pos_.begin()[h];
+			auto const n = heap_.size() - 1;
+			release_(h);
+			if (i != n) {
+				first[i] = std::move(first[n]);
+				heap_.pop_back();
+				auto c = entry_compare{comp()};
+				auto t = tracker_();
+				t(first, i);
+				// The replacement goes up or down, not both.
+				auto const moved = first[i].handle;
+				__dary::sift_up<D>(first, i, c, t);
+				if (pos_.begin()[moved] == i) {
+					__dary::sift_down<D>(first, i, n, c, t);
+				}
+			} else {
+				heap_.pop_back();
+			}
+		}
+
+		// Gives the element h identifies the value t, and moves it up or
+		// down to its place: decrease-key and increase-key both.
+		void update(handle_type h, T t) {
+			STL2_EXPECT(contains(h));
+			auto const first = data_();
+			auto const i = pos_.begin()[h];
+			auto c = entry_compare{comp()};
+			auto tr = tracker_();
+			auto const up = comp()(first[i].value, t);
+			first[i].value = std::move(t);
+			if (up) {
+				__dary::sift_up<D>(first, i, c, tr);
+			} else {
+				__dary::sift_down<D>(first, i, heap_.size(), c, tr);
+			}
+		}
+
+	private:
+		vector<entry, PA> heap_;
+		// The index in heap_ of each handle's element, or -1
+		vector<index_type, PA> pos_;
+		// Handles not in use
+		vector<index_type, PA> free_;
+
+		Compare& comp() noexcept { return base_t::get(); }
+		const Compare& comp() const noexcept { return base_t::get(); }
+
+		entry* data_() noexcept {
+			return heap_.empty() ? nullptr : std::addressof(*heap_.begin());
+		}
+
+		tracker tracker_() noexcept {
+			return tracker{std::addressof(*pos_.begin())};
+		}
+
+		handle_type acquire_() {
+			if (!free_.empty()) {
+				auto const h = free_.back();
+				free_.pop_back();
+				return h;
+			}
+			pos_.push_back(-1);
+			// Room in free_ for every handle, so that releasing one
+			// never allocates
+			if (free_.capacity() < pos_.size()) {
+				try {
+					free_.reserve(pos_.capacity());
+				} catch(...) {
+					pos_.pop_back();
+					throw;
+				}
+			}
+			return pos_.size() - 1;
+		}
+
+		void release_(handle_type h) noexcept {
+			pos_.begin()[h] = -1;
+			free_.emplace_back_unchecked(h);
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
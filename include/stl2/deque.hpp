@@ -0,0 +1,534 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_DEQUE_HPP
+#define STL2_DEQUE_HPP
+
+#include <stl2/algorithm.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __deque {
+		// Number of elements per block: enough to fill a 4KiB page, but
+		// never fewer than 16. Always a power of two so that locating an
+		// element reduces to a shift and a mask.
+		template <class T>
+		constexpr std::ptrdiff_t block_size() noexcept {
+			constexpr std::ptrdiff_t page = 4096;
+			constexpr std::ptrdiff_t min_elements = 16;
+			std::ptrdiff_t n = sizeof(T) <= page / min_elements
+				? page / static_cast<std::ptrdiff_t>(sizeof(T)) : min_elements;
+			std::ptrdiff_t result = 1;
+			while (result * 2 <= n) {
+				result *= 2;
+			}
+			return result;
+		}
+
+		template <class T, class MapPointer>
+		class cursor {
+			template <class, class> friend class cursor;
+
+			MapPointer map_;
+			std::ptrdiff_t pos_;
+
+		public:
+			using value_type = remove_cv_t<T>;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			constexpr cursor(MapPointer map, difference_type pos) noexcept
+			: map_{std::move(map)}, pos_{pos} {}
+			template <class U>
+			requires
+				std::is_const<T>::value &&
+				Same<U, remove_const_t<T>>()
+			constexpr cursor(const cursor<U, MapPointer>& that) noexcept
+			: map_{that.map_}, pos_{that.pos_} {}
+
+			T& read() const noexcept {
+				STL2_EXPECT(pos_ >= 0);
+				constexpr auto B = static_cast<std::size_t>(block_size<value_type>());
+				auto i = static_cast<std::size_t>(pos_);
+				return map_[i / B][i % B];
+			}
+			void next() noexcept { ++pos_; }
+			void prev() noexcept { --pos_; }
+			void advance(difference_type n) noexcept { pos_ += n; }
+			difference_type distance_to(const cursor& that) const noexcept {
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+		};
+	}
+
+	// A double-ended queue of fixed-size blocks addressed through a map
+	// of block pointers. Elements never move once constructed, so
+	// references survive push_front/push_back. Blocks emptied by pops are
+	// retained and recycled for later pushes at either end, so a deque
+	// used as a FIFO reaches a steady state with no allocations at all.
+	template <class T, ProtoAllocator<T> PA = std::allocator<T>>
+	requires
+		ProtoAllocator<PA, allocator_pointer_t<rebind_allocator_t<PA, T>>>()
+	class deque : detail::ebo_box<rebind_allocator_t<PA, T>> {
+		using base_t = detail::ebo_box<rebind_allocator_t<PA, T>>;
+		using traits = std::allocator_traits<rebind_allocator_t<PA, T>>;
+		using block_pointer = typename traits::pointer;
+		using map_allocator_type = rebind_allocator_t<PA, block_pointer>;
+		using map_traits = std::allocator_traits<map_allocator_type>;
+		using map_pointer = typename map_traits::pointer;
+		using cursor = __deque::cursor<T, map_pointer>;
+		using const_cursor = __deque::cursor<const T, map_pointer>;
+	public:
+		using value_type = T;
+		using allocator_type = rebind_allocator_t<PA, T>;
+		using pointer = typename traits::pointer;
+		using const_pointer = typename traits::const_pointer;
+		using size_type = difference_type_t<pointer>;
+		using iterator = __stl2::basic_iterator<cursor>;
+		using const_iterator = __stl2::basic_iterator<const_cursor>;
+
+		static constexpr size_type block_size() noexcept {
+			return __deque::block_size<T>();
+		}
+
+		~deque()
+			requires Allocator<allocator_type, T>() &&
+				AllocatorDestructible<allocator_type, T>()
+		{
+			clear_();
+			release_storage();
+		}
+
+		deque()
+			noexcept(is_nothrow_default_constructible<allocator_type>::value)
+			requires DefaultConstructible<allocator_type>() = default;
+
+		deque(allocator_type a) noexcept
+		: base_t{std::move(a)}
+		{}
+
+		deque(deque&& that) noexcept
+		: base_t{std::move(that.alloc())},
+			map_{__stl2::exchange(that.map_, nullptr)},
+			map_size_{__stl2::exchange(that.map_size_, 0)},
+			blk_begin_{__stl2::exchange(that.blk_begin_, 0)},
+			blk_end_{__stl2::exchange(that.blk_end_, 0)},
+			start_{__stl2::exchange(that.start_, 0)},
+			size_{__stl2::exchange(that.size_, 0)}
+		{}
+
+		deque(const deque& that)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		: deque{traits::select_on_container_copy_construction(that.alloc())}
+		{
+			that.for_each_segment([this](const T* first, const T* last) {
+				for (; first != last; ++first) {
+					emplace_back(*first);
+				}
+			});
+		}
+
+		// FIXME: NYI
+		deque& operator=(deque&&) & = delete;
+		deque& operator=(const deque&) & = delete;
+
+		// FIXME: same problems as vector::swap.
+		void swap(deque& that)
+			noexcept(is_nothrow_swappable<allocator_type&, allocator_type&>::value)
+		{
+			ranges::swap(alloc(), that.alloc());
+			ranges::swap(map_, that.map_);
+			ranges::swap(map_size_, that.map_size_);
+			ranges::swap(blk_begin_, that.blk_begin_);
+			ranges::swap(blk_end_, that.blk_end_);
+			ranges::swap(start_, that.start_);
+			ranges::swap(size_, that.size_);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return alloc();
+		}
+
+		iterator begin() noexcept { return cursor{map_, start_}; }
+		iterator end() noexcept { return cursor{map_, start_ + size_}; }
+
+		const_iterator begin() const noexcept { return const_cursor{map_, start_}; }
+		const_iterator end() const noexcept { return const_cursor{map_, start_ + size_}; }
+
+		auto cbegin() const noexcept { return begin(); }
+		auto cend() const noexcept { return end(); }
+
+		auto rbegin() noexcept { return reverse_iterator<iterator>{end()}; }
+		auto rend() noexcept { return reverse_iterator<iterator>{begin()}; }
+
+		auto rbegin() const noexcept { return reverse_iterator<const_iterator>{end()}; }
+		auto rend() const noexcept { return reverse_iterator<const_iterator>{begin()}; }
+
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+
+		T& operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return element(start_ + i);
+		}
+		const T& operator[](size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return element(start_ + i);
+		}
+
+		T& front() noexcept { STL2_EXPECT(!empty()); return element(start_); }
+		const T& front() const noexcept { STL2_EXPECT(!empty()); return element(start_); }
+		T& back() noexcept { STL2_EXPECT(!empty()); return element(start_ + size_ - 1); }
+		const T& back() const noexcept { STL2_EXPECT(!empty()); return element(start_ + size_ - 1); }
+
+		size_type size() const noexcept {
+			return size_;
+		}
+		bool empty() const noexcept {
+			return size_ == 0;
+		}
+
+		// Extension: the number of elements the allocated blocks can hold.
+		size_type capacity() const noexcept {
+			return (blk_end_ - blk_begin_) * block_size();
+		}
+
+		// Extension: blocks, spare or not, count their unused slots as
+		// slack; the block map is overhead.
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(size());
+			s.slack = __memory_stats::bytes<T>(capacity() - size());
+			for (auto i = blk_begin_; i != blk_end_; ++i) {
+				__memory_stats::allocation(s, alloc(), block_size());
+			}
+			if (map_) {
+				s.overhead = __memory_stats::bytes<block_pointer>(map_size_);
+				__memory_stats::allocation(s, map_allocator_type{alloc()}, map_size_);
+			}
+			return s;
+		}
+
+		// Extension: invokes f(first, last) once for each maximal run of
+		// contiguous elements, front to back, so that algorithms can run a
+		// tight loop over each block instead of paying for the two-level
+		// indexing of deque::iterator on every element.
+		template <class F>
+		F for_each_segment(F f) {
+			segments_(f, *this);
+			return f;
+		}
+		template <class F>
+		F for_each_segment(F f) const {
+			segments_(f, *this);
+			return f;
+		}
+
+		void clear() noexcept
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			clear_();
+			// Recentre so that both ends have spare blocks to recycle.
+			start_ = (blk_begin_ + (blk_end_ - blk_begin_) / 2) * block_size();
+		}
+
+		// Releases the blocks that hold no elements.
+		void shrink_to_fit() noexcept
+		requires
+			Allocator<allocator_type, T>()
+		{
+			if (empty()) {
+				release_storage();
+				start_ = 0;
+				return;
+			}
+			auto first = start_ / block_size();
+			auto last = (start_ + size_ - 1) / block_size() + 1;
+			auto a = alloc();
+			for (; blk_begin_ < first; ++blk_begin_) {
+				traits::deallocate(a, __stl2::exchange(map_[blk_begin_], nullptr), block_size());
+			}
+			for (; blk_end_ > last; --blk_end_) {
+				traits::deallocate(a, __stl2::exchange(map_[blk_end_ - 1], nullptr), block_size());
+			}
+		}
+
+		template <class...Args>
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorConstructible<allocator_type, T, Args...>()
+		T& emplace_back(Args&&...args) {
+			auto pos = start_ + size_;
+			if (pos % block_size() == 0) {
+				prepare_back_block();
+				pos = start_ + size_;
+			}
+			auto& e = element(pos);
+			traits::construct(alloc(), std::addressof(e), __stl2::forward<Args>(args)...);
+			++size_;
+			return e;
+		}
+
+		template <class...Args>
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorConstructible<allocator_type, T, Args...>()
+		T& emplace_front(Args&&...args) {
+			if (start_ % block_size() == 0) {
+				prepare_front_block();
+			}
+			auto& e = element(start_ - 1);
+			traits::construct(alloc(), std::addressof(e), __stl2::forward<Args>(args)...);
+			--start_;
+			++size_;
+			return e;
+		}
+
+		void push_back(const T& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorCopyConstructible<allocator_type, T>()
+		{
+			emplace_back(t);
+		}
+		void push_back(T&& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorMoveConstructible<allocator_type, T>()
+		{
+			emplace_back(std::move(t));
+		}
+
+		void push_front(const T& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorCopyConstructible<allocator_type, T>()
+		{
+			emplace_front(t);
+		}
+		void push_front(T&& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>() &&
+			AllocatorMoveConstructible<allocator_type, T>()
+		{
+			emplace_front(std::move(t));
+		}
+
+		void pop_back() noexcept
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			STL2_EXPECT(!empty());
+			--size_;
+			traits::destroy(alloc(), std::addressof(element(start_ + size_)));
+		}
+
+		void pop_front() noexcept
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			STL2_EXPECT(!empty());
+			traits::destroy(alloc(), std::addressof(element(start_)));
+			++start_;
+			--size_;
+		}
+
+	private:
+		// Map slots [blk_begin_, blk_end_) hold allocated blocks; all
+		// other slots are null. Element i of the deque lives at global
+		// position start_ + i, i.e., in block (start_ + i) / block_size().
+		// Blocks in the allocated run that hold no elements are spares.
+		map_pointer map_ = nullptr;
+		size_type map_size_ = 0;
+		size_type blk_begin_ = 0;
+		size_type blk_end_ = 0;
+		size_type start_ = 0;
+		size_type size_ = 0;
+
+		allocator_type& alloc() { return base_t::get(); }
+		const allocator_type& alloc() const { return base_t::get(); }
+
+		T& element(size_type pos) const noexcept {
+			STL2_EXPECT(pos >= 0);
+			constexpr auto B = static_cast<std::size_t>(block_size());
+			auto i = static_cast<std::size_t>(pos);
+			return map_[i / B][i % B];
+		}
+
+		template <class F, class Self>
+		static void segments_(F& f, Self& self) {
+			auto pos = self.start_;
+			auto const last = self.start_ + self.size_;
+			while (pos != last) {
+				auto n = __stl2::min(block_size() - pos % block_size(), last - pos);
+				auto first = std::addressof(self.element(pos));
+				f(first, first + n);
+				pos += n;
+			}
+		}
+
+		void clear_() noexcept
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			for (auto pos = start_, last = start_ + size_; pos != last; ++pos) {
+				traits::destroy(alloc(), std::addressof(element(pos)));
+			}
+			size_ = 0;
+		}
+
+		void release_storage() noexcept
+		requires
+			Allocator<allocator_type, T>()
+		{
+			if (map_) {
+				auto a = alloc();
+				for (auto i = blk_begin_; i != blk_end_; ++i) {
+					traits::deallocate(a, map_[i], block_size());
+				}
+				auto ma = map_allocator_type{alloc()};
+				map_traits::deallocate(ma, map_, map_size_);
+				map_ = nullptr;
+			}
+			map_size_ = blk_begin_ = blk_end_ = 0;
+		}
+
+		// Index of the first block holding no elements past the back.
+		size_type used_end() const noexcept {
+			return (start_ + size_ + block_size() - 1) / block_size();
+		}
+
+		// Requires: (start_ + size_) is the first position of a block.
+		// Ensures: that block is allocated.
+		void prepare_back_block()
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>()
+		{
+			auto k = (start_ + size_) / block_size();
+			if (k < blk_end_) {
+				return;
+			}
+			if (blk_begin_ < start_ / block_size()) {
+				// Recycle the spare block at the front.
+				if (k == map_size_) {
+					make_room(false);
+					k = (start_ + size_) / block_size();
+				}
+				map_[k] = __stl2::exchange(map_[blk_begin_], nullptr);
+				++blk_begin_;
+				++blk_end_;
+				return;
+			}
+			if (k == map_size_) {
+				make_room(false);
+				k = (start_ + size_) / block_size();
+			}
+			auto a = alloc();
+			map_[k] = traits::allocate(a, block_size());
+			++blk_end_;
+		}
+
+		// Requires: start_ is the first position of a block.
+		// Ensures: the block before start_ is allocated.
+		void prepare_front_block()
+		requires
+			Allocator<allocator_type, T>() &&
+			Allocator<map_allocator_type, block_pointer>()
+		{
+			if (start_ == 0) {
+				make_room(true);
+			}
+			auto k = start_ / block_size() - 1;
+			if (k >= blk_begin_) {
+				return;
+			}
+			STL2_EXPECT(k == blk_begin_ - 1);
+			if (blk_end_ > used_end()) {
+				// Recycle the spare block at the back.
+				map_[k] = __stl2::exchange(map_[blk_end_ - 1], nullptr);
+				--blk_end_;
+			} else {
+				auto a = alloc();
+				map_[k] = traits::allocate(a, block_size());
+			}
+			--blk_begin_;
+		}
+
+		// Ensures: a free map slot exists at the front (if at_front) or
+		// the back of the allocated run; shifts the run to the middle of
+		// the map, reallocating the map when it is more than half full.
+		void make_room(bool at_front)
+		requires
+			Allocator<map_allocator_type, block_pointer>()
+		{
+			auto const n = blk_end_ - blk_begin_;
+			auto ma = map_allocator_type{alloc()};
+			if (2 * (n + 1) <= map_size_) {
+				auto const new_begin = (map_size_ - n) / 2 + (at_front ? 1 : 0);
+				auto const delta = new_begin - blk_begin_;
+				if (delta < 0) {
+					for (auto i = blk_begin_; i != blk_end_; ++i) {
+						map_[i + delta] = __stl2::exchange(map_[i], nullptr);
+					}
+				} else {
+					for (auto i = blk_end_; i-- != blk_begin_;) {
+						map_[i + delta] = __stl2::exchange(map_[i], nullptr);
+					}
+				}
+				shift(delta);
+				return;
+			}
+			auto const new_size = __stl2::max(size_type{8}, 2 * map_size_);
+			map_pointer new_map = map_traits::allocate(ma, new_size);
+			for (auto i = size_type{0}; i != new_size; ++i) {
+				map_traits::construct(ma, std::addressof(new_map[i]), nullptr);
+			}
+			auto const new_begin = (new_size - n) / 2 + (at_front ? 1 : 0);
+			for (auto i = blk_begin_; i != blk_end_; ++i) {
+				new_map[new_begin + (i - blk_begin_)] = map_[i];
+			}
+			if (map_) {
+				map_traits::deallocate(ma, map_, map_size_);
+			}
+			map_ = new_map;
+			map_size_ = new_size;
+			shift(new_begin - blk_begin_);
+		}
+
+		void shift(size_type delta) noexcept {
+			blk_begin_ += delta;
+			blk_end_ += delta;
+			start_ += delta * block_size();
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
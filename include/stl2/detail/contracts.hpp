@@ -0,0 +1,51 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_DETAIL_CONTRACTS_HPP
+#define STL2_DETAIL_CONTRACTS_HPP
+
+#include <stl2/detail/fwd.hpp>
+
+// How the containers treat the preconditions they state with STL2_EXPECT:
+//
+// * By default, as cmcstl2 does: assert, and so nothing under NDEBUG.
+// * STL2_CONTRACTS_CHECKED: a violated precondition traps, with or without
+//   NDEBUG.
+// * STL2_CONTRACTS_ASSUME: the optimizer may take every precondition as
+//   true, and a violated one is undefined behavior. Preconditions must be
+//   cheap and free of side effects, since the condition may be evaluated.
+//
+// GCC before 13 has no assumption that leaves control flow alone, and the
+// __builtin_unreachable spelling leaves a branch that survives loop
+// optimization and, like the trap of the checked mode, blocks
+// vectorization: test/contracts_benchmark.cpp measured such loops an
+// order of magnitude slower than the default. There ASSUME leaves
+// STL2_EXPECT as the default.
+#if defined(STL2_CONTRACTS_CHECKED) && defined(STL2_CONTRACTS_ASSUME)
+#error "STL2_CONTRACTS_CHECKED and STL2_CONTRACTS_ASSUME are exclusive"
+#endif
+
+#if defined(STL2_CONTRACTS_CHECKED)
+ #undef STL2_EXPECT
+ #define STL2_EXPECT(...) \
+	(__builtin_expect(static_cast<bool>(__VA_ARGS__), 1) ? void(0) : __builtin_trap())
+#elif defined(STL2_CONTRACTS_ASSUME)
+ #if defined(__clang__)
+  #undef STL2_EXPECT
+  #define STL2_EXPECT(...) __builtin_assume(static_cast<bool>(__VA_ARGS__))
+ #elif __GNUC__ >= 13
+  #undef STL2_EXPECT
+  #define STL2_EXPECT(...) \
+	[&]() noexcept { __attribute__((__assume__(static_cast<bool>(__VA_ARGS__)))); }()
+ #endif
+#endif
+
+#endif
@@ -0,0 +1,333 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_EXECUTION_HPP
+#define STL2_EXECUTION_HPP
+
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+STL2_OPEN_NAMESPACE {
+	namespace execution {
+		struct sequenced_policy {};
+		struct parallel_policy {};
+		struct parallel_unsequenced_policy {};
+
+		constexpr sequenced_policy seq{};
+		constexpr parallel_policy par{};
+		constexpr parallel_unsequenced_policy par_unseq{};
+	}
+
+	template <class T>
+	struct is_execution_policy : false_type {};
+	template <>
+	struct is_execution_policy<execution::sequenced_policy> : true_type {};
+	template <>
+	struct is_execution_policy<execution::parallel_policy> : true_type {};
+	template <>
+	struct is_execution_policy<execution::parallel_unsequenced_policy> : true_type {};
+
+	template <class P>
+	concept bool ExecutionPolicy() {
+		return is_execution_policy<decay_t<P>>::value;
+	}
+
+	namespace __execution {
+		template <class P>
+		constexpr bool is_parallel =
+			!Same<decay_t<P>, execution::sequenced_policy>();
+
+		// A fixed set of workers that run one fork-join job at a time.
+		// Job i always runs on worker i (the caller is worker 0), so
+		// repeated jobs over the same partition touch the same memory
+		// from the same threads.
+		class thread_pool {
+		public:
+			static thread_pool& instance() {
+				static thread_pool pool{std::thread::hardware_concurrency()};
+				return pool;
+			}
+
+			explicit thread_pool(unsigned n)
+			: size_{n > 0 ? n : 1u}, workers_{new std::thread[size_ - 1]}
+			{
+				for (auto i = 1u; i < size_; ++i) {
+					workers_[i - 1] = std::thread{[this, i] { work(i); }};
+				}
+			}
+
+			~thread_pool() {
+				{
+					std::lock_guard<std::mutex> lock{mtx_};
+					stop_ = true;
+				}
+				start_.notify_all();
+				for (auto i = 1u; i < size_; ++i) {
+					workers_[i - 1].join();
+				}
+			}
+
+			thread_pool(thread_pool&&) = delete;
+			thread_pool& operator=(thread_pool&&) & = delete;
+
+			unsigned size() const noexcept { return size_; }
+
+			// Calls f(i) for each i in [0, n) and waits for all to return.
+			// f must not throw. Calls made from inside a job run inline.
+			template <class F>
+			void run(unsigned n, F& f) {
+				STL2_EXPECT(n <= size_);
+				if (n <= 1 || nested()) {
+					for (auto i = 0u; i < n; ++i) {
+						f(i);
+					}
+					return;
+				}
+				std::lock_guard<std::mutex> serial{run_mtx_};
+				{
+					std::lock_guard<std::mutex> lock{mtx_};
+					job_ = [](void* ctx, unsigned i) { (*static_cast<F*>(ctx))(i); };
+					ctx_ = std::addressof(f);
+					count_ = n;
+					pending_ = n - 1;
+					++generation_;
+				}
+				start_.notify_all();
+				nested() = true;
+				f(0);
+				nested() = false;
+				std::unique_lock<std::mutex> lock{mtx_};
+				done_.wait(lock, [this] { return pending_ == 0; });
+			}
+
+		private:
+			unsigned size_;
+			std::unique_ptr<std::thread[]> workers_;
+			std::mutex run_mtx_;
+			std::mutex mtx_;
+			std::condition_variable start_;
+			std::condition_variable done_;
+			void (*job_)(void*, unsigned) = nullptr;
+			void* ctx_ = nullptr;
+			unsigned count_ = 0;
+			unsigned pending_ = 0;
+			unsigned long generation_ = 0;
+			bool stop_ = false;
+
+			static bool& nested() noexcept {
+				static thread_local bool flag = false;
+				return flag;
+			}
+
+			void work(unsigned i) {
+				nested() = true;
+				auto seen = 0ul;
+				for (;;) {
+					std::unique_lock<std::mutex> lock{mtx_};
+					start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+					if (stop_) {
+						return;
+					}
+					seen = generation_;
+					if (i >= count_) {
+						continue;
+					}
+					auto const job = job_;
+					auto const ctx = ctx_;
+					lock.unlock();
+					job(ctx, i);
+					lock.lock();
+					if (--pending_ == 0) {
+						done_.notify_one();
+					}
+				}
+			}
+		};
+
+		// Splits [0, n) into at most one chunk per pool thread, with
+		// boundaries on multiples of grain, and calls f(first, last) for
+		// each. Chunk k always goes to worker k, so memory first touched
+		// through this partition lands on the NUMA node of the thread
+		// that will touch it again next time.
+		//
+		// f must leave its chunk untouched if it throws. If any chunk
+		// throws, undo(first, last) is called for every chunk that
+		// completed and the first exception is rethrown.
+		template <class EP, class F, class Undo>
+		requires ExecutionPolicy<EP>()
+		void for_each_chunk(EP&&, std::ptrdiff_t n, std::ptrdiff_t grain, F f, Undo undo) {
+			STL2_EXPECT(n >= 0 && grain > 0);
+			if (!is_parallel<EP> || n / grain <= 1) {
+				f(std::ptrdiff_t{0}, n);
+				return;
+			}
+			auto& pool = thread_pool::instance();
+			auto const threads = static_cast<std::ptrdiff_t>(pool.size());
+			auto const chunks = n / grain < threads ? n / grain : threads;
+			if (chunks <= 1) {
+				f(std::ptrdiff_t{0}, n);
+				return;
+			}
+			auto bound = [=](std::ptrdiff_t k) {
+				return k == chunks ? n : n / chunks * k / grain * grain;
+			};
+			std::unique_ptr<bool[]> done{new bool[chunks]()};
+			std::exception_ptr error;
+			std::mutex error_mtx;
+			auto body = [&](unsigned k) {
+				try {
+					f(bound(k), bound(k + 1));
+					done[k] = true;
+				} catch(...) {
+					std::lock_guard<std::mutex> lock{error_mtx};
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+			};
+			pool.run(static_cast<unsigned>(chunks), body);
+			if (error) {
+				for (auto k = std::ptrdiff_t{0}; k < chunks; ++k) {
+					if (done[k]) {
+						undo(bound(k), bound(k + 1));
+					}
+				}
+				std::rethrow_exception(error);
+			}
+		}
+
+		template <class EP, class F>
+		requires ExecutionPolicy<EP>()
+		void for_each_chunk(EP&& policy, std::ptrdiff_t n, std::ptrdiff_t grain, F f) {
+			__execution::for_each_chunk(__stl2::forward<EP>(policy), n, grain,
+				std::move(f), [](std::ptrdiff_t, std::ptrdiff_t) {});
+		}
+
+		constexpr std::ptrdiff_t cache_line = 64;
+
+		// [0, n) cut into blocks: the first head long if head > 0, the
+		// rest block long. Algorithms over contiguous storage choose head
+		// so that block boundaries fall on cache lines.
+		struct block_partition {
+			std::ptrdiff_t n;
+			std::ptrdiff_t block;
+			std::ptrdiff_t head;
+
+			constexpr block_partition(std::ptrdiff_t n, std::ptrdiff_t block,
+				std::ptrdiff_t head = 0) noexcept
+			: n{(STL2_EXPECT(n >= 0), n)}, block{(STL2_EXPECT(block > 0), block)},
+				head{(STL2_EXPECT(head >= 0), head < n ? head : n)}
+			{}
+
+			constexpr std::ptrdiff_t count() const noexcept {
+				return (head > 0) + (n - head + block - 1) / block;
+			}
+			// The first index of block b
+			constexpr std::ptrdiff_t bound(std::ptrdiff_t b) const noexcept {
+				auto const i = head > 0 ? (b > 0 ? head + (b - 1) * block : 0) : b * block;
+				return i < n ? i : n;
+			}
+			// The block that starts at first
+			constexpr std::ptrdiff_t index(std::ptrdiff_t first) const noexcept {
+				return head > 0 ? (first < head ? 0 : 1 + (first - head) / block) : first / block;
+			}
+		};
+
+		// Calls f(first, last) for each block of part on the threads of
+		// pool. Each thread starts on its own contiguous share of the
+		// blocks, the same share for the same partition every time, and
+		// once that is done steals blocks from the front of the others'
+		// shares; uneven blocks balance out without a central queue.
+		//
+		// If f throws, no further blocks are started and the first
+		// exception is rethrown once the running ones return.
+		template <class F>
+		void for_each_block(thread_pool& pool, const block_partition& part, F f) {
+			auto const blocks = part.count();
+			auto const size = static_cast<std::ptrdiff_t>(pool.size());
+			auto const threads = blocks < size ? blocks : size;
+			if (threads <= 1) {
+				for (auto b = std::ptrdiff_t{0}; b < blocks; ++b) {
+					f(part.bound(b), part.bound(b + 1));
+				}
+				return;
+			}
+
+			struct alignas(cache_line) share {
+				std::atomic<std::ptrdiff_t> next;
+				std::ptrdiff_t end;
+			};
+			std::unique_ptr<share[]> shares{new share[threads]};
+			for (auto k = std::ptrdiff_t{0}; k < threads; ++k) {
+				shares[k].next.store(blocks * k / threads, std::memory_order_relaxed);
+				shares[k].end = blocks * (k + 1) / threads;
+			}
+			std::atomic<bool> failed{false};
+			std::exception_ptr error;
+			std::mutex error_mtx;
+			auto body = [&](unsigned self) {
+				try {
+					for (auto k = std::ptrdiff_t{0}; k < threads; ++k) {
+						auto& s = shares[(self + k) % threads];
+						for (;;) {
+							if (failed.load(std::memory_order_relaxed)) {
+								return;
+							}
+							auto const b = s.next.fetch_add(1, std::memory_order_relaxed);
+							if (b >= s.end) {
+								break;
+							}
+							f(part.bound(b), part.bound(b + 1));
+						}
+					}
+				} catch(...) {
+					failed.store(true, std::memory_order_relaxed);
+					std::lock_guard<std::mutex> lock{error_mtx};
+					if (!error) {
+						error = std::current_exception();
+					}
+				}
+			};
+			pool.run(static_cast<unsigned>(threads), body);
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+		// The pool for policy: every thread under par and par_unseq, the
+		// caller alone under seq.
+		template <class EP>
+		requires ExecutionPolicy<EP>()
+		thread_pool& pool_for(EP&&) {
+			if (is_parallel<EP>) {
+				return thread_pool::instance();
+			}
+			static thread_pool serial{1};
+			return serial;
+		}
+
+		template <class EP, class F>
+		requires ExecutionPolicy<EP>()
+		void for_each_block(EP&& policy, const block_partition& part, F f) {
+			__execution::for_each_block(__execution::pool_for(policy), part, std::move(f));
+		}
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -14,9 +14,11 @@
 
 #include <stl2/algorithm.hpp>
 #include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
 #include <stl2/type_traits.hpp>
 #include <stl2/detail/ebo_box.hpp>
 #include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
 #include <stl2/detail/concepts/allocator.hpp>
 #include <memory>
 
@@ -406,6 +408,21 @@ STL2_OPEN_NAMESPACE {
 			erase_after(before_begin(), end());
 		}
 
+		// Extension
+		// Linear in the number of elements, which forward_list does not
+		// store. Each node's overhead is its link and any padding around
+		// the element.
+		memory_stats memory_usage() const noexcept {
+			auto const alloc = node_allocator_type{detail::ebo_box<A>::get()};
+			memory_stats s;
+			for (auto p = head_; p; p = p->next_) {
+				s.payload += sizeof(T);
+				s.overhead += sizeof(node_t) - sizeof(T);
+				__memory_stats::allocation(s, alloc, 1);
+			}
+			return s;
+		}
+
 		template<InputIterator I, Sentinel<I> S>
 		requires
 			Allocator<node_allocator_type, node_t>() &&
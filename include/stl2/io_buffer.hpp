@@ -0,0 +1,359 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_IO_BUFFER_HPP
+#define STL2_IO_BUFFER_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#if __has_include(<sys/uio.h>)
+#include <cerrno>
+#include <system_error>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Scatter/gather I/O over container storage: buffer_of describes the
+// storage of an object or a contiguous range as a single buffer, and
+// buffers(rng) describes each element of rng that way - one buffer per
+// vector in a list of vectors, or one per node payload in a
+// forward_list - so that containers can be handed to writev, readv or
+// io_uring without a staging copy.
+STL2_OPEN_NAMESPACE {
+	struct const_buffer {
+		const void* data;
+		std::size_t size;
+	};
+
+	struct mutable_buffer {
+		void* data;
+		std::size_t size;
+
+		constexpr operator const_buffer() const noexcept {
+			return {data, size};
+		}
+	};
+
+	// A sink writes every byte of a sequence of buffers, or throws.
+	template <class S>
+	concept bool ByteSink() {
+		return requires (S& s, const const_buffer* bufs, std::size_t n) {
+			s.write(bufs, n);
+		};
+	}
+
+	// A source fills a sequence of buffers in order, returning the number
+	// of bytes read; fewer than requested means the input is exhausted.
+	template <class S>
+	concept bool ByteSource() {
+		return requires (S& s, const mutable_buffer* bufs, std::size_t n) {
+			{ s.read(bufs, n) } -> std::size_t;
+		};
+	}
+
+	namespace models {
+		template <class>
+		constexpr bool ByteSink = false;
+		__stl2::ByteSink{S}
+		constexpr bool ByteSink<S> = true;
+
+		template <class>
+		constexpr bool ByteSource = false;
+		__stl2::ByteSource{S}
+		constexpr bool ByteSource<S> = true;
+	}
+
+	namespace __io {
+		template <class T>
+		concept bool TriviallyCopyable = std::is_trivially_copyable<T>::value;
+
+		template <class R>
+		concept bool ContiguousStorage =
+			SizedRange<R>() && ContiguousIterator<iterator_t<R>>() &&
+			TriviallyCopyable<value_type_t<iterator_t<R>>>;
+
+#if __has_include(<sys/uio.h>)
+		// Repeats op - readv or writev - until every buffer has been
+		// transferred or op reports end of file.
+		template <class Buffer, class Op>
+		std::size_t transfer(const Buffer* bufs, std::size_t n, Op op) {
+			constexpr std::size_t batch = 16;
+			std::size_t total = 0;
+			while (n > 0) {
+				::iovec iov[batch];
+				auto const count = n < batch ? n : batch;
+				for (std::size_t i = 0; i < count; ++i) {
+					iov[i].iov_base = const_cast<void*>(static_cast<const void*>(bufs[i].data));
+					iov[i].iov_len = bufs[i].size;
+				}
+				for (auto first = iov, last = iov + count;;) {
+					while (first != last && first->iov_len == 0) {
+						++first;
+					}
+					if (first == last) {
+						break;
+					}
+					auto const r = op(first, static_cast<int>(last - first));
+					if (r < 0) {
+						if (errno == EINTR) {
+							continue;
+						}
+						throw std::system_error{errno, std::generic_category()};
+					}
+					if (r == 0) {
+						return total;
+					}
+					total += static_cast<std::size_t>(r);
+					auto k = static_cast<std::size_t>(r);
+					for (; first != last && k >= first->iov_len; ++first) {
+						k -= first->iov_len;
+					}
+					if (first != last) {
+						first->iov_base = static_cast<char*>(first->iov_base) + k;
+						first->iov_len -= k;
+					}
+				}
+				bufs += count;
+				n -= count;
+			}
+			return total;
+		}
+#endif
+	}
+
+#if __has_include(<sys/uio.h>)
+	// For submitting buffers to interfaces that take iovecs directly,
+	// such as io_uring.
+	inline ::iovec to_iovec(const_buffer b) noexcept {
+		return {const_cast<void*>(b.data), b.size};
+	}
+	inline ::iovec to_iovec(mutable_buffer b) noexcept {
+		return {b.data, b.size};
+	}
+
+	// A ByteSink and ByteSource over a POSIX file descriptor, which it
+	// does not own. Each call is a single writev or readv unless the
+	// kernel transfers less than requested.
+	class fd_stream {
+		int fd_;
+	public:
+		explicit fd_stream(int fd) noexcept
+		: fd_{fd} {}
+
+		int fd() const noexcept { return fd_; }
+
+		void write(const const_buffer* bufs, std::size_t n) {
+			std::size_t expected = 0;
+			for (std::size_t i = 0; i < n; ++i) {
+				expected += bufs[i].size;
+			}
+			auto const written = __io::transfer(bufs, n,
+				[this](const ::iovec* iov, int count) { return ::writev(fd_, iov, count); });
+			if (written != expected) {
+				throw std::system_error{EIO, std::generic_category(), "short write"};
+			}
+		}
+
+		std::size_t read(const mutable_buffer* bufs, std::size_t n) {
+			return __io::transfer(bufs, n,
+				[this](const ::iovec* iov, int count) { return ::readv(fd_, iov, count); });
+		}
+	};
+#endif
+
+	// The elements of a contiguous range, as one buffer.
+	template <class R>
+	requires
+		__io::ContiguousStorage<const R>
+	const_buffer buffer_of(const R& r) {
+		auto const n = __stl2::end(r) - __stl2::begin(r);
+		using T = value_type_t<iterator_t<const R>>;
+		return {n > 0 ? std::addressof(*__stl2::begin(r)) : nullptr,
+			static_cast<std::size_t>(n) * sizeof(T)};
+	}
+	template <class R>
+	requires
+		_IsNot<R, is_const> &&
+		__io::ContiguousStorage<R>
+	mutable_buffer buffer_of(R& r) {
+		auto const n = __stl2::end(r) - __stl2::begin(r);
+		using T = value_type_t<iterator_t<R>>;
+		return {n > 0 ? std::addressof(*__stl2::begin(r)) : nullptr,
+			static_cast<std::size_t>(n) * sizeof(T)};
+	}
+
+	// The object representation of a trivially copyable object.
+	template <class T>
+	requires
+		__io::TriviallyCopyable<T> &&
+		!Range<const T>()
+	const_buffer buffer_of(const T& t) noexcept {
+		return {std::addressof(t), sizeof(T)};
+	}
+	template <class T>
+	requires
+		_IsNot<T, is_const> &&
+		__io::TriviallyCopyable<T> &&
+		!Range<T>()
+	mutable_buffer buffer_of(T& t) noexcept {
+		return {std::addressof(t), sizeof(T)};
+	}
+
+	namespace __io {
+		template <InputIterator I, Sentinel<I> S>
+		class buffer_cursor {
+			I first_;
+			S last_;
+		public:
+			using value_type = decay_t<decltype(__stl2::buffer_of(*declval<I&>()))>;
+			using difference_type = difference_type_t<I>;
+
+			buffer_cursor() = default;
+			constexpr buffer_cursor(I first, S last)
+			: first_{std::move(first)}, last_{std::move(last)} {}
+
+			value_type read() const { return __stl2::buffer_of(*first_); }
+			void next() { ++first_; }
+			bool done() const { return first_ == last_; }
+			bool equal(const buffer_cursor& that) const
+			requires ForwardIterator<I>()
+			{
+				return first_ == that.first_;
+			}
+		};
+	}
+
+	// A view of buffer_of(e) for each element e of rng.
+	template <InputRange Rng>
+	requires
+		requires (reference_t<iterator_t<Rng>> e) { __stl2::buffer_of(e); }
+	class buffer_sequence {
+		using cursor = __io::buffer_cursor<iterator_t<Rng>, sentinel_t<Rng>>;
+		Rng* rng_;
+	public:
+		explicit buffer_sequence(Rng& rng) noexcept
+		: rng_{std::addressof(rng)} {}
+
+		__stl2::basic_iterator<cursor> begin() const {
+			return cursor{__stl2::begin(*rng_), __stl2::end(*rng_)};
+		}
+		default_sentinel end() const noexcept {
+			return {};
+		}
+	};
+
+	template <InputRange Rng>
+	requires
+		requires (reference_t<iterator_t<Rng>> e) { __stl2::buffer_of(e); }
+	buffer_sequence<Rng> buffers(Rng& rng) noexcept {
+		return buffer_sequence<Rng>{rng};
+	}
+
+	// Writes every buffer in rng to sink, gathering them in batches.
+	template <InputRange Rng, ByteSink S>
+	requires
+		ConvertibleTo<reference_t<iterator_t<Rng>>, const_buffer>()
+	void write_buffers(S& sink, Rng&& rng) {
+		constexpr std::size_t batch = 64;
+		const_buffer bufs[batch];
+		std::size_t n = 0;
+		for (auto first = __stl2::begin(rng), last = __stl2::end(rng); first != last; ++first) {
+			bufs[n] = *first;
+			if (++n == batch) {
+				sink.write(bufs, n);
+				n = 0;
+			}
+		}
+		if (n > 0) {
+			sink.write(bufs, n);
+		}
+	}
+
+	// Fills the buffers in rng from source, scattering in batches.
+	// Returns the number of bytes read.
+	template <InputRange Rng, ByteSource S>
+	requires
+		ConvertibleTo<reference_t<iterator_t<Rng>>, mutable_buffer>()
+	std::size_t read_buffers(S& source, Rng&& rng) {
+		constexpr std::size_t batch = 64;
+		mutable_buffer bufs[batch];
+		std::size_t n = 0;
+		std::size_t total = 0;
+		std::size_t expected = 0;
+		for (auto first = __stl2::begin(rng), last = __stl2::end(rng); first != last; ++first) {
+			bufs[n] = *first;
+			expected += bufs[n].size;
+			if (++n == batch) {
+				total += source.read(bufs, n);
+				if (total != expected) {
+					return total;
+				}
+				n = 0;
+			}
+		}
+		if (n > 0) {
+			total += source.read(bufs, n);
+		}
+		return total;
+	}
+
+	// The uninitialized storage between vec.end() and the end of its
+	// capacity.
+	template <class T, class PA>
+	requires
+		__io::TriviallyCopyable<T>
+	mutable_buffer tail_buffer(vector<T, PA>& vec) noexcept {
+		auto const n = vec.capacity() - vec.size();
+		return {n > 0 ? std::addressof(*vec.end()) : nullptr,
+			static_cast<std::size_t>(n) * sizeof(T)};
+	}
+
+	// Reads from source directly into the uninitialized tail of vec and
+	// appends the whole elements that arrived. partial is the number of
+	// bytes of a trailing partial element left just past vec.end() by the
+	// previous call, zero at first; it is updated for the next call, so
+	// vec must not be modified in between. Returns the number of bytes
+	// read.
+	template <class T, class PA, ByteSource S>
+	requires
+		__io::TriviallyCopyable<T>
+	std::size_t read_tail(S& source, vector<T, PA>& vec, std::size_t& partial) {
+		STL2_EXPECT(partial < sizeof(T));
+		auto buf = tail_buffer(vec);
+		if (buf.size <= partial) {
+			return 0;
+		}
+		buf.data = static_cast<unsigned char*>(buf.data) + partial;
+		buf.size -= partial;
+		auto const n = source.read(&buf, 1);
+		auto const total = partial + n;
+		vec.extend_unchecked(static_cast<typename vector<T, PA>::size_type>(total / sizeof(T)));
+		partial = total % sizeof(T);
+		return n;
+	}
+
+	// As above, for elements that cannot be split.
+	template <class T, class PA, ByteSource S>
+	requires
+		__io::TriviallyCopyable<T> && sizeof(T) == 1
+	std::size_t read_tail(S& source, vector<T, PA>& vec) {
+		std::size_t partial = 0;
+		return read_tail(source, vec, partial);
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,587 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_MEMORY_RESOURCE_HPP
+#define STL2_MEMORY_RESOURCE_HPP
+
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+
+STL2_OPEN_NAMESPACE {
+	// A source of raw memory, chosen at run time. The public members
+	// forward to the private virtual ones, which resources override.
+	class memory_resource {
+	public:
+		virtual ~memory_resource() = default;
+
+		// Requires align to be a power of two
+		void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+			STL2_EXPECT(align != 0 && (align & (align - 1)) == 0);
+			return do_allocate(bytes, align);
+		}
+
+		// Requires that *this, or a resource equal to it, returned p from
+		// allocate(bytes, align)
+		void deallocate(void* p, std::size_t bytes,
+			std::size_t align = alignof(std::max_align_t)) noexcept
+		{
+			do_deallocate(p, bytes, align);
+		}
+
+		// True if either of *this and that can free memory the other
+		// allocated
+		bool is_equal(const memory_resource& that) const noexcept {
+			return do_is_equal(that);
+		}
+
+	private:
+		virtual void* do_allocate(std::size_t bytes, std::size_t align) = 0;
+		virtual void do_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept = 0;
+		virtual bool do_is_equal(const memory_resource& that) const noexcept = 0;
+	};
+
+	inline bool operator==(const memory_resource& a, const memory_resource& b) noexcept {
+		return std::addressof(a) == std::addressof(b) || a.is_equal(b);
+	}
+	inline bool operator!=(const memory_resource& a, const memory_resource& b) noexcept {
+		return !(a == b);
+	}
+
+	namespace __pmr {
+		constexpr bool over_aligned(std::size_t align) noexcept {
+			return align > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+		}
+
+		constexpr std::size_t align_up(std::size_t n, std::size_t align) noexcept {
+			return (n + align - 1) & ~(align - 1);
+		}
+
+		// Operator new and delete
+		class new_delete final : public memory_resource {
+			void* do_allocate(std::size_t bytes, std::size_t align) override {
+				return over_aligned(align) ?
+					::operator new(bytes, std::align_val_t{align}) :
+					::operator new(bytes);
+			}
+			void do_deallocate(void* p, std::size_t, std::size_t align) noexcept override {
+				if (over_aligned(align)) {
+					::operator delete(p, std::align_val_t{align});
+				} else {
+					::operator delete(p);
+				}
+			}
+			bool do_is_equal(const memory_resource& that) const noexcept override {
+				return this == std::addressof(that);
+			}
+		};
+
+		class null_resource final : public memory_resource {
+			void* do_allocate(std::size_t, std::size_t) override {
+				throw std::bad_alloc{};
+			}
+			void do_deallocate(void*, std::size_t, std::size_t) noexcept override {}
+			bool do_is_equal(const memory_resource& that) const noexcept override {
+				return this == std::addressof(that);
+			}
+		};
+	}
+
+	// The resource that calls ::operator new and ::operator delete
+	inline memory_resource* new_delete_resource() noexcept {
+		static __pmr::new_delete r;
+		return &r;
+	}
+
+	// The resource whose every allocation throws std::bad_alloc
+	inline memory_resource* null_memory_resource() noexcept {
+		static __pmr::null_resource r;
+		return &r;
+	}
+
+	namespace __pmr {
+		inline std::atomic<memory_resource*>& default_resource() noexcept {
+			static std::atomic<memory_resource*> r{new_delete_resource()};
+			return r;
+		}
+	}
+
+	// The resource default-constructed polymorphic_allocators use;
+	// initially new_delete_resource().
+	inline memory_resource* get_default_resource() noexcept {
+		return __pmr::default_resource().load(std::memory_order_acquire);
+	}
+
+	// Makes r - or new_delete_resource(), if r is null - the default
+	// resource, and returns the previous one.
+	inline memory_resource* set_default_resource(memory_resource* r) noexcept {
+		return __pmr::default_resource().exchange(r ? r : new_delete_resource(),
+			std::memory_order_acq_rel);
+	}
+
+	// A type-erased allocator: the resource is chosen when the allocator
+	// is constructed, not in the type, so containers that draw from an
+	// arena, a pool or the heap are all the same type.
+	//
+	// Containers keep the allocator they were constructed with: it does
+	// not propagate on copy, move or swap, and a copy-constructed
+	// container uses the default resource.
+	template <class T = std::byte>
+	class polymorphic_allocator {
+		template <class> friend class polymorphic_allocator;
+
+		memory_resource* resource_;
+
+	public:
+		using value_type = T;
+
+		polymorphic_allocator() noexcept
+		: resource_{get_default_resource()}
+		{}
+
+		// Requires r != nullptr
+		polymorphic_allocator(memory_resource* r) noexcept
+		: resource_{(STL2_EXPECT(r), r)}
+		{}
+
+		template <class U>
+		polymorphic_allocator(const polymorphic_allocator<U>& that) noexcept
+		: resource_{that.resource_}
+		{}
+
+		T* allocate(std::size_t n) {
+			if (n > max_size()) {
+				throw std::bad_array_new_length{};
+			}
+			return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T* p, std::size_t n) noexcept {
+			resource_->deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		static constexpr std::size_t max_size() noexcept {
+			return std::size_t(-1) / sizeof(T);
+		}
+
+		polymorphic_allocator select_on_container_copy_construction() const noexcept {
+			return polymorphic_allocator{};
+		}
+
+		memory_resource* resource() const noexcept {
+			return resource_;
+		}
+	};
+
+	template <class T, class U>
+	bool operator==(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) noexcept {
+		return *a.resource() == *b.resource();
+	}
+	template <class T, class U>
+	bool operator!=(const polymorphic_allocator<T>& a, const polymorphic_allocator<U>& b) noexcept {
+		return !(a == b);
+	}
+
+	// A resource that hands out successive pieces of its buffers and frees
+	// nothing until release() or destruction. Each buffer it gets from
+	// upstream is larger than the last by half again.
+	//
+	// The resources below are final, and define their overrides in the
+	// class: given a resource whose type it can see, the compiler calls
+	// and inlines the override directly, leaving only the fast path - a
+	// bump here, a free list pop in the pools - in the caller.
+	class monotonic_buffer_resource final : public memory_resource {
+		struct chunk {
+			chunk* next;
+			std::size_t bytes;
+			std::size_t align;
+		};
+
+		memory_resource* upstream_;
+		unsigned char* current_;
+		std::size_t space_;
+		std::size_t next_size_;
+		chunk* chunks_ = nullptr;
+		unsigned char* const initial_;
+		std::size_t const initial_size_;
+
+		static constexpr std::size_t min_size = 256;
+
+		void* do_allocate(std::size_t bytes, std::size_t align) override {
+			auto const pad = static_cast<std::size_t>(
+				-reinterpret_cast<std::uintptr_t>(current_) & (align - 1));
+			if (pad + bytes <= space_) {
+				auto const p = current_ + pad;
+				current_ = p + bytes;
+				space_ -= pad + bytes;
+				return p;
+			}
+			return grow_(bytes, align);
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) noexcept override {}
+
+		bool do_is_equal(const memory_resource& that) const noexcept override {
+			return this == std::addressof(that);
+		}
+
+		// Gets a buffer from upstream big enough for bytes at align, with
+		// the chunk header that records it at the front.
+		void* grow_(std::size_t bytes, std::size_t align) {
+			auto const a = align < alignof(chunk) ? alignof(chunk) : align;
+			auto const header = __pmr::align_up(sizeof(chunk), a);
+			auto size = next_size_;
+			if (size < header + bytes) {
+				size = header + bytes;
+			}
+			auto const raw = static_cast<unsigned char*>(upstream_->allocate(size, a));
+			chunks_ = ::new (static_cast<void*>(raw)) chunk{chunks_, size, a};
+			next_size_ = next_size_ / 2 * 3;
+			auto const p = raw + header;
+			current_ = p + bytes;
+			space_ = size - header - bytes;
+			return p;
+		}
+
+	public:
+		explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+		: monotonic_buffer_resource{nullptr, 0, upstream}
+		{}
+
+		// The first buffer from upstream will be at least initial_size
+		// bytes.
+		explicit monotonic_buffer_resource(std::size_t initial_size,
+			memory_resource* upstream = get_default_resource()) noexcept
+		: upstream_{(STL2_EXPECT(upstream), upstream)}, current_{nullptr}, space_{0},
+			next_size_{initial_size < min_size ? min_size : initial_size},
+			initial_{nullptr}, initial_size_{0}
+		{}
+
+		// Hands out buffer before going upstream; buffer must outlive
+		// *this.
+		monotonic_buffer_resource(void* buffer, std::size_t size,
+			memory_resource* upstream = get_default_resource()) noexcept
+		: upstream_{(STL2_EXPECT(upstream), upstream)},
+			current_{static_cast<unsigned char*>(buffer)}, space_{size},
+			next_size_{size / 2 * 3 < min_size ? min_size : size / 2 * 3},
+			initial_{static_cast<unsigned char*>(buffer)}, initial_size_{size}
+		{}
+
+		monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+		monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+		~monotonic_buffer_resource() {
+			release();
+		}
+
+		// Returns every buffer to upstream, and starts over with the
+		// initial buffer.
+		void release() noexcept {
+			while (auto const c = chunks_) {
+				chunks_ = c->next;
+				upstream_->deallocate(c, c->bytes, c->align);
+			}
+			current_ = initial_;
+			space_ = initial_size_;
+		}
+
+		memory_resource* upstream_resource() const noexcept {
+			return upstream_;
+		}
+	};
+
+	struct pool_options {
+		// The most blocks a pool gets from upstream at once; 0 for the
+		// default.
+		std::size_t max_blocks_per_chunk = 0;
+		// Larger allocations go straight upstream; 0 for the default.
+		std::size_t largest_required_pool_block = 0;
+	};
+
+	namespace __pmr {
+		// Pools of blocks whose sizes are the powers of two from 8 bytes
+		// up, each with a free list and the chunks it carves. Blocks are
+		// aligned to their size; larger requests go upstream, linked in a
+		// list so that release() can find them.
+		class pools {
+			struct block {
+				block* next;
+			};
+
+			struct chunk {
+				chunk* next;
+				std::size_t bytes;
+				std::size_t align;
+			};
+
+			struct pool {
+				block* free = nullptr;
+				chunk* chunks = nullptr;
+				std::size_t next_blocks = 4;
+			};
+
+			// Precedes each large allocation, at the end of a header
+			// padded to the allocation's alignment
+			struct alignas(std::max_align_t) large {
+				large* prev;
+				large* next;
+				std::size_t bytes;
+				std::size_t align;
+			};
+
+			static constexpr std::size_t large_header(std::size_t align) noexcept {
+				return align_up(sizeof(large), align);
+			}
+
+			static unsigned char* large_base(large* l) noexcept {
+				return reinterpret_cast<unsigned char*>(l + 1) - large_header(l->align);
+			}
+
+			static constexpr std::size_t min_block = 8;
+			static constexpr std::size_t default_largest = 4096;
+			static constexpr std::size_t max_largest = std::size_t{1} << 20;
+			static constexpr std::size_t default_max_blocks = 1024;
+			static constexpr int max_pools = 18; // 8 B to 1 MiB
+
+			memory_resource* upstream_;
+			pool_options options_;
+			int pool_count_;
+			pool pools_[max_pools];
+			large* large_ = nullptr;
+
+			// The pool whose blocks fit bytes at align, or -1
+			int index_(std::size_t bytes, std::size_t align) const noexcept {
+				auto n = bytes < align ? align : bytes;
+				if (n > options_.largest_required_pool_block) {
+					return -1;
+				}
+				auto k = 0;
+				for (auto size = min_block; size < n; size *= 2) {
+					++k;
+				}
+				return k;
+			}
+
+			static constexpr std::size_t block_size(int k) noexcept {
+				return min_block << k;
+			}
+
+			void* refill_(int k) {
+				auto& p = pools_[k];
+				auto const size = block_size(k);
+				auto const n = p.next_blocks;
+				auto const header = align_up(sizeof(chunk), alignof(chunk));
+				auto const a = size < alignof(chunk) ? alignof(chunk) : size;
+				auto const bytes = align_up(n * size, alignof(chunk)) + header;
+				auto const raw = static_cast<unsigned char*>(upstream_->allocate(bytes, a));
+				// The header follows the blocks, which keep the chunk's
+				// alignment.
+				p.chunks = ::new (static_cast<void*>(raw + bytes - header)) chunk{p.chunks, bytes, a};
+				for (auto i = n; i-- > 1;) {
+					auto const b = ::new (static_cast<void*>(raw + i * size)) block{p.free};
+					p.free = b;
+				}
+				if (p.next_blocks < options_.max_blocks_per_chunk) {
+					p.next_blocks *= 2;
+					if (p.next_blocks > options_.max_blocks_per_chunk) {
+						p.next_blocks = options_.max_blocks_per_chunk;
+					}
+				}
+				return raw;
+			}
+
+			void* allocate_large_(std::size_t bytes, std::size_t align) {
+				auto const a = align < alignof(large) ? alignof(large) : align;
+				auto const header = large_header(a);
+				auto const raw = static_cast<unsigned char*>(upstream_->allocate(header + bytes, a));
+				auto const l = ::new (static_cast<void*>(raw + header - sizeof(large)))
+					large{nullptr, large_, header + bytes, a};
+				if (large_) {
+					large_->prev = l;
+				}
+				large_ = l;
+				return raw + header;
+			}
+
+			void free_large_(large* l) noexcept {
+				upstream_->deallocate(large_base(l), l->bytes, l->align);
+			}
+
+			void deallocate_large_(void* p) noexcept {
+				auto const l = static_cast<large*>(p) - 1;
+				(l->prev ? l->prev->next : large_) = l->next;
+				if (l->next) {
+					l->next->prev = l->prev;
+				}
+				free_large_(l);
+			}
+
+		public:
+			pools(const pool_options& options, memory_resource* upstream) noexcept
+			: upstream_{(STL2_EXPECT(upstream), upstream)}, options_{options}
+			{
+				auto& largest = options_.largest_required_pool_block;
+				if (largest == 0) {
+					largest = default_largest;
+				} else if (largest > max_largest) {
+					largest = max_largest;
+				}
+				pool_count_ = index_(largest, 1) + 1;
+				largest = block_size(pool_count_ - 1);
+				if (options_.max_blocks_per_chunk == 0) {
+					options_.max_blocks_per_chunk = default_max_blocks;
+				}
+			}
+
+			pools(const pools&) = delete;
+			pools& operator=(const pools&) = delete;
+
+			~pools() {
+				release();
+			}
+
+			void* allocate(std::size_t bytes, std::size_t align) {
+				auto const k = index_(bytes, align);
+				if (k < 0) {
+					return allocate_large_(bytes, align);
+				}
+				auto& p = pools_[k];
+				if (auto const b = p.free) {
+					p.free = b->next;
+					return b;
+				}
+				return refill_(k);
+			}
+
+			void deallocate(void* ptr, std::size_t bytes, std::size_t align) noexcept {
+				auto const k = index_(bytes, align);
+				if (k < 0) {
+					deallocate_large_(ptr);
+				} else {
+					auto& p = pools_[k];
+					p.free = ::new (ptr) block{p.free};
+				}
+			}
+
+			void release() noexcept {
+				for (auto k = 0; k < pool_count_; ++k) {
+					auto& p = pools_[k];
+					while (auto const c = p.chunks) {
+						p.chunks = c->next;
+						auto const raw = reinterpret_cast<unsigned char*>(c + 1) - c->bytes;
+						upstream_->deallocate(raw, c->bytes, c->align);
+					}
+					p = pool{};
+				}
+				while (auto const l = large_) {
+					large_ = l->next;
+					free_large_(l);
+				}
+			}
+
+			memory_resource* upstream_resource() const noexcept {
+				return upstream_;
+			}
+
+			pool_options options() const noexcept {
+				return options_;
+			}
+		};
+	}
+
+	// Pools of fixed-size blocks, for a single thread. Freed blocks go
+	// back on their pool's free list; memory returns upstream only on
+	// release() or destruction.
+	class unsynchronized_pool_resource final : public memory_resource {
+		__pmr::pools pools_;
+
+		void* do_allocate(std::size_t bytes, std::size_t align) override {
+			return pools_.allocate(bytes, align);
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept override {
+			pools_.deallocate(p, bytes, align);
+		}
+		bool do_is_equal(const memory_resource& that) const noexcept override {
+			return this == std::addressof(that);
+		}
+
+	public:
+		unsynchronized_pool_resource(const pool_options& options,
+			memory_resource* upstream = get_default_resource()) noexcept
+		: pools_{options, upstream}
+		{}
+		explicit unsynchronized_pool_resource(memory_resource* upstream = get_default_resource()) noexcept
+		: pools_{pool_options{}, upstream}
+		{}
+
+		void release() noexcept {
+			pools_.release();
+		}
+
+		memory_resource* upstream_resource() const noexcept {
+			return pools_.upstream_resource();
+		}
+
+		pool_options options() const noexcept {
+			return pools_.options();
+		}
+	};
+
+	// unsynchronized_pool_resource, made safe to share between threads
+	// with a lock.
+	class synchronized_pool_resource final : public memory_resource {
+		std::mutex mtx_;
+		__pmr::pools pools_;
+
+		void* do_allocate(std::size_t bytes, std::size_t align) override {
+			std::lock_guard<std::mutex> lock{mtx_};
+			return pools_.allocate(bytes, align);
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept override {
+			std::lock_guard<std::mutex> lock{mtx_};
+			pools_.deallocate(p, bytes, align);
+		}
+		bool do_is_equal(const memory_resource& that) const noexcept override {
+			return this == std::addressof(that);
+		}
+
+	public:
+		synchronized_pool_resource(const pool_options& options,
+			memory_resource* upstream = get_default_resource()) noexcept
+		: pools_{options, upstream}
+		{}
+		explicit synchronized_pool_resource(memory_resource* upstream = get_default_resource()) noexcept
+		: pools_{pool_options{}, upstream}
+		{}
+
+		void release() noexcept {
+			std::lock_guard<std::mutex> lock{mtx_};
+			pools_.release();
+		}
+
+		memory_resource* upstream_resource() const noexcept {
+			return pools_.upstream_resource();
+		}
+
+		pool_options options() const noexcept {
+			return pools_.options();
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
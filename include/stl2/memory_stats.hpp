@@ -0,0 +1,108 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_MEMORY_STATS_HPP
+#define STL2_MEMORY_STATS_HPP
+
+#include <stl2/detail/fwd.hpp>
+#include <cstddef>
+
+STL2_OPEN_NAMESPACE {
+	// Extension
+	// Where a container's memory goes, as reported by its memory_usage().
+	// payload and slack count element storage wherever it lives: in
+	// allocations, or inline in the container object (static_vector, the
+	// small buffer of basic_string). overhead and allocator count
+	// allocated storage only. Nothing counts sizeof the container object.
+	struct memory_stats {
+		// Bytes holding live elements.
+		std::size_t payload = 0;
+		// Bytes set aside for elements that do not exist: unused
+		// capacity, erased slots, unfilled blocks.
+		std::size_t slack = 0;
+		// Bytes of the container's own structure within its allocations:
+		// links and their padding in nodes, block headers, index tables.
+		std::size_t overhead = 0;
+		// Bytes the allocator reports spending beyond those requested -
+		// size-class rounding, headers - for allocators with a member
+		// allocation_overhead(n); zero for the rest.
+		std::size_t allocator = 0;
+		// Live allocations.
+		std::size_t allocations = 0;
+
+		constexpr std::size_t total() const noexcept {
+			return payload + slack + overhead + allocator;
+		}
+
+		constexpr memory_stats& operator+=(const memory_stats& that) noexcept {
+			payload += that.payload;
+			slack += that.slack;
+			overhead += that.overhead;
+			allocator += that.allocator;
+			allocations += that.allocations;
+			return *this;
+		}
+		friend constexpr memory_stats operator+(memory_stats x, const memory_stats& y) noexcept {
+			return x += y;
+		}
+	};
+
+	namespace __memory_stats {
+		template <class T, class N>
+		constexpr std::size_t bytes(N n) noexcept {
+			return sizeof(T) * static_cast<std::size_t>(n);
+		}
+
+		// The overhead a reports for allocating n objects, if it can.
+		template <class A>
+		constexpr std::size_t allocator_overhead(const A&, std::size_t) noexcept {
+			return 0;
+		}
+		template <class A>
+		requires
+			requires(const A& a, std::size_t n) {
+				{ a.allocation_overhead(n) } -> std::size_t;
+			}
+		constexpr std::size_t allocator_overhead(const A& a, std::size_t n) noexcept {
+			return a.allocation_overhead(n);
+		}
+
+		// The stats of a container that serves as another's bookkeeping
+		// - an index, a free list - whose elements are all overhead.
+		constexpr memory_stats as_overhead(memory_stats s) noexcept {
+			s.overhead += s.payload + s.slack;
+			s.payload = s.slack = 0;
+			return s;
+		}
+
+		// Records in s an allocation of n objects obtained from a.
+		template <class A, class N>
+		constexpr void allocation(memory_stats& s, const A& a, N n) noexcept {
+			++s.allocations;
+			s.allocator += __memory_stats::allocator_overhead(a, static_cast<std::size_t>(n));
+		}
+	}
+
+	// Extension
+	// The memory statistics of c, for aggregating across containers of
+	// different types. Every container here has a member memory_usage();
+	// other types may overload this function.
+	template <class C>
+	requires
+		requires(const C& c) {
+			{ c.memory_usage() } -> memory_stats;
+		}
+	memory_stats memory_usage(const C& c) noexcept(noexcept(c.memory_usage())) {
+		return c.memory_usage();
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,446 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_PACKED_INT_VECTOR_HPP
+#define STL2_PACKED_INT_VECTOR_HPP
+
+#include <stl2/bit_vector.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+STL2_OPEN_NAMESPACE {
+	enum class packed_encoding {
+		// Each value is stored as is.
+		plain,
+		// Each block of block_size values is stored as offsets from the
+		// smallest value in the block. For sorted data the offsets are
+		// distances from the start of the block, which need far fewer
+		// bits than the values.
+		frame_of_reference
+	};
+
+	namespace __packed {
+		using __bitvec::word;
+		using __bitvec::word_bits;
+		using __bitvec::low_mask;
+
+		// The number of bits needed to represent v; at least 1.
+		constexpr int bits_needed(std::uint64_t v) noexcept {
+			auto n = 1;
+			while (n < 64 && (v >> n) != 0) {
+				++n;
+			}
+			return n;
+		}
+
+		inline word get(const word* words, std::ptrdiff_t i, int width) noexcept {
+			auto const bit = i * width;
+			auto const k = bit / word_bits;
+			auto const s = static_cast<int>(bit % word_bits);
+			auto v = words[k] >> s;
+			if (s + width > word_bits) {
+				v |= words[k + 1] << (word_bits - s);
+			}
+			return v & low_mask(width);
+		}
+
+		inline void put(word* words, std::ptrdiff_t i, int width, word v) noexcept {
+			STL2_EXPECT((v & ~low_mask(width)) == 0);
+			auto const bit = i * width;
+			auto const k = bit / word_bits;
+			auto const s = static_cast<int>(bit % word_bits);
+			words[k] = (words[k] & ~(low_mask(width) << s)) | (v << s);
+			if (s + width > word_bits) {
+				auto const spill = s + width - word_bits;
+				words[k + 1] = (words[k + 1] & ~low_mask(spill)) | (v >> (word_bits - s));
+			}
+		}
+
+		// Value J of a group of 64 values of width W, which occupy exactly
+		// W words starting at in.
+		template <int W, int J, class T>
+		inline T extract(const word* in) noexcept {
+			constexpr auto bit = J * W;
+			constexpr auto k = bit / word_bits;
+			constexpr auto s = static_cast<int>(bit % word_bits);
+			auto v = in[k] >> s;
+			if (W != word_bits && s + W > word_bits) {
+				v |= in[k + 1] << ((word_bits - s) % word_bits);
+			}
+			return static_cast<T>(v & low_mask(W));
+		}
+
+		template <int W, class T, std::size_t...Js>
+		inline void unpack_group(const word* in, T* out, std::index_sequence<Js...>) noexcept {
+			(void)(..., (out[Js] = extract<W, static_cast<int>(Js), T>(in)));
+		}
+
+		// Decodes n values of width W starting at value first. Whole
+		// groups are unpacked by straight-line code in which every shift
+		// and mask is a constant, which compilers turn into vector code
+		// for many widths.
+		template <int W, class T>
+		void unpack(const word* words, std::ptrdiff_t first, std::ptrdiff_t n, T* out) noexcept {
+			auto const last = first + n;
+			for (; first < last && first % word_bits; ++first) {
+				*out++ = static_cast<T>(get(words, first, W));
+			}
+			for (; last - first >= word_bits; first += word_bits, out += word_bits) {
+				unpack_group<W>(words + first / word_bits * W, out,
+					std::make_index_sequence<word_bits>{});
+			}
+			for (; first < last; ++first) {
+				*out++ = static_cast<T>(get(words, first, W));
+			}
+		}
+
+		template <class T>
+		using unpack_fn = void (*)(const word*, std::ptrdiff_t, std::ptrdiff_t, T*) noexcept;
+
+		template <class T, std::size_t...Is>
+		constexpr std::array<unpack_fn<T>, sizeof...(Is)>
+		unpack_table(std::index_sequence<Is...>) noexcept {
+			return {{&unpack<static_cast<int>(Is) + 1, T>...}};
+		}
+
+		template <class PIV>
+		class reference {
+			PIV* vec_ = nullptr;
+			std::ptrdiff_t pos_ = 0;
+			using value_type = typename PIV::value_type;
+		public:
+			reference() = default;
+			constexpr reference(PIV& vec, std::ptrdiff_t pos) noexcept
+			: vec_{std::addressof(vec)}, pos_{pos} {}
+			reference(const reference&) = default;
+
+			operator value_type() const noexcept {
+				return vec_->get(pos_);
+			}
+			const reference& operator=(value_type v) const noexcept {
+				vec_->set(pos_, v);
+				return *this;
+			}
+			const reference& operator=(const reference& that) const noexcept {
+				return *this = static_cast<value_type>(that);
+			}
+
+			friend void swap(reference x, reference y) noexcept {
+				value_type const v = x;
+				x = static_cast<value_type>(y);
+				y = v;
+			}
+		};
+
+		template <class PIV>
+		class cursor {
+			template <class> friend class cursor;
+
+			PIV* vec_ = nullptr;
+			std::ptrdiff_t pos_ = 0;
+
+		public:
+			using value_type = typename remove_const_t<PIV>::value_type;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			constexpr cursor(PIV& vec, difference_type pos) noexcept
+			: vec_{std::addressof(vec)}, pos_{pos} {}
+			template <class U>
+			requires
+				std::is_const<PIV>::value &&
+				Same<U, remove_const_t<PIV>>()
+			constexpr cursor(const cursor<U>& that) noexcept
+			: vec_{that.vec_}, pos_{that.pos_} {}
+
+			value_type read() const noexcept
+			requires std::is_const<PIV>::value
+			{
+				return vec_->get(pos_);
+			}
+			reference<PIV> read() const noexcept
+			requires (!std::is_const<PIV>::value)
+			{
+				return {*vec_, pos_};
+			}
+			void next() noexcept { ++pos_; }
+			void prev() noexcept { --pos_; }
+			void advance(difference_type n) noexcept { pos_ += n; }
+			difference_type distance_to(const cursor& that) const noexcept {
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+		};
+	}
+
+	// A sequence of unsigned integers, each stored in width() bits of a
+	// packed array of 64-bit words. The width is fixed at construction,
+	// or chosen from the data when constructing from a range. Elements
+	// are accessed through proxy references; decode() unpacks a run of
+	// elements into a caller's buffer much faster than element-wise
+	// access.
+	//
+	// Storing a value that does not fit - in width() bits, or under
+	// frame_of_reference, as an offset from its block's base - is a
+	// precondition violation.
+	template <class T, ProtoAllocator<__bitvec::word> PA = std::allocator<__bitvec::word>>
+	requires
+		std::is_integral<T>::value &&
+		std::is_unsigned<T>::value &&
+		ProtoAllocator<PA, T>()
+	class packed_int_vector {
+		using word = __bitvec::word;
+		friend __packed::reference<packed_int_vector>;
+		friend __packed::cursor<packed_int_vector>;
+		friend __packed::cursor<const packed_int_vector>;
+	public:
+		using value_type = T;
+		using allocator_type = PA;
+		using size_type = std::ptrdiff_t;
+		using reference = __packed::reference<packed_int_vector>;
+		using const_reference = T;
+		using iterator = __stl2::basic_iterator<__packed::cursor<packed_int_vector>>;
+		using const_iterator = __stl2::basic_iterator<__packed::cursor<const packed_int_vector>>;
+
+		static constexpr size_type block_size = 128;
+		static constexpr int max_width = static_cast<int>(sizeof(T) * 8);
+
+		packed_int_vector(int width, packed_encoding encoding, allocator_type a)
+		: words_{rebind_allocator_t<PA, word>{a}}, bases_{rebind_allocator_t<PA, T>{a}},
+			width_{(STL2_EXPECT(0 < width && width <= max_width), width)},
+			encoding_{encoding}
+		{}
+
+		explicit packed_int_vector(int width = max_width,
+			packed_encoding encoding = packed_encoding::plain)
+			requires DefaultConstructible<allocator_type>()
+		: packed_int_vector{width, encoding, allocator_type{}}
+		{}
+
+		// Chooses the narrowest width that holds every element of rng
+		// under encoding.
+		template <ForwardRange Rng>
+		requires
+			ConvertibleTo<reference_t<iterator_t<Rng>>, T>()
+		packed_int_vector(Rng&& rng, packed_encoding encoding, allocator_type a)
+		: packed_int_vector{1, encoding, std::move(a)}
+		{
+			assign_(__stl2::begin(rng), __stl2::end(rng));
+		}
+
+		template <ForwardRange Rng>
+		requires
+			ConvertibleTo<reference_t<iterator_t<Rng>>, T>() &&
+			DefaultConstructible<allocator_type>()
+		explicit packed_int_vector(Rng&& rng,
+			packed_encoding encoding = packed_encoding::plain)
+		: packed_int_vector{__stl2::forward<Rng>(rng), encoding, allocator_type{}}
+		{}
+
+		// FIXME: NYI (as for vector)
+		packed_int_vector(packed_int_vector&&) = delete;
+		packed_int_vector(const packed_int_vector&) = delete;
+		packed_int_vector& operator=(packed_int_vector&&) & = delete;
+		packed_int_vector& operator=(const packed_int_vector&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return allocator_type{words_.get_allocator()};
+		}
+
+		iterator begin() noexcept { return __packed::cursor<packed_int_vector>{*this, 0}; }
+		iterator end() noexcept { return __packed::cursor<packed_int_vector>{*this, size_}; }
+
+		const_iterator begin() const noexcept { return __packed::cursor<const packed_int_vector>{*this, 0}; }
+		const_iterator end() const noexcept { return __packed::cursor<const packed_int_vector>{*this, size_}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		int width() const noexcept { return width_; }
+		packed_encoding encoding() const noexcept { return encoding_; }
+
+		size_type size() const noexcept { return size_; }
+		bool empty() const noexcept { return size_ == 0; }
+
+		// The words holding the packed elements.
+		const word* data() const noexcept { return words_.begin(); }
+		size_type word_count() const noexcept { return words_.size(); }
+
+		reference operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return {*this, i};
+		}
+		T operator[](size_type i) const noexcept {
+			return get(i);
+		}
+
+		reference front() noexcept { return (*this)[0]; }
+		T front() const noexcept { return get(0); }
+		reference back() noexcept { return (*this)[size_ - 1]; }
+		T back() const noexcept { return get(size_ - 1); }
+
+		// Requires n <= capacity() or *this is reallocatable
+		void reserve(size_type n) {
+			words_.reserve(__bitvec::words_for(n * width_));
+			if (encoding_ == packed_encoding::frame_of_reference) {
+				bases_.reserve((n + block_size - 1) / block_size);
+			}
+		}
+
+		void clear() noexcept {
+			words_.clear();
+			bases_.clear();
+			size_ = 0;
+		}
+
+		// Under frame_of_reference, the first element of each block sets
+		// the block's base, so appended data should be sorted (or at
+		// least, no element should be less than the first of its block).
+		void push_back(T v) {
+			if (encoding_ == packed_encoding::frame_of_reference && size_ % block_size == 0) {
+				bases_.push_back(v);
+			}
+			append_(v);
+		}
+
+		void pop_back() noexcept {
+			STL2_EXPECT(size_ > 0);
+			--size_;
+			if (encoding_ == packed_encoding::frame_of_reference && size_ % block_size == 0) {
+				bases_.pop_back();
+			}
+			while (words_.size() > __bitvec::words_for(size_ * width_)) {
+				words_.pop_back();
+			}
+			if (words_.size() > 0) {
+				words_.back() &= __bitvec::low_mask((size_ * width_ - 1) % __bitvec::word_bits + 1);
+			}
+		}
+
+		// Writes the n elements starting at first to out.
+		// Requires [first, first + n) is in [0, size()), and out points
+		// to n writable Ts.
+		void decode(size_type first, size_type n, T* out) const noexcept {
+			STL2_EXPECT(0 <= first && 0 <= n && first + n <= size_);
+			static constexpr auto table =
+				__packed::unpack_table<T>(std::make_index_sequence<max_width>{});
+			table[width_ - 1](words_.begin(), first, n, out);
+			if (encoding_ == packed_encoding::frame_of_reference) {
+				auto const bases = bases_.begin();
+				for (auto i = size_type{0}; i < n;) {
+					auto const b = (first + i) / block_size;
+					auto const last = __stl2::min(n, (b + 1) * block_size - first);
+					auto const base = bases[b];
+					for (; i < last; ++i) {
+						out[i] += base;
+					}
+				}
+			}
+		}
+		void decode(T* out) const noexcept {
+			decode(0, size_, out);
+		}
+
+		// The number of bytes of storage in use.
+		size_type memory_bytes() const noexcept {
+			return words_.capacity() * static_cast<size_type>(sizeof(word)) +
+				bases_.capacity() * static_cast<size_type>(sizeof(T));
+		}
+
+		// Extension: payload is the words holding the packed elements;
+		// the frame-of-reference bases count as overhead.
+		memory_stats memory_usage() const noexcept {
+			return words_.memory_usage() + __memory_stats::as_overhead(bases_.memory_usage());
+		}
+
+	private:
+		vector<word, PA> words_;
+		vector<T, PA> bases_;
+		size_type size_ = 0;
+		int width_;
+		packed_encoding encoding_;
+
+		T base(size_type i) const noexcept {
+			return encoding_ == packed_encoding::frame_of_reference ?
+				bases_.begin()[i / block_size] : T{0};
+		}
+
+		T get(size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return static_cast<T>(base(i) + __packed::get(words_.begin(), i, width_));
+		}
+
+		void set(size_type i, T v) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			auto const b = base(i);
+			STL2_EXPECT(v >= b);
+			__packed::put(words_.begin(), i, width_, static_cast<word>(v - b));
+		}
+
+		void append_(T v) {
+			auto const need = __bitvec::words_for((size_ + 1) * width_);
+			while (words_.size() < need) {
+				words_.push_back(word{0});
+			}
+			++size_;
+			set(size_ - 1, v);
+		}
+
+		template <ForwardIterator I, Sentinel<I> S>
+		void assign_(I first, S last) {
+			word widest = 0;
+			size_type n = 0;
+			if (encoding_ == packed_encoding::frame_of_reference) {
+				// One pass for the base and span of each block.
+				T lo = 0, hi = 0;
+				for (auto i = first; i != last; ++i, ++n) {
+					T const v = *i;
+					if (n % block_size == 0) {
+						if (n > 0) {
+							bases_.push_back(lo);
+							widest = __stl2::max(widest, word{hi} - lo);
+						}
+						lo = hi = v;
+					} else {
+						lo = __stl2::min(lo, v);
+						hi = __stl2::max(hi, v);
+					}
+				}
+				if (n > 0) {
+					bases_.push_back(lo);
+					widest = __stl2::max(widest, word{hi} - lo);
+				}
+			} else {
+				for (auto i = first; i != last; ++i, ++n) {
+					widest = __stl2::max(widest, word{static_cast<T>(*i)});
+				}
+			}
+			width_ = __packed::bits_needed(widest);
+			words_.reserve(__bitvec::words_for(n * width_));
+			for (; first != last; ++first) {
+				append_(*first);
+			}
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
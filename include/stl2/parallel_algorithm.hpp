@@ -0,0 +1,573 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_PARALLEL_ALGORITHM_HPP
+#define STL2_PARALLEL_ALGORITHM_HPP
+
+#include <stl2/algorithm.hpp>
+#include <stl2/execution.hpp>
+#include <stl2/functional.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/simd_algorithm.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/utility.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+
+// Extension: execution policy overloads of the algorithms that dominate
+// bulk work on vectors. The range is cut into blocks of about 64 KiB that
+// the threads of the pool claim and steal (see
+// __execution::for_each_block); when the iterator is a pointer, as
+// vector's is, the blocks of the range being written start on cache
+// lines, so no two threads write the same line. Each block of a fill
+// over arithmetic elements runs the vector kernel of simd_algorithm.hpp.
+//
+// Under seq the same blocks run in order on the calling thread, so reduce
+// and the scans combine elements identically under every policy: with
+// an associative operation the results are the same bit for bit, even
+// for floating point.
+//
+// Element access functions run concurrently under par and par_unseq. An
+// exception thrown by one is rethrown from the algorithm, leaving the
+// output in a valid but unspecified state.
+STL2_OPEN_NAMESPACE {
+	namespace __parallel {
+		using __execution::block_partition;
+
+		template <class T>
+		constexpr std::ptrdiff_t block_size() noexcept {
+			return sizeof(T) < 65536 ? 65536 / sizeof(T) : 1;
+		}
+
+		// The number of elements before the first cache line boundary
+		// at or after i, when i is a pointer to elements that tile the
+		// line; 0 otherwise.
+		template <class I>
+		constexpr std::ptrdiff_t head(const I&) noexcept {
+			return 0;
+		}
+		template <class T>
+		std::ptrdiff_t head(T* p) noexcept {
+			constexpr auto line = __execution::cache_line;
+			constexpr auto size = static_cast<std::ptrdiff_t>(sizeof(T));
+			auto const offset = static_cast<std::ptrdiff_t>(
+				reinterpret_cast<std::uintptr_t>(p) % line);
+			if (line % size != 0 || offset % size != 0) {
+				return 0;
+			}
+			return (line - offset) % line / size;
+		}
+
+		template <class I, class O = I>
+		block_partition partition(std::ptrdiff_t n, const O& out) noexcept {
+			return {n, block_size<value_type_t<I>>(), __parallel::head(out)};
+		}
+
+		template <class Comp, class Proj>
+		struct projected_less {
+			Comp& comp;
+			Proj& proj;
+
+			template <class T, class U>
+			bool operator()(T&& t, U&& u) const {
+				return __stl2::invoke(comp, __stl2::invoke(proj, t), __stl2::invoke(proj, u));
+			}
+		};
+
+		// The number of elements of a in the first k of the stable merge
+		// of a (length an) and b (length bn).
+		template <class I, class J, class Less>
+		std::ptrdiff_t co_rank(std::ptrdiff_t k, I a, std::ptrdiff_t an,
+			J b, std::ptrdiff_t bn, Less& less)
+		{
+			auto lo = k - bn > 0 ? k - bn : std::ptrdiff_t{0};
+			auto hi = k < an ? k : an;
+			while (lo < hi) {
+				auto const i = lo + (hi - lo) / 2;
+				if (less(b[k - i - 1], a[i])) {
+					hi = i;
+				} else {
+					lo = i + 1;
+				}
+			}
+			return lo;
+		}
+
+		// Moves elements [k0, k1) of the stable merge of the sorted runs
+		// src[first, mid) and src[mid, last) to dst[first + k0, first + k1).
+		template <class I, class O, class Less>
+		void merge_slice(I src, O dst, std::ptrdiff_t first, std::ptrdiff_t mid,
+			std::ptrdiff_t last, std::ptrdiff_t k0, std::ptrdiff_t k1, Less& less)
+		{
+			auto const a = src + first;
+			auto const b = src + mid;
+			auto const an = mid - first;
+			auto const bn = last - mid;
+			auto i = __parallel::co_rank(k0, a, an, b, bn, less);
+			auto j = k0 - i;
+			auto const i1 = __parallel::co_rank(k1, a, an, b, bn, less);
+			auto const j1 = k1 - i1;
+			auto out = dst + (first + k0);
+			while (i < i1 && j < j1) {
+				if (less(b[j], a[i])) {
+					*out = __stl2::iter_move(b + j);
+					++j;
+				} else {
+					*out = __stl2::iter_move(a + i);
+					++i;
+				}
+				++out;
+			}
+			for (; i < i1; ++i, ++out) {
+				*out = __stl2::iter_move(a + i);
+			}
+			for (; j < j1; ++j, ++out) {
+				*out = __stl2::iter_move(b + j);
+			}
+		}
+
+		// Uninitialized storage for n Ts, destroying the first
+		// constructed of them when it goes away.
+		template <class T>
+		struct buffer {
+			std::allocator<T> a;
+			T* data;
+			std::ptrdiff_t n;
+			std::ptrdiff_t constructed = 0;
+
+			explicit buffer(std::ptrdiff_t n)
+			: data{a.allocate(static_cast<std::size_t>(n))}, n{n} {}
+			~buffer() {
+				for (auto i = std::ptrdiff_t{0}; i < constructed; ++i) {
+					data[i].~T();
+				}
+				a.deallocate(data, static_cast<std::size_t>(n));
+			}
+			buffer(buffer&&) = delete;
+			buffer& operator=(buffer&&) & = delete;
+		};
+
+		// Sorts each of up to one run per thread with sort_run, then
+		// merges pairs of runs - back and forth between [first, first + n)
+		// and a buffer - until one run remains. Every merge round splits
+		// its output evenly into blocks, located in the two input runs by
+		// binary search, so all threads stay busy to the last round.
+		template <class EP, class I, class Comp, class Proj, class SortRun>
+		void sort(EP& policy, I first, std::ptrdiff_t n, Comp& comp, Proj& proj,
+			SortRun sort_run)
+		{
+			using T = value_type_t<I>;
+			auto& pool = __execution::pool_for(policy);
+			auto const block = block_size<T>();
+			auto const threads = static_cast<std::ptrdiff_t>(pool.size());
+			auto runs = n / block < threads ? n / block : threads;
+			if (runs <= 1 || !std::is_nothrow_move_constructible<T>::value) {
+				sort_run(first, first + n);
+				return;
+			}
+			auto const run = (n + runs - 1) / runs;
+			__execution::for_each_block(pool, block_partition{n, run},
+				[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+					sort_run(first + lo, first + hi);
+				});
+
+			buffer<T> buf{n};
+			auto const data = buf.data;
+			__execution::for_each_block(pool, block_partition{n, block, __parallel::head(data)},
+				[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+					for (auto i = lo; i < hi; ++i) {
+						::new (static_cast<void*>(data + i)) T(__stl2::iter_move(first + i));
+					}
+				});
+			buf.constructed = n;
+
+			auto less = projected_less<Comp, Proj>{comp, proj};
+			auto merge_round = [&](auto src, auto dst, std::ptrdiff_t width) {
+				__execution::for_each_block(pool, partition<I>(n, dst),
+					[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+						while (lo < hi) {
+							auto const start = lo / (2 * width) * (2 * width);
+							auto const mid = start + width < n ? start + width : n;
+							auto const end = start + 2 * width < n ? start + 2 * width : n;
+							auto const stop = hi < end ? hi : end;
+							__parallel::merge_slice(src, dst, start, mid, end, lo - start, stop - start, less);
+							lo = stop;
+						}
+					});
+			};
+			auto in_buffer = true;
+			for (auto width = run; width < n; width *= 2) {
+				if (in_buffer) {
+					merge_round(data, first, width);
+				} else {
+					merge_round(first, data, width);
+				}
+				in_buffer = !in_buffer;
+			}
+			if (in_buffer) {
+				__execution::for_each_block(pool, partition<I>(n, first),
+					[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+						for (auto i = lo; i < hi; ++i) {
+							first[i] = __stl2::iter_move(data + i);
+						}
+					});
+			}
+		}
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, class T, RandomAccessIterator O, SizedSentinel<O> S>
+	requires
+		Writable<O, const T&>()
+	O fill(EP&& policy, O first, S last, const T& value) {
+		auto const n = last - first;
+		__execution::for_each_block(policy, __parallel::partition<O>(n, first),
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				__stl2::fill(first + lo, first + hi, value);
+			});
+		return first + n;
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, class T, RandomAccessRange Rng>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		Writable<iterator_t<Rng>, const T&>()
+	safe_iterator_t<Rng> fill(EP&& policy, Rng&& rng, const T& value) {
+		return __stl2::fill(policy, __stl2::begin(rng), __stl2::end(rng), value);
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		RandomAccessIterator O>
+	requires
+		IndirectlyCopyable<I, O>()
+	tagged_pair<tag::in(I), tag::out(O)>
+	copy(EP&& policy, I first, S last, O result) {
+		auto const n = last - first;
+		__execution::for_each_block(policy, __parallel::partition<I>(n, result),
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				__stl2::copy(first + lo, first + hi, result + lo);
+			});
+		return {first + n, result + n};
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, RandomAccessIterator O>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		IndirectlyCopyable<iterator_t<Rng>, O>()
+	tagged_pair<tag::in(safe_iterator_t<Rng>), tag::out(O)>
+	copy(EP&& policy, Rng&& rng, O result) {
+		return __stl2::copy(policy, __stl2::begin(rng), __stl2::end(rng), std::move(result));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		RandomAccessIterator O, CopyConstructible F, class Proj = identity>
+	requires
+		Writable<O, indirect_result_of_t<F&(projected<I, Proj>)>>()
+	tagged_pair<tag::in(I), tag::out(O)>
+	transform(EP&& policy, I first, S last, O result, F op, Proj proj = Proj{}) {
+		auto const n = last - first;
+		__execution::for_each_block(policy, __parallel::partition<I>(n, result),
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				for (auto i = lo; i < hi; ++i) {
+					result[i] = __stl2::invoke(op, __stl2::invoke(proj, first[i]));
+				}
+			});
+		return {first + n, result + n};
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, RandomAccessIterator O,
+		CopyConstructible F, class Proj = identity>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		Writable<O, indirect_result_of_t<F&(projected<iterator_t<Rng>, Proj>)>>()
+	tagged_pair<tag::in(safe_iterator_t<Rng>), tag::out(O)>
+	transform(EP&& policy, Rng&& rng, O result, F op, Proj proj = Proj{}) {
+		return __stl2::transform(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::move(result), std::ref(op), std::ref(proj));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		class Proj = identity, IndirectPredicate<projected<I, Proj>> Pred>
+	I find_if(EP&& policy, I first, S last, Pred pred, Proj proj = Proj{}) {
+		auto const n = last - first;
+		std::atomic<std::ptrdiff_t> found{n};
+		__execution::for_each_block(policy, __parallel::partition<I>(n, first),
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				for (auto i = lo; i < hi; ++i) {
+					if (i >= found.load(std::memory_order_relaxed)) {
+						return;
+					}
+					if (__stl2::invoke(pred, __stl2::invoke(proj, first[i]))) {
+						auto f = found.load(std::memory_order_relaxed);
+						while (i < f && !found.compare_exchange_weak(f, i,
+							std::memory_order_relaxed)) {}
+						return;
+					}
+				}
+			});
+		return first + found.load(std::memory_order_relaxed);
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, class Proj = identity,
+		IndirectPredicate<projected<iterator_t<Rng>, Proj>> Pred>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>()
+	safe_iterator_t<Rng> find_if(EP&& policy, Rng&& rng, Pred pred, Proj proj = Proj{}) {
+		return __stl2::find_if(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::ref(pred), std::ref(proj));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		class T, class Proj = identity>
+	requires
+		IndirectRelation<equal_to<>, projected<I, Proj>, const T*>()
+	I find(EP&& policy, I first, S last, const T& value, Proj proj = Proj{}) {
+		return __stl2::find_if(policy, std::move(first), std::move(last),
+			[&value](auto&& t) { return t == value; }, std::ref(proj));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, class T, class Proj = identity>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		IndirectRelation<equal_to<>, projected<iterator_t<Rng>, Proj>, const T*>()
+	safe_iterator_t<Rng> find(EP&& policy, Rng&& rng, const T& value, Proj proj = Proj{}) {
+		return __stl2::find(policy, __stl2::begin(rng), __stl2::end(rng), value, std::ref(proj));
+	}
+
+	// Extension
+	// Requires: op is associative.
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		CopyConstructible T, class Op, IndirectUnaryInvocable<I> F>
+	requires
+		CopyConstructible<Op>() && CopyConstructible<F>()
+	T transform_reduce(EP&& policy, I first, S last, T init, Op op, F f) {
+		auto const n = last - first;
+		auto const part = __parallel::partition<I>(n, first);
+		std::unique_ptr<std::optional<T>[]> partial{new std::optional<T>[part.count()]};
+		__execution::for_each_block(policy, part,
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				T acc = __stl2::invoke(f, first[lo]);
+				for (auto i = lo + 1; i < hi; ++i) {
+					acc = __stl2::invoke(op, std::move(acc), __stl2::invoke(f, first[i]));
+				}
+				partial[part.index(lo)].emplace(std::move(acc));
+			});
+		for (auto b = std::ptrdiff_t{0}; b < part.count(); ++b) {
+			init = __stl2::invoke(op, std::move(init), std::move(*partial[b]));
+		}
+		return init;
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, CopyConstructible T,
+		class Op, IndirectUnaryInvocable<iterator_t<Rng>> F>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		CopyConstructible<Op>() && CopyConstructible<F>()
+	T transform_reduce(EP&& policy, Rng&& rng, T init, Op op, F f) {
+		return __stl2::transform_reduce(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::move(init), std::ref(op), std::ref(f));
+	}
+
+	// Extension
+	// Requires: op is associative.
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		CopyConstructible T, class Op = std::plus<>>
+	requires
+		CopyConstructible<Op>()
+	T reduce(EP&& policy, I first, S last, T init, Op op = Op{}) {
+		return __stl2::transform_reduce(policy, std::move(first), std::move(last),
+			std::move(init), std::ref(op), identity{});
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, CopyConstructible T,
+		class Op = std::plus<>>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		CopyConstructible<Op>()
+	T reduce(EP&& policy, Rng&& rng, T init, Op op = Op{}) {
+		return __stl2::reduce(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::move(init), std::ref(op));
+	}
+
+	// Extension
+	// Requires: op is associative. result may equal first.
+	//
+	// Two passes over the blocks: the first totals each block, the
+	// second scans each block starting from the total of those before it.
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		RandomAccessIterator O, class Op = std::plus<>>
+	requires
+		CopyConstructible<Op>() &&
+		Writable<O, const value_type_t<I>&>()
+	tagged_pair<tag::in(I), tag::out(O)>
+	inclusive_scan(EP&& policy, I first, S last, O result, Op op = Op{}) {
+		using T = value_type_t<I>;
+		auto const n = last - first;
+		auto const part = __parallel::partition<I>(n, result);
+		std::unique_ptr<std::optional<T>[]> carry{new std::optional<T>[part.count()]};
+		__execution::for_each_block(policy, part,
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				T acc = first[lo];
+				for (auto i = lo + 1; i < hi; ++i) {
+					acc = __stl2::invoke(op, std::move(acc), first[i]);
+				}
+				carry[part.index(lo)].emplace(std::move(acc));
+			});
+		std::optional<T> total;
+		for (auto b = std::ptrdiff_t{0}; b < part.count(); ++b) {
+			auto next = total ? __stl2::invoke(op, *total, std::move(*carry[b])) : std::move(*carry[b]);
+			carry[b] = std::move(total);
+			total.emplace(std::move(next));
+		}
+		__execution::for_each_block(policy, part,
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				auto& c = carry[part.index(lo)];
+				T acc = c ? __stl2::invoke(op, std::move(*c), first[lo]) : T(first[lo]);
+				result[lo] = acc;
+				for (auto i = lo + 1; i < hi; ++i) {
+					acc = __stl2::invoke(op, std::move(acc), first[i]);
+					result[i] = acc;
+				}
+			});
+		return {first + n, result + n};
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, RandomAccessIterator O,
+		class Op = std::plus<>>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		CopyConstructible<Op>() &&
+		Writable<O, const value_type_t<iterator_t<Rng>>&>()
+	tagged_pair<tag::in(safe_iterator_t<Rng>), tag::out(O)>
+	inclusive_scan(EP&& policy, Rng&& rng, O result, Op op = Op{}) {
+		return __stl2::inclusive_scan(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::move(result), std::ref(op));
+	}
+
+	// Extension
+	// Requires: op is associative. result may equal first.
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		RandomAccessIterator O, CopyConstructible T, class Op = std::plus<>>
+	requires
+		CopyConstructible<Op>() &&
+		Writable<O, const T&>()
+	tagged_pair<tag::in(I), tag::out(O)>
+	exclusive_scan(EP&& policy, I first, S last, O result, T init, Op op = Op{}) {
+		auto const n = last - first;
+		auto const part = __parallel::partition<I>(n, result);
+		std::unique_ptr<std::optional<T>[]> carry{new std::optional<T>[part.count()]};
+		__execution::for_each_block(policy, part,
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				T acc = first[lo];
+				for (auto i = lo + 1; i < hi; ++i) {
+					acc = __stl2::invoke(op, std::move(acc), first[i]);
+				}
+				carry[part.index(lo)].emplace(std::move(acc));
+			});
+		for (auto b = std::ptrdiff_t{0}; b < part.count(); ++b) {
+			auto next = __stl2::invoke(op, init, std::move(*carry[b]));
+			carry[b].emplace(std::move(init));
+			init = std::move(next);
+		}
+		__execution::for_each_block(policy, part,
+			[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+				T acc = std::move(*carry[part.index(lo)]);
+				for (auto i = lo; i < hi; ++i) {
+					T next = __stl2::invoke(op, acc, first[i]);
+					result[i] = std::move(acc);
+					acc = std::move(next);
+				}
+			});
+		return {first + n, result + n};
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, RandomAccessIterator O,
+		CopyConstructible T, class Op = std::plus<>>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		CopyConstructible<Op>() &&
+		Writable<O, const T&>()
+	tagged_pair<tag::in(safe_iterator_t<Rng>), tag::out(O)>
+	exclusive_scan(EP&& policy, Rng&& rng, O result, T init, Op op = Op{}) {
+		return __stl2::exclusive_scan(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::move(result), std::move(init), std::ref(op));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		class Comp = less<>, class Proj = identity>
+	requires
+		Sortable<I, Comp, Proj>()
+	I sort(EP&& policy, I first, S last, Comp comp = Comp{}, Proj proj = Proj{}) {
+		auto const n = last - first;
+		__parallel::sort(policy, first, n, comp, proj, [&](I lo, I hi) {
+			__stl2::sort(lo, hi, std::ref(comp), std::ref(proj));
+		});
+		return first + n;
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, class Comp = less<>,
+		class Proj = identity>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		Sortable<iterator_t<Rng>, Comp, Proj>()
+	safe_iterator_t<Rng> sort(EP&& policy, Rng&& rng, Comp comp = Comp{}, Proj proj = Proj{}) {
+		return __stl2::sort(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::ref(comp), std::ref(proj));
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessIterator I, SizedSentinel<I> S,
+		class Comp = less<>, class Proj = identity>
+	requires
+		Sortable<I, Comp, Proj>()
+	I stable_sort(EP&& policy, I first, S last, Comp comp = Comp{}, Proj proj = Proj{}) {
+		auto const n = last - first;
+		__parallel::sort(policy, first, n, comp, proj, [&](I lo, I hi) {
+			__stl2::stable_sort(lo, hi, std::ref(comp), std::ref(proj));
+		});
+		return first + n;
+	}
+
+	// Extension
+	template <ExecutionPolicy EP, RandomAccessRange Rng, class Comp = less<>,
+		class Proj = identity>
+	requires
+		SizedSentinel<sentinel_t<Rng>, iterator_t<Rng>>() &&
+		Sortable<iterator_t<Rng>, Comp, Proj>()
+	safe_iterator_t<Rng> stable_sort(EP&& policy, Rng&& rng, Comp comp = Comp{}, Proj proj = Proj{}) {
+		return __stl2::stable_sort(policy, __stl2::begin(rng), __stl2::end(rng),
+			std::ref(comp), std::ref(proj));
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
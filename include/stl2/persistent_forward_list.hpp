@@ -0,0 +1,313 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_PERSISTENT_FORWARD_LIST_HPP
+#define STL2_PERSISTENT_FORWARD_LIST_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __pfl {
+		// Like __fl::node, but shared: a node is reachable from every
+		// version whose head is at or before it, and is freed when the
+		// last of them lets go. next_ never changes once the node is
+		// published.
+		template <class T, PointerTo<void> VoidPointer>
+		struct node {
+			using pointer = rebind_pointer_t<VoidPointer, node>;
+
+			node() = default;
+			node(const node&) = delete;
+			node& operator=(const node&) & = delete;
+
+			const T& get() const& noexcept { return reinterpret_cast<const T&>(storage_); }
+			T* storage() noexcept { return reinterpret_cast<T*>(std::addressof(storage_)); }
+
+			std::atomic<long> refs_{1};
+			pointer next_ = nullptr;
+			aligned_storage_t<sizeof(T), alignof(T)> storage_;
+		};
+
+		template <class T, PointerTo<void> VoidPointer>
+		struct cursor {
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using node_pointer = typename node<T, VoidPointer>::pointer;
+
+			cursor() = default;
+			constexpr cursor(default_sentinel) noexcept
+			: pos_{nullptr} {}
+			explicit constexpr cursor(node_pointer pos) noexcept
+			: pos_{std::move(pos)} {}
+
+			const T& read() const noexcept {
+				STL2_EXPECT(pos_);
+				return pos_->get();
+			}
+			void next() noexcept {
+				STL2_EXPECT(pos_);
+				pos_ = pos_->next_;
+			}
+			constexpr bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+			constexpr bool done() const noexcept {
+				return pos_ == nullptr;
+			}
+		private:
+			node_pointer pos_;
+		};
+	}
+
+	// An immutable singly linked list whose versions share their tails.
+	// Copying, push_front, and pop_front are all O(1): push_front links
+	// one new node in front of the (shared) old head, and pop_front
+	// moves the head along without touching the rest. Node lifetimes are
+	// reference counted with atomic counts, so a version can be handed
+	// to another thread as a lock-free snapshot; copies of allocator_type
+	// must be able to free each other's nodes from any thread.
+	template <class T, ProtoAllocator A = std::allocator<T>>
+	requires
+		ProtoAllocator<A, __pfl::node<T, proto_allocator_pointer_t<A>>>()
+	class persistent_forward_list : detail::ebo_box<A> {
+		using node_t = __pfl::node<T, proto_allocator_pointer_t<A>>;
+		using node_allocator_type = rebind_allocator_t<A, node_t>;
+		using node_pointer = allocator_pointer_t<node_allocator_type>;
+		using traits = std::allocator_traits<node_allocator_type>;
+		using cursor = __pfl::cursor<T, proto_allocator_pointer_t<A>>;
+
+	public:
+		using value_type = T;
+		using allocator_type = A;
+		using iterator = __stl2::basic_iterator<cursor>;
+		using const_iterator = iterator;
+
+		~persistent_forward_list()
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorDestructible<node_allocator_type, T>()
+		{ clear(); }
+
+		persistent_forward_list()
+		requires
+			DefaultConstructible<A>() = default;
+
+		constexpr explicit persistent_forward_list(allocator_type a) noexcept
+		: detail::ebo_box<A>(std::move(a)) {}
+
+		// O(1): the copy shares every node, and the allocator, with that.
+		persistent_forward_list(const persistent_forward_list& that) noexcept
+		: detail::ebo_box<A>{that.alloc()}
+		, head_{retain(that.head_)} {}
+
+		persistent_forward_list(persistent_forward_list&& that) noexcept
+		: detail::ebo_box<A>{std::move(that.alloc())}
+		, head_{__stl2::exchange(that.head_, nullptr)} {}
+
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorConstructible<node_allocator_type, T, reference_t<I>>()
+		persistent_forward_list(I first, S last, allocator_type a)
+		: persistent_forward_list{std::move(a)}
+		{
+			// The new nodes are not shared yet, so they can be linked in
+			// order.
+			auto pos = std::addressof(head_);
+			for (; first != last; ++first) {
+				*pos = make_node(*first);
+				pos = std::addressof((*pos)->next_);
+			}
+		}
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			DefaultConstructible<A>() &&
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorConstructible<node_allocator_type, T, reference_t<I>>()
+		persistent_forward_list(I first, S last)
+		: persistent_forward_list{std::move(first), std::move(last), allocator_type{}}
+		{}
+
+		persistent_forward_list(std::initializer_list<T> il)
+		requires
+			DefaultConstructible<A>() &&
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorCopyConstructible<node_allocator_type, T>()
+		: persistent_forward_list{il.begin(), il.end()}
+		{}
+
+		persistent_forward_list& operator=(const persistent_forward_list& that) &
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorDestructible<node_allocator_type, T>()
+		{
+			if (std::addressof(that) != this) {
+				auto head = retain(that.head_);
+				clear();
+				alloc() = that.alloc();
+				head_ = std::move(head);
+			}
+			return *this;
+		}
+		persistent_forward_list& operator=(persistent_forward_list&& that) &
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorDestructible<node_allocator_type, T>()
+		{
+			if (std::addressof(that) != this) {
+				clear();
+				alloc() = std::move(that.alloc());
+				head_ = __stl2::exchange(that.head_, nullptr);
+			}
+			return *this;
+		}
+
+		void swap(persistent_forward_list& that)
+		noexcept(is_nothrow_swappable<A&, A&>::value)
+		{
+			ranges::swap(alloc(), that.alloc());
+			ranges::swap(head_, that.head_);
+		}
+		friend void swap(persistent_forward_list& lhs, persistent_forward_list& rhs)
+		noexcept(noexcept(lhs.swap(rhs)))
+		{
+			lhs.swap(rhs);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return alloc();
+		}
+
+		iterator begin() const noexcept { return cursor{head_}; }
+		default_sentinel end() const noexcept { return {}; }
+		iterator cbegin() const noexcept { return begin(); }
+		default_sentinel cend() const noexcept { return {}; }
+
+		bool empty() const noexcept { return !head_; }
+
+		const T& front() const noexcept {
+			STL2_EXPECT(head_);
+			return head_->get();
+		}
+
+		template <class...Args>
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorConstructible<node_allocator_type, T, Args...>()
+		const T& emplace_front(Args&&...args) {
+			auto n = make_node(__stl2::forward<Args>(args)...);
+			n->next_ = std::move(head_);
+			head_ = std::move(n);
+			return head_->get();
+		}
+
+		void push_front(const T& t)
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorCopyConstructible<node_allocator_type, T>()
+		{
+			emplace_front(t);
+		}
+		void push_front(T&& t)
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorMoveConstructible<node_allocator_type, T>()
+		{
+			emplace_front(std::move(t));
+		}
+
+		void pop_front() noexcept
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorDestructible<node_allocator_type, T>()
+		{
+			STL2_EXPECT(head_);
+			node_pointer old = head_;
+			head_ = retain(old->next_);
+			release(std::move(old));
+		}
+
+		void clear() noexcept
+		requires
+			Allocator<node_allocator_type, node_t>() &&
+			AllocatorDestructible<node_allocator_type, T>()
+		{
+			release(__stl2::exchange(head_, nullptr));
+		}
+
+		// Extension
+		// Linear in the length of this version. Nodes shared with other
+		// versions are counted in full by each; a node's overhead is its
+		// reference count, link, and any padding.
+		memory_stats memory_usage() const noexcept {
+			auto const alloc = node_allocator_type{this->alloc()};
+			memory_stats s;
+			for (auto p = head_; p; p = p->next_) {
+				s.payload += sizeof(T);
+				s.overhead += sizeof(node_t) - sizeof(T);
+				__memory_stats::allocation(s, alloc, 1);
+			}
+			return s;
+		}
+
+	private:
+		node_pointer head_ = nullptr;
+
+		A& alloc() noexcept { return detail::ebo_box<A>::get(); }
+		const A& alloc() const noexcept { return detail::ebo_box<A>::get(); }
+
+		static node_pointer retain(node_pointer p) noexcept {
+			if (p) {
+				p->refs_.fetch_add(1, std::memory_order_relaxed);
+			}
+			return p;
+		}
+
+		template <class...Args>
+		node_pointer make_node(Args&&...args) {
+			auto alloc = node_allocator_type{this->alloc()};
+			Same<node_pointer> n = traits::allocate(alloc, 1);
+			traits::construct(alloc, std::addressof(*n));
+			try {
+				traits::construct(alloc, n->storage(), __stl2::forward<Args>(args)...);
+			} catch(...) {
+				traits::destroy(alloc, std::addressof(*n));
+				traits::deallocate(alloc, n, 1);
+				throw;
+			}
+			return n;
+		}
+
+		// Drops a reference to p, and so on down the list for as long as
+		// that was the last reference.
+		void release(node_pointer p) noexcept {
+			auto alloc = node_allocator_type{this->alloc()};
+			while (p && p->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				node_pointer next = std::move(p->next_);
+				traits::destroy(alloc, p->storage());
+				traits::destroy(alloc, std::addressof(*p));
+				traits::deallocate(alloc, p, 1);
+				p = std::move(next);
+			}
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
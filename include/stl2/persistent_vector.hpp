@@ -0,0 +1,608 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_PERSISTENT_VECTOR_HPP
+#define STL2_PERSISTENT_VECTOR_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __pvec {
+		constexpr int bits = 5;
+		constexpr std::ptrdiff_t width = std::ptrdiff_t{1} << bits;
+		constexpr std::ptrdiff_t mask = width - 1;
+		constexpr int max_depth = (64 + bits - 1) / bits;
+
+		// Nodes are shared between versions and freed by whichever
+		// version drops the last reference.
+		struct node {
+			std::atomic<long> refs{1};
+		};
+
+		struct inner : node {
+			node* child[width] = {};
+		};
+
+		template <class T>
+		struct leaf : node {
+			std::ptrdiff_t count = 0;
+			aligned_storage_t<sizeof(T), alignof(T)> slots[width];
+
+			T* data() noexcept { return reinterpret_cast<T*>(slots); }
+			const T* data() const noexcept { return reinterpret_cast<const T*>(slots); }
+		};
+
+		inline node* retain(node* n) noexcept {
+			if (n) {
+				n->refs.fetch_add(1, std::memory_order_relaxed);
+			}
+			return n;
+		}
+
+		inline bool unique(const node* n) noexcept {
+			return n->refs.load(std::memory_order_acquire) == 1;
+		}
+
+		// Caches the leaf holding the current element, so that stepping
+		// through a block of width elements walks the trie only once.
+		template <class PV>
+		class cursor {
+			const PV* vec_ = nullptr;
+			const typename PV::value_type* block_ = nullptr;
+			std::ptrdiff_t pos_ = 0;
+
+			void seek(std::ptrdiff_t pos) noexcept {
+				pos_ = pos;
+				block_ = 0 <= pos && pos < vec_->size() ? vec_->block(pos) : nullptr;
+			}
+
+		public:
+			using value_type = typename PV::value_type;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			cursor(const PV& vec, difference_type pos) noexcept
+			: vec_{std::addressof(vec)} { seek(pos); }
+
+			const value_type& read() const noexcept {
+				STL2_EXPECT(block_);
+				return block_[pos_ & mask];
+			}
+			void next() noexcept {
+				if ((++pos_ & mask) == 0) {
+					seek(pos_);
+				}
+			}
+			void prev() noexcept {
+				// end() has no block to step back within.
+				if (!block_ || (pos_ & mask) == 0) {
+					seek(pos_ - 1);
+				} else {
+					--pos_;
+				}
+			}
+			void advance(difference_type n) noexcept { seek(pos_ + n); }
+			difference_type distance_to(const cursor& that) const noexcept {
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+		};
+	}
+
+	// A vector with value semantics and O(1) copy: elements live in the
+	// leaves of a 32-way trie plus a separate tail leaf, and copies share
+	// every node. Indexed access walks log32(size()) nodes. Updates copy
+	// only the nodes on the path to the element that are shared with
+	// another copy; nodes this object owns alone are updated in place, so
+	// a batch of updates after taking a snapshot copies each path at most
+	// once and then runs like a plain (transient) vector.
+	//
+	// Snapshots are meant to be handed to readers on other threads: the
+	// reference counts are atomic, and elements are only ever mutated in
+	// nodes no other copy can see. Copies of allocator_type must be able
+	// to free each other's memory from any thread. A single
+	// persistent_vector object is not itself safe to read and write
+	// concurrently; take the snapshot on the writing thread.
+	template <class T, ProtoAllocator<T> PA = std::allocator<T>>
+	requires
+		ProtoAllocator<PA, __pvec::inner>() &&
+		ProtoAllocator<PA, __pvec::leaf<T>>()
+	class persistent_vector : detail::ebo_box<rebind_allocator_t<PA, T>> {
+		using base_t = detail::ebo_box<rebind_allocator_t<PA, T>>;
+		using traits = std::allocator_traits<rebind_allocator_t<PA, T>>;
+		using node = __pvec::node;
+		using inner = __pvec::inner;
+		using leaf = __pvec::leaf<T>;
+		using inner_allocator = rebind_allocator_t<PA, inner>;
+		using inner_traits = std::allocator_traits<inner_allocator>;
+		using leaf_allocator = rebind_allocator_t<PA, leaf>;
+		using leaf_traits = std::allocator_traits<leaf_allocator>;
+
+		friend __pvec::cursor<persistent_vector>;
+
+	public:
+		using value_type = T;
+		using allocator_type = rebind_allocator_t<PA, T>;
+		using size_type = std::ptrdiff_t;
+		using reference = const T&;
+		using const_reference = const T&;
+		using iterator = __stl2::basic_iterator<__pvec::cursor<persistent_vector>>;
+		using const_iterator = iterator;
+
+		~persistent_vector()
+			requires Allocator<allocator_type, T>() &&
+				AllocatorDestructible<allocator_type, T>()
+		{
+			clear();
+		}
+
+		persistent_vector()
+			noexcept(is_nothrow_default_constructible<allocator_type>::value)
+			requires DefaultConstructible<allocator_type>() = default;
+
+		explicit persistent_vector(allocator_type a) noexcept
+		: base_t{std::move(a)}
+		{}
+
+		// O(1). The copy shares every node, and the allocator, with that.
+		persistent_vector(const persistent_vector& that) noexcept
+		: base_t{that.alloc()},
+			root_{__pvec::retain(that.root_)},
+			tail_{static_cast<leaf*>(__pvec::retain(that.tail_))},
+			size_{that.size_}, shift_{that.shift_}
+		{}
+
+		persistent_vector(persistent_vector&& that) noexcept
+		: base_t{std::move(that.alloc())},
+			root_{__stl2::exchange(that.root_, nullptr)},
+			tail_{__stl2::exchange(that.tail_, nullptr)},
+			size_{__stl2::exchange(that.size_, 0)},
+			shift_{__stl2::exchange(that.shift_, __pvec::bits)}
+		{}
+
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			Allocator<allocator_type, T>() &&
+			AllocatorConstructible<allocator_type, T, reference_t<I>>() &&
+			AllocatorCopyConstructible<allocator_type, T>()
+		persistent_vector(I first, S last, allocator_type a)
+		: persistent_vector{std::move(a)}
+		{
+			for (; first != last; ++first) {
+				emplace_back(*first);
+			}
+		}
+
+		template <InputIterator I, Sentinel<I> S>
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, T>() &&
+			AllocatorConstructible<allocator_type, T, reference_t<I>>() &&
+			AllocatorCopyConstructible<allocator_type, T>()
+		persistent_vector(I first, S last)
+		: persistent_vector{std::move(first), std::move(last), allocator_type{}}
+		{}
+
+		persistent_vector(std::initializer_list<T> il)
+			requires DefaultConstructible<allocator_type>() &&
+				Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		: persistent_vector{il.begin(), il.end()}
+		{}
+
+		// O(1), plus the cost of freeing whatever only *this referenced.
+		persistent_vector& operator=(const persistent_vector& that) &
+			requires Allocator<allocator_type, T>() &&
+				AllocatorDestructible<allocator_type, T>()
+		{
+			if (this != &that) {
+				auto root = __pvec::retain(that.root_);
+				auto tail = __pvec::retain(that.tail_);
+				clear();
+				alloc() = that.alloc();
+				root_ = root;
+				tail_ = static_cast<leaf*>(tail);
+				size_ = that.size_;
+				shift_ = that.shift_;
+			}
+			return *this;
+		}
+
+		persistent_vector& operator=(persistent_vector&& that) &
+			requires Allocator<allocator_type, T>() &&
+				AllocatorDestructible<allocator_type, T>()
+		{
+			if (this != &that) {
+				clear();
+				alloc() = std::move(that.alloc());
+				root_ = __stl2::exchange(that.root_, nullptr);
+				tail_ = __stl2::exchange(that.tail_, nullptr);
+				size_ = __stl2::exchange(that.size_, 0);
+				shift_ = __stl2::exchange(that.shift_, __pvec::bits);
+			}
+			return *this;
+		}
+
+		void swap(persistent_vector& that)
+			noexcept(is_nothrow_swappable<allocator_type&, allocator_type&>::value)
+		{
+			ranges::swap(alloc(), that.alloc());
+			ranges::swap(root_, that.root_);
+			ranges::swap(tail_, that.tail_);
+			ranges::swap(size_, that.size_);
+			ranges::swap(shift_, that.shift_);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return alloc();
+		}
+
+		iterator begin() const noexcept { return __pvec::cursor<persistent_vector>{*this, 0}; }
+		iterator end() const noexcept { return __pvec::cursor<persistent_vector>{*this, size_}; }
+		iterator cbegin() const noexcept { return begin(); }
+		iterator cend() const noexcept { return end(); }
+
+		size_type size() const noexcept { return size_; }
+		bool empty() const noexcept { return size_ == 0; }
+
+		// Extension
+		// Linear in the number of nodes. Nodes shared with other versions
+		// are counted in full by each version that reaches them.
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			usage_(s, root_, shift_);
+			usage_(s, tail_, 0);
+			return s;
+		}
+
+		const T& operator[](size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return block(i)[i & __pvec::mask];
+		}
+
+		const T& front() const noexcept { return (*this)[0]; }
+		const T& back() const noexcept { return (*this)[size_ - 1]; }
+
+		void clear() noexcept
+			requires AllocatorDestructible<allocator_type, T>()
+		{
+			release(root_, shift_);
+			release(tail_, 0);
+			root_ = nullptr;
+			tail_ = nullptr;
+			size_ = 0;
+			shift_ = __pvec::bits;
+		}
+
+		// Replaces the i-th element. Copies of *this are unaffected.
+		void set(size_type i, const T& t)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>() &&
+				Copyable<T>()
+		{
+			STL2_EXPECT(0 <= i && i < size_);
+			*mutable_slot(i) = t;
+		}
+		void set(size_type i, T&& t)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>() &&
+				Copyable<T>()
+		{
+			STL2_EXPECT(0 <= i && i < size_);
+			*mutable_slot(i) = std::move(t);
+		}
+
+		template <class...Args>
+		requires
+			Allocator<allocator_type, T>() &&
+			AllocatorConstructible<allocator_type, T, Args...>() &&
+			AllocatorCopyConstructible<allocator_type, T>()
+		void emplace_back(Args&&...args) {
+			if (tail_ && tail_->count < __pvec::width) {
+				tail_ = static_cast<leaf*>(own(tail_, 0));
+				construct(*tail_, __stl2::forward<Args>(args)...);
+			} else {
+				auto const t = new_leaf();
+				try {
+					construct(*t, __stl2::forward<Args>(args)...);
+					if (tail_) {
+						push_tail();
+					}
+				} catch(...) {
+					destroy_leaf(t);
+					throw;
+				}
+				tail_ = t;
+			}
+			++size_;
+		}
+
+		void push_back(const T& t)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		{
+			emplace_back(t);
+		}
+		void push_back(T&& t)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorMoveConstructible<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		{
+			emplace_back(std::move(t));
+		}
+
+		void pop_back()
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		{
+			STL2_EXPECT(size_ > 0);
+			if (tail_->count > 1) {
+				tail_ = static_cast<leaf*>(own(tail_, 0));
+				traits::destroy(alloc(), tail_->data() + --tail_->count);
+			} else if (size_ == 1) {
+				release(tail_, 0);
+				tail_ = nullptr;
+			} else {
+				pop_tail();
+			}
+			--size_;
+		}
+
+	private:
+		node* root_ = nullptr;
+		leaf* tail_ = nullptr;
+		size_type size_ = 0;
+		int shift_ = __pvec::bits;
+
+		allocator_type& alloc() noexcept { return base_t::get(); }
+		const allocator_type& alloc() const noexcept { return base_t::get(); }
+
+		static inner* as_inner(node* n) noexcept { return static_cast<inner*>(n); }
+
+		void usage_(memory_stats& s, const node* n, int level) const noexcept {
+			if (!n) {
+				return;
+			}
+			if (level == 0) {
+				auto const l = static_cast<const leaf*>(n);
+				s.payload += __memory_stats::bytes<T>(l->count);
+				s.slack += __memory_stats::bytes<T>(__pvec::width - l->count);
+				s.overhead += sizeof(leaf) - __memory_stats::bytes<T>(__pvec::width);
+				__memory_stats::allocation(s, leaf_allocator{alloc()}, 1);
+			} else {
+				s.overhead += sizeof(inner);
+				__memory_stats::allocation(s, inner_allocator{alloc()}, 1);
+				for (auto c : static_cast<const inner*>(n)->child) {
+					usage_(s, c, level - __pvec::bits);
+				}
+			}
+		}
+
+		size_type tail_offset() const noexcept {
+			return size_ < __pvec::width ? 0 : ((size_ - 1) >> __pvec::bits) << __pvec::bits;
+		}
+
+		// The elements of the leaf that holds element i.
+		const T* block(size_type i) const noexcept {
+			if (i >= tail_offset()) {
+				return tail_->data();
+			}
+			auto n = root_;
+			for (auto level = shift_; level > 0; level -= __pvec::bits) {
+				n = as_inner(n)->child[(i >> level) & __pvec::mask];
+			}
+			return static_cast<leaf*>(n)->data();
+		}
+
+		inner* new_inner() {
+			auto a = inner_allocator{alloc()};
+			auto const p = std::addressof(*inner_traits::allocate(a, 1));
+			inner_traits::construct(a, p);
+			return p;
+		}
+		void delete_inner(inner* p) noexcept {
+			auto a = inner_allocator{alloc()};
+			inner_traits::destroy(a, p);
+			inner_traits::deallocate(a,
+				std::pointer_traits<typename inner_traits::pointer>::pointer_to(*p), 1);
+		}
+
+		leaf* new_leaf() {
+			auto a = leaf_allocator{alloc()};
+			auto const p = std::addressof(*leaf_traits::allocate(a, 1));
+			leaf_traits::construct(a, p);
+			return p;
+		}
+		void destroy_leaf(leaf* p) noexcept {
+			while (p->count > 0) {
+				traits::destroy(alloc(), p->data() + --p->count);
+			}
+			auto a = leaf_allocator{alloc()};
+			leaf_traits::destroy(a, p);
+			leaf_traits::deallocate(a,
+				std::pointer_traits<typename leaf_traits::pointer>::pointer_to(*p), 1);
+		}
+
+		template <class...Args>
+		void construct(leaf& l, Args&&...args) {
+			STL2_EXPECT(l.count < __pvec::width);
+			traits::construct(alloc(), l.data() + l.count, __stl2::forward<Args>(args)...);
+			++l.count;
+		}
+
+		// Drops a reference to n, the root of a subtree whose leaves are
+		// level bits below it.
+		void release(node* n, int level) noexcept {
+			if (!n || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+				return;
+			}
+			if (level == 0) {
+				destroy_leaf(static_cast<leaf*>(n));
+			} else {
+				for (auto c : as_inner(n)->child) {
+					release(c, level - __pvec::bits);
+				}
+				delete_inner(as_inner(n));
+			}
+		}
+
+		// Returns n if *this is its only owner, and otherwise trades
+		// this reference to n for a reference to a fresh copy.
+		node* own(node* n, int level) {
+			if (__pvec::unique(n)) {
+				return n;
+			}
+			node* copy;
+			if (level == 0) {
+				auto const from = static_cast<leaf*>(n);
+				auto const to = new_leaf();
+				try {
+					while (to->count < from->count) {
+						construct(*to, from->data()[to->count]);
+					}
+				} catch(...) {
+					destroy_leaf(to);
+					throw;
+				}
+				copy = to;
+			} else {
+				auto const to = new_inner();
+				for (auto k = 0; k < __pvec::width; ++k) {
+					to->child[k] = __pvec::retain(as_inner(n)->child[k]);
+				}
+				copy = to;
+			}
+			release(n, level);
+			return copy;
+		}
+
+		// Returns a chain of new inner nodes, level bits tall, that leads
+		// to l.
+		node* new_path(int level, node* l) {
+			if (level == 0) {
+				return l;
+			}
+			auto const n = new_inner();
+			try {
+				n->child[0] = new_path(level - __pvec::bits, l);
+			} catch(...) {
+				delete_inner(n);
+				throw;
+			}
+			return n;
+		}
+
+		T* mutable_slot(size_type i) {
+			if (i >= tail_offset()) {
+				tail_ = static_cast<leaf*>(own(tail_, 0));
+				return tail_->data() + (i & __pvec::mask);
+			}
+			auto n = root_ = own(root_, shift_);
+			for (auto level = shift_; level > 0; level -= __pvec::bits) {
+				auto& c = as_inner(n)->child[(i >> level) & __pvec::mask];
+				n = c = own(c, level - __pvec::bits);
+			}
+			return static_cast<leaf*>(n)->data() + (i & __pvec::mask);
+		}
+
+		// Moves the full tail into the trie as the leaf for elements
+		// [size_ - width, size_).
+		void push_tail() {
+			STL2_EXPECT(tail_->count == __pvec::width);
+			auto const i = size_ - __pvec::width;
+			if (!root_) {
+				auto const r = new_inner();
+				r->child[0] = tail_;
+				root_ = r;
+				return;
+			}
+			if ((i >> __pvec::bits) >= (size_type{1} << shift_)) {
+				auto const r = new_inner();
+				try {
+					r->child[1] = new_path(shift_, tail_);
+				} catch(...) {
+					delete_inner(r);
+					throw;
+				}
+				r->child[0] = root_;
+				root_ = r;
+				shift_ += __pvec::bits;
+				return;
+			}
+			auto n = root_ = own(root_, shift_);
+			for (auto level = shift_; level > __pvec::bits; level -= __pvec::bits) {
+				auto& c = as_inner(n)->child[(i >> level) & __pvec::mask];
+				if (!c) {
+					c = new_path(level - __pvec::bits, tail_);
+					return;
+				}
+				n = c = own(c, level - __pvec::bits);
+			}
+			as_inner(n)->child[(i >> __pvec::bits) & __pvec::mask] = tail_;
+		}
+
+		// Replaces the single-element tail with the trie's last leaf.
+		void pop_tail() {
+			STL2_EXPECT(tail_->count == 1 && root_);
+			auto const i = size_ - 2;
+			node* path[__pvec::max_depth];
+			auto depth = 0;
+			leaf* last = nullptr;
+			auto n = root_ = own(root_, shift_);
+			for (auto level = shift_;; level -= __pvec::bits) {
+				path[depth++] = n;
+				auto& c = as_inner(n)->child[(i >> level) & __pvec::mask];
+				if (level == __pvec::bits) {
+					last = static_cast<leaf*>(__stl2::exchange(c, nullptr));
+					break;
+				}
+				n = c = own(c, level - __pvec::bits);
+			}
+			// Free the inner nodes that held nothing but the last leaf.
+			for (auto k = depth - 1; k >= 0; --k) {
+				auto const level = shift_ - k * __pvec::bits;
+				if (((i >> __pvec::bits) & ((size_type{1} << level) - 1)) != 0) {
+					break;
+				}
+				release(path[k], level);
+				if (k == 0) {
+					root_ = nullptr;
+				} else {
+					as_inner(path[k - 1])->child[(i >> (level + __pvec::bits)) & __pvec::mask] = nullptr;
+				}
+			}
+			if (!root_) {
+				shift_ = __pvec::bits;
+			} else if (shift_ > __pvec::bits && !as_inner(root_)->child[1]) {
+				auto const r = as_inner(root_);
+				root_ = __stl2::exchange(r->child[0], nullptr);
+				delete_inner(r);
+				shift_ -= __pvec::bits;
+			}
+			release(tail_, 0);
+			tail_ = last;
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,527 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_RING_BUFFER_HPP
+#define STL2_RING_BUFFER_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+STL2_OPEN_NAMESPACE {
+	namespace __ring_buffer {
+		// Assumed destructive interference size; indices written by
+		// different threads are kept this far apart.
+		constexpr std::size_t cache_line = 64;
+
+		constexpr std::size_t round_up_pow2(std::size_t n) noexcept {
+			std::size_t result = 1;
+			while (result < n) {
+				result *= 2;
+			}
+			return result;
+		}
+
+		template <class T, class...Args>
+		concept bool NothrowConstructible =
+			std::is_nothrow_constructible<T, Args...>::value;
+
+		template <class T>
+		struct cell {
+			std::atomic<std::size_t> seq_;
+			aligned_storage_t<sizeof(T), alignof(T)> storage_;
+
+			T& get() & noexcept { return reinterpret_cast<T&>(storage_); }
+		};
+	}
+
+	// A bounded, wait-free single-producer/single-consumer queue. At most
+	// one thread may push and at most one thread may pop concurrently.
+	// The capacity is rounded up to a power of two.
+	template <class T, ProtoAllocator<T> PA = std::allocator<T>>
+	class ring_buffer : detail::ebo_box<rebind_allocator_t<PA, T>> {
+		using value_allocator_type = rebind_allocator_t<PA, T>;
+		using base_t = detail::ebo_box<value_allocator_type>;
+		using traits = std::allocator_traits<value_allocator_type>;
+	public:
+		using value_type = T;
+		using allocator_type = PA;
+		using pointer = typename traits::pointer;
+		using size_type = difference_type_t<pointer>;
+
+		~ring_buffer()
+			requires Allocator<value_allocator_type, T>() &&
+				AllocatorDestructible<value_allocator_type, T>()
+		{
+			auto tail = tail_.load(std::memory_order_relaxed);
+			for (auto head = head_.load(std::memory_order_relaxed); head != tail; ++head) {
+				traits::destroy(alloc(), std::addressof(slot(head)));
+			}
+			traits::deallocate(alloc(), buf_, capacity());
+		}
+
+		ring_buffer(size_type n, allocator_type a)
+			requires Allocator<value_allocator_type, T>()
+		: base_t{value_allocator_type{std::move(a)}},
+			mask_{__ring_buffer::round_up_pow2((STL2_EXPECT(n > 0), n)) - 1},
+			buf_{traits::allocate(alloc(), capacity())}
+		{}
+
+		explicit ring_buffer(size_type n)
+			requires Allocator<value_allocator_type, T>() &&
+				DefaultConstructible<allocator_type>()
+		: ring_buffer{n, allocator_type{}}
+		{}
+
+		ring_buffer(const ring_buffer&) = delete;
+		ring_buffer& operator=(const ring_buffer&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return allocator_type{alloc()};
+		}
+
+		size_type capacity() const noexcept {
+			return static_cast<size_type>(mask_ + 1);
+		}
+
+		// Exact when called by the producer or the consumer while the
+		// other side is quiescent; otherwise merely a snapshot.
+		size_type size() const noexcept {
+			return static_cast<size_type>(tail_.load(std::memory_order_acquire) -
+				head_.load(std::memory_order_acquire));
+		}
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		// Extension
+		// A snapshot, like size(). Called from a third thread, the two
+		// indices may be loaded out of step, so n is clamped to
+		// [0, capacity()].
+		memory_stats memory_usage() const noexcept {
+			auto const n = __stl2::min(__stl2::max(size(), size_type{0}), capacity());
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(n);
+			s.slack = __memory_stats::bytes<T>(capacity() - n);
+			__memory_stats::allocation(s, alloc(), capacity());
+			return s;
+		}
+
+		// Producer only.
+		template <class...Args>
+		requires
+			AllocatorConstructible<value_allocator_type, T, Args...>()
+		bool try_emplace(Args&&...args) {
+			auto const tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head_cache_ > mask_) {
+				head_cache_ = head_.load(std::memory_order_acquire);
+				if (tail - head_cache_ > mask_) {
+					return false;
+				}
+			}
+			traits::construct(alloc(), std::addressof(slot(tail)),
+				__stl2::forward<Args>(args)...);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+		bool try_push(const T& t)
+		requires
+			AllocatorCopyConstructible<value_allocator_type, T>()
+		{
+			return try_emplace(t);
+		}
+		bool try_push(T&& t)
+		requires
+			AllocatorMoveConstructible<value_allocator_type, T>()
+		{
+			return try_emplace(std::move(t));
+		}
+
+		// Producer only. Pushes up to n elements from first, constructing
+		// them directly into (at most two) contiguous runs of the buffer
+		// and publishing them all with a single store. Returns the number
+		// pushed. If a constructor throws, nothing is pushed.
+		template <InputIterator I>
+		requires
+			AllocatorConstructible<value_allocator_type, T, reference_t<I>>()
+		size_type push_n(I first, size_type n) {
+			STL2_EXPECT(n >= 0);
+			auto const tail = tail_.load(std::memory_order_relaxed);
+			auto room = capacity() - static_cast<size_type>(tail - head_cache_);
+			if (room < n) {
+				head_cache_ = head_.load(std::memory_order_acquire);
+				room = capacity() - static_cast<size_type>(tail - head_cache_);
+			}
+			n = __stl2::min(n, room);
+			auto const run = __stl2::min(n, capacity() - static_cast<size_type>(tail & mask_));
+			auto const lo = std::addressof(slot(tail));
+			auto const hi = std::addressof(buf_[0]);
+			auto i = size_type{0};
+			try {
+				for (; i < run; ++i, ++first) {
+					traits::construct(alloc(), lo + i, *first);
+				}
+				for (; i < n; ++i, ++first) {
+					traits::construct(alloc(), hi + (i - run), *first);
+				}
+			} catch(...) {
+				while (i > run) {
+					--i;
+					traits::destroy(alloc(), hi + (i - run));
+				}
+				while (i > 0) {
+					traits::destroy(alloc(), lo + --i);
+				}
+				throw;
+			}
+			tail_.store(tail + static_cast<std::size_t>(n), std::memory_order_release);
+			return n;
+		}
+
+		// Consumer only.
+		template <class U>
+		requires
+			Assignable<U&, T>() &&
+			AllocatorDestructible<value_allocator_type, T>()
+		bool try_pop(U& out) {
+			auto const head = head_.load(std::memory_order_relaxed);
+			if (head == tail_cache_) {
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+				if (head == tail_cache_) {
+					return false;
+				}
+			}
+			auto& t = slot(head);
+			out = std::move(t);
+			traits::destroy(alloc(), std::addressof(t));
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Moves up to n elements to out from (at most two)
+		// contiguous runs of the buffer and releases their slots with a
+		// single store. Returns the number popped.
+		template <WeaklyIncrementable O>
+		requires
+			Writable<O, T&&>() &&
+			AllocatorDestructible<value_allocator_type, T>()
+		size_type pop_n(O out, size_type n) {
+			STL2_EXPECT(n >= 0);
+			auto const head = head_.load(std::memory_order_relaxed);
+			auto avail = static_cast<size_type>(tail_cache_ - head);
+			if (avail < n) {
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+				avail = static_cast<size_type>(tail_cache_ - head);
+			}
+			n = __stl2::min(n, avail);
+			auto const run = __stl2::min(n, capacity() - static_cast<size_type>(head & mask_));
+			auto p = std::addressof(slot(head));
+			for (auto e = p + run; p != e; ++p, ++out) {
+				*out = std::move(*p);
+				traits::destroy(alloc(), p);
+			}
+			p = std::addressof(buf_[0]);
+			for (auto e = p + (n - run); p != e; ++p, ++out) {
+				*out = std::move(*p);
+				traits::destroy(alloc(), p);
+			}
+			head_.store(head + static_cast<std::size_t>(n), std::memory_order_release);
+			return n;
+		}
+
+	private:
+		std::size_t const mask_;
+		pointer const buf_;
+
+		// Producer side.
+		alignas(__ring_buffer::cache_line) std::atomic<std::size_t> tail_{0};
+		std::size_t head_cache_ = 0;
+
+		// Consumer side.
+		alignas(__ring_buffer::cache_line) std::atomic<std::size_t> head_{0};
+		std::size_t tail_cache_ = 0;
+
+		alignas(__ring_buffer::cache_line) char pad_[1] = {};
+
+		value_allocator_type& alloc() { return base_t::get(); }
+		const value_allocator_type& alloc() const { return base_t::get(); }
+
+		T& slot(std::size_t i) const noexcept {
+			return buf_[i & mask_];
+		}
+	};
+
+	// A bounded multi-producer/multi-consumer queue after Dmitry Vyukov's
+	// design: every cell carries a sequence number that tells producers
+	// and consumers whose turn it is, so the only shared read-modify-write
+	// is a compare-exchange on the position counter of the acting side.
+	template <class T, ProtoAllocator PA = std::allocator<T>>
+	requires
+		ProtoAllocator<PA, __ring_buffer::cell<T>>()
+	class mpmc_ring_buffer : detail::ebo_box<rebind_allocator_t<PA, __ring_buffer::cell<T>>> {
+		using cell_t = __ring_buffer::cell<T>;
+		using cell_allocator_type = rebind_allocator_t<PA, cell_t>;
+		using base_t = detail::ebo_box<cell_allocator_type>;
+		using traits = std::allocator_traits<cell_allocator_type>;
+		using cell_pointer = typename traits::pointer;
+	public:
+		using value_type = T;
+		using allocator_type = PA;
+		using size_type = difference_type_t<cell_pointer>;
+
+		~mpmc_ring_buffer()
+			requires Allocator<cell_allocator_type, cell_t>() &&
+				AllocatorDestructible<cell_allocator_type, T>()
+		{
+			auto const tail = enqueue_pos_.load(std::memory_order_relaxed);
+			for (auto head = dequeue_pos_.load(std::memory_order_relaxed); head != tail; ++head) {
+				traits::destroy(alloc(), std::addressof(cell(head).get()));
+			}
+			for (auto i = std::size_t{0}; i <= mask_; ++i) {
+				traits::destroy(alloc(), std::addressof(cells_[i].seq_));
+			}
+			traits::deallocate(alloc(), cells_, capacity());
+		}
+
+		mpmc_ring_buffer(size_type n, allocator_type a)
+			requires Allocator<cell_allocator_type, cell_t>()
+		: base_t{cell_allocator_type{std::move(a)}},
+			mask_{__ring_buffer::round_up_pow2((STL2_EXPECT(n > 0), n)) - 1},
+			cells_{traits::allocate(alloc(), capacity())}
+		{
+			for (auto i = std::size_t{0}; i <= mask_; ++i) {
+				traits::construct(alloc(), std::addressof(cells_[i].seq_), i);
+			}
+		}
+
+		explicit mpmc_ring_buffer(size_type n)
+			requires Allocator<cell_allocator_type, cell_t>() &&
+				DefaultConstructible<allocator_type>()
+		: mpmc_ring_buffer{n, allocator_type{}}
+		{}
+
+		mpmc_ring_buffer(const mpmc_ring_buffer&) = delete;
+		mpmc_ring_buffer& operator=(const mpmc_ring_buffer&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return allocator_type{alloc()};
+		}
+
+		size_type capacity() const noexcept {
+			return static_cast<size_type>(mask_ + 1);
+		}
+
+		// A snapshot; may be stale by the time it is returned.
+		size_type size() const noexcept {
+			auto const tail = enqueue_pos_.load(std::memory_order_acquire);
+			auto const head = dequeue_pos_.load(std::memory_order_acquire);
+			return tail > head ? static_cast<size_type>(tail - head) : 0;
+		}
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		// Extension
+		// A snapshot, like size(). Each cell's sequence number, and any
+		// padding, counts as overhead.
+		memory_stats memory_usage() const noexcept {
+			auto const n = size();
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(n);
+			s.slack = __memory_stats::bytes<T>(capacity() - n);
+			s.overhead = (sizeof(cell_t) - sizeof(T)) * static_cast<std::size_t>(capacity());
+			__memory_stats::allocation(s, alloc(), capacity());
+			return s;
+		}
+
+		// A claimed cell cannot be handed back, and its consumer waits
+		// for it to be published, so only a constructor that cannot throw
+		// runs in the cell.
+		template <class...Args>
+		requires
+			AllocatorConstructible<cell_allocator_type, T, Args...>() &&
+			__ring_buffer::NothrowConstructible<T, Args...>
+		bool try_emplace(Args&&...args) {
+			std::size_t pos;
+			if (claim(enqueue_pos_, 0, 1, pos) == 0) {
+				return false;
+			}
+			auto& c = cell(pos);
+			traits::construct(alloc(), std::addressof(c.get()),
+				__stl2::forward<Args>(args)...);
+			c.seq_.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+		// Otherwise the element is built before the claim and moved into
+		// the cell; if the queue is full, args may have been consumed.
+		template <class...Args>
+		requires
+			AllocatorConstructible<cell_allocator_type, T, Args...>() &&
+			!__ring_buffer::NothrowConstructible<T, Args...> &&
+			AllocatorMoveConstructible<cell_allocator_type, T>() &&
+			__ring_buffer::NothrowConstructible<T, T&&>
+		bool try_emplace(Args&&...args) {
+			T t(__stl2::forward<Args>(args)...);
+			return try_emplace(std::move(t));
+		}
+		bool try_push(const T& t)
+		requires
+			AllocatorCopyConstructible<cell_allocator_type, T>()
+		{
+			return try_emplace(t);
+		}
+		bool try_push(T&& t)
+		requires
+			AllocatorMoveConstructible<cell_allocator_type, T>()
+		{
+			return try_emplace(std::move(t));
+		}
+
+		// Claims up to n consecutive free cells with a single
+		// compare-exchange, then fills and publishes them. Returns the
+		// number pushed.
+		template <InputIterator I>
+		requires
+			AllocatorConstructible<cell_allocator_type, T, reference_t<I>>() &&
+			__ring_buffer::NothrowConstructible<T, reference_t<I>>
+		size_type push_n(I first, size_type n) {
+			STL2_EXPECT(n >= 0);
+			std::size_t pos;
+			n = claim(enqueue_pos_, 0, n, pos);
+			for (auto i = n; i > 0; --i, ++first, ++pos) {
+				auto& c = cell(pos);
+				traits::construct(alloc(), std::addressof(c.get()), *first);
+				c.seq_.store(pos + 1, std::memory_order_release);
+			}
+			return n;
+		}
+		// When construction might throw, pushes one element at a time
+		// through try_emplace. If a constructor throws, the elements
+		// before it remain pushed.
+		template <InputIterator I>
+		requires
+			AllocatorConstructible<cell_allocator_type, T, reference_t<I>>() &&
+			!__ring_buffer::NothrowConstructible<T, reference_t<I>> &&
+			AllocatorMoveConstructible<cell_allocator_type, T>() &&
+			__ring_buffer::NothrowConstructible<T, T&&>
+		size_type push_n(I first, size_type n) {
+			STL2_EXPECT(n >= 0);
+			auto pushed = size_type{0};
+			while (pushed < n && try_emplace(*first)) {
+				++pushed;
+				++first;
+			}
+			return pushed;
+		}
+
+		template <class U>
+		requires
+			Assignable<U&, T>() &&
+			AllocatorDestructible<cell_allocator_type, T>()
+		bool try_pop(U& out) {
+			std::size_t pos;
+			if (claim(dequeue_pos_, 1, 1, pos) == 0) {
+				return false;
+			}
+			release(pos, out);
+			return true;
+		}
+
+		// Claims up to n consecutive full cells with a single
+		// compare-exchange, then drains them to out. Returns the number
+		// popped.
+		template <WeaklyIncrementable O>
+		requires
+			Writable<O, T&&>() &&
+			AllocatorDestructible<cell_allocator_type, T>()
+		size_type pop_n(O out, size_type n) {
+			STL2_EXPECT(n >= 0);
+			std::size_t pos;
+			n = claim(dequeue_pos_, 1, n, pos);
+			for (auto i = n; i > 0; --i, ++out, ++pos) {
+				release(pos, *out);
+			}
+			return n;
+		}
+
+	private:
+		std::size_t const mask_;
+		cell_pointer const cells_;
+
+		alignas(__ring_buffer::cache_line) std::atomic<std::size_t> enqueue_pos_{0};
+		alignas(__ring_buffer::cache_line) std::atomic<std::size_t> dequeue_pos_{0};
+		alignas(__ring_buffer::cache_line) char pad_[1] = {};
+
+		cell_allocator_type& alloc() { return base_t::get(); }
+		const cell_allocator_type& alloc() const { return base_t::get(); }
+
+		cell_t& cell(std::size_t i) const noexcept {
+			return cells_[i & mask_];
+		}
+
+		// Cell i is ready for the side with the given lag when its
+		// sequence number is i + lag: producers have lag 0, consumers 1.
+		// Claims the longest run of ready cells starting at the current
+		// position, up to n, by advancing counter past them. Returns the
+		// length of the claimed run and its first position in pos.
+		size_type claim(std::atomic<std::size_t>& counter, std::size_t lag,
+			size_type n, std::size_t& pos) noexcept
+		{
+			pos = counter.load(std::memory_order_relaxed);
+			if (n == 0) {
+				return 0;
+			}
+			for (;;) {
+				size_type ready = 0;
+				for (; ready < n; ++ready) {
+					auto const p = pos + static_cast<std::size_t>(ready);
+					auto const seq = cell(p).seq_.load(std::memory_order_acquire);
+					if (seq != p + lag) {
+						break;
+					}
+				}
+				if (ready == 0) {
+					auto const seq = cell(pos).seq_.load(std::memory_order_acquire);
+					auto const dif = static_cast<std::ptrdiff_t>(seq - (pos + lag));
+					if (dif < 0) {
+						return 0; // full (producers) or empty (consumers)
+					}
+					// Another thread claimed this position first.
+					pos = counter.load(std::memory_order_relaxed);
+					continue;
+				}
+				if (counter.compare_exchange_weak(pos, pos + static_cast<std::size_t>(ready),
+					std::memory_order_relaxed))
+				{
+					return ready;
+				}
+			}
+		}
+
+		template <class U>
+		void release(std::size_t pos, U&& out) {
+			auto& c = cell(pos);
+			out = std::move(c.get());
+			traits::destroy(alloc(), std::addressof(c.get()));
+			c.seq_.store(pos + mask_ + 1, std::memory_order_release);
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
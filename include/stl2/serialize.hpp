@@ -0,0 +1,365 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_SERIALIZE_HPP
+#define STL2_SERIALIZE_HPP
+
+#include <stl2/forward_list.hpp>
+#include <stl2/io_buffer.hpp>
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+// Binary serialization of trivially copyable elements.
+//
+// Every serialized container starts with a 24-byte header: the magic
+// "STL2", a format version, a byte order mark written in the writer's
+// native order, the kind of payload, the element size, and (for
+// contiguous payloads) the element count. A reader that sees the mark
+// reversed byte-swaps the header and, for arithmetic and enumeration
+// element types, the elements; other element types cannot be
+// reinterpreted and are rejected.
+//
+// Contiguous payloads - vector - follow the header as one block.
+// Stream payloads - forward_list and arbitrary input ranges - are a
+// sequence of chunks, each a 32-bit element count followed by that many
+// elements, terminated by an empty chunk. Neither side ever needs the
+// whole sequence in memory.
+STL2_OPEN_NAMESPACE {
+	class serialization_error : public std::runtime_error {
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	namespace __serialize {
+		template <class T>
+		constexpr bool byte_swappable =
+			std::is_arithmetic<T>::value || std::is_enum<T>::value;
+
+		constexpr std::uint16_t version = 1;
+		constexpr std::uint16_t byte_order_mark = 0x0102;
+		constexpr std::uint16_t reversed_byte_order_mark = 0x0201;
+
+		enum class kind : std::uint8_t { contiguous = 1, stream = 2 };
+
+		struct header {
+			char magic[4];
+			std::uint16_t version;
+			std::uint16_t byte_order;
+			kind payload;
+			std::uint8_t reserved[3];
+			std::uint32_t element_size;
+			std::uint64_t count;
+		};
+		static_assert(sizeof(header) == 24);
+
+		template <class T>
+		void byteswap(T& t) noexcept {
+			unsigned char bytes[sizeof(T)];
+			std::memcpy(bytes, &t, sizeof(T));
+			for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+				auto const tmp = bytes[i];
+				bytes[i] = bytes[sizeof(T) - 1 - i];
+				bytes[sizeof(T) - 1 - i] = tmp;
+			}
+			std::memcpy(&t, bytes, sizeof(T));
+		}
+
+		template <class T>
+		header make_header(kind payload, std::uint64_t count) noexcept {
+			return {{'S', 'T', 'L', '2'}, version, byte_order_mark, payload,
+				{}, static_cast<std::uint32_t>(sizeof(T)), count};
+		}
+
+		// Validates h as a header for a payload of T, correcting its byte
+		// order in place. Returns whether the payload must be swapped.
+		template <class T>
+		bool check_header(header& h, kind payload) {
+			if (std::memcmp(h.magic, "STL2", 4) != 0) {
+				throw serialization_error{"bad magic"};
+			}
+			auto const swap = h.byte_order == reversed_byte_order_mark;
+			if (swap) {
+				byteswap(h.version);
+				byteswap(h.element_size);
+				byteswap(h.count);
+			} else if (h.byte_order != byte_order_mark) {
+				throw serialization_error{"bad byte order mark"};
+			}
+			if (h.version == 0 || h.version > version) {
+				throw serialization_error{"unsupported format version"};
+			}
+			if (h.payload != payload) {
+				throw serialization_error{"unexpected payload kind"};
+			}
+			if (h.element_size != sizeof(T)) {
+				throw serialization_error{"element size mismatch"};
+			}
+			if (swap && sizeof(T) > 1 && !byte_swappable<T>) {
+				throw serialization_error{"cannot convert the byte order of this element type"};
+			}
+			return swap && sizeof(T) > 1;
+		}
+
+		template <ByteSource S>
+		void read_exactly(S& source, void* p, std::size_t n) {
+			auto const buf = mutable_buffer{p, n};
+			if (source.read(&buf, 1) != n) {
+				throw serialization_error{"unexpected end of input"};
+			}
+		}
+
+		template <ByteSink S>
+		void write_chunk(S& sink, const unsigned char* data, std::uint32_t count, std::size_t size) {
+			const_buffer const bufs[] = {{&count, sizeof(count)}, {data, count * size}};
+			sink.write(bufs, count > 0 ? 2 : 1);
+		}
+	}
+
+	// Writes the elements of vec as a single contiguous block.
+	template <class T, class PA, ByteSink S>
+	requires
+		__io::TriviallyCopyable<T>
+	void serialize(S& sink, const vector<T, PA>& vec) {
+		auto const h = __serialize::make_header<T>(__serialize::kind::contiguous,
+			static_cast<std::uint64_t>(vec.size()));
+		auto const data = vec.empty() ? nullptr : std::addressof(*vec.begin());
+		const_buffer const bufs[] = {{&h, sizeof(h)},
+			{data, static_cast<std::size_t>(vec.size()) * sizeof(T)}};
+		sink.write(bufs, 2);
+	}
+
+	// Replaces the contents of vec. The elements are read in one call
+	// directly into freshly reserved storage, which vec then adopts.
+	template <class T, class PA, ByteSource S>
+	requires
+		__io::TriviallyCopyable<T> &&
+		Allocator<typename vector<T, PA>::allocator_type, T>()
+	void deserialize(S& source, vector<T, PA>& vec) {
+		using V = vector<T, PA>;
+		auto h = __serialize::header{};
+		__serialize::read_exactly(source, &h, sizeof(h));
+		auto const swap = __serialize::check_header<T>(h, __serialize::kind::contiguous);
+		if (h.count > static_cast<std::uint64_t>(PTRDIFF_MAX) / sizeof(T)) {
+			throw serialization_error{"element count too large"};
+		}
+		auto const n = static_cast<typename V::size_type>(h.count);
+		auto tmp = V{reserve_t{}, n, vec.get_allocator()};
+		if (n > 0) {
+			__serialize::read_exactly(source, std::addressof(*tmp.begin()),
+				static_cast<std::size_t>(n) * sizeof(T));
+		}
+		auto b = tmp.release();
+		b.size = n;
+		auto result = V{adopt_t{}, b, vec.get_allocator()};
+		if (swap) {
+			for (auto& e : result) {
+				__serialize::byteswap(e);
+			}
+		}
+		vec.swap(result);
+	}
+
+	// Writes the elements of rng in chunks of at most chunk elements, so
+	// that rng may be a single pass over more data than fits in memory.
+	template <InputRange Rng, ByteSink S>
+	requires
+		__io::TriviallyCopyable<value_type_t<iterator_t<Rng>>>
+	void serialize_stream(S& sink, Rng&& rng, std::ptrdiff_t chunk = 0) {
+		using T = value_type_t<iterator_t<Rng>>;
+		if (chunk <= 0) {
+			chunk = sizeof(T) < 65536 ? 65536 / sizeof(T) : 1;
+		}
+		auto const h = __serialize::make_header<T>(__serialize::kind::stream, 0);
+		auto const hbuf = const_buffer{&h, sizeof(h)};
+		sink.write(&hbuf, 1);
+
+		std::unique_ptr<unsigned char[]> buf{new unsigned char[chunk * sizeof(T)]};
+		std::uint32_t count = 0;
+		for (auto first = __stl2::begin(rng), last = __stl2::end(rng); first != last; ++first) {
+			T const& t = *first;
+			std::memcpy(buf.get() + count * sizeof(T), std::addressof(t), sizeof(T));
+			if (++count == static_cast<std::uint32_t>(chunk)) {
+				__serialize::write_chunk(sink, buf.get(), count, sizeof(T));
+				count = 0;
+			}
+		}
+		if (count > 0) {
+			__serialize::write_chunk(sink, buf.get(), count, sizeof(T));
+		}
+		__serialize::write_chunk(sink, buf.get(), 0, sizeof(T));
+	}
+
+	template <class T, class A, ByteSink S>
+	requires
+		__io::TriviallyCopyable<T>
+	void serialize(S& sink, const forward_list<T, A>& list) {
+		__stl2::serialize_stream(sink, list);
+	}
+
+	// An incremental decoder for stream payloads: feed it bytes as they
+	// arrive, in pieces of any size, and it hands each complete element to
+	// a callback. Suited to asynchronous I/O, where the caller owns the
+	// buffers and the event loop.
+	template <class T>
+	requires
+		__io::TriviallyCopyable<T>
+	class stream_decoder {
+	public:
+		// Decodes a prefix of [data, data + n), passing each element to
+		// f. Returns the number of bytes consumed, which is n unless the
+		// stream ends first.
+		template <class F>
+		std::size_t feed(const void* data, std::size_t n, F&& f) {
+			auto const first = static_cast<const unsigned char*>(data);
+			auto p = first;
+			auto const last = first + n;
+			while (p != last && state_ != state::done) {
+				switch (state_) {
+				case state::header:
+					if (fill(p, last, sizeof(__serialize::header))) {
+						auto h = __serialize::header{};
+						std::memcpy(&h, buf_, sizeof(h));
+						swap_ = __serialize::check_header<T>(h, __serialize::kind::stream);
+						have_ = 0;
+						state_ = state::length;
+					}
+					break;
+				case state::length:
+					if (fill(p, last, sizeof(remaining_))) {
+						std::memcpy(&remaining_, buf_, sizeof(remaining_));
+						if (swap_) {
+							__serialize::byteswap(remaining_);
+						}
+						have_ = 0;
+						state_ = remaining_ > 0 ? state::elements : state::done;
+					}
+					break;
+				case state::elements:
+					if (have_ == 0 && static_cast<std::size_t>(last - p) >= sizeof(T)) {
+						emit(p, f);
+						p += sizeof(T);
+					} else if (fill(p, last, sizeof(T))) {
+						emit(buf_, f);
+						have_ = 0;
+					} else {
+						break;
+					}
+					if (--remaining_ == 0) {
+						state_ = state::length;
+					}
+					break;
+				case state::done:
+					break;
+				}
+			}
+			return static_cast<std::size_t>(p - first);
+		}
+
+		// The number of bytes the decoder can consume before it must
+		// produce something: reading no more than this from a source never
+		// reads past the end of the stream.
+		std::size_t wanted() const noexcept {
+			switch (state_) {
+			case state::header:
+				return sizeof(__serialize::header) - have_;
+			case state::length:
+				return sizeof(remaining_) - have_;
+			case state::elements:
+				return remaining_ * sizeof(T) - have_;
+			case state::done:
+				break;
+			}
+			return 0;
+		}
+
+		bool done() const noexcept {
+			return state_ == state::done;
+		}
+
+	private:
+		enum class state : unsigned char { header, length, elements, done };
+
+		static constexpr std::size_t buffer_size =
+			sizeof(T) > sizeof(__serialize::header) ? sizeof(T) : sizeof(__serialize::header);
+
+		state state_ = state::header;
+		bool swap_ = false;
+		std::uint32_t remaining_ = 0;
+		std::size_t have_ = 0;
+		unsigned char buf_[buffer_size];
+
+		// Accumulates bytes in buf_ until it holds n of them; returns
+		// whether it does.
+		bool fill(const unsigned char*& p, const unsigned char* last, std::size_t n) noexcept {
+			auto k = static_cast<std::size_t>(last - p);
+			if (k > n - have_) {
+				k = n - have_;
+			}
+			std::memcpy(buf_ + have_, p, k);
+			have_ += k;
+			p += k;
+			return have_ == n;
+		}
+
+		template <class F>
+		void emit(const unsigned char* p, F& f) {
+			aligned_storage_t<sizeof(T), alignof(T)> raw;
+			std::memcpy(&raw, p, sizeof(T));
+			auto& t = reinterpret_cast<T&>(raw);
+			if (swap_) {
+				__serialize::byteswap(t);
+			}
+			f(static_cast<const T&>(t));
+		}
+	};
+
+	// Decodes a stream payload from source, passing each element to f.
+	// Reads no further than the end of the stream.
+	template <class T, ByteSource S, class F>
+	requires
+		__io::TriviallyCopyable<T>
+	void deserialize_stream(S& source, F f) {
+		constexpr std::size_t buffer_size = 16384;
+		stream_decoder<T> decoder;
+		std::unique_ptr<unsigned char[]> buf{new unsigned char[buffer_size]};
+		while (!decoder.done()) {
+			auto const wanted = decoder.wanted();
+			auto const b = mutable_buffer{buf.get(), wanted < buffer_size ? wanted : buffer_size};
+			auto const n = source.read(&b, 1);
+			if (n == 0) {
+				throw serialization_error{"unexpected end of input"};
+			}
+			decoder.feed(buf.get(), n, f);
+		}
+	}
+
+	// Replaces the contents of list, appending each node as its element
+	// is decoded. On failure, list holds the elements decoded so far.
+	template <class T, class A, ByteSource S>
+	requires
+		__io::TriviallyCopyable<T>
+	void deserialize(S& source, forward_list<T, A>& list) {
+		list.clear();
+		auto pos = list.before_begin();
+		__stl2::deserialize_stream<T>(source, [&](const T& t) {
+			pos = list.emplace_after(pos, t);
+		});
+	}
+} STL2_CLOSE_NAMESPACE
+
+#endif
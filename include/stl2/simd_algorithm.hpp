@@ -0,0 +1,531 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_SIMD_ALGORITHM_HPP
+#define STL2_SIMD_ALGORITHM_HPP
+
+#include <stl2/algorithm.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/utility.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Extension: vectorized find, count, min_element, max_element, mismatch,
+// equal and fill over pointer ranges of arithmetic type, which covers
+// vector<T>::iterator and static_vector<T, N>::iterator. Overload
+// resolution prefers them to the generic algorithms whenever the
+// arguments are pointers to the same arithmetic type and no comparison
+// or projection is passed; the range forms and calls with a projection
+// still take the generic path.
+//
+// Each kernel is compiled for SSE4.2, AVX2 and AVX-512 and the widest
+// the processor supports is chosen on first use, so the library need not
+// be built with -march to get the wide vectors. Results are exactly
+// those of the generic algorithms, including for floating point: == and
+// != keep their IEEE meaning, and min_element and max_element fall back
+// to the scalar loop when the range holds a NaN.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STL2_SIMD_X86 1
+#define STL2_SIMD_TARGET(isa) __attribute__((__target__(isa)))
+#else
+#define STL2_SIMD_X86 0
+#define STL2_SIMD_TARGET(isa)
+#endif
+#define STL2_SIMD_INLINE inline __attribute__((__always_inline__))
+
+STL2_OPEN_NAMESPACE {
+	namespace __simd {
+		template <class T>
+		concept bool Arithmetic =
+			std::is_arithmetic<T>::value && !std::is_volatile<T>::value &&
+			!std::is_same<T, bool>::value &&
+			(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+		// T and U are the same arithmetic type, either possibly const.
+		template <class T, class U>
+		concept bool Vectorizable =
+			Arithmetic<std::remove_const_t<T>> &&
+			Same<std::remove_const_t<T>, std::remove_const_t<U>>();
+
+		enum class isa { scalar, sse42, avx2, avx512 };
+
+		inline isa detect() noexcept {
+#if STL2_SIMD_X86
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+				return isa::avx512;
+			}
+			if (__builtin_cpu_supports("avx2")) {
+				return isa::avx2;
+			}
+			if (__builtin_cpu_supports("sse4.2")) {
+				return isa::sse42;
+			}
+#endif
+			return isa::scalar;
+		}
+
+		// The widest instruction set this processor supports
+		inline isa level() noexcept {
+			static const isa l = detect();
+			return l;
+		}
+
+		// Vectors hold the fixed-width type of the same size, signedness
+		// and kind as T, so char, wchar_t, long and friends share kernels.
+		template <std::size_t N, bool Signed> struct int_lane;
+		template <> struct int_lane<1, true> { using type = std::int8_t; };
+		template <> struct int_lane<1, false> { using type = std::uint8_t; };
+		template <> struct int_lane<2, true> { using type = std::int16_t; };
+		template <> struct int_lane<2, false> { using type = std::uint16_t; };
+		template <> struct int_lane<4, true> { using type = std::int32_t; };
+		template <> struct int_lane<4, false> { using type = std::uint32_t; };
+		template <> struct int_lane<8, true> { using type = std::int64_t; };
+		template <> struct int_lane<8, false> { using type = std::uint64_t; };
+
+		template <class T, bool = std::is_floating_point<T>::value>
+		struct lane_of { using type = T; };
+		template <class T>
+		struct lane_of<T, false> : int_lane<sizeof(T), std::is_signed<T>::value> {};
+
+		template <class T, std::size_t Bytes>
+		struct vector_of {
+			typedef typename lane_of<T>::type type __attribute__((__vector_size__(Bytes)));
+		};
+
+		// Bytes-wide vectors of T. Kernels load and store through at(),
+		// which views memory of T as unaligned vectors, and never pass
+		// vectors by value: they are inlined into an entry point compiled
+		// for the instruction set whose registers are Bytes wide, but GCC
+		// would still warn about the calling convention. Masks are merged
+		// with ?: rather than |, which GCC 12 scalarizes for 64-byte
+		// vectors instead of using AVX-512 mask registers.
+		template <class T, std::size_t Bytes>
+		struct pack {
+			using lane = typename lane_of<T>::type;
+			using vec = typename vector_of<T, Bytes>::type;
+			typedef vec unaligned __attribute__((__aligned__(alignof(T)), __may_alias__));
+			using mask = decltype(vec{} == vec{});
+			static constexpr std::ptrdiff_t lanes = Bytes / sizeof(T);
+
+			STL2_SIMD_INLINE static const unaligned* at(const T* p) noexcept {
+				return reinterpret_cast<const unaligned*>(p);
+			}
+			STL2_SIMD_INLINE static unaligned* at(T* p) noexcept {
+				return reinterpret_cast<unaligned*>(p);
+			}
+			STL2_SIMD_INLINE static bool any(const mask& m) noexcept {
+				using words = typename vector_of<std::uint64_t, Bytes>::type;
+				auto const w = reinterpret_cast<words>(m);
+				auto r = std::uint64_t{0};
+				for (auto i = std::size_t{0}; i < Bytes / 8; ++i) {
+					r |= w[i];
+				}
+				return r != 0;
+			}
+		};
+
+		// Each kernel is a struct with a scalar form, used when no vector
+		// unit is available, and a form for each register width.
+		struct find_fn {
+			template <class T>
+			static const T* scalar(const T* first, const T* last, T value) noexcept {
+				for (; first != last; ++first) {
+					if (*first == value) {
+						break;
+					}
+				}
+				return first;
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static const T* run(const T* first, const T* last, T value) noexcept {
+				using P = pack<T, Bytes>;
+				constexpr auto L = P::lanes;
+				auto const v = typename P::vec{} + typename P::lane(value);
+				auto const ones = ~typename P::mask{};
+				// Four vectors per test of the combined mask; the scalar
+				// loop then locates the match within them.
+				for (; last - first >= 4 * L; first += 4 * L) {
+					auto m = typename P::mask{};
+					for (auto k = 0; k < 4; ++k) {
+						m = *P::at(first + k * L) == v ? ones : m;
+					}
+					if (P::any(m)) {
+						break;
+					}
+				}
+				for (; last - first >= L; first += L) {
+					if (P::any(*P::at(first) == v)) {
+						break;
+					}
+				}
+				return scalar(first, last, value);
+			}
+		};
+
+		struct count_fn {
+			template <class T>
+			static std::ptrdiff_t scalar(const T* first, const T* last, T value) noexcept {
+				auto n = std::ptrdiff_t{0};
+				for (; first != last; ++first) {
+					n += *first == value;
+				}
+				return n;
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static std::ptrdiff_t run(const T* first, const T* last, T value) noexcept {
+				using P = pack<T, Bytes>;
+				constexpr auto L = P::lanes;
+				// Each lane counts its matches in an integer as wide as
+				// itself, which is emptied into n before it can overflow.
+				constexpr auto width = sizeof(T) < 4 ? sizeof(T) : std::size_t{4};
+				constexpr auto limit = (std::ptrdiff_t{1} << (8 * width - 1)) - 1;
+				auto const v = typename P::vec{} + typename P::lane(value);
+				auto n = std::ptrdiff_t{0};
+				while (last - first >= 4 * L) {
+					auto const groups = (last - first) / (4 * L);
+					auto const m = groups < limit ? groups : limit;
+					// Four accumulators, so the additions need not wait on
+					// one another.
+					typename P::mask acc[4] = {};
+					for (auto i = std::ptrdiff_t{0}; i < m; ++i, first += 4 * L) {
+						for (auto k = 0; k < 4; ++k) {
+							acc[k] = *P::at(first + k * L) == v ? acc[k] + 1 : acc[k];
+						}
+					}
+					for (auto k = 0; k < 4; ++k) {
+						for (auto i = std::ptrdiff_t{0}; i < L; ++i) {
+							n += acc[k][i];
+						}
+					}
+				}
+				return n + scalar(first, last, value);
+			}
+		};
+
+		// The number of elements of [first, last) less than value or, if
+		// Upper, not greater than it: for a sorted range, the offset at
+		// which lower_bound, or upper_bound, stops. Every element is
+		// compared and none of the outcomes is branched on, which for the
+		// few dozen keys of a tree node beats a binary search whose
+		// branches the processor cannot predict.
+		template <bool Upper>
+		struct rank_fn {
+			template <class T>
+			static std::ptrdiff_t scalar(const T* first, const T* last, T value) noexcept {
+				auto n = std::ptrdiff_t{0};
+				for (; first != last; ++first) {
+					n += Upper ? *first <= value : *first < value;
+				}
+				return n;
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static std::ptrdiff_t run(const T* first, const T* last, T value) noexcept {
+				using P = pack<T, Bytes>;
+				constexpr auto L = P::lanes;
+				// Lanes count as in count_fn, subtracting each mask,
+				// whose true lanes are -1.
+				constexpr auto width = sizeof(T) < 4 ? sizeof(T) : std::size_t{4};
+				constexpr auto limit = (std::ptrdiff_t{1} << (8 * width - 1)) - 1;
+				auto const v = typename P::vec{} + typename P::lane(value);
+				auto n = std::ptrdiff_t{0};
+				while (last - first >= 4 * L) {
+					auto const groups = (last - first) / (4 * L);
+					auto const m = groups < limit ? groups : limit;
+					typename P::mask acc[4] = {};
+					for (auto i = std::ptrdiff_t{0}; i < m; ++i, first += 4 * L) {
+						for (auto k = 0; k < 4; ++k) {
+							acc[k] -= Upper ? *P::at(first + k * L) <= v : *P::at(first + k * L) < v;
+						}
+					}
+					for (auto k = 0; k < 4; ++k) {
+						for (auto i = std::ptrdiff_t{0}; i < L; ++i) {
+							n += acc[k][i];
+						}
+					}
+				}
+				for (; last - first >= L; first += L) {
+					auto const m = Upper ? *P::at(first) <= v : *P::at(first) < v;
+					for (auto i = std::ptrdiff_t{0}; i < L; ++i) {
+						n -= m[i];
+					}
+				}
+				return n + scalar(first, last, value);
+			}
+		};
+
+		// min_element if Max is false, max_element if it is true
+		template <bool Max>
+		struct extremum_fn {
+			template <class V>
+			STL2_SIMD_INLINE static void keep(V& acc, const V& v) noexcept {
+				acc = Max ? (acc < v ? v : acc) : (v < acc ? v : acc);
+			}
+
+			template <class T>
+			static const T* scalar(const T* first, const T* last) noexcept {
+				if (first == last) {
+					return last;
+				}
+				auto result = first;
+				while (++first != last) {
+					if (Max ? *result < *first : *first < *result) {
+						result = first;
+					}
+				}
+				return result;
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static const T* run(const T* first, const T* last) noexcept {
+				using P = pack<T, Bytes>;
+				using V = typename P::vec;
+				constexpr auto L = P::lanes;
+				if (last - first < 4 * L) {
+					return scalar(first, last);
+				}
+				// Four accumulators hide the latency of the comparison.
+				V acc[4] = {*P::at(first), *P::at(first + L),
+					*P::at(first + 2 * L), *P::at(first + 3 * L)};
+				auto const ones = ~typename P::mask{};
+				auto nan = typename P::mask{};
+				for (auto k = 0; k < 4; ++k) {
+					nan = acc[k] != acc[k] ? ones : nan;
+				}
+				auto p = first + 4 * L;
+				for (; last - p >= 4 * L; p += 4 * L) {
+					for (auto k = 0; k < 4; ++k) {
+						auto const v = *P::at(p + k * L);
+						nan = v != v ? ones : nan;
+						keep(acc[k], v);
+					}
+				}
+				for (; last - p >= L; p += L) {
+					auto const v = *P::at(p);
+					nan = v != v ? ones : nan;
+					keep(acc[0], v);
+				}
+				// A NaN makes < no longer a strict weak order, and the
+				// generic algorithm's answer depends on where it sits.
+				if (std::is_floating_point<T>::value && P::any(nan)) {
+					return scalar(first, last);
+				}
+				keep(acc[0], acc[1]);
+				keep(acc[2], acc[3]);
+				keep(acc[0], acc[2]);
+				auto const& all = acc[0];
+				T best = all[0];
+				for (auto i = std::ptrdiff_t{1}; i < L; ++i) {
+					if (Max ? best < all[i] : all[i] < best) {
+						best = all[i];
+					}
+				}
+				for (; p != last; ++p) {
+					if (Max ? best < *p : *p < best) {
+						best = *p;
+					}
+				}
+				// The first element equal to the extremum is the answer.
+				return find_fn::run<Bytes>(first, last, best);
+			}
+		};
+
+		// The length of the common prefix of [a, a + n) and [b, b + n)
+		struct mismatch_fn {
+			template <class T>
+			static std::ptrdiff_t scalar(const T* a, const T* b, std::ptrdiff_t n) noexcept {
+				auto i = std::ptrdiff_t{0};
+				while (i < n && a[i] == b[i]) {
+					++i;
+				}
+				return i;
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static std::ptrdiff_t run(const T* a, const T* b, std::ptrdiff_t n) noexcept {
+				using P = pack<T, Bytes>;
+				constexpr auto L = P::lanes;
+				auto i = std::ptrdiff_t{0};
+				auto const ones = ~typename P::mask{};
+				for (; n - i >= 4 * L; i += 4 * L) {
+					auto m = typename P::mask{};
+					for (auto k = 0; k < 4; ++k) {
+						m = *P::at(a + i + k * L) != *P::at(b + i + k * L) ? ones : m;
+					}
+					if (P::any(m)) {
+						break;
+					}
+				}
+				for (; n - i >= L; i += L) {
+					if (P::any(*P::at(a + i) != *P::at(b + i))) {
+						break;
+					}
+				}
+				return i + scalar(a + i, b + i, n - i);
+			}
+		};
+
+		struct fill_fn {
+			template <class T>
+			static void scalar(T* first, T* last, T value) noexcept {
+				for (; first != last; ++first) {
+					*first = value;
+				}
+			}
+
+			template <std::size_t Bytes, class T>
+			STL2_SIMD_INLINE static void run(T* first, T* last, T value) noexcept {
+				using P = pack<T, Bytes>;
+				constexpr auto L = P::lanes;
+				auto const v = typename P::vec{} + typename P::lane(value);
+				for (; last - first >= 4 * L; first += 4 * L) {
+					for (auto k = 0; k < 4; ++k) {
+						*P::at(first + k * L) = v;
+					}
+				}
+				for (; last - first >= L; first += L) {
+					*P::at(first) = v;
+				}
+				scalar(first, last, value);
+			}
+		};
+
+		template <class K, class...Args>
+		STL2_SIMD_TARGET("sse4.2")
+		auto run_sse42(Args...args) noexcept {
+			return K::template run<16>(args...);
+		}
+
+		template <class K, class...Args>
+		STL2_SIMD_TARGET("avx2")
+		auto run_avx2(Args...args) noexcept {
+			return K::template run<32>(args...);
+		}
+
+		template <class K, class...Args>
+		STL2_SIMD_TARGET("avx512f,avx512bw")
+		auto run_avx512(Args...args) noexcept {
+			return K::template run<64>(args...);
+		}
+
+		// Runs kernel K for instruction set i, which must not be wider
+		// than level().
+		template <class K, class...Args>
+		auto run_with(isa i, Args...args) noexcept {
+			STL2_EXPECT(i <= level());
+			switch (i) {
+#if STL2_SIMD_X86
+			case isa::avx512:
+				return __simd::run_avx512<K>(args...);
+			case isa::avx2:
+				return __simd::run_avx2<K>(args...);
+			case isa::sse42:
+				return __simd::run_sse42<K>(args...);
+#endif
+			default:
+				return K::scalar(args...);
+			}
+		}
+
+		template <class K, class...Args>
+		auto run(Args...args) noexcept {
+			return __simd::run_with<K>(level(), args...);
+		}
+	}
+
+	// Extension
+	template <class T, class U>
+	requires __simd::Vectorizable<T, U>
+	T* find(T* first, T* last, const U& value) noexcept {
+		STL2_EXPECT(first <= last);
+		auto const p = __simd::run<__simd::find_fn>(
+			static_cast<const T*>(first), static_cast<const T*>(last), std::remove_const_t<T>{value});
+		return first + (p - first);
+	}
+
+	// Extension
+	template <class T, class U>
+	requires __simd::Vectorizable<T, U>
+	std::ptrdiff_t count(T* first, T* last, const U& value) noexcept {
+		STL2_EXPECT(first <= last);
+		return __simd::run<__simd::count_fn>(
+			static_cast<const T*>(first), static_cast<const T*>(last), std::remove_const_t<T>{value});
+	}
+
+	// Extension
+	template <class T>
+	requires __simd::Vectorizable<T, T>
+	T* min_element(T* first, T* last) noexcept {
+		STL2_EXPECT(first <= last);
+		auto const p = __simd::run<__simd::extremum_fn<false>>(
+			static_cast<const T*>(first), static_cast<const T*>(last));
+		return first + (p - first);
+	}
+
+	// Extension
+	template <class T>
+	requires __simd::Vectorizable<T, T>
+	T* max_element(T* first, T* last) noexcept {
+		STL2_EXPECT(first <= last);
+		auto const p = __simd::run<__simd::extremum_fn<true>>(
+			static_cast<const T*>(first), static_cast<const T*>(last));
+		return first + (p - first);
+	}
+
+	// Extension
+	template <class T1, class T2>
+	requires __simd::Vectorizable<T1, T2>
+	tagged_pair<tag::in1(T1*), tag::in2(T2*)>
+	mismatch(T1* first1, T1* last1, T2* first2, T2* last2) noexcept {
+		STL2_EXPECT(first1 <= last1 && first2 <= last2);
+		auto const n1 = last1 - first1;
+		auto const n2 = last2 - first2;
+		auto const i = __simd::run<__simd::mismatch_fn>(
+			static_cast<const T1*>(first1), static_cast<const T2*>(first2), n1 < n2 ? n1 : n2);
+		return {first1 + i, first2 + i};
+	}
+
+	// Extension
+	template <class T1, class T2>
+	requires __simd::Vectorizable<T1, T2>
+	bool equal(T1* first1, T1* last1, T2* first2, T2* last2) noexcept {
+		STL2_EXPECT(first1 <= last1 && first2 <= last2);
+		auto const n = last1 - first1;
+		return n == last2 - first2 &&
+			__simd::run<__simd::mismatch_fn>(static_cast<const T1*>(first1),
+				static_cast<const T2*>(first2), n) == n;
+	}
+
+	// Extension
+	template <class T, class U>
+	requires
+		__simd::Vectorizable<T, U> &&
+		(!std::is_const<T>::value)
+	T* fill(T* first, T* last, const U& value) noexcept {
+		STL2_EXPECT(first <= last);
+		__simd::run<__simd::fill_fn>(first, last, T{value});
+		return last;
+	}
+} STL2_CLOSE_NAMESPACE
+
+#undef STL2_SIMD_INLINE
+#undef STL2_SIMD_TARGET
+#undef STL2_SIMD_X86
+
+#endif
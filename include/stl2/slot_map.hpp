@@ -0,0 +1,230 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_SLOT_MAP_HPP
+#define STL2_SLOT_MAP_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstdint>
+#include <memory>
+
+STL2_OPEN_NAMESPACE {
+	namespace __slot_map {
+		// A handle to an element of a slot_map. A key outlives its element:
+		// once the element is erased, the generation of its slot moves on
+		// and the key no longer matches anything.
+		struct key {
+			std::uint32_t index;
+			std::uint32_t generation;
+
+			friend constexpr bool operator==(key x, key y) noexcept {
+				return x.index == y.index && x.generation == y.generation;
+			}
+			friend constexpr bool operator!=(key x, key y) noexcept {
+				return !(x == y);
+			}
+		};
+
+		// For a live slot, index is the position of the element in the
+		// dense array; for a free slot, it is the next free slot.
+		struct slot {
+			std::uint32_t index;
+			std::uint32_t generation;
+		};
+
+		constexpr std::uint32_t none = std::uint32_t(-1);
+	}
+
+	// Elements are stored densely in a vector and addressed through
+	// generation-checked keys. Insertion and erasure are O(1): erasure
+	// moves the last element into the hole, and freed slots are recycled
+	// through an intrusive free list.
+	template <class T, ProtoAllocator<T> PA = std::allocator<T>>
+	requires
+		ProtoAllocator<PA, __slot_map::slot>() &&
+		ProtoAllocator<PA, std::uint32_t>()
+	class slot_map {
+		using slot = __slot_map::slot;
+		using data_t = vector<T, PA>;
+	public:
+		using value_type = T;
+		using key_type = __slot_map::key;
+		using allocator_type = typename data_t::allocator_type;
+		using size_type = typename data_t::size_type;
+		using iterator = typename data_t::iterator;
+		using const_iterator = typename data_t::const_iterator;
+
+		slot_map()
+			requires DefaultConstructible<allocator_type>() = default;
+
+		slot_map(allocator_type a)
+		: data_{a},
+			slots_{rebind_allocator_t<PA, slot>{a}},
+			slot_of_{rebind_allocator_t<PA, std::uint32_t>{a}}
+		{}
+
+		slot_map(slot_map&&) = delete;
+		slot_map& operator=(slot_map&&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return data_.get_allocator();
+		}
+
+		// Iteration visits the elements densely, in no particular order.
+		iterator begin() noexcept { return data_.begin(); }
+		iterator end() noexcept { return data_.end(); }
+
+		const_iterator begin() const noexcept { return data_.begin(); }
+		const_iterator end() const noexcept { return data_.end(); }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		size_type size() const noexcept { return data_.size(); }
+		bool empty() const noexcept { return data_.empty(); }
+		size_type capacity() const noexcept { return data_.capacity(); }
+
+		// Extension: the slot table and the slot index of each element
+		// count as overhead.
+		memory_stats memory_usage() const noexcept {
+			return data_.memory_usage() +
+				__memory_stats::as_overhead(slots_.memory_usage()) +
+				__memory_stats::as_overhead(slot_of_.memory_usage());
+		}
+
+		void reserve(size_type n) {
+			data_.reserve(n);
+			slot_of_.reserve(n);
+			slots_.reserve(n);
+		}
+
+		template <class...Args>
+		requires
+			AllocatorConstructible<allocator_type, T, Args...>()
+		key_type emplace(Args&&...args) {
+			STL2_EXPECT(size() < static_cast<size_type>(__slot_map::none));
+			// Grow the bookkeeping first: a spare free slot is harmless
+			// if constructing the element throws.
+			if (free_head_ == __slot_map::none) {
+				slots_.emplace_back(slot{__slot_map::none, 0u});
+				free_head_ = static_cast<std::uint32_t>(slots_.size() - 1);
+			}
+			slot_of_.emplace_back(free_head_);
+			try {
+				data_.emplace_back(__stl2::forward<Args>(args)...);
+			} catch (...) {
+				slot_of_.pop_back();
+				throw;
+			}
+			auto const index = free_head_;
+			auto& s = slots_.begin()[index];
+			free_head_ = s.index;
+			s.index = static_cast<std::uint32_t>(size() - 1);
+			return {index, s.generation};
+		}
+
+		key_type insert(const T& t)
+		requires
+			AllocatorCopyConstructible<allocator_type, T>()
+		{
+			return emplace(t);
+		}
+		key_type insert(T&& t)
+		requires
+			AllocatorMoveConstructible<allocator_type, T>()
+		{
+			return emplace(std::move(t));
+		}
+
+		bool contains(key_type k) const noexcept {
+			return static_cast<size_type>(k.index) < slots_.size() &&
+				slots_.begin()[k.index].generation == k.generation;
+		}
+
+		// Returns a pointer to the element designated by k, or nullptr if
+		// that element has been erased.
+		T* find(key_type k) noexcept {
+			return contains(k) ? std::addressof(data_.begin()[slots_.begin()[k.index].index]) : nullptr;
+		}
+		const T* find(key_type k) const noexcept {
+			return contains(k) ? std::addressof(data_.begin()[slots_.begin()[k.index].index]) : nullptr;
+		}
+
+		T& operator[](key_type k) noexcept {
+			STL2_EXPECT(contains(k));
+			return data_.begin()[slots_.begin()[k.index].index];
+		}
+		const T& operator[](key_type k) const noexcept {
+			STL2_EXPECT(contains(k));
+			return data_.begin()[slots_.begin()[k.index].index];
+		}
+
+		// The key of the element at i.
+		key_type key_of(const_iterator i) const noexcept {
+			STL2_EXPECT(begin() <= i && i < end());
+			auto const index = slot_of_.begin()[i - begin()];
+			return {index, slots_.begin()[index].generation};
+		}
+
+		// Erases the element designated by k, if any; returns whether
+		// there was one. Invalidates iterators and pointers to the last
+		// element, which moves into the hole.
+		bool erase(key_type k)
+		requires
+			Movable<T>()
+		{
+			if (!contains(k)) {
+				return false;
+			}
+			auto& s = slots_.begin()[k.index];
+			auto const pos = s.index;
+			auto const last = static_cast<std::uint32_t>(size() - 1);
+			if (pos != last) {
+				data_.begin()[pos] = std::move(data_.back());
+				auto const moved = slot_of_.back();
+				slot_of_.begin()[pos] = moved;
+				slots_.begin()[moved].index = pos;
+			}
+			data_.pop_back();
+			slot_of_.pop_back();
+			free_slot(s, k.index);
+			return true;
+		}
+
+		void clear() noexcept {
+			for (auto index : slot_of_) {
+				free_slot(slots_.begin()[index], index);
+			}
+			data_.clear();
+			slot_of_.clear();
+		}
+
+	private:
+		data_t data_;
+		vector<slot, PA> slots_;
+		// slot_of_[i] is the slot of data_[i].
+		vector<std::uint32_t, PA> slot_of_;
+		std::uint32_t free_head_ = __slot_map::none;
+
+		void free_slot(slot& s, std::uint32_t index) noexcept {
+			++s.generation;
+			s.index = free_head_;
+			free_head_ = index;
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
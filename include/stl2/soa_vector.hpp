@@ -0,0 +1,500 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_SOA_VECTOR_HPP
+#define STL2_SOA_VECTOR_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+STL2_OPEN_NAMESPACE {
+	namespace __soa {
+		constexpr std::size_t column_alignment = 64;
+
+		// The unit of allocation: every column starts on a boundary of
+		// one of these, so kernels can use aligned vector loads.
+		struct alignas(column_alignment) line {
+			unsigned char bytes_[column_alignment];
+		};
+
+		template <class T>
+		constexpr std::ptrdiff_t lines_for(std::ptrdiff_t n) noexcept {
+			return (n * static_cast<std::ptrdiff_t>(sizeof(T)) +
+				static_cast<std::ptrdiff_t>(column_alignment) - 1) /
+				static_cast<std::ptrdiff_t>(column_alignment);
+		}
+
+		// A contiguous run of the elements of one column.
+		template <class T>
+		class column_span {
+			T* data_ = nullptr;
+			std::ptrdiff_t size_ = 0;
+		public:
+			column_span() = default;
+			constexpr column_span(T* data, std::ptrdiff_t size) noexcept
+			: data_{data}, size_{size} {}
+
+			constexpr T* begin() const noexcept { return data_; }
+			constexpr T* end() const noexcept { return data_ + size_; }
+			constexpr T* data() const noexcept { return data_; }
+			constexpr std::ptrdiff_t size() const noexcept { return size_; }
+			constexpr bool empty() const noexcept { return size_ == 0; }
+			T& operator[](std::ptrdiff_t i) const noexcept {
+				STL2_EXPECT(0 <= i && i < size_);
+				return data_[i];
+			}
+		};
+
+		template <class SoA>
+		class cursor {
+			template <class> friend class cursor;
+
+			SoA* vec_ = nullptr;
+			std::ptrdiff_t pos_ = 0;
+
+		public:
+			using value_type = typename remove_const_t<SoA>::value_type;
+			using difference_type = std::ptrdiff_t;
+
+			cursor() = default;
+			constexpr cursor(SoA& vec, difference_type pos) noexcept
+			: vec_{std::addressof(vec)}, pos_{pos} {}
+			template <class U>
+			requires
+				std::is_const<SoA>::value &&
+				Same<U, remove_const_t<SoA>>()
+			constexpr cursor(const cursor<U>& that) noexcept
+			: vec_{that.vec_}, pos_{that.pos_} {}
+
+			auto read() const noexcept { return (*vec_)[pos_]; }
+			void next() noexcept { ++pos_; }
+			void prev() noexcept { --pos_; }
+			void advance(difference_type n) noexcept { pos_ += n; }
+			difference_type distance_to(const cursor& that) const noexcept {
+				return that.pos_ - pos_;
+			}
+			bool equal(const cursor& that) const noexcept {
+				return pos_ == that.pos_;
+			}
+		};
+	}
+
+	// A sequence of rows whose fields are stored column by column: one
+	// allocation, through the proto-allocator rebound to cache-line-sized
+	// units, holds every column at a 64-byte aligned offset. All columns
+	// share a single capacity and grow in a single step. Rows are accessed
+	// through tuples of references; column<I>() exposes a field of every
+	// row as a contiguous span for vectorized kernels.
+	template <ProtoAllocator PA, class...Fields>
+	requires
+		sizeof...(Fields) > 0 &&
+		ProtoAllocator<PA, __soa::line>() &&
+		(ProtoAllocator<PA, Fields>() && ...) &&
+		((alignof(Fields) <= __soa::column_alignment) && ...)
+	class basic_soa_vector : detail::ebo_box<rebind_allocator_t<PA, __soa::line>> {
+		using line = __soa::line;
+		using line_allocator_type = rebind_allocator_t<PA, line>;
+		using base_t = detail::ebo_box<line_allocator_type>;
+		using traits = std::allocator_traits<line_allocator_type>;
+		using line_pointer = typename traits::pointer;
+		using indices = std::index_sequence_for<Fields...>;
+		using columns_t = std::tuple<Fields*...>;
+
+		template <std::size_t I>
+		using field_t = std::tuple_element_t<I, std::tuple<Fields...>>;
+		template <std::size_t I>
+		using field_allocator_t = rebind_allocator_t<PA, field_t<I>>;
+		template <std::size_t I>
+		using field_traits = std::allocator_traits<field_allocator_t<I>>;
+
+	public:
+		using value_type = std::tuple<Fields...>;
+		using reference = std::tuple<Fields&...>;
+		using const_reference = std::tuple<const Fields&...>;
+		using allocator_type = PA;
+		using size_type = difference_type_t<line_pointer>;
+		using iterator = __stl2::basic_iterator<__soa::cursor<basic_soa_vector>>;
+		using const_iterator = __stl2::basic_iterator<__soa::cursor<const basic_soa_vector>>;
+
+		template <std::size_t I>
+		using column_type = __soa::column_span<field_t<I>>;
+		template <std::size_t I>
+		using const_column_type = __soa::column_span<const field_t<I>>;
+
+		static constexpr std::size_t column_alignment = __soa::column_alignment;
+
+		~basic_soa_vector()
+		requires
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorDestructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			clear();
+			release(storage_, capacity_);
+		}
+
+		basic_soa_vector()
+			noexcept(is_nothrow_default_constructible<line_allocator_type>::value)
+			requires DefaultConstructible<line_allocator_type>() = default;
+
+		explicit basic_soa_vector(allocator_type a) noexcept
+		: base_t{line_allocator_type{std::move(a)}}
+		{}
+
+		basic_soa_vector(basic_soa_vector&& that) noexcept
+		: base_t{std::move(that.alloc())},
+			storage_{__stl2::exchange(that.storage_, nullptr)},
+			columns_{__stl2::exchange(that.columns_, columns_t{})},
+			size_{__stl2::exchange(that.size_, 0)},
+			capacity_{__stl2::exchange(that.capacity_, 0)}
+		{}
+
+		// FIXME: NYI
+		basic_soa_vector(const basic_soa_vector&) = delete;
+		basic_soa_vector& operator=(basic_soa_vector&&) & = delete;
+		basic_soa_vector& operator=(const basic_soa_vector&) & = delete;
+
+		allocator_type get_allocator() const noexcept {
+			return allocator_type{alloc()};
+		}
+
+		iterator begin() noexcept { return __soa::cursor<basic_soa_vector>{*this, 0}; }
+		iterator end() noexcept { return __soa::cursor<basic_soa_vector>{*this, size_}; }
+
+		const_iterator begin() const noexcept { return __soa::cursor<const basic_soa_vector>{*this, 0}; }
+		const_iterator end() const noexcept { return __soa::cursor<const basic_soa_vector>{*this, size_}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		size_type size() const noexcept { return size_; }
+		bool empty() const noexcept { return size_ == 0; }
+		size_type capacity() const noexcept { return capacity_; }
+
+		// Extension: a row counts the sizes of its fields; padding each
+		// column out to a whole line counts as overhead.
+		memory_stats memory_usage() const noexcept {
+			constexpr auto row = (sizeof(Fields) + ...);
+			memory_stats s;
+			s.payload = row * static_cast<std::size_t>(size_);
+			s.slack = row * static_cast<std::size_t>(capacity_ - size_);
+			if (storage_) {
+				s.overhead = __memory_stats::bytes<line>(lines_for(capacity_)) - s.payload - s.slack;
+				__memory_stats::allocation(s, alloc(), lines_for(capacity_));
+			}
+			return s;
+		}
+
+		reference operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return row<reference>(indices{}, i);
+		}
+		const_reference operator[](size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return row<const_reference>(indices{}, i);
+		}
+
+		reference front() noexcept { return (*this)[0]; }
+		const_reference front() const noexcept { return (*this)[0]; }
+		reference back() noexcept { return (*this)[size_ - 1]; }
+		const_reference back() const noexcept { return (*this)[size_ - 1]; }
+
+		// The I-th field of every row, contiguous and aligned to
+		// column_alignment.
+		template <std::size_t I>
+		column_type<I> column() noexcept {
+			return {std::get<I>(columns_), size_};
+		}
+		template <std::size_t I>
+		const_column_type<I> column() const noexcept {
+			return {std::get<I>(columns_), size_};
+		}
+		template <std::size_t I>
+		field_t<I>* data() noexcept {
+			return std::get<I>(columns_);
+		}
+		template <std::size_t I>
+		const field_t<I>* data() const noexcept {
+			return std::get<I>(columns_);
+		}
+
+		void clear() noexcept
+		requires
+			(AllocatorDestructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			destroy_rows(indices{}, columns_, 0, size_);
+			size_ = 0;
+		}
+
+		void reserve(size_type n)
+		requires
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorMoveConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			if (n > capacity_) {
+				change_capacity(n);
+			}
+		}
+
+		void shrink_to_fit()
+		requires
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorMoveConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			if (size_ < capacity_) {
+				change_capacity(size_);
+			}
+		}
+
+		// Constructs the I-th field of the new row from the I-th argument.
+		template <class...Args>
+		requires
+			sizeof...(Args) == sizeof...(Fields) &&
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorMoveConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...) &&
+			(AllocatorConstructible<rebind_allocator_t<PA, Fields>, Fields, Args>() && ...)
+		void emplace_back(Args&&...args) {
+			if (size_ == capacity_) {
+				emplace_back_slow_path(__stl2::forward<Args>(args)...);
+				return;
+			}
+			construct_row(indices{}, columns_, size_, __stl2::forward<Args>(args)...);
+			++size_;
+		}
+
+		void push_back(const value_type& v)
+		requires
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorCopyConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			push_back_(indices{}, v);
+		}
+
+		void pop_back() noexcept
+		requires
+			(AllocatorDestructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			STL2_EXPECT(size_ > 0);
+			--size_;
+			destroy_rows(indices{}, columns_, size_, size_ + 1);
+		}
+
+		void resize(size_type n)
+		requires
+			Allocator<line_allocator_type, line>() &&
+			(AllocatorDefaultConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...) &&
+			(AllocatorMoveConstructible<rebind_allocator_t<PA, Fields>, Fields>() && ...)
+		{
+			if (n < size_) {
+				destroy_rows(indices{}, columns_, n, size_);
+				size_ = n;
+				return;
+			}
+			reserve(n);
+			for (; size_ < n; ++size_) {
+				default_construct_row(indices{}, columns_, size_);
+			}
+		}
+
+	private:
+		line_pointer storage_ = nullptr;
+		columns_t columns_{};
+		size_type size_ = 0;
+		size_type capacity_ = 0;
+
+		line_allocator_type& alloc() { return base_t::get(); }
+		const line_allocator_type& alloc() const { return base_t::get(); }
+
+		static size_type lines_for(size_type n) noexcept {
+			size_type total = 0;
+			(void)(..., (total += __soa::lines_for<Fields>(n)));
+			return total;
+		}
+
+		template <class Ref, std::size_t...Is>
+		Ref row(std::index_sequence<Is...>, size_type i) const noexcept {
+			return Ref{std::get<Is>(columns_)[i]...};
+		}
+
+		template <std::size_t...Is>
+		void push_back_(std::index_sequence<Is...>, const value_type& v) {
+			emplace_back(std::get<Is>(v)...);
+		}
+
+		// Carves columns for n rows out of storage.
+		template <std::size_t...Is>
+		static columns_t carve(std::index_sequence<Is...>, line_pointer storage, size_type n) noexcept {
+			columns_t columns{};
+			if (storage) {
+				auto p = std::addressof(*storage);
+				(void)(..., (std::get<Is>(columns) = reinterpret_cast<field_t<Is>*>(p),
+					p += __soa::lines_for<field_t<Is>>(n)));
+			}
+			return columns;
+		}
+
+		template <std::size_t I, class...Args>
+		void construct_at(const columns_t& columns, size_type i, Args&&...args) {
+			auto a = field_allocator_t<I>{alloc()};
+			field_traits<I>::construct(a, std::get<I>(columns) + i, __stl2::forward<Args>(args)...);
+		}
+
+		template <std::size_t I>
+		void destroy_at(const columns_t& columns, size_type i) noexcept {
+			auto a = field_allocator_t<I>{alloc()};
+			field_traits<I>::destroy(a, std::get<I>(columns) + i);
+		}
+
+		// Constructs row i of columns; on failure, destroys whatever
+		// fields of the row were constructed.
+		template <std::size_t...Is, class...Args>
+		void construct_row(std::index_sequence<Is...>, const columns_t& columns,
+			size_type i, Args&&...args)
+		{
+			std::size_t constructed = 0;
+			try {
+				(void)(..., (construct_at<Is>(columns, i, __stl2::forward<Args>(args)), ++constructed));
+			} catch(...) {
+				(void)(..., (Is < constructed ? destroy_at<Is>(columns, i) : void()));
+				throw;
+			}
+		}
+		template <std::size_t...Is>
+		void default_construct_row(std::index_sequence<Is...>, const columns_t& columns, size_type i) {
+			std::size_t constructed = 0;
+			try {
+				(void)(..., (construct_at<Is>(columns, i), ++constructed));
+			} catch(...) {
+				(void)(..., (Is < constructed ? destroy_at<Is>(columns, i) : void()));
+				throw;
+			}
+		}
+
+		template <std::size_t...Is>
+		void destroy_rows(std::index_sequence<Is...>, const columns_t& columns,
+			size_type first, size_type last) noexcept
+		{
+			for (auto i = first; i != last; ++i) {
+				(void)(..., destroy_at<Is>(columns, i));
+			}
+		}
+
+		void release(line_pointer storage, size_type capacity) noexcept {
+			if (storage) {
+				traits::deallocate(alloc(), storage, lines_for(capacity));
+			}
+		}
+
+		// Constructs a copy of every row in the columns to - moving the
+		// fields whose move constructors cannot throw - leaving the
+		// originals in place. On failure, destroys whatever was
+		// constructed in to, so *this is unchanged unless a field that
+		// cannot be copied threw while moving.
+		template <std::size_t...Is>
+		void relocate(std::index_sequence<Is...>, const columns_t& to) {
+			std::size_t relocated = 0;
+			try {
+				(void)(..., (relocate_column<Is>(std::get<Is>(to)), ++relocated));
+			} catch(...) {
+				(void)(..., (Is < relocated ? destroy_column<Is>(std::get<Is>(to), size_) : void()));
+				throw;
+			}
+		}
+		template <std::size_t I>
+		void relocate_column(field_t<I>* to) {
+			auto a = field_allocator_t<I>{alloc()};
+			auto from = std::get<I>(columns_);
+			auto i = size_type{0};
+			try {
+				for (; i != size_; ++i) {
+					field_traits<I>::construct(a, to + i, std::move_if_noexcept(from[i]));
+				}
+			} catch(...) {
+				destroy_column<I>(to, i);
+				throw;
+			}
+		}
+		template <std::size_t I>
+		void destroy_column(field_t<I>* p, size_type n) noexcept {
+			auto a = field_allocator_t<I>{alloc()};
+			for (auto i = size_type{0}; i != n; ++i) {
+				field_traits<I>::destroy(a, p + i);
+			}
+		}
+
+		// Replaces the storage with the relocated rows in storage, which
+		// has room for n.
+		void adopt(line_pointer storage, const columns_t& columns, size_type n) noexcept {
+			destroy_rows(indices{}, columns_, 0, size_);
+			release(storage_, capacity_);
+			storage_ = storage;
+			columns_ = columns;
+			capacity_ = n;
+		}
+
+		void change_capacity(size_type n)
+		{
+			STL2_EXPECT(n >= size_);
+			line_pointer storage = n > 0 ? traits::allocate(alloc(), lines_for(n)) : nullptr;
+			auto columns = carve(indices{}, storage, n);
+			try {
+				relocate(indices{}, columns);
+			} catch(...) {
+				release(storage, n);
+				throw;
+			}
+			adopt(storage, columns, n);
+		}
+
+		// Requires size() == capacity(). Constructs the new row in the
+		// new storage before relocating, so that args may refer to
+		// existing rows.
+		template <class...Args>
+		void emplace_back_slow_path(Args&&...args) {
+			auto const n = grow();
+			auto const storage = traits::allocate(alloc(), lines_for(n));
+			auto const columns = carve(indices{}, storage, n);
+			try {
+				construct_row(indices{}, columns, size_, __stl2::forward<Args>(args)...);
+				try {
+					relocate(indices{}, columns);
+				} catch(...) {
+					destroy_rows(indices{}, columns, size_, size_ + 1);
+					throw;
+				}
+			} catch(...) {
+				release(storage, n);
+				throw;
+			}
+			adopt(storage, columns, n);
+			++size_;
+		}
+
+		size_type grow() const noexcept {
+			auto new_capacity = __stl2::max(size_type{16}, (3 * capacity_ + 1) / 2);
+			STL2_EXPECT(new_capacity > capacity_);
+			return new_capacity;
+		}
+	};
+
+	template <class...Fields>
+	using soa_vector = basic_soa_vector<std::allocator<void>, Fields...>;
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,292 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_STATIC_VECTOR_HPP
+#define STL2_STATIC_VECTOR_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+
+STL2_OPEN_NAMESPACE {
+	namespace __static_vector {
+		template <class T>
+		concept bool Trivial = std::is_trivial<T>::value;
+
+		// Elements live in raw storage and are constructed and destroyed
+		// in place.
+		template <class T, std::size_t N>
+		class storage {
+		public:
+			storage() = default;
+
+			// The destructor does not run for a constructor that throws,
+			// so the elements copied so far are destroyed here.
+			storage(const storage& that)
+			requires CopyConstructible<T>()
+			{
+				try {
+					for (auto i = std::ptrdiff_t{0}; i < that.size_; ++i) {
+						construct(that.data()[i]);
+					}
+				} catch(...) {
+					clear();
+					throw;
+				}
+			}
+
+			storage(storage&& that)
+				noexcept(is_nothrow_move_constructible<T>::value)
+			requires MoveConstructible<T>()
+			{
+				try {
+					for (auto i = std::ptrdiff_t{0}; i < that.size_; ++i) {
+						construct(std::move(that.data()[i]));
+					}
+				} catch(...) {
+					clear();
+					throw;
+				}
+			}
+
+			storage& operator=(const storage& that) &
+			requires Copyable<T>()
+			{
+				if (this != &that) {
+					clear();
+					for (auto i = std::ptrdiff_t{0}; i < that.size_; ++i) {
+						construct(that.data()[i]);
+					}
+				}
+				return *this;
+			}
+
+			storage& operator=(storage&& that) &
+				noexcept(is_nothrow_move_constructible<T>::value)
+			requires Movable<T>()
+			{
+				if (this != &that) {
+					clear();
+					for (auto i = std::ptrdiff_t{0}; i < that.size_; ++i) {
+						construct(std::move(that.data()[i]));
+					}
+				}
+				return *this;
+			}
+
+			~storage() { clear(); }
+
+			T* data() noexcept { return reinterpret_cast<T*>(raw_); }
+			const T* data() const noexcept { return reinterpret_cast<const T*>(raw_); }
+
+			template <class...Args>
+			T& construct(Args&&...args) {
+				auto const p = ::new (static_cast<void*>(data() + size_))
+					T(__stl2::forward<Args>(args)...);
+				++size_;
+				return *p;
+			}
+
+			void destroy_last() noexcept {
+				data()[--size_].~T();
+			}
+
+			void clear() noexcept {
+				while (size_ > 0) {
+					destroy_last();
+				}
+			}
+
+		protected:
+			std::ptrdiff_t size_ = 0;
+
+		private:
+			aligned_storage_t<sizeof(T), alignof(T)> raw_[N > 0 ? N : 1];
+		};
+
+		// Trivial elements live in a plain array, which makes every
+		// operation usable in constant expressions.
+		template <Trivial T, std::size_t N>
+		class storage<T, N> {
+		public:
+			constexpr T* data() noexcept { return data_; }
+			constexpr const T* data() const noexcept { return data_; }
+
+			template <class...Args>
+			constexpr T& construct(Args&&...args) {
+				data_[size_] = T(__stl2::forward<Args>(args)...);
+				return data_[size_++];
+			}
+
+			constexpr void destroy_last() noexcept {
+				--size_;
+			}
+
+			constexpr void clear() noexcept {
+				size_ = 0;
+			}
+
+		protected:
+			std::ptrdiff_t size_ = 0;
+
+		private:
+			T data_[N > 0 ? N : 1] {};
+		};
+	}
+
+	// A vector whose elements live inside the object, up to a fixed
+	// capacity N. When T is trivial, static_vector<T, N> is a literal type
+	// and all of its operations are constexpr, so tables can be built
+	// during constant evaluation and placed in read-only storage.
+	template <class T, std::size_t N>
+	requires
+		_Is<T, is_object> &&
+		Destructible<T>()
+	class static_vector : __static_vector::storage<T, N> {
+		using base_t = __static_vector::storage<T, N>;
+		using base_t::size_;
+	public:
+		using value_type = T;
+		using pointer = T*;
+		using const_pointer = const T*;
+		using size_type = std::ptrdiff_t;
+		using iterator = pointer;
+		using const_iterator = const_pointer;
+
+		static_vector() = default;
+
+		constexpr static_vector(std::initializer_list<T> il)
+		requires CopyConstructible<T>()
+		{
+			STL2_EXPECT(il.size() <= N);
+			for (auto&& e : il) {
+				base_t::construct(e);
+			}
+		}
+
+		constexpr explicit static_vector(size_type n)
+		requires DefaultConstructible<T>()
+		{
+			resize(n);
+		}
+
+		constexpr static_vector(size_type n, const T& t)
+		requires CopyConstructible<T>()
+		{
+			STL2_EXPECT(0 <= n && n <= capacity());
+			while (n-- > 0) {
+				base_t::construct(t);
+			}
+		}
+
+		constexpr iterator begin() noexcept { return data(); }
+		constexpr iterator end() noexcept { return data() + size_; }
+
+		constexpr const_iterator begin() const noexcept { return data(); }
+		constexpr const_iterator end() const noexcept { return data() + size_; }
+
+		constexpr const_iterator cbegin() const noexcept { return begin(); }
+		constexpr const_iterator cend() const noexcept { return end(); }
+
+		auto rbegin() noexcept { return reverse_iterator<iterator>{end()}; }
+		auto rend() noexcept { return reverse_iterator<iterator>{begin()}; }
+
+		auto rbegin() const noexcept { return reverse_iterator<const_iterator>{end()}; }
+		auto rend() const noexcept { return reverse_iterator<const_iterator>{begin()}; }
+
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+
+		constexpr T* data() noexcept { return base_t::data(); }
+		constexpr const T* data() const noexcept { return base_t::data(); }
+
+		constexpr T& operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return data()[i];
+		}
+		constexpr const T& operator[](size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i < size_);
+			return data()[i];
+		}
+
+		constexpr T& front() noexcept { STL2_EXPECT(!empty()); return data()[0]; }
+		constexpr const T& front() const noexcept { STL2_EXPECT(!empty()); return data()[0]; }
+		constexpr T& back() noexcept { STL2_EXPECT(!empty()); return data()[size_ - 1]; }
+		constexpr const T& back() const noexcept { STL2_EXPECT(!empty()); return data()[size_ - 1]; }
+
+		constexpr size_type size() const noexcept { return size_; }
+		constexpr bool empty() const noexcept { return size_ == 0; }
+		static constexpr size_type capacity() noexcept { return N; }
+		static constexpr size_type max_size() noexcept { return N; }
+
+		// Extension: the elements live inside the object, so there are
+		// no allocations; unused capacity is slack.
+		constexpr memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(size_);
+			s.slack = __memory_stats::bytes<T>(N - static_cast<std::size_t>(size_));
+			return s;
+		}
+
+		constexpr void clear() noexcept { base_t::clear(); }
+
+		// Requires size() < capacity()
+		template <class...Args>
+		requires
+			Constructible<T, Args...>()
+		constexpr T& emplace_back(Args&&...args) {
+			STL2_EXPECT(size_ < capacity());
+			return base_t::construct(__stl2::forward<Args>(args)...);
+		}
+
+		// Requires size() < capacity()
+		constexpr void push_back(const T& t)
+		requires
+			CopyConstructible<T>()
+		{
+			emplace_back(t);
+		}
+
+		// Requires size() < capacity()
+		constexpr void push_back(T&& t)
+		requires
+			MoveConstructible<T>()
+		{
+			emplace_back(std::move(t));
+		}
+
+		constexpr void pop_back() noexcept {
+			STL2_EXPECT(!empty());
+			base_t::destroy_last();
+		}
+
+		// Requires n <= capacity()
+		constexpr void resize(size_type n)
+		requires
+			DefaultConstructible<T>()
+		{
+			STL2_EXPECT(0 <= n && n <= capacity());
+			while (size_ > n) {
+				base_t::destroy_last();
+			}
+			while (size_ < n) {
+				base_t::construct();
+			}
+		}
+	};
+} STL2_CLOSE_NAMESPACE
+
+#endif
@@ -0,0 +1,718 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#ifndef STL2_STRING_HPP
+#define STL2_STRING_HPP
+
+#include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/type_traits.hpp>
+#include <stl2/utility.hpp>
+#include <stl2/vector.hpp>
+#include <stl2/detail/ebo_box.hpp>
+#include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
+#include <stl2/detail/concepts/allocator.hpp>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+
+STL2_OPEN_NAMESPACE {
+	namespace __string {
+		template <class CharT, class Traits>
+		concept bool Character =
+			std::is_trivial<CharT>::value && std::is_standard_layout<CharT>::value &&
+			Same<typename Traits::char_type, CharT>();
+	}
+
+	// A string whose characters are allocated with PA, which may use fancy
+	// pointers. Strings of up to sso_capacity characters - 23 chars, when
+	// pointers and sizes are 8 bytes - live inside the object, which is
+	// no larger than the three words that describe a heap buffer, and
+	// allocate nothing.
+	//
+	// The last byte of the object tells the two apart. Inline, it belongs
+	// to the last character slot, which holds sso_capacity - size(): a
+	// small number whose top bit is clear, and the terminating null when
+	// the string is full. On the heap, it belongs to the capacity word,
+	// whose top bit (on big-endian machines, whose low byte) is the flag.
+	template <class CharT, class Traits = std::char_traits<CharT>,
+		ProtoAllocator<CharT> PA = std::allocator<CharT>>
+	requires
+		__string::Character<CharT, Traits>
+	class basic_string : detail::ebo_box<rebind_allocator_t<PA, CharT>> {
+		using base_t = detail::ebo_box<rebind_allocator_t<PA, CharT>>;
+		using traits = std::allocator_traits<rebind_allocator_t<PA, CharT>>;
+	public:
+		using traits_type = Traits;
+		using value_type = CharT;
+		using allocator_type = rebind_allocator_t<PA, CharT>;
+		using pointer = typename traits::pointer;
+		using const_pointer = typename traits::const_pointer;
+		using size_type = difference_type_t<pointer>;
+		using iterator = CharT*;
+		using const_iterator = const CharT*;
+		using view_type = std::basic_string_view<CharT, Traits>;
+
+	private:
+		using cap_t = std::make_unsigned_t<size_type>;
+
+		struct long_rep {
+			pointer data;
+			size_type size;
+			cap_t cap;
+		};
+		static_assert(sizeof(long_rep) == sizeof(pointer) + 2 * sizeof(size_type),
+			"the capacity must end the object");
+		static_assert(sizeof(long_rep) % sizeof(CharT) == 0,
+			"characters must tile the object");
+
+		static constexpr std::size_t slots = sizeof(long_rep) / sizeof(CharT);
+
+		union rep {
+			long_rep l;
+			CharT s[slots];
+
+			rep() noexcept : s{} {}
+			~rep() {}
+		};
+
+	public:
+		// Extension
+		static constexpr size_type sso_capacity = slots - 1;
+
+		~basic_string()
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			free_();
+		}
+
+		basic_string()
+			noexcept(is_nothrow_default_constructible<allocator_type>::value)
+		requires
+			DefaultConstructible<allocator_type>()
+		{
+			set_short_size(0);
+		}
+
+		explicit basic_string(allocator_type a) noexcept
+		: base_t{std::move(a)}
+		{
+			set_short_size(0);
+		}
+
+		// Extension
+		// An empty string with room for n characters
+		basic_string(reserve_t, size_type n, allocator_type a)
+		requires
+			Allocator<allocator_type, CharT>()
+		: basic_string{std::move(a)}
+		{
+			reserve(n);
+		}
+
+		// Extension
+		basic_string(reserve_t, size_type n)
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, CharT>()
+		: basic_string{reserve_t{}, n, allocator_type{}}
+		{}
+
+		explicit basic_string(view_type v, allocator_type a)
+		requires
+			Allocator<allocator_type, CharT>()
+		: basic_string{std::move(a)}
+		{
+			append(v);
+		}
+
+		explicit basic_string(view_type v)
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, CharT>()
+		: basic_string{v, allocator_type{}}
+		{}
+
+		basic_string(const CharT* s, allocator_type a)
+		requires
+			Allocator<allocator_type, CharT>()
+		: basic_string{view_type{s}, std::move(a)}
+		{}
+
+		basic_string(const CharT* s)
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, CharT>()
+		: basic_string{view_type{s}, allocator_type{}}
+		{}
+
+		basic_string(size_type n, CharT c, allocator_type a)
+		requires
+			Allocator<allocator_type, CharT>()
+		: basic_string{std::move(a)}
+		{
+			append(n, c);
+		}
+
+		basic_string(size_type n, CharT c)
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, CharT>()
+		: basic_string{n, c, allocator_type{}}
+		{}
+
+		template <ForwardIterator I, Sentinel<I> S>
+		requires
+			Allocator<allocator_type, CharT>() &&
+			ConvertibleTo<reference_t<I>, CharT>()
+		basic_string(I first, S last, allocator_type a)
+		: basic_string{std::move(a)}
+		{
+			append(std::move(first), std::move(last));
+		}
+
+		template <ForwardIterator I, Sentinel<I> S>
+		requires
+			DefaultConstructible<allocator_type>() &&
+			Allocator<allocator_type, CharT>() &&
+			ConvertibleTo<reference_t<I>, CharT>()
+		basic_string(I first, S last)
+		: basic_string{std::move(first), std::move(last), allocator_type{}}
+		{}
+
+		basic_string(const basic_string& that)
+		requires
+			Allocator<allocator_type, CharT>()
+		: basic_string{view_type{that},
+			traits::select_on_container_copy_construction(that.alloc())}
+		{}
+
+		basic_string(basic_string&& that) noexcept
+		: base_t{std::move(that.alloc())}
+		{
+			steal_(that);
+		}
+
+		basic_string& operator=(basic_string&& that) &
+		noexcept(traits::is_always_equal::value ||
+			traits::propagate_on_container_move_assignment::value)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			if (std::addressof(that) != this) {
+				if (traits::is_always_equal::value ||
+					traits::propagate_on_container_move_assignment::value ||
+					alloc() == that.alloc())
+				{
+					free_();
+					if (traits::propagate_on_container_move_assignment::value) {
+						alloc() = std::move(that.alloc());
+					}
+					steal_(that);
+				} else {
+					assign(view_type{that});
+				}
+			}
+			return *this;
+		}
+
+		basic_string& operator=(const basic_string& that) &
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			if (std::addressof(that) != this) {
+				if (!traits::is_always_equal::value &&
+					traits::propagate_on_container_copy_assignment::value &&
+					!(alloc() == that.alloc()))
+				{
+					free_();
+					set_short_size(0);
+					alloc() = that.alloc();
+				}
+				assign(view_type{that});
+			}
+			return *this;
+		}
+
+		basic_string& operator=(view_type v) &
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			return assign(v);
+		}
+
+		// v may view part of *this.
+		basic_string& assign(view_type v)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			auto const n = static_cast<size_type>(v.size());
+			if (n <= capacity()) {
+				Traits::move(data(), v.data(), n);
+				set_size(n);
+			} else {
+				replace_buffer_(n, 0, n, [&](CharT* d) { Traits::copy(d, v.data(), n); });
+			}
+			return *this;
+		}
+
+		void swap(basic_string& that)
+		noexcept(traits::is_always_equal::value || traits::propagate_on_container_swap::value)
+		{
+			if (traits::propagate_on_container_swap::value) {
+				ranges::swap(alloc(), that.alloc());
+			} else if (!traits::is_always_equal::value) {
+				STL2_EXPECT(alloc() == that.alloc());
+			}
+			rep tmp;
+			move_rep_(tmp, that.rep_);
+			move_rep_(that.rep_, rep_);
+			move_rep_(rep_, tmp);
+		}
+		friend void swap(basic_string& lhs, basic_string& rhs)
+		noexcept(noexcept(lhs.swap(rhs)))
+		{
+			lhs.swap(rhs);
+		}
+
+		allocator_type get_allocator() const noexcept {
+			return alloc();
+		}
+
+		iterator begin() noexcept { return data(); }
+		iterator end() noexcept { return data() + size(); }
+
+		const_iterator begin() const noexcept { return data(); }
+		const_iterator end() const noexcept { return data() + size(); }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+		const_iterator cend() const noexcept { return end(); }
+
+		auto rbegin() noexcept { return reverse_iterator<iterator>{end()}; }
+		auto rend() noexcept { return reverse_iterator<iterator>{begin()}; }
+
+		auto rbegin() const noexcept { return reverse_iterator<const_iterator>{end()}; }
+		auto rend() const noexcept { return reverse_iterator<const_iterator>{begin()}; }
+
+		auto crbegin() const noexcept { return rbegin(); }
+		auto crend() const noexcept { return rend(); }
+
+		// Followed by a null character
+		CharT* data() noexcept {
+			return is_long_(rep_) ? std::addressof(*rep_.l.data) : rep_.s;
+		}
+		const CharT* data() const noexcept {
+			return is_long_(rep_) ? std::addressof(*rep_.l.data) : rep_.s;
+		}
+		const CharT* c_str() const noexcept { return data(); }
+
+		operator view_type() const noexcept {
+			return view_type{data(), static_cast<std::size_t>(size())};
+		}
+
+		CharT& operator[](size_type i) noexcept {
+			STL2_EXPECT(0 <= i && i < size());
+			return data()[i];
+		}
+		// s[s.size()] is the terminating null.
+		const CharT& operator[](size_type i) const noexcept {
+			STL2_EXPECT(0 <= i && i <= size());
+			return data()[i];
+		}
+
+		CharT& front() noexcept { STL2_EXPECT(!empty()); return data()[0]; }
+		const CharT& front() const noexcept { STL2_EXPECT(!empty()); return data()[0]; }
+		CharT& back() noexcept { STL2_EXPECT(!empty()); return data()[size() - 1]; }
+		const CharT& back() const noexcept { STL2_EXPECT(!empty()); return data()[size() - 1]; }
+
+		size_type size() const noexcept {
+			return is_long_(rep_) ? rep_.l.size :
+				sso_capacity - static_cast<size_type>(rep_.s[sso_capacity]);
+		}
+		size_type length() const noexcept {
+			return size();
+		}
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+		size_type capacity() const noexcept {
+			return is_long_(rep_) ? decode_(rep_.l.cap) : sso_capacity;
+		}
+
+		// Extension
+		// A heap buffer's terminating null counts as overhead; an inline
+		// string allocates nothing.
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			s.payload = __memory_stats::bytes<CharT>(size());
+			s.slack = __memory_stats::bytes<CharT>(capacity() - size());
+			if (is_long_(rep_)) {
+				s.overhead = sizeof(CharT);
+				__memory_stats::allocation(s, alloc(), capacity() + 1);
+			}
+			return s;
+		}
+		static constexpr size_type max_size() noexcept {
+			// Keep clear of the flag, and leave room for the null.
+			return static_cast<size_type>(std::numeric_limits<cap_t>::max() >> 9) - 1;
+		}
+
+		// Extension
+		// True if the characters live inside the object
+		bool is_inline() const noexcept {
+			return !is_long_(rep_);
+		}
+
+		void clear() noexcept {
+			set_size(0);
+		}
+
+		// Requires n <= max_size()
+		void reserve(size_type n)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			if (n > capacity()) {
+				reallocate_(n);
+			}
+		}
+
+		// Moves the characters back inside the object when they fit.
+		void shrink_to_fit()
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			if (!is_long_(rep_)) {
+				return;
+			}
+			auto const n = size();
+			if (n <= sso_capacity) {
+				CharT buf[slots];
+				Traits::copy(buf, data(), n);
+				free_();
+				Traits::copy(rep_.s, buf, n);
+				set_short_size(n);
+			} else if (n < capacity()) {
+				reallocate_(n);
+			}
+		}
+
+		// Requires n <= max_size()
+		void resize(size_type n, CharT c)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			STL2_EXPECT(n >= 0);
+			auto const sz = size();
+			if (n <= sz) {
+				set_size(n);
+			} else {
+				append(n - sz, c);
+			}
+		}
+
+		// Requires n <= max_size()
+		void resize(size_type n)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			resize(n, CharT());
+		}
+
+		// Extension (from C++23)
+		// Makes room for n characters, calls op(data(), n) to write them,
+		// and keeps the first r, where r = op(data(), n) and 0 <= r <= n.
+		// op sees the current characters in [data(), data() + size());
+		// the rest of the n are unspecified. There is no zero fill to
+		// pay for, unlike resize(n) followed by writing the characters.
+		// If op throws, size() is unchanged but the characters are not.
+		template <class Op>
+		requires
+			Allocator<allocator_type, CharT>() &&
+			requires (Op& op, CharT* p, size_type n) {
+				{ op(p, n) } -> size_type;
+			}
+		void resize_and_overwrite(size_type n, Op op) {
+			STL2_EXPECT(0 <= n && n <= max_size());
+			if (n > capacity()) {
+				reallocate_(n);
+			}
+			auto const r = static_cast<size_type>(op(data(), n));
+			STL2_EXPECT(0 <= r && r <= n);
+			set_size(r);
+		}
+
+		// Every append allocates at most once, and then copies the
+		// existing characters and the new ones straight into the new
+		// buffer; the argument may refer to the characters of *this.
+
+		basic_string& append(view_type v)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			auto const n = static_cast<size_type>(v.size());
+			append_(n, [&](CharT* d) { Traits::copy(d, v.data(), n); });
+			return *this;
+		}
+
+		basic_string& append(const CharT* s, size_type n)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			STL2_EXPECT(n >= 0);
+			append_(n, [&](CharT* d) { Traits::copy(d, s, n); });
+			return *this;
+		}
+
+		basic_string& append(size_type n, CharT c)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			STL2_EXPECT(n >= 0);
+			append_(n, [&](CharT* d) { Traits::assign(d, n, c); });
+			return *this;
+		}
+
+		template <ForwardIterator I, Sentinel<I> S>
+		requires
+			Allocator<allocator_type, CharT>() &&
+			ConvertibleTo<reference_t<I>, CharT>()
+		basic_string& append(I first, S last) {
+			auto const n = static_cast<size_type>(__stl2::distance(first, last));
+			append_(n, [&](CharT* d) {
+				for (; first != last; ++first, ++d) {
+					Traits::assign(*d, static_cast<CharT>(*first));
+				}
+			});
+			return *this;
+		}
+
+		basic_string& operator+=(view_type v)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			return append(v);
+		}
+
+		basic_string& operator+=(CharT c)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			push_back(c);
+			return *this;
+		}
+
+		void push_back(CharT c)
+		requires
+			Allocator<allocator_type, CharT>()
+		{
+			auto const sz = size();
+			if (sz < capacity()) {
+				Traits::assign(data()[sz], c);
+				set_size(sz + 1);
+			} else {
+				append(1, c);
+			}
+		}
+
+		void pop_back() noexcept {
+			STL2_EXPECT(!empty());
+			set_size(size() - 1);
+		}
+
+		int compare(view_type v) const noexcept {
+			return view_type{*this}.compare(v);
+		}
+
+		friend bool operator==(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return view_type{lhs} == view_type{rhs};
+		}
+		friend bool operator==(const basic_string& lhs, view_type rhs) noexcept {
+			return view_type{lhs} == rhs;
+		}
+		friend bool operator==(view_type lhs, const basic_string& rhs) noexcept {
+			return lhs == view_type{rhs};
+		}
+		friend bool operator==(const basic_string& lhs, const CharT* rhs) noexcept {
+			return view_type{lhs} == view_type{rhs};
+		}
+		friend bool operator==(const CharT* lhs, const basic_string& rhs) noexcept {
+			return view_type{lhs} == view_type{rhs};
+		}
+		friend bool operator!=(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return !(lhs == rhs);
+		}
+		friend bool operator!=(const basic_string& lhs, view_type rhs) noexcept {
+			return !(lhs == rhs);
+		}
+		friend bool operator!=(view_type lhs, const basic_string& rhs) noexcept {
+			return !(lhs == rhs);
+		}
+		friend bool operator!=(const basic_string& lhs, const CharT* rhs) noexcept {
+			return !(lhs == rhs);
+		}
+		friend bool operator!=(const CharT* lhs, const basic_string& rhs) noexcept {
+			return !(lhs == rhs);
+		}
+		friend bool operator<(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return lhs.compare(rhs) < 0;
+		}
+		friend bool operator>(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return rhs < lhs;
+		}
+		friend bool operator<=(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return !(rhs < lhs);
+		}
+		friend bool operator>=(const basic_string& lhs, const basic_string& rhs) noexcept {
+			return !(lhs < rhs);
+		}
+
+	private:
+		rep rep_;
+
+		allocator_type& alloc() noexcept { return base_t::get(); }
+		const allocator_type& alloc() const noexcept { return base_t::get(); }
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		static constexpr cap_t encode_(size_type cap) noexcept {
+			return static_cast<cap_t>(cap) << 8 | 0x80;
+		}
+		static constexpr size_type decode_(cap_t cap) noexcept {
+			return static_cast<size_type>(cap >> 8);
+		}
+#else
+		static constexpr cap_t long_flag = cap_t{0x80} << (8 * (sizeof(cap_t) - 1));
+
+		static constexpr cap_t encode_(size_type cap) noexcept {
+			return static_cast<cap_t>(cap) | long_flag;
+		}
+		static constexpr size_type decode_(cap_t cap) noexcept {
+			return static_cast<size_type>(cap & ~long_flag);
+		}
+#endif
+
+		static bool is_long_(const rep& r) noexcept {
+			return reinterpret_cast<const unsigned char*>(&r)[sizeof(rep) - 1] & 0x80;
+		}
+
+		void set_short_size(size_type n) noexcept {
+			STL2_EXPECT(0 <= n && n <= sso_capacity);
+			rep_.s[sso_capacity] = static_cast<CharT>(sso_capacity - n);
+			Traits::assign(rep_.s[n], CharT());
+		}
+
+		void set_size(size_type n) noexcept {
+			if (is_long_(rep_)) {
+				STL2_EXPECT(0 <= n && n <= decode_(rep_.l.cap));
+				rep_.l.size = n;
+				Traits::assign(std::addressof(*rep_.l.data)[n], CharT());
+			} else {
+				set_short_size(n);
+			}
+		}
+
+		// Deallocates the heap buffer, if any, leaving rep_ without an
+		// active member.
+		void free_() noexcept {
+			if (is_long_(rep_)) {
+				traits::deallocate(alloc(), rep_.l.data, decode_(rep_.l.cap) + 1);
+				rep_.l.~long_rep();
+			}
+		}
+
+		// Moves the characters of from, heap buffer and all, into to,
+		// which holds nothing, and leaves from empty and inline.
+		static void move_rep_(rep& to, rep& from) noexcept {
+			if (is_long_(from)) {
+				::new (static_cast<void*>(&to.l)) long_rep{std::move(from.l)};
+				from.l.~long_rep();
+			} else {
+				Traits::copy(to.s, from.s, slots);
+			}
+			from.s[sso_capacity] = static_cast<CharT>(sso_capacity);
+			Traits::assign(from.s[0], CharT());
+		}
+
+		void steal_(basic_string& that) noexcept {
+			move_rep_(rep_, that.rep_);
+		}
+
+		// Capacity for n characters, growing geometrically
+		size_type grown_(size_type n) const noexcept {
+			STL2_EXPECT(n <= max_size());
+			auto const cap = capacity();
+			auto const next = cap <= (max_size() - 1) / 3 * 2 ? (3 * cap + 1) / 2 : max_size();
+			return n < next ? next : n;
+		}
+
+		// Moves to a new buffer of capacity cap holding n characters: the
+		// first keep of the current ones, followed by the n - keep that
+		// write(d) puts at d. The current characters stay valid until
+		// write returns.
+		template <class Write>
+		void replace_buffer_(size_type cap, size_type keep, size_type n, Write write) {
+			STL2_EXPECT(0 <= keep && keep <= size() && keep <= n && n <= cap && cap <= max_size());
+			auto p = traits::allocate(alloc(), cap + 1);
+			auto const d = std::addressof(*p);
+			Traits::copy(d, data(), keep);
+			try {
+				write(d + keep);
+			} catch(...) {
+				traits::deallocate(alloc(), p, cap + 1);
+				throw;
+			}
+			Traits::assign(d[n], CharT());
+			free_();
+			::new (static_cast<void*>(&rep_.l)) long_rep{std::move(p), n, encode_(cap)};
+		}
+
+		void reallocate_(size_type cap) {
+			auto const n = size();
+			replace_buffer_(cap, n, n, [](CharT*) {});
+		}
+
+		template <class Write>
+		void append_(size_type n, Write write) {
+			auto const sz = size();
+			STL2_EXPECT(n <= max_size() - sz);
+			if (n <= capacity() - sz) {
+				write(data() + sz);
+				set_size(sz + n);
+			} else {
+				replace_buffer_(grown_(sz + n), sz, sz + n, std::move(write));
+			}
+		}
+	};
+
+	using string = basic_string<char>;
+	using wstring = basic_string<wchar_t>;
+	using u16string = basic_string<char16_t>;
+	using u32string = basic_string<char32_t>;
+} STL2_CLOSE_NAMESPACE
+
+namespace std {
+	template <class CharT, class PA>
+	struct hash<__stl2::basic_string<CharT, std::char_traits<CharT>, PA>> {
+		std::size_t operator()(
+			const __stl2::basic_string<CharT, std::char_traits<CharT>, PA>& s) const noexcept
+		{
+			return std::hash<std::basic_string_view<CharT>>{}(s);
+		}
+	};
+}
+
+#endif
@@ -13,14 +13,31 @@
 #define STL2_VECTOR_HPP
 
 #include <stl2/algorithm.hpp>
+#include <stl2/execution.hpp>
 #include <stl2/iterator.hpp>
+#include <stl2/memory_stats.hpp>
+#include <stl2/simd_algorithm.hpp>
 #include <stl2/type_traits.hpp>
 #include <stl2/detail/ebo_box.hpp>
 #include <stl2/detail/fwd.hpp>
+#include <stl2/detail/contracts.hpp>
 #include <stl2/detail/concepts/allocator.hpp>
+#include <functional>
 
 STL2_OPEN_NAMESPACE {
 	struct reserve_t {};
+	struct adopt_t {};
+
+	namespace __vector {
+		// Allocators that advertise a lane_width (e.g. aligned_allocator)
+		// have vector round every allocation up to a whole number of lanes.
+		template <class A>
+		constexpr std::ptrdiff_t lane_width = 1;
+		template <class A>
+		requires
+			requires { { A::lane_width } -> std::ptrdiff_t; }
+		constexpr std::ptrdiff_t lane_width<A> = A::lane_width;
+	}
 
 	template <class T, ProtoAllocator<T> PA = std::allocator<T>>
 	class vector : detail::ebo_box<rebind_allocator_t<PA, T>> {
@@ -35,6 +52,19 @@ STL2_OPEN_NAMESPACE {
 		using iterator = pointer;
 		using const_iterator = const_pointer;
 
+		// Extension
+		static constexpr size_type lane_width = __vector::lane_width<allocator_type>;
+
+		// Extension
+		// A buffer of capacity elements, the first size of which are
+		// constructed, allocated from an allocator that compares equal
+		// to the vector's.
+		struct buffer {
+			pointer data;
+			size_type size;
+			size_type capacity;
+		};
+
 		~vector()
 			requires Allocator<allocator_type, T>() &&
 				AllocatorDestructible<allocator_type, T>()
@@ -55,8 +85,8 @@ STL2_OPEN_NAMESPACE {
 		vector(reserve_t, size_type n, allocator_type a)
 			requires Allocator<allocator_type, T>()
 		: base_t{std::move(a)},
-			begin_{traits::allocate(alloc(), (STL2_EXPECT(n >= 0), n))},
-			end_{begin_}, alloc_{begin_ + n}
+			begin_{traits::allocate(alloc(), padded((STL2_EXPECT(n >= 0), n)))},
+			end_{begin_}, alloc_{begin_ + padded(n)}
 		{}
 
 		// Extension
@@ -65,6 +95,20 @@ STL2_OPEN_NAMESPACE {
 				DefaultConstructible<allocator_type>()
 		: vector{reserve_t{}, n, allocator_type{}} {}
 
+		// Extension
+		// Takes ownership of b without copying or constructing anything.
+		vector(adopt_t, buffer b, allocator_type a) noexcept
+		: base_t{std::move(a)},
+			begin_{(STL2_EXPECT(b.data || b.capacity == 0), b.data)},
+			end_{begin_ + (STL2_EXPECT(0 <= b.size && b.size <= b.capacity), b.size)},
+			alloc_{begin_ + (STL2_EXPECT(padded(b.size) <= b.capacity), b.capacity)}
+		{}
+
+		// Extension
+		vector(adopt_t, buffer b) noexcept
+			requires DefaultConstructible<allocator_type>()
+		: vector{adopt_t{}, b, allocator_type{}} {}
+
 		vector(size_type n, allocator_type a)
 			requires AllocatorDefaultConstructible<allocator_type, T>()
 		: vector{reserve_t{}, n, std::move(a)}
@@ -78,7 +122,7 @@ STL2_OPEN_NAMESPACE {
 			requires DefaultConstructible<allocator_type>() &&
 				Allocator<allocator_type, T>() &&
 				AllocatorDefaultConstructible<allocator_type, T>()
-		: vector{reserve_t{}, n, allocator_type{}}
+		: vector{n, allocator_type{}}
 		{}
 
 		vector(size_type n, const T& t, allocator_type a)
@@ -95,7 +139,53 @@ STL2_OPEN_NAMESPACE {
 			requires DefaultConstructible<allocator_type>() &&
 				Allocator<allocator_type, T>() &&
 				AllocatorCopyConstructible<allocator_type, T>()
-		: vector{reserve_t{}, n, allocator_type{}}
+		: vector{n, t, allocator_type{}}
+		{}
+
+		// Extension
+		// The bulk operations that take an execution policy partition the
+		// elements across the threads of a pool; under par and par_unseq,
+		// allocator_type's construct and destroy must be safe to call
+		// concurrently. Each thread constructs - and so first touches -
+		// the same slice of the buffer every time, which places the pages
+		// of large vectors on the NUMA node of the thread that owns them.
+		template <ExecutionPolicy EP>
+		vector(EP&& policy, size_type n, allocator_type a)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorDefaultConstructible<allocator_type, T>()
+		: vector{reserve_t{}, n, std::move(a)}
+		{
+			construct_(policy, end_, n);
+			end_ += n;
+		}
+
+		// Extension
+		template <ExecutionPolicy EP>
+		vector(EP&& policy, size_type n)
+			requires DefaultConstructible<allocator_type>() &&
+				Allocator<allocator_type, T>() &&
+				AllocatorDefaultConstructible<allocator_type, T>()
+		: vector{policy, n, allocator_type{}}
+		{}
+
+		// Extension
+		template <ExecutionPolicy EP>
+		vector(EP&& policy, size_type n, const T& t, allocator_type a)
+			requires Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		: vector{reserve_t{}, n, std::move(a)}
+		{
+			construct_(policy, end_, n, t);
+			end_ += n;
+		}
+
+		// Extension
+		template <ExecutionPolicy EP>
+		vector(EP&& policy, size_type n, const T& t)
+			requires DefaultConstructible<allocator_type>() &&
+				Allocator<allocator_type, T>() &&
+				AllocatorCopyConstructible<allocator_type, T>()
+		: vector{policy, n, t, allocator_type{}}
 		{}
 
 		// FIXME: NYI
@@ -152,6 +242,25 @@ STL2_OPEN_NAMESPACE {
 			return alloc_ - begin_;
 		}
 
+		// Extension
+		// size() rounded up to a whole number of lanes; never exceeds
+		// capacity(). Kernels may load and store whole lanes in
+		// [begin(), begin() + padded_size()).
+		size_type padded_size() const noexcept {
+			return padded(size());
+		}
+
+		// Extension
+		memory_stats memory_usage() const noexcept {
+			memory_stats s;
+			s.payload = __memory_stats::bytes<T>(size());
+			s.slack = __memory_stats::bytes<T>(capacity() - size());
+			if (capacity() > 0) {
+				__memory_stats::allocation(s, alloc(), capacity());
+			}
+			return s;
+		}
+
 		void clear() noexcept
 		requires
 			AllocatorDestructible<allocator_type, T>()
@@ -160,6 +269,73 @@ STL2_OPEN_NAMESPACE {
 			end_ = begin_;
 		}
 
+		// Extension
+		// Relinquishes ownership of the elements and storage, which the
+		// caller must eventually destroy and deallocate with an allocator
+		// equal to get_allocator(). Leaves *this empty.
+		buffer release() noexcept {
+			auto b = buffer{begin_, size(), capacity()};
+			begin_ = end_ = alloc_ = nullptr;
+			return b;
+		}
+
+		// Extension
+		template <ExecutionPolicy EP>
+		void clear(EP&& policy)
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			destroy_(policy, begin_, end_);
+			end_ = begin_;
+		}
+
+		void assign(size_type n, const T& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			AllocatorCopyConstructible<allocator_type, T>() &&
+			Copyable<T>()
+		{
+			assign(execution::seq, n, t);
+		}
+
+		// Extension
+		template <ExecutionPolicy EP>
+		void assign(EP&& policy, size_type n, const T& t)
+		requires
+			Allocator<allocator_type, T>() &&
+			AllocatorCopyConstructible<allocator_type, T>() &&
+			Copyable<T>()
+		{
+			STL2_EXPECT(n >= 0);
+			if (n > capacity()) {
+				// Build the new contents first: t may be an element.
+				tmp_buf buf{alloc(), padded(n)};
+				construct_(policy, buf.begin_, n, t);
+				buf.end_ = buf.begin_ + n;
+				swap(buf);
+				destroy_(policy, buf.begin_, buf.end_);
+				buf.end_ = buf.begin_;
+				return;
+			}
+			if (is_element(t)) {
+				// Workers would read t while another overwrites it.
+				T const copy = t;
+				assign(policy, n, copy);
+				return;
+			}
+			auto const first = begin_;
+			__execution::for_each_chunk(policy, __stl2::min(n, size()), grain(),
+				[&](size_type lo, size_type hi) {
+					__stl2::fill(first + lo, first + hi, t);
+				});
+			if (n < size()) {
+				destroy_(policy, begin_ + n, end_);
+			} else {
+				construct_(policy, end_, n - size(), t);
+			}
+			end_ = begin_ + n;
+		}
+
 		// Requires n <= capacity() or *this is reallocatable
 		void reserve(size_type n)
 		requires
@@ -177,7 +353,7 @@ STL2_OPEN_NAMESPACE {
 			Allocator<allocator_type, T>() &&
 			AllocatorMoveConstructible<allocator_type, T>()
 		{
-			if (end_ < alloc_) {
+			if (padded(size()) < capacity()) {
 				change_capacity(size());
 			}
 		}
@@ -201,6 +377,24 @@ STL2_OPEN_NAMESPACE {
 			}
 		}
 
+		// Extension
+		// Requires n <= capacity() or *this is reallocatable
+		template <ExecutionPolicy EP>
+		void resize(EP&& policy, size_type n)
+		requires
+			Allocator<allocator_type, T>() &&
+			AllocatorDefaultConstructible<allocator_type, T>() &&
+			AllocatorMoveConstructible<allocator_type, T>()
+		{
+			reserve(n);
+			if (n < size()) {
+				destroy_(policy, begin_ + n, end_);
+			} else {
+				construct_(policy, end_, n - size());
+			}
+			end_ = begin_ + n;
+		}
+
 		// Extension
 		// Requires size() < capacity()
 		template <class...Args>
@@ -213,6 +407,18 @@ STL2_OPEN_NAMESPACE {
 			++end_;
 		}
 
+		// Extension
+		// Requires 0 <= n <= capacity() - size(), and that the n slots past
+		// end() hold the bytes of valid Ts - written there by readv, say.
+		// Makes them elements without constructing anything.
+		void extend_unchecked(size_type n) noexcept
+		requires
+			std::is_trivially_copyable<T>::value
+		{
+			STL2_EXPECT(0 <= n && n <= alloc_ - end_);
+			end_ += n;
+		}
+
 		// Extension?
 		class unchecked_back_inserter {
 			detail::raw_ptr<vector> vec_;
@@ -291,6 +497,10 @@ STL2_OPEN_NAMESPACE {
 		pointer end_ = nullptr;
 		pointer alloc_ = nullptr;
 
+		static constexpr size_type padded(size_type n) noexcept {
+			return (n + lane_width - 1) / lane_width * lane_width;
+		}
+
 		// FIXME: alloc and alloc_ are too similar.
 		allocator_type& alloc() { return base_t::get(); }
 		const allocator_type& alloc() const { return base_t::get(); }
@@ -304,6 +514,61 @@ STL2_OPEN_NAMESPACE {
 			}
 		}
 
+		// Elements per chunk of a parallel bulk operation: whole pages, and
+		// enough of them to amortize waking a thread.
+		static constexpr size_type grain() noexcept {
+			return sizeof(T) < 65536 ? 65536 / sizeof(T) : 1;
+		}
+
+		// Constructs n elements at first from args, partitioned per
+		// policy. On failure, nothing is left constructed.
+		template <class EP, class...Args>
+		void construct_(EP& policy, pointer first, size_type n, const Args&...args)
+		requires
+			AllocatorConstructible<allocator_type, T, const Args&...>()
+		{
+			__execution::for_each_chunk(policy, n, grain(),
+				[&](size_type lo, size_type hi) {
+					auto p = first + lo;
+					try {
+						for (; p != first + hi; ++p) {
+							traits::construct(alloc(), std::addressof(*p), args...);
+						}
+					} catch(...) {
+						clear_(first + lo, p);
+						throw;
+					}
+				},
+				[&](size_type lo, size_type hi) {
+					clear_(first + lo, first + hi);
+				});
+		}
+
+		// Arithmetic elements that std::allocator would construct are
+		// simply stored, by the vector kernel of simd_algorithm.hpp.
+		template <class EP>
+		void construct_(EP& policy, pointer first, size_type n, const T& t)
+		requires
+			__simd::Vectorizable<T, T> &&
+			Same<allocator_type, std::allocator<T>>()
+		{
+			__execution::for_each_chunk(policy, n, grain(),
+				[&](size_type lo, size_type hi) {
+					__stl2::fill(first + lo, first + hi, t);
+				});
+		}
+
+		template <class EP>
+		void destroy_(EP& policy, pointer first, pointer last)
+		requires
+			AllocatorDestructible<allocator_type, T>()
+		{
+			__execution::for_each_chunk(policy, last - first, grain(),
+				[&](size_type lo, size_type hi) {
+					clear_(first + lo, first + hi);
+				});
+		}
+
 		struct tmp_buf {
 			using value_type = vector::value_type;
 
@@ -389,6 +654,16 @@ STL2_OPEN_NAMESPACE {
 			Allocator<allocator_type, T>() &&
 			AllocatorMoveConstructible<allocator_type, T>();
 
+		bool is_element(const T& t) const noexcept {
+			if (begin_ == end_) {
+				return false;
+			}
+			auto const first = std::addressof(*begin_);
+			auto const p = std::addressof(t);
+			return !std::less<const T*>{}(p, first) &&
+				std::less<const T*>{}(p, first + size());
+		}
+
 		size_type grow() const {
 			auto new_capacity = __stl2::max(size_type{1}, (3 * capacity() + 1) / 2);
 			STL2_EXPECT(new_capacity > capacity());
@@ -404,7 +679,7 @@ STL2_OPEN_NAMESPACE {
 		AllocatorMoveConstructible<allocator_type, T>() &&
 		AllocatorConstructible<allocator_type, T, Args...>()
 	{
-		tmp_buf buf{alloc(), grow()};
+		tmp_buf buf{alloc(), padded(grow())};
 		auto new_element_ptr = buf.begin_ + size();
 		traits::construct(alloc(), std::addressof(*new_element_ptr),
 			__stl2::forward<Args>(args)...);
@@ -424,7 +699,7 @@ STL2_OPEN_NAMESPACE {
 		AllocatorMoveConstructible<allocator_type, T>()
 	{
 		STL2_EXPECT(n >= size());
-		tmp_buf buf{alloc(), n};
+		tmp_buf buf{alloc(), padded(n)};
 		__stl2::move(*this, __stl2::back_inserter(buf));
 		swap(buf);
 	}
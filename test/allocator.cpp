@@ -9,8 +9,12 @@
 //
 // Project home: https://github.com/caseycarter/cmcstl2
 //
+#include <stl2/aligned_allocator.hpp>
 #include <stl2/detail/concepts/allocator.hpp>
+#include <stl2/vector.hpp>
+#include <cstdint>
 #include <cstdlib>
+#include "../cmcstl2/test/simple_test.hpp"
 
 namespace ranges = std::experimental::ranges;
 
@@ -46,15 +50,16 @@ public:
 		throw std::bad_alloc{};
 	}
 
-#if 0 // Travis doesn't like ::aligned_alloc
+	// ::aligned_alloc requires the size to be a multiple of the alignment,
+	// which n * sizeof(U) always is.
 	template <class U = T>
 	requires
 		ranges::Same<U, T>() &&
-		alignof(U) > alignof(std::max_align_t) &&
+		(alignof(U) > alignof(std::max_align_t)) &&
 		requires { { ::aligned_alloc(alignof(U), sizeof(U)) } -> void*; }
 	U* allocate(std::size_t n) const
 	{
-		static_assert(alignof(U) & (alignof(U) - 1) == 0);
+		static_assert((alignof(U) & (alignof(U) - 1)) == 0);
 		static_assert(sizeof(U) % alignof(U) == 0);
 
 		if (n <= max_size()) {
@@ -64,7 +69,6 @@ public:
 		}
 		throw std::bad_alloc{};
 	}
-#endif
 };
 
 template <>
@@ -90,4 +94,68 @@ static_assert(ranges::models::Same<mallocator<incomplete>,
 struct incomplete {};
 static_assert(ranges::models::Allocator<mallocator<incomplete>, incomplete>);
 
-int main() {}
+struct alignas(64) cache_line {
+	int value;
+};
+static_assert(ranges::models::Allocator<mallocator<cache_line>, cache_line>);
+
+static_assert(ranges::models::ProtoAllocator<ranges::aligned_allocator<void>>);
+static_assert(ranges::models::ProtoAllocator<ranges::aligned_allocator<void, 64>, float>);
+static_assert(ranges::models::Same<ranges::aligned_allocator<float, 64>,
+	ranges::rebind_allocator_t<ranges::aligned_allocator<void, 64>, float>>);
+static_assert(ranges::models::Same<ranges::aligned_allocator<cache_line, 64>,
+	ranges::rebind_allocator_t<ranges::aligned_allocator<char>, cache_line>>);
+static_assert(ranges::models::Allocator<ranges::aligned_allocator<float, 32>, float>);
+static_assert(ranges::models::Allocator<ranges::aligned_allocator<cache_line>, cache_line>);
+static_assert(ranges::aligned_allocator<float, 64>::lane_width == 16);
+static_assert(ranges::aligned_allocator<cache_line>::lane_width == 1);
+
+template <class T>
+bool is_aligned(const T* p, std::size_t align) {
+	return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+}
+
+int main() {
+	{
+		auto a = mallocator<cache_line>{};
+		auto p = a.allocate(3);
+		CHECK(is_aligned(p, 64));
+		a.deallocate(p, 3);
+	}
+	{
+		auto a = ranges::aligned_allocator<double, 256>{};
+		for (auto n = 1u; n < 64; n += 7) {
+			auto p = a.allocate(n);
+			CHECK(is_aligned(p, 256));
+			a.deallocate(p, n);
+		}
+	}
+	{
+		// Capacity is padded to whole 64-byte lanes.
+		ranges::vector<float, ranges::aligned_allocator<float, 64>> vec;
+		CHECK(vec.lane_width == 16);
+		vec.push_back(1.0f);
+		CHECK(is_aligned(vec.begin(), 64));
+		CHECK(vec.capacity() == 16);
+		CHECK(vec.padded_size() == 16);
+		for (auto i = 1; i < 17; ++i) {
+			vec.push_back(float(i));
+		}
+		CHECK(vec.capacity() % 16 == 0);
+		CHECK(vec.padded_size() == 32);
+		CHECK(is_aligned(vec.begin(), 64));
+		vec.reserve(33);
+		CHECK(vec.capacity() == 48);
+		vec.shrink_to_fit();
+		CHECK(vec.capacity() == 32);
+		CHECK(vec.size() == 17);
+		CHECK(vec.back() == 16.0f);
+	}
+	{
+		ranges::vector<int> vec{ranges::reserve_t{}, 5};
+		CHECK(vec.lane_width == 1);
+		CHECK(vec.capacity() == 5);
+	}
+
+	return ::test_result();
+}
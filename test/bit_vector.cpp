@@ -0,0 +1,188 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/bit_vector.hpp>
+#include <stl2/algorithm.hpp>
+#include <random>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+using BV = ranges::bit_vector<>;
+static_assert(ranges::models::RandomAccessIterator<BV::iterator>);
+static_assert(ranges::models::RandomAccessIterator<BV::const_iterator>);
+static_assert(ranges::models::OutputIterator<BV::iterator, bool>);
+static_assert(ranges::models::RandomAccessRange<BV>);
+static_assert(ranges::models::Same<ranges::value_type_t<BV::iterator>, bool>);
+static_assert(ranges::models::Same<ranges::reference_t<BV::const_iterator>, bool>);
+static_assert(ranges::models::ConvertibleTo<BV::iterator, BV::const_iterator>);
+
+template <class PA>
+bool same_bits(const ranges::bit_vector<PA>& bv, const std::vector<bool>& model) {
+	if (bv.size() != static_cast<std::ptrdiff_t>(model.size())) {
+		return false;
+	}
+	for (auto i = 0; i < bv.size(); ++i) {
+		if (bv[i] != model[i]) {
+			return false;
+		}
+	}
+	return ranges::equal(bv, model);
+}
+
+int main() {
+	{
+		BV bv;
+		CHECK(bv.empty());
+		CHECK(bv.capacity() == 0);
+		bv.push_back(true);
+		bv.push_back(false);
+		bv.push_back(true);
+		CHECK(bv.size() == 3);
+		CHECK(bv.word_count() == 1);
+		CHECK(bv.data()[0] == 0b101u);
+		CHECK(bv.count() == 2);
+		bv.pop_back();
+		CHECK(bv.data()[0] == 0b1u);
+		CHECK(bv.count() == 1);
+	}
+	{
+		BV bv = {true, false, false, true};
+		CHECK(bv.front());
+		CHECK(bv.back());
+		CHECK(ranges::count(bv, true) == 2);
+		*(bv.begin() + 1) = true;
+		bv[3] = bv[2];
+		CHECK(ranges::equal(bv, std::vector<bool>{true, true, false, false}));
+		ranges::iter_swap(bv.begin(), bv.begin() + 3);
+		CHECK(ranges::equal(bv, std::vector<bool>{false, true, false, true}));
+		ranges::fill(bv, true);
+		CHECK(bv.all());
+	}
+	{
+		// Padding past size() stays clear.
+		BV bv(70, true);
+		CHECK(bv.word_count() == 2);
+		CHECK(bv.count() == 70);
+		CHECK(bv.data()[1] == 0x3fu);
+		bv.flip();
+		CHECK(bv.none());
+		bv.set();
+		CHECK(bv.all());
+		bv.resize(65);
+		CHECK(bv.data()[1] == 1u);
+		bv.resize(200, true);
+		CHECK(bv.count() == 200);
+		bv.resize(130);
+		CHECK(bv.count() == 130);
+		bv.reset();
+		CHECK(bv.none());
+		CHECK(bv.find_first() == bv.size());
+	}
+	{
+		// Growth goes through vector's reserve and grow.
+		BV bv;
+		bv.reserve(1000);
+		CHECK(bv.capacity() >= 1000);
+		auto const cap = bv.capacity();
+		for (auto i = 0; i < 1000; ++i) {
+			bv.push_back(i % 3 == 0);
+		}
+		CHECK(bv.capacity() == cap);
+		CHECK(bv.count() == 334);
+		for (auto i = 0; i < 1000; ++i) {
+			bv.push_back(false);
+		}
+		CHECK(bv.capacity() > cap);
+		bv.shrink_to_fit();
+		CHECK(bv.capacity() == 2048);
+		bv.clear();
+		CHECK(bv.empty());
+	}
+	{
+		std::mt19937 gen{7};
+		auto const n = 5000;
+		BV x(n), y(n);
+		std::vector<bool> mx(n), my(n);
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = gen() % 5 == 0;
+			my[i] = gen() % 2 == 0;
+			x.set(i, mx[i]);
+			y.set(i, my[i]);
+		}
+		CHECK(same_bits(x, mx));
+
+		// find_first / find_next visit exactly the set bits.
+		std::vector<int> ones;
+		for (auto i = x.find_first(); i != x.size(); i = i + 1 < x.size() ? x.find_next(i) : x.size()) {
+			ones.push_back(static_cast<int>(i));
+		}
+		CHECK(static_cast<std::ptrdiff_t>(ones.size()) == x.count());
+		for (auto i : ones) {
+			CHECK(mx[i]);
+		}
+
+		// rank and select agree with a scan, and with each other.
+		ranges::rank_select rs{x};
+		CHECK(rs.count() == x.count());
+		auto seen = 0;
+		for (auto i = 0; i <= n; ++i) {
+			CHECK(rs.rank(i) == seen);
+			CHECK(x.rank(i) == seen);
+			if (i < n && mx[i]) {
+				CHECK(rs.select(seen) == i);
+				++seen;
+			}
+		}
+		CHECK(rs.select(seen) == n);
+
+		// Bulk word operations.
+		x |= y;
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = mx[i] || my[i];
+		}
+		CHECK(same_bits(x, mx));
+		x.and_not(y);
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = mx[i] && !my[i];
+		}
+		CHECK(same_bits(x, mx));
+		x ^= y;
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = mx[i] != my[i];
+		}
+		CHECK(same_bits(x, mx));
+		x &= y;
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = mx[i] && my[i];
+		}
+		CHECK(same_bits(x, mx));
+		x.flip();
+		for (auto i = 0; i < n; ++i) {
+			mx[i] = !mx[i];
+		}
+		CHECK(same_bits(x, mx));
+		CHECK(x.count() == ranges::count(mx, true));
+	}
+	{
+		BV bv(1);
+		ranges::rank_select rs{bv};
+		CHECK(rs.count() == 0);
+		CHECK(rs.select(0) == 1);
+		BV empty;
+		ranges::rank_select rs2{empty};
+		CHECK(rs2.rank(0) == 0);
+		CHECK(rs2.select(0) == 0);
+	}
+
+	return ::test_result();
+}
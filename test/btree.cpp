@@ -0,0 +1,394 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/btree.hpp>
+#include <stl2/memory_resource.hpp>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	int live = 0;
+
+	// A pointer class for allocators whose pointers are not raw.
+	template <class T>
+	struct fancy_ptr {
+		T* p_ = nullptr;
+
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using pointer = fancy_ptr;
+		using iterator_category = std::random_access_iterator_tag;
+
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		explicit fancy_ptr(T* p) noexcept : p_{p} {}
+		template <class U>
+		requires std::is_convertible<U*, T*>::value
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+
+		static fancy_ptr pointer_to(T& t) noexcept { return fancy_ptr{&t}; }
+
+		T& operator*() const noexcept { return *p_; }
+		T* operator->() const noexcept { return p_; }
+		T& operator[](difference_type n) const noexcept { return p_[n]; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+
+		fancy_ptr& operator++() noexcept { ++p_; return *this; }
+		fancy_ptr operator++(int) noexcept { return fancy_ptr{p_++}; }
+		fancy_ptr& operator--() noexcept { --p_; return *this; }
+		fancy_ptr operator--(int) noexcept { return fancy_ptr{p_--}; }
+		fancy_ptr& operator+=(difference_type n) noexcept { p_ += n; return *this; }
+		fancy_ptr& operator-=(difference_type n) noexcept { p_ -= n; return *this; }
+		friend fancy_ptr operator+(fancy_ptr p, difference_type n) noexcept { return p += n; }
+		friend fancy_ptr operator+(difference_type n, fancy_ptr p) noexcept { return p += n; }
+		friend fancy_ptr operator-(fancy_ptr p, difference_type n) noexcept { return p -= n; }
+		friend difference_type operator-(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ - b.p_; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+		friend bool operator<(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ < b.p_; }
+		friend bool operator>(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ > b.p_; }
+		friend bool operator<=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ <= b.p_; }
+		friend bool operator>=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ >= b.p_; }
+	};
+
+	template <class T>
+	struct fancy_allocator {
+		using value_type = T;
+		using pointer = fancy_ptr<T>;
+		using const_pointer = fancy_ptr<const T>;
+		using void_pointer = fancy_ptr<void>;
+		using const_void_pointer = fancy_ptr<const void>;
+
+		fancy_allocator() = default;
+		template <class U>
+		fancy_allocator(const fancy_allocator<U>&) noexcept {}
+
+		pointer allocate(std::size_t n) {
+			++live;
+			return pointer{std::allocator<T>{}.allocate(n)};
+		}
+		void deallocate(pointer p, std::size_t n) noexcept {
+			--live;
+			std::allocator<T>{}.deallocate(p.p_, n);
+		}
+
+		friend bool operator==(fancy_allocator, fancy_allocator) noexcept { return true; }
+		friend bool operator!=(fancy_allocator, fancy_allocator) noexcept { return false; }
+	};
+
+	template <>
+	struct fancy_ptr<void> {
+		void* p_ = nullptr;
+		using element_type = void;
+		using difference_type = std::ptrdiff_t;
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		template <class U>
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+		template <class U>
+		explicit operator fancy_ptr<U>() const noexcept { return fancy_ptr<U>{static_cast<U*>(p_)}; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+	};
+
+	template <>
+	struct fancy_ptr<const void> {
+		const void* p_ = nullptr;
+		using element_type = const void;
+		using difference_type = std::ptrdiff_t;
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		template <class U>
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+		template <class U>
+		explicit operator fancy_ptr<U>() const noexcept { return fancy_ptr<U>{static_cast<U*>(p_)}; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+	};
+
+	// The tree holds the model's elements in the model's order, forwards
+	// and backwards, and its searches agree with the model's.
+	template <class Tree, class Model>
+	bool agrees(const Tree& t, const Model& m, int probes) {
+		if (t.size() != static_cast<std::ptrdiff_t>(m.size()) || t.empty() != m.empty() ||
+			!std::equal(t.begin(), t.end(), m.begin(), m.end()) ||
+			!std::equal(t.rbegin(), t.rend(), m.rbegin(), m.rend()))
+		{
+			return false;
+		}
+		for (auto k = -1; k <= probes; k += 1 + probes / 500) {
+			auto const lb = t.lower_bound(k);
+			auto const ub = t.upper_bound(k);
+			if (std::distance(t.begin(), lb) != std::distance(m.begin(), m.lower_bound(k)) ||
+				std::distance(t.begin(), ub) != std::distance(m.begin(), m.upper_bound(k)) ||
+				t.count(k) != static_cast<std::ptrdiff_t>(m.count(k)) ||
+				t.contains(k) != (m.count(k) > 0) ||
+				(t.find(k) == t.end()) != (m.find(k) == m.end()))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Random insertions and erasures, by key and by position, checked
+	// against the standard container after each batch.
+	template <class Tree, class Model>
+	void churn(unsigned seed, int keys) {
+		std::mt19937 gen{seed};
+		Tree t;
+		Model m;
+		auto ok = true;
+		for (auto round = 0; round < 6; ++round) {
+			// Grow, then shrink almost to nothing, then grow again.
+			auto const target = round % 2 == 0 ? 3000 : 20;
+			while (static_cast<int>(m.size()) < target) {
+				auto const k = static_cast<int>(gen() % keys);
+				auto const v = typename Model::value_type(k);
+				t.insert(v);
+				m.insert(v);
+			}
+			ok = ok && agrees(t, m, keys);
+			while (static_cast<int>(m.size()) > target) {
+				auto const op = gen() % 3;
+				if (op == 0) {
+					auto const k = static_cast<int>(gen() % keys);
+					ok = ok && t.erase(k) == static_cast<std::ptrdiff_t>(m.erase(k));
+				} else {
+					auto const n = static_cast<std::ptrdiff_t>(gen() % m.size());
+					auto const ti = t.erase(std::next(t.begin(), n));
+					auto const mi = m.erase(std::next(m.begin(), n));
+					ok = ok && std::distance(t.begin(), ti) == std::distance(m.begin(), mi);
+				}
+			}
+			ok = ok && agrees(t, m, keys);
+		}
+		// Erasing a range from the middle
+		auto const q = t.size() / 4;
+		auto const i = t.erase(std::next(t.begin(), q), std::next(t.begin(), 2 * q));
+		m.erase(std::next(m.begin(), q), std::next(m.begin(), 2 * q));
+		ok = ok && agrees(t, m, keys) && std::distance(t.begin(), i) == q;
+		CHECK(ok);
+	}
+
+	// A set of ints that compares through a function object, which the
+	// vector kernels do not handle
+	struct int_less {
+		bool operator()(int a, int b) const { return a < b; }
+	};
+
+	template <class K, class Compare = ranges::less<>>
+	using tiny_set = ranges::basic_btree<K, void, Compare, std::allocator<K>, 48, false>;
+	template <class K, class Compare = ranges::less<>>
+	using tiny_multiset = ranges::basic_btree<K, void, Compare, std::allocator<K>, 48, true>;
+	template <class K, class T>
+	using tiny_map = ranges::basic_btree<K, T, ranges::less<>, std::allocator<std::pair<K, T>>, 96, false>;
+}
+
+int main() {
+	{
+		// Small nodes make for deep trees, and many splits and merges.
+		static_assert(tiny_set<int>::leaf_capacity == 4);
+		static_assert(tiny_set<int>::inner_capacity == 4);
+		churn<tiny_set<int>, std::set<int>>(1, 5000);
+		churn<tiny_set<int, int_less>, std::set<int>>(2, 5000);
+		churn<tiny_multiset<int>, std::multiset<int>>(3, 500);
+		churn<tiny_multiset<int, int_less>, std::multiset<int>>(4, 50);
+		churn<ranges::btree_set<int>, std::set<int>>(5, 5000);
+		churn<ranges::btree_multiset<long>, std::multiset<long>>(6, 300);
+		churn<ranges::btree_set<double>, std::set<double>>(7, 5000);
+	}
+	{
+		// The default node is a few cache lines.
+		using set = ranges::btree_set<int>;
+		static_assert(ranges::models::BidirectionalIterator<set::iterator>);
+		static_assert(ranges::models::BidirectionalIterator<ranges::btree_map<int, int>::const_iterator>);
+		static_assert(sizeof(std::allocator_traits<std::allocator<int>>::void_pointer) == 8 ||
+			set::leaf_capacity > 0);
+		CHECK(set::leaf_capacity * sizeof(int) <= 512);
+		CHECK(set::leaf_capacity >= 100);
+		set s;
+		for (auto i = 0; i < 100000; ++i) {
+			s.insert(i);
+		}
+		// Ascending insertions fill the leaves.
+		CHECK(s.height() <= 2);
+		CHECK(std::is_sorted(s.begin(), s.end()));
+		CHECK(*s.begin() == 0 && *s.rbegin() == 99999);
+	}
+	{
+		// Maps
+		using map = ranges::btree_map<int, std::string>;
+		map m;
+		CHECK(m.try_emplace(3, "three").second);
+		CHECK(!m.try_emplace(3, "drei").second);
+		CHECK(m.insert({1, "one"}).second);
+		CHECK(m.emplace(2, "two").second);
+		CHECK(!m.insert_or_assign(1, "uno").second);
+		m[4] = "four";
+		CHECK(m.at(1) == "uno");
+		CHECK(m.at(3) == "three");
+		CHECK(m.size() == 4);
+		auto i = m.begin();
+		CHECK(i->first == 1 && (*i).second == "uno");
+		++i;
+		i->second += "!";
+		CHECK(m[2] == "two!");
+		auto threw = false;
+		try {
+			m.at(5);
+		} catch (std::out_of_range&) {
+			threw = true;
+		}
+		CHECK(threw);
+
+		std::map<int, int> model;
+		tiny_map<int, int> t;
+		std::mt19937 gen{8};
+		for (auto n = 0; n < 20000; ++n) {
+			auto const k = static_cast<int>(gen() % 2000);
+			if (gen() % 3 == 0) {
+				CHECK(t.erase(k) == static_cast<std::ptrdiff_t>(model.erase(k)));
+			} else {
+				t[k] += n;
+				model[k] += n;
+			}
+		}
+		CHECK(t.size() == static_cast<std::ptrdiff_t>(model.size()));
+		auto ok = true;
+		auto j = t.begin();
+		for (auto& e : model) {
+			ok = ok && j->first == e.first && j->second == e.second;
+			++j;
+		}
+		CHECK(ok);
+
+		ranges::btree_multimap<int, int> mm;
+		mm.insert({1, 10});
+		mm.insert({1, 11});
+		mm.insert({0, 0});
+		mm.insert({1, 12});
+		CHECK(mm.count(1) == 3);
+		auto r = mm.equal_range(1);
+		CHECK(r.first->second == 10);
+		CHECK((++r.first)->second == 11);
+		CHECK((++r.first)->second == 12);
+		CHECK(++r.first == r.second);
+	}
+	{
+		// Built from sorted ranges in one pass, with full nodes
+		for (auto n : {0, 1, 3, 4, 5, 17, 100, 1000, 12345}) {
+			std::vector<int> v(n);
+			for (auto i = 0; i < n; ++i) {
+				v[i] = 2 * i;
+			}
+			tiny_set<int> t{ranges::sorted_unique_t{}, v.begin(), v.end()};
+			std::set<int> m(v.begin(), v.end());
+			CHECK(agrees(t, m, 2 * n));
+			// Still balanced, so erasing everything works.
+			std::mt19937 gen{static_cast<unsigned>(n)};
+			std::shuffle(v.begin(), v.end(), gen);
+			auto ok = true;
+			for (auto i = 0; i < n; ++i) {
+				t.erase(v[i]);
+				m.erase(v[i]);
+				if (i % 97 == 0) {
+					ok = ok && agrees(t, m, 2 * n);
+				}
+			}
+			CHECK(ok);
+			CHECK(t.empty());
+		}
+		std::vector<int> dups;
+		for (auto i = 0; i < 5000; ++i) {
+			dups.push_back(i / 7);
+		}
+		tiny_multiset<int> t{ranges::sorted_equivalent_t{}, dups.begin(), dups.end()};
+		CHECK(agrees(t, std::multiset<int>(dups.begin(), dups.end()), 720));
+
+		std::vector<std::pair<int, std::string>> pairs;
+		for (auto i = 0; i < 1000; ++i) {
+			pairs.emplace_back(i, std::to_string(i));
+		}
+		ranges::btree_map<int, std::string> m{ranges::sorted_unique_t{}, pairs.begin(), pairs.end()};
+		CHECK(m.size() == 1000);
+		CHECK(m.at(567) == "567");
+		CHECK(pairs[567].second == "567");
+	}
+	{
+		// Copies, moves and swaps
+		tiny_map<int, std::string> a;
+		for (auto i = 0; i < 500; ++i) {
+			a.try_emplace(i * 3 % 500, std::to_string(i));
+		}
+		auto b = a;
+		CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+		auto c = std::move(a);
+		CHECK(a.empty());
+		CHECK(std::equal(b.begin(), b.end(), c.begin(), c.end()));
+		a = b;
+		b.clear();
+		swap(a, b);
+		CHECK(a.empty());
+		CHECK(std::equal(b.begin(), b.end(), c.begin(), c.end()));
+		a = std::move(b);
+		CHECK(a.size() == 500);
+		CHECK(b.empty());
+	}
+	{
+		// Nodes through fancy pointers, all of them freed
+		{
+			using tree = ranges::basic_btree<std::string, int, ranges::less<>,
+				fancy_allocator<std::pair<std::string, int>>, 256, false>;
+			tree t;
+			for (auto i = 0; i < 2000; ++i) {
+				t[std::to_string(i)] = i;
+			}
+			CHECK(live > 0);
+			CHECK(t.at("1234") == 1234);
+			auto const u = t;
+			for (auto i = 0; i < 2000; i += 2) {
+				t.erase(std::to_string(i));
+			}
+			CHECK(t.size() == 1000);
+			CHECK(u.size() == 2000);
+			CHECK(std::is_sorted(t.begin(), t.end()));
+		}
+		CHECK(live == 0);
+	}
+	{
+		// With a polymorphic allocator
+		ranges::unsynchronized_pool_resource pool;
+		ranges::btree_set<int, ranges::less<>, ranges::polymorphic_allocator<>> s{
+			ranges::less<>{}, ranges::polymorphic_allocator<>{&pool}};
+		for (auto i = 0; i < 10000; ++i) {
+			s.insert(i * 7919 % 10000);
+		}
+		CHECK(s.size() == 10000);
+		CHECK(s.get_allocator().resource() == &pool);
+	}
+
+	return ::test_result();
+}
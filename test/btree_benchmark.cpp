@@ -0,0 +1,142 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Inserting random keys, looking them up, and walking the whole set, with
+// std::set and with btree_set at several node sizes, from in-cache sizes
+// to well out of it. Also building a btree_set from sorted keys, in one
+// pass, against inserting them one at a time.
+//
+// usage: btree_benchmark [elements]
+//
+#include <stl2/btree.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	volatile std::uint64_t sink;
+
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		auto const start = std::chrono::steady_clock::now();
+		sink = f();
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		std::cout << "  " << name << ": " << elapsed.count() / n << " ns/op\n";
+	}
+
+	template <class Set>
+	void run_set(const char* name, const std::vector<std::uint64_t>& keys,
+		const std::vector<std::uint64_t>& probes)
+	{
+		std::cout << " " << name << "\n";
+		auto const n = static_cast<std::ptrdiff_t>(keys.size());
+		Set s;
+		measure("insert", n, [&] {
+			for (auto k : keys) {
+				s.insert(k);
+			}
+			return static_cast<std::uint64_t>(s.size());
+		});
+		measure("find", static_cast<std::ptrdiff_t>(probes.size()), [&] {
+			auto found = std::uint64_t{0};
+			for (auto k : probes) {
+				found += s.find(k) != s.end();
+			}
+			return found;
+		});
+		measure("lower_bound", static_cast<std::ptrdiff_t>(probes.size()), [&] {
+			auto sum = std::uint64_t{0};
+			for (auto k : probes) {
+				auto const i = s.lower_bound(k + 1);
+				sum += i != s.end() ? *i : 0;
+			}
+			return sum;
+		});
+		measure("iterate", n, [&] {
+			auto sum = std::uint64_t{0};
+			for (auto k : s) {
+				sum += k;
+			}
+			return sum;
+		});
+		measure("erase", n, [&] {
+			for (auto k : keys) {
+				s.erase(k);
+			}
+			return static_cast<std::uint64_t>(s.size());
+		});
+	}
+
+	template <std::size_t NodeBytes>
+	using btree_set = ranges::basic_btree<std::uint64_t, void, ranges::less<>,
+		std::allocator<std::uint64_t>, NodeBytes, false>;
+
+	void run(std::ptrdiff_t n) {
+		std::cout << n << " keys\n";
+		std::mt19937_64 gen{static_cast<std::uint64_t>(n)};
+		std::vector<std::uint64_t> keys(n);
+		for (auto& k : keys) {
+			k = gen();
+		}
+		// Half present, half not
+		std::vector<std::uint64_t> probes(std::size_t{1} << 20);
+		for (auto& p : probes) {
+			p = gen() % 2 ? keys[gen() % n] : gen();
+		}
+
+		run_set<std::set<std::uint64_t>>("std::set", keys, probes);
+		run_set<btree_set<256>>("btree_set 256B nodes", keys, probes);
+		run_set<btree_set<512>>("btree_set 512B nodes", keys, probes);
+		run_set<btree_set<1024>>("btree_set 1KiB nodes", keys, probes);
+		run_set<btree_set<4096>>("btree_set 4KiB nodes", keys, probes);
+
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+		std::cout << " sorted keys\n";
+		measure("btree_set bulk load", n, [&] {
+			ranges::btree_set<std::uint64_t> s{ranges::sorted_unique_t{}, keys.begin(), keys.end()};
+			return static_cast<std::uint64_t>(s.height());
+		});
+		measure("btree_set insert each", n, [&] {
+			ranges::btree_set<std::uint64_t> s;
+			for (auto k : keys) {
+				s.insert(k);
+			}
+			return static_cast<std::uint64_t>(s.height());
+		});
+		measure("std::set insert each", n, [&] {
+			std::set<std::uint64_t> s;
+			for (auto k : keys) {
+				s.insert(s.end(), k);
+			}
+			return static_cast<std::uint64_t>(s.size());
+		});
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		run(std::atol(argv[1]));
+	} else {
+		for (auto n : {1L << 10, 1L << 16, 1L << 22}) {
+			run(n);
+		}
+	}
+}
@@ -0,0 +1,190 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/caching_allocator.hpp>
+#include <stl2/forward_list.hpp>
+#include <stl2/algorithm.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+template <class T>
+using CA = ranges::caching_allocator<T>;
+using FL = ranges::forward_list<int, CA<int>>;
+
+static_assert(ranges::models::Allocator<CA<int>, int>);
+static_assert(ranges::models::ProtoAllocator<CA<void>, int>);
+static_assert(std::allocator_traits<CA<int>>::is_always_equal::value);
+static_assert(ranges::models::Same<std::allocator_traits<CA<void>>::rebind_alloc<int>, CA<int>>);
+
+struct alignas(64) overaligned {
+	char c;
+};
+
+std::vector<const int*> addresses(const FL& l) {
+	std::vector<const int*> result;
+	for (auto& i : l) {
+		result.push_back(&i);
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+int main() {
+	{
+		CA<int> a;
+		CA<void> v = a;
+		CA<double> d = v;
+		CHECK(a == v);
+		CHECK(!(d != a));
+
+		// Small requests come from the cache, and freed blocks are reused.
+		auto const p = a.allocate(3);
+		a.deallocate(p, 3);
+		auto const q = a.allocate(4);
+		CHECK(p == q);
+		a.deallocate(q, 4);
+
+		// Large and over-aligned requests go upstream.
+		auto const big = a.allocate(1000);
+		big[999] = 42;
+		a.deallocate(big, 1000);
+		CA<overaligned> o;
+		auto const op = o.allocate(2);
+		CHECK(reinterpret_cast<std::uintptr_t>(op) % 64 == 0);
+		o.deallocate(op, 2);
+	}
+	{
+		// Node churn reuses the same blocks.
+		FL l;
+		for (auto i = 0; i < 1000; ++i) {
+			l.push_front(i);
+		}
+		auto const before = addresses(l);
+		l.clear();
+		for (auto i = 0; i < 1000; ++i) {
+			l.push_front(i);
+		}
+		CHECK(addresses(l) == before);
+	}
+	{
+		// Swap and move assignment transfer nodes without copying.
+		FL a, b;
+		for (auto i : {3, 2, 1}) {
+			a.push_front(i);
+		}
+		for (auto i : {5, 4}) {
+			b.push_front(i);
+		}
+		auto const pa = &a.front();
+		auto const pb = &b.front();
+		a.swap(b);
+		CHECK(&a.front() == pb);
+		CHECK(&b.front() == pa);
+		a = std::move(b);
+		CHECK(&a.front() == pa);
+		CHECK(ranges::equal(a, std::vector<int>{1, 2, 3}));
+		CHECK(b.begin() == b.end());
+	}
+	{
+		// Lists built on one thread and destroyed on another.
+		constexpr int producers = 4;
+		constexpr int rounds = 50;
+		constexpr int length = 500;
+		std::vector<std::vector<FL*>> made(producers);
+		std::vector<std::thread> threads;
+		for (auto t = 0; t < producers; ++t) {
+			threads.emplace_back([&made, t] {
+				for (auto r = 0; r < rounds; ++r) {
+					auto l = new FL;
+					for (auto i = 0; i < length; ++i) {
+						l->push_front(i);
+					}
+					made[t].push_back(l);
+				}
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		threads.clear();
+		auto ok = true;
+		for (auto t = 0; t < producers; ++t) {
+			threads.emplace_back([&made, &ok, t] {
+				auto const& lists = made[(t + 1) % producers];
+				for (auto l : lists) {
+					if (ranges::distance(*l) != length) {
+						ok = false;
+					}
+					delete l;
+				}
+				// Keep allocating while holding remote blocks in flight.
+				FL local;
+				for (auto i = 0; i < length; ++i) {
+					local.push_front(i);
+				}
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		CHECK(ok);
+
+		// Blocks of exited threads are adopted, not lost.
+		FL l;
+		for (auto i = 0; i < producers * rounds * length; ++i) {
+			l.push_front(i);
+		}
+		CHECK(ranges::distance(l) == producers * rounds * length);
+	}
+	{
+		// Concurrent churn with frees crossing between threads.
+		constexpr int workers = 4;
+		std::vector<FL> inbox(workers);
+		std::vector<std::thread> threads;
+		for (auto t = 0; t < workers; ++t) {
+			threads.emplace_back([&inbox, t] {
+				for (auto r = 0; r < 200; ++r) {
+					FL l;
+					for (auto i = 0; i < 100; ++i) {
+						l.push_front(i);
+					}
+					if (r % 2) {
+						inbox[t] = std::move(l);
+					}
+				}
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		threads.clear();
+		for (auto t = 0; t < workers; ++t) {
+			threads.emplace_back([&inbox, t] {
+				inbox[(t + 1) % workers].clear();
+			});
+		}
+		for (auto& t : threads) {
+			t.join();
+		}
+		for (auto& l : inbox) {
+			CHECK(l.begin() == l.end());
+		}
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,123 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/colony.hpp>
+#include <stl2/algorithm.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+int main() {
+	{
+		using C = ranges::colony<int>;
+		static_assert(ranges::models::ForwardIterator<C::iterator>);
+		static_assert(ranges::models::ForwardRange<C>);
+
+		C c;
+		CHECK(c.empty());
+		CHECK(c.begin() == c.end());
+		auto i = c.insert(42);
+		CHECK(*i == 42);
+		CHECK(c.size() == 1);
+		CHECK(c.erase(i) == c.end());
+		CHECK(c.empty());
+		CHECK(c.capacity() == 0);
+	}
+
+	{
+		// Elements never move; erased slots are skipped and then reused.
+		ranges::colony<int> c;
+		std::vector<ranges::colony<int>::iterator> its;
+		std::vector<const int*> addresses;
+		for (auto i = 0; i < 1000; ++i) {
+			its.push_back(c.insert(i));
+			addresses.push_back(&*its.back());
+		}
+		for (auto i = 0; i < 1000; ++i) {
+			if (i % 3 != 0) {
+				c.erase(its[i]);
+			}
+		}
+		CHECK(c.size() == 334);
+		auto expected = 0;
+		for (auto&& e : c) {
+			CHECK(e == expected);
+			expected += 3;
+		}
+		for (auto i = 0; i < 1000; i += 3) {
+			CHECK(&*its[i] == addresses[i]);
+		}
+		auto const cap = c.capacity();
+		for (auto i = 0; i < 666; ++i) {
+			c.insert(-1);
+		}
+		CHECK(c.capacity() == cap);
+		CHECK(c.size() == 1000);
+		CHECK(ranges::count(c, -1) == 666);
+	}
+
+	{
+		// Random churn against a simple model.
+		std::mt19937 gen{42};
+		ranges::colony<long> c;
+		std::vector<ranges::colony<long>::iterator> live;
+		long sum = 0;
+		for (auto step = 0; step < 20000; ++step) {
+			if (live.empty() || gen() % 3 != 0) {
+				long v = gen() % 1000;
+				live.push_back(c.insert(v));
+				sum += v;
+			} else {
+				auto k = gen() % live.size();
+				sum -= *live[k];
+				c.erase(live[k]);
+				live[k] = live.back();
+				live.pop_back();
+			}
+		}
+		CHECK(c.size() == static_cast<long>(live.size()));
+		CHECK(ranges::distance(c) == c.size());
+		long total = 0;
+		for (auto e : c) {
+			total += e;
+		}
+		CHECK(total == sum);
+
+		auto copy = c;
+		CHECK(ranges::distance(copy) == c.size());
+		auto moved = std::move(copy);
+		CHECK(copy.empty());
+		CHECK(ranges::distance(moved) == c.size());
+		c.clear();
+		CHECK(c.empty());
+		CHECK(c.begin() == c.end());
+	}
+
+	{
+		ranges::colony<std::unique_ptr<int>> c;
+		for (auto i = 0; i < 100; ++i) {
+			c.emplace(std::make_unique<int>(i));
+		}
+		auto it = c.begin();
+		while (it != c.end()) {
+			it = **it % 2 == 0 ? c.erase(it) : ranges::next(it);
+		}
+		CHECK(c.size() == 50);
+		for (auto&& p : c) {
+			CHECK(*p % 2 == 1);
+		}
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,265 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/concurrent_vector.hpp>
+#include <stl2/memory_resource.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	// Counts live allocations, to check that clear frees every segment.
+	int live = 0;
+
+	template <class T>
+	struct counting_allocator {
+		using value_type = T;
+
+		counting_allocator() = default;
+		template <class U>
+		counting_allocator(const counting_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n) {
+			++live;
+			return std::allocator<T>{}.allocate(n);
+		}
+		void deallocate(T* p, std::size_t n) noexcept {
+			--live;
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		template <class U>
+		bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+		template <class U>
+		bool operator!=(const counting_allocator<U>&) const noexcept { return false; }
+	};
+
+	// Throws when constructed from a negative value, or when copied once
+	// copies_left - if not negative - has run out.
+	struct picky {
+		static int count;
+		static int copies_left;
+		int value;
+		picky(int v) : value{v} {
+			if (v < 0) {
+				throw std::runtime_error{"picky"};
+			}
+			++count;
+		}
+		picky(const picky& that) : picky{copy_(that.value)} {}
+		~picky() { --count; }
+
+		static int copy_(int v) {
+			if (copies_left == 0) {
+				throw std::runtime_error{"picky copy"};
+			}
+			if (copies_left > 0) {
+				--copies_left;
+			}
+			return v;
+		}
+	};
+	int picky::count = 0;
+	int picky::copies_left = -1;
+
+	void test_basics() {
+		{
+			ranges::concurrent_vector<int, counting_allocator<int>> v;
+			CHECK(v.empty());
+			CHECK(v.capacity() == 0);
+			auto& first = v.push_back(0);
+			for (auto i = 1; i < 100000; ++i) {
+				CHECK(&v.push_back(i) == &v[i]);
+			}
+			// Growth never moves elements.
+			CHECK(&first == &v[0]);
+			CHECK(v.size() == 100000);
+			CHECK(v.capacity() >= 100000);
+			auto ok = true;
+			auto i = 0;
+			for (auto& x : v) {
+				ok = ok && x == i++;
+			}
+			CHECK(ok);
+			CHECK(v.end() - v.begin() == 100000);
+			CHECK(v.begin()[777] == 777);
+			CHECK(v.published(99999));
+			CHECK(!v.published(100000));
+			CHECK(!v.published(-1));
+			CHECK(v.at(5) == 5);
+			auto threw = false;
+			try {
+				v.at(100000);
+			} catch (std::out_of_range&) {
+				threw = true;
+			}
+			CHECK(threw);
+
+			auto const it = v.grow_by(70, 42);
+			CHECK(it - v.begin() == 100000);
+			CHECK(v.size() == 100070);
+			CHECK(it[0] == 42 && it[69] == 42);
+			auto const it2 = v.grow_by(3);
+			CHECK(*it2 == 0 && it2[2] == 0);
+			CHECK(v.grow_by(0) == v.end());
+
+			ranges::concurrent_vector<int, counting_allocator<int>> w{std::move(v)};
+			CHECK(v.empty());
+			CHECK(w.size() == 100073);
+			CHECK(&w[0] == &first);
+			swap(v, w);
+			CHECK(v.size() == 100073);
+			CHECK(w.empty());
+
+			v.clear();
+			CHECK(v.empty());
+			CHECK(live == 0);
+			v.push_back(1);
+			CHECK(v[0] == 1);
+		}
+		CHECK(live == 0);
+		{
+			ranges::concurrent_vector<int, counting_allocator<int>> v{ranges::reserve_t{}, 1000};
+			CHECK(v.capacity() >= 1000);
+			CHECK(v.empty());
+			auto const p = &v.push_back(1);
+			for (auto i = 1; i < 1000; ++i) {
+				v.push_back(i);
+			}
+			CHECK(&v[0] == p);
+		}
+		CHECK(live == 0);
+	}
+
+	void test_exceptions() {
+		{
+			ranges::concurrent_vector<picky> v;
+			v.emplace_back(1);
+			auto threw = false;
+			try {
+				v.emplace_back(-1);
+			} catch (std::runtime_error&) {
+				threw = true;
+			}
+			CHECK(threw);
+			// The failed append leaves an unpublished hole.
+			CHECK(v.size() == 2);
+			CHECK(!v.published(1));
+			v.emplace_back(2);
+			CHECK(v.published(2));
+			CHECK(v[2].value == 2);
+
+			// Indices [3, 64) fill the first block and [64, 128) the
+			// second; the copy of index 103 throws.
+			threw = false;
+			picky::copies_left = 100;
+			try {
+				v.grow_by(200, picky{5});
+			} catch (std::runtime_error&) {
+				threw = true;
+			}
+			picky::copies_left = -1;
+			CHECK(threw);
+			CHECK(v.size() == 203);
+			// The block already filled stays published...
+			CHECK(v.published(3) && v.published(63));
+			CHECK(v[3].value == 5 && v[63].value == 5);
+			// ...while the one that threw is rolled back, and nothing
+			// past it is constructed.
+			CHECK(!v.published(64) && !v.published(102));
+			CHECK(!v.published(103) && !v.published(202));
+			CHECK(picky::count == 2 + 61);
+			v.emplace_back(6);
+			CHECK(v.published(203));
+			// Holes count as slack, not payload.
+			CHECK(v.memory_usage().payload == 64 * sizeof(picky));
+		}
+		CHECK(picky::count == 0);
+	}
+
+	void test_threads() {
+		constexpr int threads = 4;
+		constexpr int per_thread = 50000;
+		ranges::concurrent_vector<int> v;
+		std::atomic<bool> done{false};
+		std::atomic<int> bad{0};
+
+		// Readers only ever see published elements fully constructed.
+		std::thread reader{[&] {
+			while (!done.load(std::memory_order_acquire)) {
+				auto const n = v.size();
+				for (auto i = n - 1; i >= 0 && i >= n - 1000; --i) {
+					if (v.published(i) && (v[i] < 1 || v[i] > threads * per_thread)) {
+						++bad;
+					}
+				}
+			}
+		}};
+
+		std::vector<std::thread> writers;
+		for (auto t = 0; t < threads; ++t) {
+			writers.emplace_back([&v, &bad, t] {
+				std::vector<int*> mine;
+				for (auto i = 0; i < per_thread; ++i) {
+					auto const value = t * per_thread + i + 1;
+					if (i % 10 == 0) {
+						auto it = v.grow_by(1, value);
+						mine.push_back(&*it);
+					} else {
+						mine.push_back(&v.push_back(value));
+					}
+				}
+				// References stay put while the other threads grow the vector.
+				for (auto i = 0; i < per_thread; ++i) {
+					if (*mine[i] != t * per_thread + i + 1) {
+						++bad;
+					}
+				}
+			});
+		}
+		for (auto& w : writers) {
+			w.join();
+		}
+		done.store(true, std::memory_order_release);
+		reader.join();
+
+		CHECK(bad.load() == 0);
+		CHECK(v.size() == threads * per_thread);
+		std::vector<bool> seen(threads * per_thread + 1);
+		auto ok = true;
+		for (auto i = 0; i < v.size(); ++i) {
+			ok = ok && v.published(i) && !seen[v[i]];
+			seen[v[i]] = true;
+		}
+		CHECK(ok);
+	}
+}
+
+int main() {
+	test_basics();
+	test_exceptions();
+	test_threads();
+
+	{
+		ranges::monotonic_buffer_resource r;
+		ranges::concurrent_vector<int, ranges::polymorphic_allocator<int>> v{&r};
+		v.grow_by(1000, 7);
+		CHECK(v.get_allocator().resource() == &r);
+		CHECK(v[999] == 7);
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,155 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Throughput of threads appending to a shared vector - concurrent_vector
+// one element at a time and in batches, against a vector guarded by a
+// std::mutex - while another thread repeatedly scans what has been
+// appended so far. Reports the time per element appended and the
+// elements scanned per appended element.
+//
+// usage: concurrent_vector_benchmark [elements per thread]
+//
+#include <stl2/concurrent_vector.hpp>
+#include <stl2/vector.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	constexpr std::ptrdiff_t batch = 64;
+
+	volatile std::uint64_t sink;
+
+	// Runs append(t) on each of threads threads and scan() on one more
+	// until they finish; returns the number of elements scanned.
+	template <class Append, class Scan>
+	void measure(const char* name, int threads, std::ptrdiff_t n, Append append, Scan scan) {
+		std::atomic<bool> done{false};
+		std::uint64_t scanned = 0;
+		auto const start = std::chrono::steady_clock::now();
+		std::thread scanner{[&] {
+			std::uint64_t sum = 0;
+			while (!done.load(std::memory_order_acquire)) {
+				scanned += scan(sum);
+			}
+			sink = sum;
+		}};
+		std::vector<std::thread> writers;
+		for (auto t = 0; t < threads; ++t) {
+			writers.emplace_back([&append, t] { append(t); });
+		}
+		for (auto& w : writers) {
+			w.join();
+		}
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		done.store(true, std::memory_order_release);
+		scanner.join();
+		auto const total = static_cast<double>(n) * threads;
+		std::cout << "  " << name << ": " << elapsed.count() / total << " ns/append, "
+			<< scanned / total << " scanned/append\n";
+	}
+
+	void run(std::ptrdiff_t n, int threads) {
+		std::cout << threads << " threads x " << n << " elements\n";
+
+		{
+			ranges::concurrent_vector<std::uint64_t> v;
+			measure("concurrent_vector push_back", threads, n,
+				[&](int t) {
+					for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+						v.push_back(static_cast<std::uint64_t>(t) + i);
+					}
+				},
+				[&](std::uint64_t& sum) {
+					auto const size = v.size();
+					for (auto i = std::ptrdiff_t{0}; i < size; ++i) {
+						if (v.published(i)) {
+							sum += v[i];
+						}
+					}
+					return size;
+				});
+		}
+		{
+			ranges::concurrent_vector<std::uint64_t> v;
+			measure("concurrent_vector grow_by", threads, n,
+				[&](int t) {
+					for (auto i = std::ptrdiff_t{0}; i < n; i += batch) {
+						v.grow_by(batch, static_cast<std::uint64_t>(t) + i);
+					}
+				},
+				[&](std::uint64_t& sum) {
+					auto const size = v.size();
+					for (auto i = std::ptrdiff_t{0}; i < size; ++i) {
+						if (v.published(i)) {
+							sum += v[i];
+						}
+					}
+					return size;
+				});
+		}
+		{
+			ranges::vector<std::uint64_t> v;
+			std::mutex m;
+			measure("mutex + vector push_back", threads, n,
+				[&](int t) {
+					for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+						std::lock_guard<std::mutex> lock{m};
+						v.push_back(static_cast<std::uint64_t>(t) + i);
+					}
+				},
+				[&](std::uint64_t& sum) {
+					// Readers must hold the lock too, since growth moves
+					// the elements.
+					std::lock_guard<std::mutex> lock{m};
+					for (auto x : v) {
+						sum += x;
+					}
+					return static_cast<std::uint64_t>(v.size());
+				});
+		}
+		{
+			ranges::vector<std::uint64_t> v;
+			std::mutex m;
+			measure("mutex + vector batch", threads, n,
+				[&](int t) {
+					for (auto i = std::ptrdiff_t{0}; i < n; i += batch) {
+						std::lock_guard<std::mutex> lock{m};
+						for (auto j = std::ptrdiff_t{0}; j < batch; ++j) {
+							v.push_back(static_cast<std::uint64_t>(t) + i);
+						}
+					}
+				},
+				[&](std::uint64_t& sum) {
+					std::lock_guard<std::mutex> lock{m};
+					for (auto x : v) {
+						sum += x;
+					}
+					return static_cast<std::uint64_t>(v.size());
+				});
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const n = argc > 1 ? std::atol(argv[1]) : 1L << 20;
+	for (auto threads : {1, 2, 4, 8}) {
+		run(n, threads);
+	}
+}
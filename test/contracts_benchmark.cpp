@@ -0,0 +1,124 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Hot loops whose bodies are guarded by STL2_EXPECT preconditions, built
+// once per contract mode (see <stl2/detail/contracts.hpp>). The kernels
+// are out of line so that their code can be compared directly, e.g.
+//
+//   objdump -d --no-show-raw-insn -C contracts_benchmark_assume | less
+//
+// On GCC before 13 the assume build is the default build, since there is
+// no assumption there that does not cost more than it saves.
+//
+// usage: contracts_benchmark [elements]
+//
+#include <stl2/forward_list.hpp>
+#include <stl2/static_vector.hpp>
+#include <stl2/vector.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+namespace ranges = std::experimental::ranges;
+
+#if defined(STL2_CONTRACTS_CHECKED)
+#define MODE "checked"
+#elif defined(STL2_CONTRACTS_ASSUME) && !defined(__clang__) && __GNUC__ < 13
+#define MODE "assume (unsupported, so default)"
+#elif defined(STL2_CONTRACTS_ASSUME)
+#define MODE "assume"
+#else
+#define MODE "default"
+#endif
+
+namespace {
+	constexpr std::ptrdiff_t chunk = 1024;
+
+	volatile std::int64_t sink;
+
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		auto const start = std::chrono::steady_clock::now();
+		sink = f();
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		std::cout << "  " << name << ": " << elapsed.count() / n << " ns/element\n";
+	}
+}
+
+__attribute__((noinline))
+void fill_unchecked(ranges::vector<int>& v, const int* src, std::ptrdiff_t n) {
+	auto out = ranges::vector<int>::unchecked_back_inserter{v};
+	for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+		*out++ = src[i];
+	}
+}
+
+__attribute__((noinline))
+std::int64_t fill_static(ranges::static_vector<int, chunk>& v, const int* src) {
+	v.clear();
+	for (auto i = std::ptrdiff_t{0}; i < chunk; ++i) {
+		v.push_back(src[i]);
+	}
+	return v.back();
+}
+
+__attribute__((noinline))
+std::int64_t sum_list(const ranges::forward_list<int>& l) {
+	std::int64_t sum = 0;
+	for (auto i : l) {
+		sum += i;
+	}
+	return sum;
+}
+
+int main(int argc, char** argv) {
+	auto const n = argc > 1 ? std::atol(argv[1]) : 1L << 24;
+	ranges::vector<int> src{ranges::reserve_t{}, chunk};
+	for (auto i = 0; i < chunk; ++i) {
+		src.push_back(i * 7 % 1000);
+	}
+	std::cout << MODE << " contracts, " << n << " elements\n";
+
+	ranges::vector<int> v{ranges::reserve_t{}, chunk};
+	measure("unchecked_back_inserter fill", n, [&] {
+		std::int64_t total = 0;
+		for (auto i = std::ptrdiff_t{0}; i < n; i += chunk) {
+			v.clear();
+			fill_unchecked(v, &*src.begin(), chunk);
+			total += v.size();
+		}
+		return total;
+	});
+
+	ranges::static_vector<int, chunk> sv;
+	measure("static_vector push_back", n, [&] {
+		std::int64_t last = 0;
+		for (auto i = std::ptrdiff_t{0}; i < n; i += chunk) {
+			last += fill_static(sv, &*src.begin());
+		}
+		return last;
+	});
+
+	ranges::forward_list<int> l;
+	auto const m = n / 16;
+	for (auto i = std::ptrdiff_t{0}; i < m; ++i) {
+		l.push_front(static_cast<int>(i));
+	}
+	measure("forward_list traversal", m * 16, [&] {
+		std::int64_t sum = 0;
+		for (auto r = 0; r < 16; ++r) {
+			sum += sum_list(l);
+		}
+		return sum;
+	});
+}
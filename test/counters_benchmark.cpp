@@ -0,0 +1,370 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Hardware counters - cycles, instructions, L1D, last-level cache and
+// dTLB read misses, branch misses - per element for vector growth (push
+// with and without reserve, reallocation of a full vector) and for
+// forward_list build, traversal, sort and clear, at sizes from L1-resident
+// to well beyond the last-level cache. Counters come from Linux
+// perf_event_open, counting user-space events of this thread only; where
+// they are unavailable (another OS, a container without
+// perf_event_paranoid permission, a PMU without the event) the affected
+// columns read "-", and with none at all only times are reported.
+//
+// usage: counters_benchmark [elements]
+//
+#include <stl2/forward_list.hpp>
+#include <stl2/vector.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	// Elements processed per scenario, split into repetitions of the
+	// size under test so that small sizes are not lost in noise.
+	constexpr std::ptrdiff_t work = std::ptrdiff_t{1} << 23;
+
+	volatile std::uint64_t sink;
+
+	struct event {
+		const char* name;
+		std::uint32_t type;
+		std::uint64_t config;
+	};
+
+#ifdef __linux__
+	constexpr std::uint64_t cache_read_miss(std::uint64_t cache) {
+		return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+			(PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+
+	constexpr event events[] = {
+		{"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{"instrs", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{"L1D miss", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_L1D)},
+		{"LLC miss", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_LL)},
+		{"dTLB miss", PERF_TYPE_HW_CACHE, cache_read_miss(PERF_COUNT_HW_CACHE_DTLB)},
+		{"br miss", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+	};
+#else
+	constexpr event events[] = {
+		{"cycles", 0, 0}, {"instrs", 0, 0}, {"L1D miss", 0, 0},
+		{"LLC miss", 0, 0}, {"dTLB miss", 0, 0}, {"br miss", 0, 0},
+	};
+#endif
+	constexpr int event_count = sizeof(events) / sizeof(events[0]);
+
+	// The events of a single perf group, so that they are scheduled onto
+	// the PMU together and their ratios are meaningful. Time and counts
+	// accumulate over start/stop pairs; counts are scaled up if the kernel
+	// had to multiplex the group.
+	class counters {
+	public:
+		counters() {
+#ifdef __linux__
+			for (auto i = 0; i < event_count; ++i) {
+				perf_event_attr attr{};
+				attr.size = sizeof(attr);
+				attr.type = events[i].type;
+				attr.config = events[i].config;
+				attr.disabled = leader_ < 0;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+					PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				auto const fd = static_cast<int>(
+					syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+				if (fd < 0) {
+					continue;
+				}
+				fds_[i] = fd;
+				ioctl(fd, PERF_EVENT_IOC_ID, &ids_[i]);
+				if (leader_ < 0) {
+					leader_ = fd;
+				}
+			}
+#endif
+		}
+		~counters() {
+#ifdef __linux__
+			for (auto fd : fds_) {
+				if (fd >= 0) {
+					close(fd);
+				}
+			}
+#endif
+		}
+		counters(const counters&) = delete;
+		counters& operator=(const counters&) = delete;
+
+		bool any() const noexcept { return leader_ >= 0; }
+		bool has(int i) const noexcept { return fds_[i] >= 0 && running_ > 0; }
+
+		void reset() noexcept {
+			elapsed_ = std::chrono::steady_clock::duration::zero();
+			enabled_ = running_ = 0;
+			for (auto& c : counts_) {
+				c = 0;
+			}
+		}
+
+		void start() noexcept {
+#ifdef __linux__
+			if (any()) {
+				snapshot(before_);
+				ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+			}
+#endif
+			start_ = std::chrono::steady_clock::now();
+		}
+
+		void stop() noexcept {
+			elapsed_ += std::chrono::steady_clock::now() - start_;
+#ifdef __linux__
+			if (any()) {
+				ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+				std::uint64_t after[event_count + 2];
+				snapshot(after);
+				enabled_ += after[0] - before_[0];
+				running_ += after[1] - before_[1];
+				for (auto i = 0; i < event_count; ++i) {
+					counts_[i] += after[i + 2] - before_[i + 2];
+				}
+			}
+#endif
+		}
+
+		double nanoseconds() const noexcept {
+			return std::chrono::duration<double, std::nano>(elapsed_).count();
+		}
+		double count(int i) const noexcept {
+			return running_ == 0 ? 0.0
+				: static_cast<double>(counts_[i]) * enabled_ / running_;
+		}
+
+	private:
+		int fds_[event_count] = {-1, -1, -1, -1, -1, -1};
+		std::uint64_t ids_[event_count] = {};
+		int leader_ = -1;
+
+		std::chrono::steady_clock::time_point start_;
+		std::chrono::steady_clock::duration elapsed_{};
+		// Time enabled and running, then each event, in events order.
+		std::uint64_t before_[event_count + 2] = {};
+		std::uint64_t enabled_ = 0;
+		std::uint64_t running_ = 0;
+		std::uint64_t counts_[event_count] = {};
+
+#ifdef __linux__
+		// Reads the group, whose members come back in the order they
+		// were opened, tagged with their ids.
+		void snapshot(std::uint64_t* out) const noexcept {
+			std::uint64_t buf[3 + 2 * event_count] = {};
+			if (read(leader_, buf, sizeof(buf)) <= 0) {
+				return;
+			}
+			out[0] = buf[1];
+			out[1] = buf[2];
+			for (auto i = 0; i < event_count; ++i) {
+				out[i + 2] = 0;
+				for (auto j = std::uint64_t{0}; j < buf[0]; ++j) {
+					if (fds_[i] >= 0 && buf[4 + 2 * j] == ids_[i]) {
+						out[i + 2] = buf[3 + 2 * j];
+					}
+				}
+			}
+		}
+#endif
+	};
+
+	counters& pmu() {
+		static counters c;
+		return c;
+	}
+
+	void header() {
+		std::printf("  %-28s %9s", "", "ns");
+		if (pmu().any()) {
+			for (auto const& e : events) {
+				std::printf(" %9s", e.name);
+			}
+		}
+		std::printf("   (per element)\n");
+	}
+
+	// Runs f(reps) - which brackets the work to be measured with
+	// pmu().start() and pmu().stop() - and reports per element figures.
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		auto const reps = std::max(std::ptrdiff_t{1}, work / n);
+		pmu().reset();
+		f(reps);
+		auto const ops = static_cast<double>(n) * reps;
+		std::printf("  %-28s %9.3f", name, pmu().nanoseconds() / ops);
+		if (pmu().any()) {
+			for (auto i = 0; i < event_count; ++i) {
+				if (pmu().has(i)) {
+					std::printf(" %9.3f", pmu().count(i) / ops);
+				} else {
+					std::printf(" %9s", "-");
+				}
+			}
+		}
+		std::printf("\n");
+	}
+
+	void run_vector(std::ptrdiff_t n) {
+		std::printf(" vector\n");
+		measure("push_back", n, [n](std::ptrdiff_t reps) {
+			for (auto r = reps; r > 0; --r) {
+				pmu().start();
+				{
+					ranges::vector<std::uint64_t> v;
+					for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+						v.push_back(static_cast<std::uint64_t>(i));
+					}
+					sink = v.end()[-1];
+				}
+				pmu().stop();
+			}
+		});
+		measure("reserve + push_back", n, [n](std::ptrdiff_t reps) {
+			for (auto r = reps; r > 0; --r) {
+				pmu().start();
+				{
+					ranges::vector<std::uint64_t> v;
+					v.reserve(n);
+					for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+						v.push_back(static_cast<std::uint64_t>(i));
+					}
+					sink = v.end()[-1];
+				}
+				pmu().stop();
+			}
+		});
+		measure("reallocate full vector", n, [n](std::ptrdiff_t reps) {
+			for (auto r = reps; r > 0; --r) {
+				ranges::vector<std::uint64_t> v;
+				v.reserve(n);
+				for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+					v.push_back(static_cast<std::uint64_t>(i));
+				}
+				pmu().start();
+				v.reserve(2 * n);
+				pmu().stop();
+				sink = v.begin()[0];
+			}
+		});
+	}
+
+	void run_forward_list(std::ptrdiff_t n, const std::vector<std::uint64_t>& values) {
+		std::printf(" forward_list\n");
+		using list = ranges::forward_list<std::uint64_t>;
+		auto build = [&](list& l) {
+			for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+				l.push_front(values[i]);
+			}
+		};
+		measure("build (push_front)", n, [&](std::ptrdiff_t reps) {
+			for (auto r = reps; r > 0; --r) {
+				list l;
+				pmu().start();
+				build(l);
+				pmu().stop();
+				sink = l.front();
+			}
+		});
+		measure("iterate", n, [&](std::ptrdiff_t reps) {
+			list l;
+			build(l);
+			for (auto r = reps; r > 0; --r) {
+				pmu().start();
+				std::uint64_t sum = 0;
+				for (auto x : l) {
+					sum += x;
+				}
+				pmu().stop();
+				sink = sum;
+			}
+		});
+		// forward_list has no sort member; the values are sorted in
+		// place, copied out to contiguous storage and back through the
+		// list's iterators, which costs two traversals.
+		measure("sort (values)", n, [&](std::ptrdiff_t reps) {
+			std::vector<std::uint64_t> scratch(n);
+			for (auto r = reps; r > 0; --r) {
+				list l;
+				build(l);
+				pmu().start();
+				auto out = scratch.begin();
+				for (auto x : l) {
+					*out++ = x;
+				}
+				std::sort(scratch.begin(), scratch.end());
+				auto in = scratch.begin();
+				for (auto& x : l) {
+					x = *in++;
+				}
+				pmu().stop();
+				sink = l.front();
+			}
+		});
+		measure("clear", n, [&](std::ptrdiff_t reps) {
+			for (auto r = reps; r > 0; --r) {
+				list l;
+				build(l);
+				pmu().start();
+				l.clear();
+				pmu().stop();
+			}
+		});
+	}
+
+	void run(std::ptrdiff_t n) {
+		std::printf("%td elements (%td KiB)\n", n,
+			n * static_cast<std::ptrdiff_t>(sizeof(std::uint64_t)) / 1024);
+		header();
+		std::mt19937_64 gen{static_cast<std::uint64_t>(n)};
+		std::vector<std::uint64_t> values(n);
+		for (auto& v : values) {
+			v = gen();
+		}
+		run_vector(n);
+		run_forward_list(n, values);
+	}
+}
+
+int main(int argc, char** argv) {
+	if (!pmu().any()) {
+		std::printf("hardware counters unavailable; reporting times only\n");
+	}
+	if (argc > 1) {
+		run(std::atol(argv[1]));
+	} else {
+		// 32KiB, 256KiB, 4MiB and 64MiB of elements
+		for (auto n : {1L << 12, 1L << 15, 1L << 19, 1L << 23}) {
+			run(n);
+		}
+	}
+}
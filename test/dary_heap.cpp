@@ -0,0 +1,305 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/dary_heap.hpp>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	// Every element is no greater than its parent.
+	template <std::ptrdiff_t D, class V, class C = std::less<>>
+	bool is_dary_heap(const V& v, C comp = C{}) {
+		auto const first = v.begin();
+		auto const n = static_cast<std::ptrdiff_t>(v.end() - v.begin());
+		for (auto i = std::ptrdiff_t{1}; i < n; ++i) {
+			if (comp(first[(i - 1) / D], first[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	template <std::ptrdiff_t D>
+	void test_arity() {
+		std::mt19937 gen{D};
+		std::vector<int> values(1000);
+		for (auto& v : values) {
+			v = static_cast<int>(gen() % 500);
+		}
+
+		// Pushed one at a time, popped in order
+		{
+			ranges::dary_heap<int, D> h;
+			for (auto v : values) {
+				h.push(v);
+			}
+			CHECK(h.size() == 1000);
+			CHECK(is_dary_heap<D>(h.container()));
+			auto sorted = values;
+			std::sort(sorted.begin(), sorted.end(), std::greater<>{});
+			std::vector<int> out;
+			while (!h.empty()) {
+				out.push_back(h.top());
+				h.pop();
+			}
+			CHECK(out == sorted);
+		}
+
+		// Heapified, for every size up to a few levels
+		for (auto n = 0; n < 100; ++n) {
+			ranges::dary_heap<int, D> h{values.begin(), values.begin() + n};
+			CHECK(h.size() == n);
+			CHECK(is_dary_heap<D>(h.container()));
+		}
+
+		// Ranges pushed onto existing heaps, both few and many elements
+		for (auto k : {0, 1, 10, 500}) {
+			for (auto m : {0, 1, 5, 100, 1000 - k}) {
+				ranges::dary_heap<int, D> h{values.begin(), values.begin() + k};
+				h.push_range(values.begin() + k, values.begin() + k + m);
+				CHECK(h.size() == k + m);
+				CHECK(is_dary_heap<D>(h.container()));
+				CHECK((k + m == 0 ||
+					h.top() == *std::max_element(values.begin(), values.begin() + k + m)));
+			}
+		}
+
+		// pop_push agrees with pop then push.
+		{
+			ranges::dary_heap<int, D> a{values.begin(), values.end()};
+			ranges::dary_heap<int, D> b{values.begin(), values.end()};
+			for (auto i = 0; i < 2000; ++i) {
+				auto const v = static_cast<int>(gen() % 600);
+				a.pop_push(v);
+				b.pop();
+				b.push(v);
+				CHECK(a.top() == b.top());
+			}
+			CHECK(is_dary_heap<D>(a.container()));
+		}
+
+		// A min-heap
+		{
+			ranges::dary_heap<int, D, std::greater<>> h{values.begin(), values.end()};
+			CHECK(h.top() == *std::min_element(values.begin(), values.end()));
+			CHECK(is_dary_heap<D>(h.container(), std::greater<>{}));
+		}
+	}
+
+	template <std::ptrdiff_t D>
+	void test_indexed() {
+		std::mt19937 gen{D + 100};
+		ranges::indexed_dary_heap<int, D, std::greater<>> h;
+		// The value of each live handle, as the model
+		std::vector<int> model;
+		std::vector<bool> live;
+		auto ok = true;
+		auto check = [&] {
+			auto best = -1;
+			auto count = 0;
+			for (auto i = 0u; i < model.size(); ++i) {
+				if (live[i]) {
+					++count;
+					ok = ok && h.contains(i) && h[i] == model[i];
+					if (best < 0 || model[i] < model[best]) {
+						best = i;
+					}
+				} else {
+					ok = ok && !h.contains(i);
+				}
+			}
+			ok = ok && h.size() == count;
+			if (count > 0) {
+				ok = ok && h.top() == model[best] && model[h.top_handle()] == h.top();
+			}
+		};
+		for (auto step = 0; step < 5000; ++step) {
+			auto const op = gen() % 8;
+			if (op < 3 || h.empty()) {
+				auto const v = static_cast<int>(gen() % 1000);
+				auto const k = h.push(v);
+				if (k >= static_cast<std::ptrdiff_t>(model.size())) {
+					model.resize(k + 1);
+					live.resize(k + 1);
+				}
+				ok = ok && !live[k];
+				model[k] = v;
+				live[k] = true;
+			} else if (op < 4) {
+				live[h.top_handle()] = false;
+				h.pop();
+			} else {
+				// A random live handle
+				auto k = static_cast<int>(gen() % model.size());
+				while (!live[k]) {
+					k = (k + 1) % model.size();
+				}
+				if (op < 5) {
+					h.erase(k);
+					live[k] = false;
+				} else {
+					// Decrease or increase
+					auto const v = static_cast<int>(gen() % 1000);
+					h.update(k, v);
+					model[k] = v;
+				}
+			}
+			check();
+		}
+		h.clear();
+		CHECK(h.empty());
+		CHECK(!h.contains(0));
+		// Handles are reused.
+		CHECK(h.push(1) < static_cast<std::ptrdiff_t>(model.size()));
+		CHECK(ok);
+	}
+
+	// Throws bad_alloc once budget allocations have been made, unless
+	// budget is negative.
+	int budget = -1;
+
+	template <class T>
+	struct limited_allocator {
+		using value_type = T;
+
+		limited_allocator() = default;
+		template <class U>
+		limited_allocator(const limited_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n) {
+			if (budget == 0) {
+				throw std::bad_alloc{};
+			}
+			--budget;
+			return std::allocator<T>{}.allocate(n);
+		}
+		void deallocate(T* p, std::size_t n) noexcept {
+			std::allocator<T>{}.deallocate(p, n);
+		}
+
+		template <class U>
+		bool operator==(const limited_allocator<U>&) const noexcept { return true; }
+		template <class U>
+		bool operator!=(const limited_allocator<U>&) const noexcept { return false; }
+	};
+
+	// Converts to its value, unless that is negative.
+	struct checked {
+		int value;
+		operator int() const {
+			if (value < 0) {
+				throw std::runtime_error{"checked"};
+			}
+			return value;
+		}
+	};
+
+	// Moves only, to check that the heap never copies.
+	struct move_only {
+		std::unique_ptr<int> p;
+		move_only(int i) : p{std::make_unique<int>(i)} {}
+		move_only(move_only&&) = default;
+		move_only& operator=(move_only&&) = default;
+		bool operator<(const move_only& that) const { return *p < *that.p; }
+	};
+}
+
+int main() {
+	test_arity<2>();
+	test_arity<3>();
+	test_arity<4>();
+	test_arity<8>();
+	test_arity<16>();
+	test_indexed<2>();
+	test_indexed<4>();
+	test_indexed<8>();
+
+	{
+		ranges::priority_queue<int> q;
+		static_assert(decltype(q)::arity == 4);
+		q.push(3);
+		q.emplace(7);
+		q.push(5);
+		CHECK(q.top() == 7);
+		q.pop();
+		CHECK(q.top() == 5);
+		q.clear();
+		CHECK(q.empty());
+		int more[] = {4, 9, 2};
+		q.push_range(more);
+		CHECK(q.top() == 9);
+	}
+	{
+		ranges::dary_heap<move_only, 8> h;
+		for (auto i = 0; i < 100; ++i) {
+			h.emplace((i * 37) % 100);
+		}
+		h.pop_push(move_only{1000});
+		CHECK(*h.top().p == 1000);
+		h.pop();
+		CHECK(*h.top().p == 98);
+	}
+	{
+		ranges::indexed_dary_heap<move_only> h;
+		auto const a = h.emplace(5);
+		auto const b = h.emplace(10);
+		CHECK(h.top_handle() == b);
+		h.update(a, move_only{20});
+		CHECK(h.top_handle() == a);
+		CHECK(*h[b].p == 10);
+	}
+
+	{
+		// A push_range that throws partway leaves the heap as it was.
+		ranges::dary_heap<int> h;
+		for (auto i = 0; i < 10; ++i) {
+			h.push(i);
+		}
+		checked more[] = {{100}, {200}, {-1}, {300}};
+		auto threw = false;
+		try {
+			h.push_range(more);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(h.size() == 10);
+		CHECK(is_dary_heap<4>(h.container()));
+		CHECK(h.top() == 9);
+	}
+
+	{
+		// A handle whose bookkeeping cannot be allocated is not leaked.
+		ranges::indexed_dary_heap<int, 4, std::less<>, limited_allocator<int>> h;
+		budget = 1;
+		auto threw = false;
+		try {
+			h.push(1);
+		} catch (std::bad_alloc&) {
+			threw = true;
+		}
+		budget = -1;
+		CHECK(threw);
+		CHECK(h.empty());
+		CHECK(h.push(2) == 0);
+		CHECK(h.top() == 2);
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,131 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Throughput of a timer queue - a min-heap of deadlines, from which the
+// earliest is repeatedly taken and a later one put back - with
+// std::priority_queue and with dary_heap at arities 2, 4 and 8, at sizes
+// from in-cache to well out of it. Also the time to build a heap from
+// unordered deadlines, with push_range against one push at a time.
+//
+// usage: dary_heap_benchmark [elements]
+//
+#include <stl2/dary_heap.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	constexpr std::ptrdiff_t operations = std::ptrdiff_t{1} << 24;
+
+	volatile std::uint64_t sink;
+
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		auto const start = std::chrono::steady_clock::now();
+		sink = f();
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		std::cout << "  " << name << ": " << elapsed.count() / n << " ns/op\n";
+	}
+
+	// Takes the earliest deadline and schedules one a random interval
+	// after it, operations times.
+	template <class Heap>
+	std::uint64_t churn(Heap& h, const std::vector<std::uint64_t>& intervals) {
+		auto const mask = intervals.size() - 1;
+		for (auto i = std::ptrdiff_t{0}; i < operations; ++i) {
+			auto const next = h.top() + intervals[i & mask];
+			h.pop();
+			h.push(next);
+		}
+		return h.top();
+	}
+
+	template <std::ptrdiff_t D>
+	void run_dary(std::ptrdiff_t n, const std::vector<std::uint64_t>& deadlines,
+		const std::vector<std::uint64_t>& intervals)
+	{
+		using heap = ranges::dary_heap<std::uint64_t, D, std::greater<>>;
+		std::cout << " dary_heap<" << D << ">\n";
+		{
+			heap h{deadlines.begin(), deadlines.end()};
+			measure("pop + push", operations, [&] { return churn(h, intervals); });
+		}
+		{
+			heap h{deadlines.begin(), deadlines.end()};
+			auto const mask = intervals.size() - 1;
+			measure("pop_push", operations, [&] {
+				for (auto i = std::ptrdiff_t{0}; i < operations; ++i) {
+					h.pop_push(h.top() + intervals[i & mask]);
+				}
+				return h.top();
+			});
+		}
+		measure("push_range", n, [&] {
+			heap h;
+			h.push_range(deadlines.begin(), deadlines.end());
+			return h.top();
+		});
+		measure("push each", n, [&] {
+			heap h;
+			h.reserve(n);
+			for (auto d : deadlines) {
+				h.push(d);
+			}
+			return h.top();
+		});
+	}
+
+	void run(std::ptrdiff_t n) {
+		std::cout << n << " timers\n";
+		std::mt19937_64 gen{static_cast<std::uint64_t>(n)};
+		std::vector<std::uint64_t> deadlines(n);
+		for (auto& d : deadlines) {
+			d = gen() % (std::uint64_t{1} << 40);
+		}
+		std::vector<std::uint64_t> intervals(std::size_t{1} << 16);
+		for (auto& i : intervals) {
+			i = gen() % (std::uint64_t{1} << 40);
+		}
+
+		std::cout << " std::priority_queue\n";
+		{
+			std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>> q{
+				std::greater<>{}, deadlines};
+			measure("pop + push", operations, [&] { return churn(q, intervals); });
+		}
+		measure("construct", n, [&] {
+			std::priority_queue<std::uint64_t, std::vector<std::uint64_t>, std::greater<>> q{
+				std::greater<>{}, deadlines};
+			return q.top();
+		});
+		run_dary<2>(n, deadlines, intervals);
+		run_dary<4>(n, deadlines, intervals);
+		run_dary<8>(n, deadlines, intervals);
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1) {
+		run(std::atol(argv[1]));
+	} else {
+		for (auto n : {1L << 10, 1L << 16, 1L << 22}) {
+			run(n);
+		}
+	}
+}
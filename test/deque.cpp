@@ -0,0 +1,140 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/deque.hpp>
+#include <stl2/algorithm.hpp>
+#include <stl2/view/repeat_n.hpp>
+#include <memory>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace incomplete {
+	struct foo;
+	ranges::deque<foo> deq;
+	struct foo {};
+
+	void test() {
+		deq.emplace_back();
+		deq.emplace_front();
+		CHECK(deq.size() == 2);
+	}
+}
+
+int main() {
+	{
+		using D = ranges::deque<int>;
+		using I = decltype(ranges::declval<D&>().begin());
+		static_assert(ranges::models::RandomAccessIterator<I>);
+		static_assert(ranges::models::RandomAccessRange<D>);
+		static_assert(D::block_size() == 1024);
+		static_assert(ranges::deque<char[4096]>::block_size() == 16);
+	}
+
+	{
+		ranges::deque<int> deq;
+		deq.push_back(42);
+		for (auto i = 1; i < 32; ++i) {
+			deq.push_back(deq.back());
+		}
+		CHECK(ranges::equal(deq, ranges::repeat_n_view<int>{42, 32}));
+		for (auto i = 0; i < 16; ++i) {
+			deq.pop_back();
+		}
+		CHECK(ranges::equal(deq, ranges::repeat_n_view<int>{42, 16}));
+	}
+
+	{
+		// References survive growth at both ends.
+		ranges::deque<int> deq;
+		auto n = 4 * ranges::deque<int>::block_size();
+		auto& first = deq.emplace_back(0);
+		for (auto i = 1; i < n; ++i) {
+			deq.push_back(i);
+			deq.push_front(-i);
+		}
+		CHECK(first == 0);
+		CHECK(&deq[n - 1] == &first);
+		CHECK(deq.size() == 2 * n - 1);
+		CHECK(deq.front() == -(n - 1));
+		CHECK(deq.back() == n - 1);
+		CHECK(ranges::is_sorted(deq));
+		CHECK(deq.end() - deq.begin() == deq.size());
+		CHECK(ranges::equal(deq.rbegin(), deq.rend(), deq.begin(), deq.end(),
+			[](int x, int y) { return x == -y; }));
+	}
+
+	{
+		// FIFO use recycles emptied blocks instead of allocating.
+		ranges::deque<int> deq;
+		auto const B = ranges::deque<int>::block_size();
+		for (auto i = 0; i < 2 * B; ++i) {
+			deq.push_back(i);
+		}
+		auto const cap = deq.capacity();
+		for (auto i = 2 * B; i < 64 * B; ++i) {
+			CHECK(deq.front() == i - 2 * B);
+			deq.pop_front();
+			deq.push_back(i);
+		}
+		CHECK(deq.size() == 2 * B);
+		CHECK(deq.capacity() <= cap + B);
+		deq.shrink_to_fit();
+		CHECK(deq.capacity() <= 3 * B);
+		CHECK(ranges::is_sorted(deq));
+	}
+
+	{
+		ranges::deque<int> deq;
+		auto const B = ranges::deque<int>::block_size();
+		for (auto i = 0; i < 3 * B + 5; ++i) {
+			deq.push_front(i);
+		}
+		auto segments = 0;
+		auto total = 0;
+		auto expected = 3 * B + 5;
+		deq.for_each_segment([&](const int* first, const int* last) {
+			++segments;
+			for (; first != last; ++first) {
+				CHECK(*first == --expected);
+				++total;
+			}
+		});
+		CHECK(segments == 4);
+		CHECK(total == 3 * B + 5);
+
+		auto copy = deq;
+		CHECK(ranges::equal(copy, deq));
+		auto moved = std::move(copy);
+		CHECK(copy.empty());
+		CHECK(ranges::equal(moved, deq));
+		deq.clear();
+		CHECK(deq.empty());
+		deq.push_front(1);
+		deq.push_back(2);
+		CHECK(deq.front() == 1 && deq.back() == 2);
+	}
+
+	{
+		ranges::deque<std::unique_ptr<int>> deq;
+		for (auto i = 0; i < 100; ++i) {
+			deq.push_back(std::make_unique<int>(i));
+		}
+		auto i = 0;
+		for (auto&& p : deq) {
+			CHECK(*p == i++);
+		}
+	}
+
+	incomplete::test();
+
+	return ::test_result();
+}
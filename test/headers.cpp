@@ -9,7 +9,30 @@
 //
 // Project home: https://github.com/caseycarter/cmcstl2
 //
+#include <stl2/aligned_allocator.hpp>
+#include <stl2/bit_vector.hpp>
+#include <stl2/btree.hpp>
+#include <stl2/caching_allocator.hpp>
+#include <stl2/colony.hpp>
+#include <stl2/concurrent_vector.hpp>
+#include <stl2/dary_heap.hpp>
+#include <stl2/deque.hpp>
+#include <stl2/execution.hpp>
+#include <stl2/io_buffer.hpp>
+#include <stl2/memory_resource.hpp>
+#include <stl2/memory_stats.hpp>
 #include <stl2/vector.hpp>
 #include <stl2/forward_list.hpp>
+#include <stl2/packed_int_vector.hpp>
+#include <stl2/parallel_algorithm.hpp>
+#include <stl2/persistent_forward_list.hpp>
+#include <stl2/persistent_vector.hpp>
+#include <stl2/ring_buffer.hpp>
+#include <stl2/serialize.hpp>
+#include <stl2/simd_algorithm.hpp>
+#include <stl2/slot_map.hpp>
+#include <stl2/soa_vector.hpp>
+#include <stl2/static_vector.hpp>
+#include <stl2/string.hpp>
 
 int main() {}
@@ -0,0 +1,149 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/io_buffer.hpp>
+#include <stl2/algorithm.hpp>
+#include <stl2/forward_list.hpp>
+#include <stl2/vector.hpp>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+// A source that yields at most chunk bytes per read.
+struct trickle {
+	const unsigned char* data;
+	std::size_t size;
+	std::size_t chunk;
+
+	std::size_t read(const ranges::mutable_buffer* bufs, std::size_t n) {
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < n && chunk > total; ++i) {
+			auto const k = std::min({bufs[i].size, size, chunk - total});
+			std::memcpy(bufs[i].data, data, k);
+			data += k;
+			size -= k;
+			total += k;
+		}
+		return total;
+	}
+};
+
+int main() {
+	{
+		ranges::vector<int> vec;
+		for (auto i = 0; i < 10; ++i) {
+			vec.push_back(i);
+		}
+		auto b = ranges::buffer_of(vec);
+		CHECK(b.data == &*vec.begin());
+		CHECK(b.size == 10 * sizeof(int));
+
+		const auto& cvec = vec;
+		ranges::const_buffer cb = ranges::buffer_of(cvec);
+		CHECK(cb.data == b.data && cb.size == b.size);
+
+		ranges::vector<int> empty;
+		CHECK(ranges::buffer_of(empty).size == 0);
+	}
+	{
+		// One buffer per node payload.
+		ranges::forward_list<long> list;
+		for (auto i = 0; i < 5; ++i) {
+			list.push_front(i);
+		}
+		auto n = 0;
+		auto it = list.begin();
+		for (ranges::mutable_buffer b : ranges::buffers(list)) {
+			CHECK(b.data == &*it);
+			CHECK(b.size == sizeof(long));
+			++it;
+			++n;
+		}
+		CHECK(n == 5);
+	}
+	{
+		// Gather several strings and a vector through a pipe, then scatter
+		// the bytes back into the nodes of a presized list.
+		int fds[2];
+		CHECK(::pipe(fds) == 0);
+		ranges::fd_stream out{fds[1]};
+		ranges::fd_stream in{fds[0]};
+
+		ranges::forward_list<std::string> strings;
+		strings.push_front("world");
+		strings.push_front(", ");
+		strings.push_front("hello");
+		ranges::write_buffers(out, ranges::buffers(strings));
+
+		ranges::forward_list<char> chars;
+		for (auto i = 0; i < 12; ++i) {
+			chars.push_front('\0');
+		}
+		CHECK(ranges::read_buffers(in, ranges::buffers(chars)) == 12);
+		CHECK(ranges::equal(chars, std::string{"hello, world"}));
+
+		// Reading directly into the uninitialized tail of a vector.
+		ranges::vector<short> nums{ranges::reserve_t{}, 8};
+		nums.push_back(-1);
+		auto tail = ranges::tail_buffer(nums);
+		CHECK(tail.data == &*nums.end());
+		CHECK(tail.size == 7 * sizeof(short));
+
+		short data[] = {1, 2, 3, 4};
+		ranges::const_buffer const db = ranges::buffer_of(data);
+		out.write(&db, 1);
+		::close(fds[1]);
+		std::size_t partial = 0;
+		CHECK(ranges::read_tail(in, nums, partial) == sizeof(data));
+		CHECK(partial == 0);
+		CHECK(nums.size() == 5);
+		CHECK(nums.capacity() == 8);
+		short expected[] = {-1, 1, 2, 3, 4};
+		CHECK(ranges::equal(nums, expected));
+		::close(fds[0]);
+
+		auto iov = ranges::to_iovec(db);
+		CHECK(iov.iov_base == data && iov.iov_len == sizeof(data));
+	}
+
+	{
+		// Short reads that split elements carry their bytes over.
+		int const data[] = {0x01020304, 0x05060708, 0x090a0b0c};
+		trickle in{reinterpret_cast<const unsigned char*>(data), sizeof(data), 5};
+		ranges::vector<int> nums{ranges::reserve_t{}, 4};
+		std::size_t partial = 0;
+		CHECK(ranges::read_tail(in, nums, partial) == 5);
+		CHECK(nums.size() == 1);
+		CHECK(partial == 1);
+		CHECK(ranges::read_tail(in, nums, partial) == 5);
+		CHECK(nums.size() == 2);
+		CHECK(partial == 2);
+		CHECK(ranges::read_tail(in, nums, partial) == 2);
+		CHECK(partial == 0);
+		CHECK(ranges::equal(nums, data));
+		CHECK(ranges::read_tail(in, nums, partial) == 0);
+
+		// Byte vectors need no carry.
+		char const text[] = "scatter";
+		trickle chars_in{reinterpret_cast<const unsigned char*>(text), 7, 3};
+		ranges::vector<char> chars{ranges::reserve_t{}, 8};
+		CHECK(ranges::read_tail(chars_in, chars) == 3);
+		CHECK(ranges::read_tail(chars_in, chars) == 3);
+		CHECK(ranges::read_tail(chars_in, chars) == 1);
+		CHECK(ranges::equal(chars, std::string{"scatter"}));
+	}
+
+	return ::test_result();
+}
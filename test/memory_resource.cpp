@@ -0,0 +1,273 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/memory_resource.hpp>
+#include <stl2/forward_list.hpp>
+#include <stl2/vector.hpp>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	// Checks that every deallocation matches an allocation, in address,
+	// size and alignment.
+	class tracking_resource final : public ranges::memory_resource {
+		struct record {
+			void* p;
+			std::size_t bytes;
+			std::size_t align;
+		};
+		std::vector<record> live_;
+		bool ok_ = true;
+
+		void* do_allocate(std::size_t bytes, std::size_t align) override {
+			auto const p = ranges::new_delete_resource()->allocate(bytes, align);
+			live_.push_back({p, bytes, align});
+			++allocations;
+			return p;
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t align) noexcept override {
+			for (auto i = live_.begin(); i != live_.end(); ++i) {
+				if (i->p == p) {
+					ok_ = ok_ && i->bytes == bytes && i->align == align;
+					live_.erase(i);
+					ranges::new_delete_resource()->deallocate(p, bytes, align);
+					return;
+				}
+			}
+			ok_ = false;
+		}
+		bool do_is_equal(const memory_resource& that) const noexcept override {
+			return this == &that;
+		}
+
+	public:
+		int allocations = 0;
+
+		std::size_t live() const noexcept { return live_.size(); }
+		bool ok() const noexcept { return ok_; }
+	};
+
+	bool aligned(void* p, std::size_t align) {
+		return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+	}
+
+	using pvector = ranges::vector<int, ranges::polymorphic_allocator<>>;
+	using plist = ranges::forward_list<int, ranges::polymorphic_allocator<>>;
+
+	// The same function, and the same container type, whichever resource
+	// the caller picks.
+	int fill_and_sum(ranges::memory_resource* r) {
+		pvector v{ranges::polymorphic_allocator<>{r}};
+		plist l{ranges::polymorphic_allocator<>{r}};
+		for (auto i = 0; i < 1000; ++i) {
+			v.push_back(i);
+			l.push_front(i);
+		}
+		auto sum = 0;
+		for (auto i : l) {
+			sum += i;
+		}
+		for (auto i : v) {
+			sum -= i;
+		}
+		return sum;
+	}
+}
+
+static_assert(ranges::models::ProtoAllocator<ranges::polymorphic_allocator<>>);
+static_assert(ranges::models::Allocator<ranges::polymorphic_allocator<int>, int>);
+static_assert(ranges::models::Same<
+	ranges::rebind_allocator_t<ranges::polymorphic_allocator<>, int>,
+	ranges::polymorphic_allocator<int>>);
+
+int main() {
+	{
+		auto const r = ranges::new_delete_resource();
+		CHECK(*r == *ranges::new_delete_resource());
+		CHECK(*r != *ranges::null_memory_resource());
+		auto const p = r->allocate(100, 256);
+		CHECK(aligned(p, 256));
+		r->deallocate(p, 100, 256);
+
+		auto threw = false;
+		try {
+			ranges::null_memory_resource()->allocate(1);
+		} catch (std::bad_alloc&) {
+			threw = true;
+		}
+		CHECK(threw);
+	}
+	{
+		// The default resource
+		CHECK(ranges::get_default_resource() == ranges::new_delete_resource());
+		CHECK(ranges::polymorphic_allocator<int>{}.resource() == ranges::new_delete_resource());
+		auto const old = ranges::set_default_resource(ranges::null_memory_resource());
+		CHECK(old == ranges::new_delete_resource());
+		CHECK(ranges::polymorphic_allocator<int>{}.resource() == ranges::null_memory_resource());
+		ranges::set_default_resource(nullptr);
+		CHECK(ranges::get_default_resource() == ranges::new_delete_resource());
+	}
+	{
+		// The buffer first, then upstream, and everything back on release.
+		tracking_resource upstream;
+		alignas(64) unsigned char buffer[128];
+		{
+			ranges::monotonic_buffer_resource m{buffer, sizeof(buffer), &upstream};
+			auto const a = m.allocate(10, 1);
+			auto const b = m.allocate(8, 8);
+			CHECK(a == buffer);
+			CHECK(b == buffer + 16);
+			CHECK(upstream.allocations == 0);
+			auto const c = m.allocate(200, 64);
+			CHECK(aligned(c, 64));
+			CHECK(upstream.allocations == 1);
+			for (auto i = 0; i < 100; ++i) {
+				auto const p = static_cast<long double*>(m.allocate(sizeof(long double), alignof(long double)));
+				CHECK(aligned(p, alignof(long double)));
+				*p = i;
+				m.deallocate(p, sizeof(long double), alignof(long double));
+			}
+			// Geometric growth
+			CHECK(upstream.allocations < 10);
+			auto const big = m.allocate(100000, 4096);
+			CHECK(aligned(big, 4096));
+			m.release();
+			CHECK(upstream.live() == 0);
+			CHECK(m.allocate(10, 1) == buffer);
+		}
+		CHECK(upstream.live() == 0);
+		CHECK(upstream.ok());
+	}
+	{
+		// Pools reuse freed blocks.
+		tracking_resource upstream;
+		{
+			ranges::unsynchronized_pool_resource pool{&upstream};
+			CHECK(pool.options().largest_required_pool_block == 4096);
+			CHECK(pool.options().max_blocks_per_chunk > 0);
+			auto const a = pool.allocate(24, 8);
+			auto const b = pool.allocate(24, 8);
+			CHECK(a != b);
+			pool.deallocate(a, 24, 8);
+			CHECK(pool.allocate(24, 8) == a);
+
+			// Blocks are aligned to their power-of-two size.
+			std::vector<void*> blocks;
+			for (auto size : {1, 7, 8, 9, 64, 100, 1000, 4096}) {
+				blocks.clear();
+				for (auto i = 0; i < 50; ++i) {
+					auto const p = pool.allocate(size, 1);
+					CHECK(aligned(p, size <= 8 ? 8 : size <= 16 ? 16 : 64));
+					blocks.push_back(p);
+				}
+				auto const before = upstream.allocations;
+				for (auto p : blocks) {
+					pool.deallocate(p, size, 1);
+				}
+				for (auto i = 0; i < 50; ++i) {
+					pool.allocate(size, 1);
+				}
+				CHECK(upstream.allocations == before);
+			}
+
+			// Larger than any pool, or more aligned than its size
+			auto const large = pool.allocate(10000, 8);
+			auto const strict = pool.allocate(16, 512);
+			CHECK(aligned(strict, 512));
+			auto const huge = pool.allocate(50000, 8192);
+			CHECK(aligned(huge, 8192));
+			pool.deallocate(large, 10000, 8);
+			auto const live = upstream.live();
+			auto const again = pool.allocate(20000, 16);
+			CHECK(upstream.live() == live + 1);
+			pool.deallocate(again, 20000, 16);
+			CHECK(upstream.live() == live);
+			pool.deallocate(huge, 50000, 8192);
+			pool.deallocate(strict, 16, 512);
+
+			pool.release();
+			CHECK(upstream.live() == 0);
+			pool.allocate(100000, 8);
+			pool.allocate(8, 8);
+		}
+		CHECK(upstream.live() == 0);
+		CHECK(upstream.ok());
+	}
+	{
+		ranges::pool_options opts;
+		opts.largest_required_pool_block = 100;
+		opts.max_blocks_per_chunk = 16;
+		ranges::unsynchronized_pool_resource pool{opts};
+		CHECK(pool.options().largest_required_pool_block == 128);
+		CHECK(pool.options().max_blocks_per_chunk == 16);
+		CHECK(pool.upstream_resource() == ranges::get_default_resource());
+	}
+	{
+		// Containers switch resources at run time.
+		alignas(std::max_align_t) unsigned char buffer[1 << 16];
+		ranges::monotonic_buffer_resource arena{buffer, sizeof(buffer)};
+		ranges::unsynchronized_pool_resource pool;
+		ranges::synchronized_pool_resource shared;
+		CHECK(fill_and_sum(&arena) == 0);
+		CHECK(fill_and_sum(&pool) == 0);
+		CHECK(fill_and_sum(&shared) == 0);
+		CHECK(fill_and_sum(ranges::new_delete_resource()) == 0);
+
+		plist a{ranges::polymorphic_allocator<>{&pool}};
+		plist b{ranges::polymorphic_allocator<>{&arena}};
+		a.push_front(1);
+		b.push_front(2);
+		CHECK(a.get_allocator() != b.get_allocator());
+		// Unequal allocators: moving copies the elements, and each list
+		// keeps its resource.
+		b = std::move(a);
+		CHECK(*b.begin() == 1);
+		CHECK(b.get_allocator().resource() == &arena);
+
+		plist copy{b};
+		CHECK(copy.get_allocator().resource() == ranges::get_default_resource());
+		CHECK(*copy.begin() == 1);
+	}
+	{
+		// Threads sharing a synchronized pool
+		tracking_resource upstream;
+		{
+			ranges::synchronized_pool_resource shared{&upstream};
+			std::thread threads[4];
+			for (auto& t : threads) {
+				t = std::thread{[&] {
+					std::vector<void*> blocks;
+					for (auto round = 0; round < 100; ++round) {
+						for (auto i = 0; i < 100; ++i) {
+							blocks.push_back(shared.allocate(8 * (i % 8 + 1), 8));
+						}
+						for (auto i = 0; i < 100; ++i) {
+							shared.deallocate(blocks[i], 8 * (i % 8 + 1), 8);
+						}
+						blocks.clear();
+					}
+				}};
+			}
+			for (auto& t : threads) {
+				t.join();
+			}
+		}
+		CHECK(upstream.live() == 0);
+		CHECK(upstream.ok());
+	}
+
+	return ::test_result();
+}
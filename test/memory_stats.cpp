@@ -0,0 +1,324 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/memory_stats.hpp>
+#include <stl2/bit_vector.hpp>
+#include <stl2/btree.hpp>
+#include <stl2/caching_allocator.hpp>
+#include <stl2/colony.hpp>
+#include <stl2/concurrent_vector.hpp>
+#include <stl2/dary_heap.hpp>
+#include <stl2/deque.hpp>
+#include <stl2/forward_list.hpp>
+#include <stl2/packed_int_vector.hpp>
+#include <stl2/persistent_forward_list.hpp>
+#include <stl2/persistent_vector.hpp>
+#include <stl2/ring_buffer.hpp>
+#include <stl2/slot_map.hpp>
+#include <stl2/soa_vector.hpp>
+#include <stl2/static_vector.hpp>
+#include <stl2/string.hpp>
+#include <stl2/vector.hpp>
+#include <cstdint>
+#include <memory>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	// Counts live allocations, so that each container's reported count
+	// can be checked.
+	std::size_t live = 0;
+
+	template <class T>
+	struct counting_allocator {
+		using value_type = T;
+
+		counting_allocator() = default;
+		template <class U>
+		counting_allocator(const counting_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n) {
+			++live;
+			return std::allocator<T>{}.allocate(n);
+		}
+		// vector hands back its null buffer when it never allocated.
+		void deallocate(T* p, std::size_t n) noexcept {
+			if (p) {
+				--live;
+				std::allocator<T>{}.deallocate(p, n);
+			}
+		}
+
+		template <class U>
+		bool operator==(const counting_allocator<U>&) const noexcept { return true; }
+		template <class U>
+		bool operator!=(const counting_allocator<U>&) const noexcept { return false; }
+	};
+
+	// Reports a fixed overhead for every allocation.
+	template <class T>
+	struct reporting_allocator : std::allocator<T> {
+		template <class U>
+		struct rebind { using other = reporting_allocator<U>; };
+
+		reporting_allocator() = default;
+		template <class U>
+		reporting_allocator(const reporting_allocator<U>&) noexcept {}
+
+		std::size_t allocation_overhead(std::size_t) const noexcept { return 16; }
+	};
+
+	template <class C>
+	bool counts_allocations(const C& c) {
+		return ranges::memory_usage(c).allocations == live;
+	}
+
+	void test_vector() {
+		{
+			ranges::vector<int, counting_allocator<int>> v;
+			CHECK(ranges::memory_usage(v).total() == 0);
+			v.reserve(100);
+			for (auto i = 0; i < 10; ++i) {
+				v.push_back(i);
+			}
+			auto const s = v.memory_usage();
+			CHECK(s.payload == 10 * sizeof(int));
+			CHECK(s.slack == 90 * sizeof(int));
+			CHECK(s.overhead == 0);
+			CHECK(s.allocator == 0);
+			CHECK(counts_allocations(v));
+		}
+		{
+			ranges::vector<int, reporting_allocator<int>> v;
+			v.push_back(1);
+			CHECK(v.memory_usage().allocator == 16);
+		}
+		{
+			// Rounded up to a 32-byte size class
+			ranges::vector<char, ranges::caching_allocator<char>> v;
+			v.reserve(20);
+			CHECK(v.memory_usage().allocator == 12);
+		}
+	}
+
+	void test_forward_list() {
+		using list = ranges::forward_list<int, counting_allocator<int>>;
+		using node = ranges::__fl::node<int, void*>;
+		list l;
+		for (auto i = 0; i < 5; ++i) {
+			l.push_front(i);
+		}
+		auto const s = l.memory_usage();
+		CHECK(s.payload == 5 * sizeof(int));
+		CHECK(s.slack == 0);
+		CHECK(s.overhead == 5 * (sizeof(node) - sizeof(int)));
+		CHECK(counts_allocations(l));
+		l.clear();
+		CHECK(l.memory_usage().total() == 0);
+	}
+
+	void test_other_containers() {
+		{
+			ranges::deque<int, counting_allocator<int>> d;
+			for (auto i = 0; i < 5000; ++i) {
+				d.push_back(i);
+			}
+			auto const s = d.memory_usage();
+			CHECK(s.payload == 5000 * sizeof(int));
+			CHECK(s.slack == (d.capacity() - d.size()) * sizeof(int));
+			CHECK(s.overhead > 0);
+			CHECK(counts_allocations(d));
+		}
+		{
+			ranges::colony<int, counting_allocator<int>> c;
+			for (auto i = 0; i < 1000; ++i) {
+				c.insert(i);
+			}
+			c.erase(c.begin());
+			auto const s = c.memory_usage();
+			CHECK(s.payload == 999 * sizeof(int));
+			CHECK(s.slack == (c.capacity() - 999) * sizeof(int));
+			CHECK(counts_allocations(c));
+		}
+		{
+			ranges::slot_map<double, counting_allocator<double>> m;
+			for (auto i = 0; i < 100; ++i) {
+				m.emplace(i);
+			}
+			auto const s = m.memory_usage();
+			CHECK(s.payload == 100 * sizeof(double));
+			CHECK(s.overhead >= 100 * (sizeof(std::uint32_t) * 3));
+			CHECK(counts_allocations(m));
+		}
+		{
+			ranges::basic_soa_vector<counting_allocator<void>, int, double> v;
+			for (auto i = 0; i < 10; ++i) {
+				v.emplace_back(i, 1.0);
+			}
+			auto const s = v.memory_usage();
+			CHECK(s.payload == 10 * (sizeof(int) + sizeof(double)));
+			CHECK(s.payload + s.slack + s.overhead ==
+				static_cast<std::size_t>(v.capacity() * sizeof(int) + 63) / 64 * 64 +
+				static_cast<std::size_t>(v.capacity() * sizeof(double) + 63) / 64 * 64);
+			CHECK(counts_allocations(v));
+		}
+		{
+			constexpr auto s = [] {
+				ranges::static_vector<int, 8> v;
+				v.push_back(1);
+				v.push_back(2);
+				v.push_back(3);
+				return v.memory_usage();
+			}();
+			static_assert(s.payload == 3 * sizeof(int));
+			static_assert(s.slack == 5 * sizeof(int));
+			static_assert(s.allocations == 0);
+		}
+		{
+			ranges::basic_string<char, std::char_traits<char>, counting_allocator<char>> str{"short"};
+			CHECK(str.memory_usage().payload == 5);
+			CHECK(str.memory_usage().slack == static_cast<std::size_t>(str.sso_capacity - 5));
+			CHECK(str.memory_usage().allocations == 0);
+			str.assign("a string too long to fit in the object itself");
+			auto const s = str.memory_usage();
+			CHECK(s.payload == static_cast<std::size_t>(str.size()));
+			CHECK(s.overhead == 1);
+			CHECK(counts_allocations(str));
+		}
+		{
+			ranges::bit_vector<counting_allocator<std::uint64_t>> b(1000, true);
+			CHECK(b.memory_usage().payload == 16 * sizeof(std::uint64_t));
+			CHECK(counts_allocations(b));
+		}
+		{
+			ranges::packed_int_vector<std::uint32_t, counting_allocator<std::uint64_t>> p{
+				10, ranges::packed_encoding::plain, {}};
+			for (auto i = 0u; i < 640; ++i) {
+				p.push_back(i % 1000);
+			}
+			CHECK(p.memory_usage().payload == 100 * sizeof(std::uint64_t));
+			CHECK(counts_allocations(p));
+		}
+	}
+
+	void test_persistent() {
+		{
+			ranges::persistent_vector<int, counting_allocator<int>> v;
+			for (auto i = 0; i < 1000; ++i) {
+				v.push_back(i);
+			}
+			auto const s = v.memory_usage();
+			CHECK(s.payload == 1000 * sizeof(int));
+			CHECK(counts_allocations(v));
+			// A copy shares every node, and counts them all again.
+			auto const w = v;
+			CHECK(w.memory_usage().total() == s.total());
+			CHECK(w.memory_usage().allocations == live);
+		}
+		{
+			ranges::persistent_forward_list<int, counting_allocator<int>> l;
+			for (auto i = 0; i < 10; ++i) {
+				l.push_front(i);
+			}
+			CHECK(l.memory_usage().payload == 10 * sizeof(int));
+			CHECK(counts_allocations(l));
+		}
+	}
+
+	void test_concurrent() {
+		{
+			ranges::ring_buffer<int, counting_allocator<int>> q{16};
+			q.try_push(1);
+			q.try_push(2);
+			auto const s = q.memory_usage();
+			CHECK(s.payload == 2 * sizeof(int));
+			CHECK(s.slack == 14 * sizeof(int));
+			CHECK(counts_allocations(q));
+		}
+		{
+			ranges::mpmc_ring_buffer<int, counting_allocator<int>> q{16};
+			q.try_push(1);
+			auto const s = q.memory_usage();
+			CHECK(s.payload == sizeof(int));
+			CHECK(s.overhead > 0);
+			CHECK(counts_allocations(q));
+		}
+		{
+			ranges::concurrent_vector<int, counting_allocator<int>> v;
+			v.grow_by(100, 1);
+			auto const s = v.memory_usage();
+			CHECK(s.payload == 100 * sizeof(int));
+			CHECK(s.slack == static_cast<std::size_t>(v.capacity() - 100) * sizeof(int));
+			CHECK(counts_allocations(v));
+		}
+	}
+
+	void test_ordered() {
+		{
+			ranges::btree_set<int, ranges::less<>, counting_allocator<int>> t;
+			for (auto i = 0; i < 10000; ++i) {
+				t.insert(i);
+			}
+			auto const s = t.memory_usage();
+			CHECK(s.payload == 10000 * sizeof(int));
+			CHECK(s.overhead > 0);
+			CHECK(counts_allocations(t));
+		}
+		{
+			ranges::btree_map<int, double, ranges::less<>, counting_allocator<std::pair<int, double>>> t;
+			t.insert({1, 2.0});
+			CHECK(t.memory_usage().payload == sizeof(int) + sizeof(double));
+			CHECK(counts_allocations(t));
+		}
+		{
+			ranges::dary_heap<int, 4, ranges::less<>, counting_allocator<int>> h;
+			for (auto i = 0; i < 100; ++i) {
+				h.push(i);
+			}
+			CHECK(h.memory_usage().payload == 100 * sizeof(int));
+			CHECK(counts_allocations(h));
+		}
+		{
+			ranges::indexed_dary_heap<int, 4, ranges::less<>, counting_allocator<int>> h;
+			for (auto i = 0; i < 100; ++i) {
+				h.push(i);
+			}
+			auto const s = h.memory_usage();
+			CHECK(s.payload == 100 * sizeof(int));
+			CHECK(s.overhead >= 200 * sizeof(std::ptrdiff_t));
+			CHECK(counts_allocations(h));
+		}
+	}
+}
+
+int main() {
+	test_vector();
+	test_forward_list();
+	test_other_containers();
+	test_persistent();
+	test_concurrent();
+	test_ordered();
+	CHECK(live == 0);
+
+	// Stats of different containers add up.
+	{
+		ranges::vector<int> v(10);
+		ranges::forward_list<int> l;
+		l.push_front(1);
+		auto const s = ranges::memory_usage(v) + ranges::memory_usage(l);
+		CHECK(s.payload == 11 * sizeof(int));
+		CHECK(s.allocations == 2);
+		CHECK(s.total() == v.memory_usage().total() + l.memory_usage().total());
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,134 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/packed_int_vector.hpp>
+#include <stl2/algorithm.hpp>
+#include <stl2/vector.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+using PIV = ranges::packed_int_vector<std::uint32_t>;
+static_assert(ranges::models::RandomAccessIterator<PIV::iterator>);
+static_assert(ranges::models::RandomAccessIterator<PIV::const_iterator>);
+static_assert(ranges::models::OutputIterator<PIV::iterator, std::uint32_t>);
+static_assert(ranges::models::Same<ranges::reference_t<PIV::const_iterator>, std::uint32_t>);
+
+int main() {
+	{
+		PIV v{5};
+		CHECK(v.width() == 5);
+		CHECK(v.encoding() == ranges::packed_encoding::plain);
+		for (auto i = 0u; i < 100; ++i) {
+			v.push_back(i % 32);
+		}
+		CHECK(v.size() == 100);
+		CHECK(v.word_count() == 8);
+		for (auto i = 0; i < 100; ++i) {
+			CHECK(v[i] == static_cast<std::uint32_t>(i % 32));
+		}
+		v[12] = 31;
+		v[13] = v[12];
+		CHECK(v[11] == 11u);
+		CHECK(v[12] == 31u);
+		CHECK(v[13] == 31u);
+		CHECK(v[14] == 14u);
+		*(v.begin() + 50) = 0;
+		CHECK(ranges::count(v, 0u) == 5);
+		while (v.size() > 13) {
+			v.pop_back();
+		}
+		CHECK(v.word_count() == 2);
+		CHECK(v.back() == 31u);
+	}
+	{
+		// Widths that straddle word boundaries, up to the full width.
+		std::mt19937_64 gen{1};
+		for (auto w = 1; w <= 64; ++w) {
+			ranges::packed_int_vector<std::uint64_t> v{w};
+			std::vector<std::uint64_t> model;
+			auto const mask = w == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << w) - 1;
+			for (auto i = 0; i < 300; ++i) {
+				model.push_back(gen() & mask);
+				v.push_back(model.back());
+			}
+			CHECK(ranges::equal(v, model));
+			for (auto i = 0; i < 300; i += 7) {
+				v[i] = mask - model[i];
+				model[i] = mask - model[i];
+			}
+			CHECK(ranges::equal(v, model));
+			std::vector<std::uint64_t> out(300);
+			v.decode(out.data());
+			CHECK(out == model);
+			v.decode(37, 200, out.data());
+			CHECK(ranges::equal(out.begin(), out.begin() + 200, model.begin() + 37, model.begin() + 237));
+		}
+	}
+	{
+		// Range construction picks the narrowest width.
+		ranges::vector<std::uint32_t> src{ranges::reserve_t{}, 1000};
+		for (auto i = 0u; i < 1000; ++i) {
+			src.push_back(i % 700);
+		}
+		PIV v{src};
+		CHECK(v.width() == 10);
+		CHECK(v.size() == 1000);
+		CHECK(ranges::equal(v, src));
+		CHECK(v.memory_bytes() < 1000 * 4 / 3 + 8);
+	}
+	{
+		// Sorted data under frame_of_reference stores small offsets.
+		std::vector<std::uint32_t> sorted;
+		std::mt19937 gen{2};
+		auto x = 1000000u;
+		for (auto i = 0; i < 10000; ++i) {
+			x += gen() % 16;
+			sorted.push_back(x);
+		}
+		PIV plain{sorted};
+		PIV packed{sorted, ranges::packed_encoding::frame_of_reference};
+		CHECK(plain.width() == 21);
+		CHECK(packed.width() <= 11);
+		CHECK(ranges::equal(packed, sorted));
+		std::vector<std::uint32_t> out(10000);
+		packed.decode(out.data());
+		CHECK(out == sorted);
+		packed.decode(100, 5000, out.data());
+		CHECK(ranges::equal(out.begin(), out.begin() + 5000, sorted.begin() + 100, sorted.begin() + 5100));
+
+		// Appending sorted data keeps working across blocks.
+		PIV grown{12, ranges::packed_encoding::frame_of_reference};
+		for (auto v : sorted) {
+			grown.push_back(v);
+		}
+		CHECK(ranges::equal(grown, sorted));
+		grown[5] = sorted[5] + 3;
+		CHECK(grown[5] == sorted[5] + 3);
+		while (grown.size() > 129) {
+			grown.pop_back();
+		}
+		grown.pop_back();
+		grown.push_back(7);
+		CHECK(grown.back() == 7u);
+		CHECK(grown[127] == sorted[127]);
+	}
+	{
+		PIV v{std::vector<std::uint32_t>{}};
+		CHECK(v.empty());
+		CHECK(v.width() == 1);
+	}
+
+	return ::test_result();
+}
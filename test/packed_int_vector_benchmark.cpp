@@ -0,0 +1,122 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Memory use, sequential scan, and random lookup speed of
+// packed_int_vector against a plain vector of the same values, for
+// small values and for sorted values.
+//
+// usage: packed_int_vector_benchmark [elements]
+//
+#include <stl2/packed_int_vector.hpp>
+#include <stl2/vector.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	using value_t = std::uint32_t;
+	constexpr std::ptrdiff_t block = 1024;
+	constexpr std::ptrdiff_t lookups = 1 << 22;
+
+	volatile std::uint64_t sink;
+
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		auto const start = std::chrono::steady_clock::now();
+		sink = f();
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		std::cout << "  " << name << ": " << elapsed.count() / n << " ns/element\n";
+	}
+
+	void run(const char* name, const ranges::vector<value_t>& plain,
+		ranges::packed_encoding encoding)
+	{
+		ranges::packed_int_vector<value_t> packed{plain, encoding};
+		auto const& cpacked = packed;
+		auto const n = plain.size();
+		std::cout << name << ": " << n << " elements, width " << packed.width() << '\n'
+			<< "  memory: vector " << plain.capacity() * sizeof(value_t)
+			<< " bytes, packed " << packed.memory_bytes() << " bytes\n";
+
+		measure("vector scan", n, [&] {
+			std::uint64_t sum = 0;
+			for (auto v : plain) {
+				sum += v;
+			}
+			return sum;
+		});
+		measure("packed scan (iterator)", n, [&] {
+			std::uint64_t sum = 0;
+			for (value_t v : cpacked) {
+				sum += v;
+			}
+			return sum;
+		});
+		measure("packed scan (decode)", n, [&] {
+			std::uint64_t sum = 0;
+			value_t buf[block];
+			for (auto i = std::ptrdiff_t{0}; i < n; i += block) {
+				auto const m = n - i < block ? n - i : block;
+				packed.decode(i, m, buf);
+				for (auto j = std::ptrdiff_t{0}; j < m; ++j) {
+					sum += buf[j];
+				}
+			}
+			return sum;
+		});
+
+		ranges::vector<std::ptrdiff_t> idx{ranges::reserve_t{}, lookups};
+		std::mt19937_64 gen{42};
+		for (auto i = std::ptrdiff_t{0}; i < lookups; ++i) {
+			idx.push_back(static_cast<std::ptrdiff_t>(gen() % n));
+		}
+		measure("vector lookup", lookups, [&] {
+			std::uint64_t sum = 0;
+			for (auto i : idx) {
+				sum += plain.begin()[i];
+			}
+			return sum;
+		});
+		measure("packed lookup", lookups, [&] {
+			std::uint64_t sum = 0;
+			for (auto i : idx) {
+				sum += cpacked[i];
+			}
+			return sum;
+		});
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const n = argc > 1 ? std::atol(argv[1]) : 1L << 24;
+	std::mt19937 gen{7};
+	{
+		ranges::vector<value_t> small{ranges::reserve_t{}, n};
+		for (auto i = 0L; i < n; ++i) {
+			small.push_back(gen() % 1000);
+		}
+		run("small values", small, ranges::packed_encoding::plain);
+	}
+	{
+		ranges::vector<value_t> sorted{ranges::reserve_t{}, n};
+		value_t x = 0;
+		for (auto i = 0L; i < n; ++i) {
+			x += gen() % 64;
+			sorted.push_back(x);
+		}
+		run("sorted values", sorted, ranges::packed_encoding::frame_of_reference);
+	}
+}
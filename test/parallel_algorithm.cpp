@@ -0,0 +1,201 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/parallel_algorithm.hpp>
+#include <stl2/vector.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+// Spans several blocks of ints, and does not end on a block boundary.
+constexpr std::ptrdiff_t n = (1 << 18) + 123;
+
+std::vector<int> random_ints(std::ptrdiff_t count, int limit) {
+	std::mt19937 gen{static_cast<unsigned>(count)};
+	std::vector<int> v(count);
+	for (auto& i : v) {
+		i = static_cast<int>(gen() % limit);
+	}
+	return v;
+}
+
+template <class EP>
+void test_policy(EP&& policy) {
+	auto const src = random_ints(n, 1000000);
+	{
+		ranges::vector<int> v{ranges::reserve_t{}, n};
+		for (auto i : src) {
+			v.push_back(i);
+		}
+		auto const end = ranges::sort(policy, v);
+		CHECK(end == v.end());
+		auto expected = src;
+		std::sort(expected.begin(), expected.end());
+		CHECK(ranges::equal(v, expected));
+
+		ranges::sort(policy, v.begin() + 1, v.end() - 1, std::greater<>{});
+		std::sort(expected.begin() + 1, expected.end() - 1, std::greater<>{});
+		CHECK(ranges::equal(v, expected));
+	}
+	{
+		// stable_sort keeps equal keys in order, also across runs.
+		std::vector<std::pair<int, int>> v(n);
+		for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+			v[i] = {src[i] % 100, static_cast<int>(i)};
+		}
+		ranges::stable_sort(policy, v, ranges::less<>{}, &std::pair<int, int>::first);
+		auto ok = true;
+		for (auto i = std::ptrdiff_t{1}; i < n; ++i) {
+			ok = ok && (v[i - 1].first < v[i].first ||
+				(v[i - 1].first == v[i].first && v[i - 1].second < v[i].second));
+		}
+		CHECK(ok);
+	}
+	{
+		ranges::vector<int> v{ranges::reserve_t{}, n};
+		for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+			v.push_back(0);
+		}
+		// Starting off a cache line boundary.
+		ranges::fill(policy, v.begin() + 3, v.end(), 7);
+		CHECK(v.begin()[2] == 0);
+		CHECK(std::count(v.begin(), v.end(), 7) == n - 3);
+
+		auto r = ranges::copy(policy, src, v.begin());
+		CHECK(r.in() == src.end());
+		CHECK(r.out() == v.end());
+		CHECK(ranges::equal(v, src));
+
+		auto t = ranges::transform(policy, v, v.begin(), [](int i) { return i * 2; });
+		CHECK(t.out() == v.end());
+		auto ok = true;
+		for (auto i = std::ptrdiff_t{0}; i < n; ++i) {
+			ok = ok && v.begin()[i] == src[i] * 2;
+		}
+		CHECK(ok);
+
+		std::vector<long> halves(n);
+		ranges::transform(policy, v.begin(), v.end(), halves.begin(),
+			[](long i) { return i / 2; });
+		CHECK(ranges::equal(halves, src));
+	}
+	{
+		// find returns the first match, wherever the blocks run.
+		std::vector<int> v(n, 0);
+		v[n - 5] = 3;
+		v[n / 2] = 3;
+		v[n / 3 * 2] = 3;
+		CHECK(ranges::find(policy, v, 3) == v.begin() + n / 2);
+		CHECK(ranges::find(policy, v, 4) == v.end());
+		CHECK(ranges::find_if(policy, v.begin(), v.end(), [](int i) { return i != 0; }) ==
+			v.begin() + n / 2);
+		CHECK(ranges::find(policy, v.begin(), v.begin(), 3) == v.begin());
+	}
+	{
+		auto const sum = std::accumulate(src.begin(), src.end(), std::int64_t{0});
+		CHECK(ranges::reduce(policy, src, std::int64_t{0}) == sum);
+		CHECK(ranges::reduce(policy, src.begin(), src.begin(), 5) == 5);
+		auto const squares = ranges::transform_reduce(policy, src, std::int64_t{0},
+			std::plus<>{}, [](int i) { return std::int64_t{i} * i; });
+		auto expected = std::int64_t{0};
+		for (auto i : src) {
+			expected += std::int64_t{i} * i;
+		}
+		CHECK(squares == expected);
+	}
+	{
+		std::vector<std::int64_t> in(src.begin(), src.end());
+		std::vector<std::int64_t> expected(n);
+		std::partial_sum(in.begin(), in.end(), expected.begin());
+		std::vector<std::int64_t> out(n);
+		auto r = ranges::inclusive_scan(policy, in, out.begin());
+		CHECK(r.out() == out.end());
+		CHECK(out == expected);
+
+		ranges::exclusive_scan(policy, in, out.begin(), std::int64_t{10});
+		CHECK(out[0] == 10);
+		auto ok = true;
+		for (auto i = std::ptrdiff_t{1}; i < n; ++i) {
+			ok = ok && out[i] == expected[i - 1] + 10;
+		}
+		CHECK(ok);
+
+		// In place
+		ranges::inclusive_scan(policy, in, in.begin());
+		CHECK(in == expected);
+	}
+}
+
+void test_pool(unsigned threads) {
+	// Every index is visited once, however uneven the blocks' work.
+	ranges::__execution::thread_pool pool{threads};
+	CHECK(pool.size() == threads);
+	constexpr std::ptrdiff_t m = 10000;
+	std::vector<std::atomic<int>> seen(m);
+	ranges::__execution::for_each_block(pool, {m, 7, 3},
+		[&](std::ptrdiff_t lo, std::ptrdiff_t hi) {
+			volatile int spin = 0;
+			for (auto i = 0; i < (lo < m / 4 ? 10000 : 0); ++i) {
+				spin = spin + 1;
+			}
+			for (auto i = lo; i < hi; ++i) {
+				++seen[i];
+			}
+		});
+	CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int>& i) { return i == 1; }));
+
+	auto count = 0;
+	try {
+		ranges::__execution::for_each_block(pool, {m, 100},
+			[&](std::ptrdiff_t lo, std::ptrdiff_t) {
+				if (lo == 500) {
+					throw 42;
+				}
+			});
+	} catch (int i) {
+		count = i;
+	}
+	CHECK(count == 42);
+}
+
+int main() {
+	test_policy(ranges::execution::seq);
+	test_policy(ranges::execution::par);
+	test_policy(ranges::execution::par_unseq);
+
+	{
+		using ranges::__execution::block_partition;
+		block_partition p{100, 16, 5};
+		CHECK(p.count() == 7);
+		CHECK(p.bound(0) == 0);
+		CHECK(p.bound(1) == 5);
+		CHECK(p.bound(2) == 21);
+		CHECK(p.bound(7) == 100);
+		CHECK(p.index(5) == 1);
+		CHECK(p.index(85) == 6);
+		CHECK(block_partition{0, 16}.count() == 0);
+		CHECK(block_partition{3, 16, 5}.count() == 1);
+	}
+	// Serial, small, odd-sized and oversubscribed pools.
+	for (auto threads : {1u, 2u, 4u, 7u, 64u}) {
+		test_pool(threads);
+	}
+
+	return ::test_result();
+}
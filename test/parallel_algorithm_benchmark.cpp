@@ -0,0 +1,83 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// The policy overloads of <stl2/parallel_algorithm.hpp> over a vector
+// of random 64-bit integers, under seq and under par.
+//
+// usage: parallel_algorithm_benchmark [elements]
+//
+#include <stl2/parallel_algorithm.hpp>
+#include <stl2/vector.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	using value_t = std::uint64_t;
+
+	volatile std::uint64_t sink;
+
+	template <class F>
+	double measure(F f) {
+		auto const start = std::chrono::steady_clock::now();
+		f();
+		std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::steady_clock::now() - start;
+		return elapsed.count();
+	}
+
+	void fill_random(ranges::vector<value_t>& v) {
+		std::mt19937_64 gen{42};
+		for (auto i = v.begin(); i != v.end(); ++i) {
+			*i = gen();
+		}
+	}
+
+	template <class EP>
+	void run(const char* name, EP&& policy, ranges::vector<value_t>& v,
+		ranges::vector<value_t>& out)
+	{
+		std::cout << name << ":\n";
+		fill_random(v);
+		std::cout << "  sort: " << measure([&] { ranges::sort(policy, v); }) << " ms\n";
+		fill_random(v);
+		std::cout << "  stable_sort: " << measure([&] { ranges::stable_sort(policy, v); }) << " ms\n";
+		std::cout << "  fill: " << measure([&] { ranges::fill(policy, out, value_t{1}); }) << " ms\n";
+		std::cout << "  copy: " << measure([&] { ranges::copy(policy, v, out.begin()); }) << " ms\n";
+		std::cout << "  transform: " << measure([&] {
+			ranges::transform(policy, v, out.begin(), [](value_t x) { return x >> 3; });
+		}) << " ms\n";
+		std::cout << "  reduce: " << measure([&] {
+			sink = ranges::reduce(policy, out, value_t{0});
+		}) << " ms\n";
+		std::cout << "  find (absent): " << measure([&] {
+			sink = ranges::find(policy, out, ~value_t{0}) - out.begin();
+		}) << " ms\n";
+		std::cout << "  inclusive_scan: " << measure([&] {
+			ranges::inclusive_scan(policy, out, out.begin());
+		}) << " ms\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const n = argc > 1 ? std::atol(argv[1]) : 1L << 26;
+	std::cout << n << " elements, " << std::thread::hardware_concurrency() << " threads\n";
+	// Constructing under par places each block's pages with its thread.
+	ranges::vector<value_t> v{ranges::execution::par, n};
+	ranges::vector<value_t> out{ranges::execution::par, n};
+	run("seq", ranges::execution::seq, v, out);
+	run("par", ranges::execution::par, v, out);
+}
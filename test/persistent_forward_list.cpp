@@ -0,0 +1,126 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/persistent_forward_list.hpp>
+#include <stl2/algorithm.hpp>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+using PFL = ranges::persistent_forward_list<int>;
+static_assert(ranges::models::ForwardIterator<PFL::iterator>);
+static_assert(ranges::models::ForwardRange<const PFL>);
+static_assert(ranges::models::Same<ranges::reference_t<PFL::iterator>, const int&>);
+
+int main() {
+	{
+		PFL l;
+		CHECK(l.empty());
+		CHECK(l.begin() == l.end());
+		l.push_front(1);
+		CHECK(!l.empty());
+		CHECK(l.front() == 1);
+		l.pop_front();
+		CHECK(l.empty());
+	}
+	{
+		PFL l = {1, 2, 3};
+		CHECK(ranges::equal(l, std::vector<int>{1, 2, 3}));
+		auto const v = std::vector<int>{4, 5};
+		PFL m{v.begin(), v.end()};
+		CHECK(ranges::equal(m, v));
+	}
+	{
+		// Versions share their tails.
+		PFL base = {3, 4, 5};
+		auto a = base;
+		a.push_front(2);
+		auto b = base;
+		b.push_front(-2);
+		b.push_front(-1);
+		CHECK(ranges::equal(base, std::vector<int>{3, 4, 5}));
+		CHECK(ranges::equal(a, std::vector<int>{2, 3, 4, 5}));
+		CHECK(ranges::equal(b, std::vector<int>{-1, -2, 3, 4, 5}));
+		CHECK(&*ranges::next(a.begin()) == &base.front());
+		CHECK(&*ranges::next(b.begin(), 2) == &base.front());
+
+		auto c = b;
+		c.pop_front();
+		c.pop_front();
+		CHECK(&c.front() == &base.front());
+		base.clear();
+		CHECK(ranges::equal(c, std::vector<int>{3, 4, 5}));
+		CHECK(ranges::equal(a, std::vector<int>{2, 3, 4, 5}));
+	}
+	{
+		// Elements are destroyed exactly when the last version lets go.
+		auto const p = std::make_shared<int>(0);
+		{
+			ranges::persistent_forward_list<std::shared_ptr<int>> l;
+			std::vector<ranges::persistent_forward_list<std::shared_ptr<int>>> history;
+			for (auto i = 0; i < 100; ++i) {
+				l.push_front(p);
+				history.push_back(l);
+			}
+			CHECK(p.use_count() == 101);
+			history.erase(history.begin() + 10, history.end());
+			l = history.back();
+			CHECK(p.use_count() == 11);
+			l.pop_front();
+			history.pop_back();
+			CHECK(p.use_count() == 10);
+			l = {};
+			CHECK(p.use_count() == 10);
+			history.clear();
+			CHECK(p.use_count() == 1);
+		}
+		CHECK(p.use_count() == 1);
+	}
+	{
+		// Dropping a long list does not recurse.
+		PFL l;
+		for (auto i = 0; i < 1000000; ++i) {
+			l.push_front(i);
+		}
+		auto const copy = l;
+		l.clear();
+		CHECK(copy.front() == 999999);
+	}
+	{
+		// Readers walk snapshots while the writer keeps pushing.
+		PFL l;
+		std::vector<std::thread> readers;
+		int counts[4] = {};
+		for (auto i = 0; i < 4; ++i) {
+			for (auto j = 0; j < 1000; ++j) {
+				l.push_front(j);
+			}
+			readers.emplace_back([snap = l, &n = counts[i]] {
+				for (auto&& x : snap) {
+					(void)x;
+					++n;
+				}
+			});
+		}
+		for (auto& t : readers) {
+			t.join();
+		}
+		for (auto i = 0; i < 4; ++i) {
+			CHECK(counts[i] == 1000 * (i + 1));
+		}
+		l.clear();
+	}
+
+	return ::test_result();
+}
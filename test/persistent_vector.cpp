@@ -0,0 +1,186 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/persistent_vector.hpp>
+#include <stl2/algorithm.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+using PV = ranges::persistent_vector<int>;
+static_assert(ranges::models::RandomAccessIterator<PV::iterator>);
+static_assert(ranges::models::RandomAccessRange<const PV>);
+static_assert(ranges::models::Same<ranges::reference_t<PV::iterator>, const int&>);
+
+template <class T>
+bool same_elements(const ranges::persistent_vector<T>& pv, const std::vector<T>& model) {
+	if (pv.size() != static_cast<std::ptrdiff_t>(model.size())) {
+		return false;
+	}
+	for (auto i = 0; i < pv.size(); ++i) {
+		if (pv[i] != model[i]) {
+			return false;
+		}
+	}
+	return ranges::equal(pv, model);
+}
+
+int main() {
+	{
+		PV v;
+		CHECK(v.empty());
+		CHECK(v.begin() == v.end());
+		v.push_back(42);
+		CHECK(v.size() == 1);
+		CHECK(v.front() == 42);
+		v.pop_back();
+		CHECK(v.empty());
+	}
+	{
+		PV v = {0, 1, 2, 3, 4};
+		CHECK(ranges::equal(v, std::vector<int>{0, 1, 2, 3, 4}));
+		auto it = v.begin();
+		it += 3;
+		CHECK(*it == 3);
+		CHECK(v.end() - it == 2);
+	}
+	{
+		// Reverse iteration from end(), at sizes that end partway through
+		// a leaf.
+		for (auto n : {1, 5, 31, 32, 33, 1000, 1057}) {
+			PV v;
+			for (auto i = 0; i < n; ++i) {
+				v.push_back(i);
+			}
+			auto ok = true;
+			auto expected = n;
+			for (auto it = v.end(); it != v.begin();) {
+				ok = ok && *--it == --expected;
+			}
+			CHECK(ok);
+			CHECK(expected == 0);
+			auto last = v.end();
+			--last;
+			CHECK(*last == n - 1);
+		}
+	}
+	{
+		// Push and pop across leaf and level boundaries.
+		PV v;
+		std::vector<int> model;
+		for (auto i = 0; i < 40000; ++i) {
+			v.push_back(i);
+			model.push_back(i);
+		}
+		CHECK(same_elements(v, model));
+		while (!v.empty()) {
+			v.pop_back();
+			model.pop_back();
+			auto const n = v.size();
+			if (n % 997 == 0 || n < 70 || (n > 1000 && n < 1100) || (n > 32700 && n < 32800)) {
+				CHECK(same_elements(v, model));
+			}
+		}
+	}
+	{
+		// Copies share every node; an update copies only its path.
+		PV v;
+		for (auto i = 0; i < 5000; ++i) {
+			v.push_back(i);
+		}
+		auto const snap = v;
+		CHECK(&snap[0] == &v[0]);
+		CHECK(&snap[4999] == &v[4999]);
+		v.set(1234, -1);
+		v.set(4999, -2);
+		CHECK(v[1234] == -1);
+		CHECK(snap[1234] == 1234);
+		CHECK(v[4999] == -2);
+		CHECK(snap[4999] == 4999);
+		CHECK(&snap[1234] != &v[1234]);
+		CHECK(&snap[0] == &v[0]);
+		CHECK(&snap[1233 - 1233 % 32 - 1] == &v[1233 - 1233 % 32 - 1]);
+
+		// Once the path is owned, further updates happen in place.
+		auto const p = &v[1235];
+		v.set(1235, -3);
+		CHECK(&v[1235] == p);
+		CHECK(snap[1235] == 1235);
+
+		v.push_back(5000);
+		v.pop_back();
+		v.pop_back();
+		CHECK(v.size() == 4999);
+		CHECK(snap.size() == 5000);
+		CHECK(snap.back() == 4999);
+	}
+	{
+		// Random operations against snapshots of a model.
+		std::mt19937 gen{42};
+		PV v;
+		std::vector<int> model;
+		std::vector<std::pair<PV, std::vector<int>>> snaps;
+		for (auto step = 0; step < 20000; ++step) {
+			auto const op = gen() % 10;
+			if (op < 5 || model.empty()) {
+				auto const x = static_cast<int>(gen());
+				v.push_back(x);
+				model.push_back(x);
+			} else if (op < 8) {
+				auto const i = static_cast<std::ptrdiff_t>(gen() % model.size());
+				auto const x = static_cast<int>(gen());
+				v.set(i, x);
+				model[i] = x;
+			} else if (op < 9) {
+				v.pop_back();
+				model.pop_back();
+			} else if (step % 7 == 0) {
+				snaps.emplace_back(v, model);
+			}
+		}
+		CHECK(same_elements(v, model));
+		for (auto& s : snaps) {
+			CHECK(same_elements(s.first, s.second));
+		}
+		PV w;
+		w = snaps.front().first;
+		auto const expected = snaps.front().second;
+		snaps.clear();
+		CHECK(same_elements(w, expected));
+	}
+	{
+		// Elements are destroyed exactly when the last version lets go.
+		auto const p = std::make_shared<int>(7);
+		{
+			ranges::persistent_vector<std::shared_ptr<int>> v;
+			for (auto i = 0; i < 100; ++i) {
+				v.push_back(p);
+			}
+			CHECK(p.use_count() == 101);
+			auto w = v;
+			CHECK(p.use_count() == 101);
+			w.set(0, nullptr);
+			CHECK(p.use_count() == 132);
+			v = std::move(w);
+			CHECK(p.use_count() == 100);
+			v.clear();
+			CHECK(p.use_count() == 1);
+			v.push_back(p);
+			w = v;
+		}
+		CHECK(p.use_count() == 1);
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,263 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/ring_buffer.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+template <class Q>
+void test_single_threaded() {
+	Q q{5};
+	CHECK(q.capacity() == 8);
+	CHECK(q.empty());
+	for (auto i = 0; i < 8; ++i) {
+		CHECK(q.try_push(i));
+	}
+	CHECK(!q.try_push(8));
+	CHECK(q.size() == 8);
+
+	int x = -1;
+	CHECK(q.try_pop(x));
+	CHECK(x == 0);
+
+	// Wraps around the end of the buffer.
+	int out[16] = {};
+	int in[] = {8, 9, 10, 11};
+	CHECK(q.push_n(in, 4) == 1);
+	CHECK(q.pop_n(out, 16) == 8);
+	for (auto i = 0; i < 8; ++i) {
+		CHECK(out[i] == i + 1);
+	}
+	CHECK(q.empty());
+	CHECK(!q.try_pop(x));
+	CHECK(q.pop_n(out, 0) == 0);
+	CHECK(q.push_n(in, 4) == 4);
+	CHECK(q.pop_n(out, 2) == 2);
+	CHECK(out[0] == 8 && out[1] == 9);
+
+	// Zero-length transfers are no-ops whether or not there is room.
+	CHECK(q.push_n(in, 0) == 0);
+	CHECK(q.pop_n(out, 0) == 0);
+	CHECK(q.size() == 2);
+}
+
+// Throws when constructed from a negative value.
+struct picky {
+	static int count;
+	int value;
+	picky(int v) : value{v} {
+		if (v < 0) {
+			throw std::runtime_error{"picky"};
+		}
+		++count;
+	}
+	picky(const picky& that) : picky{that.value} {}
+	picky(picky&& that) noexcept : value{that.value} { ++count; }
+	picky& operator=(const picky&) = default;
+	~picky() { --count; }
+};
+int picky::count = 0;
+
+void test_spsc_exceptions() {
+	{
+		ranges::ring_buffer<picky> q{8};
+		picky sink{0};
+		for (auto i = 0; i < 6; ++i) {
+			CHECK(q.try_emplace(i));
+			CHECK(q.try_pop(sink));
+		}
+		// The throw comes in the run that wraps to the front of the buffer.
+		int in[] = {1, 2, 3, -1};
+		auto threw = false;
+		try {
+			q.push_n(in, 4);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(q.empty());
+		CHECK(picky::count == 1);
+		CHECK(q.push_n(in, 3) == 3);
+		CHECK(q.try_pop(sink) && sink.value == 1);
+	}
+	CHECK(picky::count == 0);
+}
+
+void test_mpmc_exceptions() {
+	{
+		ranges::mpmc_ring_buffer<picky> q{4};
+		auto threw = false;
+		try {
+			q.try_emplace(-1);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		// The failed push claims no cell, so the queue is not wedged.
+		CHECK(q.empty());
+		picky sink{0};
+		CHECK(q.try_emplace(1));
+		CHECK(q.try_pop(sink) && sink.value == 1);
+
+		int in[] = {2, 3, -1, 4};
+		threw = false;
+		try {
+			q.push_n(in, 4);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(q.size() == 2);
+		CHECK(q.try_pop(sink) && sink.value == 2);
+		CHECK(q.try_pop(sink) && sink.value == 3);
+		CHECK(!q.try_pop(sink));
+		CHECK(q.push_n(in, 2) == 2);
+		// A full queue stops a push_n of throwing types as it does others.
+		CHECK(q.push_n(in, 2) == 2);
+		CHECK(q.push_n(in, 2) == 0);
+		CHECK(picky::count == 5);
+	}
+	CHECK(picky::count == 0);
+}
+
+void test_spsc_threads() {
+	constexpr int n = 1 << 18;
+	ranges::ring_buffer<int> q{1024};
+	std::thread producer{[&] {
+		int buf[64];
+		for (auto i = 0; i < n;) {
+			auto k = 0;
+			for (; k < 64 && i + k < n; ++k) {
+				buf[k] = i + k;
+			}
+			auto first = buf;
+			while (k > 0) {
+				auto pushed = q.push_n(first, k);
+				if (pushed == 0) {
+					std::this_thread::yield();
+				}
+				first += pushed;
+				k -= static_cast<int>(pushed);
+				i += static_cast<int>(pushed);
+			}
+		}
+	}};
+	auto ok = true;
+	int buf[64];
+	for (auto expected = 0; expected < n;) {
+		auto popped = q.pop_n(buf, 64);
+		if (popped == 0) {
+			std::this_thread::yield();
+		}
+		for (auto i = 0; i < popped; ++i) {
+			ok = ok && buf[i] == expected++;
+		}
+	}
+	producer.join();
+	CHECK(ok);
+	CHECK(q.empty());
+}
+
+void test_mpmc_threads() {
+	constexpr int producers = 4;
+	constexpr int consumers = 4;
+	constexpr long per_producer = 1 << 15;
+	ranges::mpmc_ring_buffer<long> q{256};
+	std::atomic<long> sum{0};
+	std::atomic<long> count{0};
+	std::vector<std::thread> threads;
+	for (auto p = 0; p < producers; ++p) {
+		threads.emplace_back([&q, p] {
+			for (long i = 0; i < per_producer;) {
+				long buf[8];
+				auto k = 0;
+				for (; k < 8 && i + k < per_producer; ++k) {
+					buf[k] = p * per_producer + i + k;
+				}
+				auto pushed = k > 1 ? q.push_n(buf, k) : q.try_push(buf[0]);
+				if (pushed == 0) {
+					std::this_thread::yield();
+				}
+				i += pushed;
+			}
+		});
+	}
+	for (auto c = 0; c < consumers; ++c) {
+		threads.emplace_back([&] {
+			constexpr long total = producers * per_producer;
+			long local_sum = 0;
+			long buf[8];
+			while (count.load(std::memory_order_relaxed) < total) {
+				auto popped = q.pop_n(buf, 8);
+				if (popped == 0) {
+					std::this_thread::yield();
+				}
+				for (auto i = 0; i < popped; ++i) {
+					local_sum += buf[i];
+				}
+				count += popped;
+			}
+			sum += local_sum;
+		});
+	}
+	for (auto& t : threads) {
+		t.join();
+	}
+	constexpr long total = producers * per_producer;
+	CHECK(count == total);
+	CHECK(sum == total * (total - 1) / 2);
+	CHECK(q.empty());
+}
+
+int main() {
+	test_single_threaded<ranges::ring_buffer<int>>();
+	test_single_threaded<ranges::mpmc_ring_buffer<int>>();
+
+	{
+		// Elements left in the queue are destroyed with it.
+		auto p = std::make_shared<int>(42);
+		{
+			ranges::ring_buffer<std::shared_ptr<int>> q{4};
+			q.try_push(p);
+			q.try_push(p);
+			CHECK(p.use_count() == 3);
+		}
+		{
+			ranges::mpmc_ring_buffer<std::shared_ptr<int>> q{4};
+			q.try_push(p);
+			CHECK(p.use_count() == 2);
+		}
+		CHECK(p.use_count() == 1);
+	}
+
+	{
+		// Both queues report the allocator they were given.
+		ranges::ring_buffer<int, std::allocator<void>> q{4};
+		ranges::mpmc_ring_buffer<int, std::allocator<void>> m{4};
+		static_assert(std::is_same<decltype(q.get_allocator()), std::allocator<void>>::value);
+		static_assert(std::is_same<decltype(m.get_allocator()), std::allocator<void>>::value);
+		CHECK(q.try_push(1) && m.try_push(1));
+	}
+
+	test_spsc_exceptions();
+	test_mpmc_exceptions();
+	test_spsc_threads();
+	test_mpmc_threads();
+
+	return ::test_result();
+}
@@ -0,0 +1,218 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Throughput and round-trip latency of ring_buffer and mpmc_ring_buffer
+// against a mutex-protected std::deque, with each thread pinned to a core.
+//
+// usage: ring_buffer_benchmark [producer-cpu [consumer-cpu]]
+//
+#include <stl2/ring_buffer.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	constexpr long items = 1L << 24;
+	constexpr long round_trips = 1L << 18;
+	constexpr long batch = 64;
+
+	int cpus[2] = {0, 1};
+
+	void pin(int which) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpus[which] % std::thread::hardware_concurrency(), &set);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+			std::cerr << "warning: could not pin thread to cpu " << cpus[which] << '\n';
+		}
+	}
+
+	// Busy-waits, yielding occasionally so that the benchmark still makes
+	// progress when both threads share a core.
+	struct backoff {
+		int spins = 0;
+
+		void operator()() {
+			if (++spins % 1024 == 0) {
+				std::this_thread::yield();
+			}
+		}
+	};
+
+	template <class F>
+	void spin_until(F f) {
+		for (backoff wait; !f();) {
+			wait();
+		}
+	}
+
+	template <class Produce, class Consume>
+	void throughput(const char* name, Produce produce, Consume consume) {
+		auto start = std::chrono::steady_clock::now();
+		std::thread producer{[&] { pin(0); produce(); }};
+		pin(1);
+		consume();
+		producer.join();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << name << ": " << items / elapsed.count() / 1e6 << " Mitems/s\n";
+	}
+
+	struct locked_deque {
+		std::mutex mtx_;
+		std::deque<long> q_;
+
+		locked_deque() = default;
+		explicit locked_deque(long) {}
+
+		bool try_push(long x) {
+			std::lock_guard<std::mutex> lock{mtx_};
+			q_.push_back(x);
+			return true;
+		}
+		bool try_pop(long& x) {
+			std::lock_guard<std::mutex> lock{mtx_};
+			if (q_.empty()) {
+				return false;
+			}
+			x = q_.front();
+			q_.pop_front();
+			return true;
+		}
+	};
+
+	template <class Q>
+	void one_at_a_time(const char* name, Q& q) {
+		long sum = 0;
+		throughput(name,
+			[&] {
+				for (long i = 0; i < items; ++i) {
+					spin_until([&] { return q.try_push(i); });
+				}
+			},
+			[&] {
+				long x;
+				for (long i = 0; i < items; ++i) {
+					spin_until([&] { return q.try_pop(x); });
+					sum += x;
+				}
+			});
+		if (sum != items * (items - 1) / 2) {
+			std::cerr << name << ": wrong sum\n";
+			std::exit(1);
+		}
+	}
+
+	template <class Q>
+	void batched(const char* name, Q& q) {
+		long sum = 0;
+		throughput(name,
+			[&] {
+				long buf[batch];
+				backoff wait;
+				for (long i = 0; i < items;) {
+					long n = 0;
+					for (; n < batch && i + n < items; ++n) {
+						buf[n] = i + n;
+					}
+					for (auto first = buf; n > 0;) {
+						auto pushed = q.push_n(first, n);
+						if (pushed == 0) {
+							wait();
+						}
+						first += pushed;
+						n -= pushed;
+						i += pushed;
+					}
+				}
+			},
+			[&] {
+				long buf[batch];
+				backoff wait;
+				for (long i = 0; i < items;) {
+					auto popped = q.pop_n(buf, batch);
+					if (popped == 0) {
+						wait();
+					}
+					for (long k = 0; k < popped; ++k) {
+						sum += buf[k];
+					}
+					i += popped;
+				}
+			});
+		if (sum != items * (items - 1) / 2) {
+			std::cerr << name << ": wrong sum\n";
+			std::exit(1);
+		}
+	}
+
+	template <class Q>
+	void latency(const char* name) {
+		Q ping{64};
+		Q pong{64};
+		std::thread echo{[&] {
+			pin(0);
+			long x;
+			for (long i = 0; i < round_trips; ++i) {
+				spin_until([&] { return ping.try_pop(x); });
+				spin_until([&] { return pong.try_push(x); });
+			}
+		}};
+		pin(1);
+		auto start = std::chrono::steady_clock::now();
+		long x;
+		for (long i = 0; i < round_trips; ++i) {
+			spin_until([&] { return ping.try_push(i); });
+			spin_until([&] { return pong.try_pop(x); });
+		}
+		std::chrono::duration<double, std::nano> elapsed =
+			std::chrono::steady_clock::now() - start;
+		echo.join();
+		std::cout << name << ": " << elapsed.count() / round_trips << " ns/round trip\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	for (int i = 1; i < argc && i <= 2; ++i) {
+		cpus[i - 1] = std::atoi(argv[i]);
+	}
+
+	{
+		locked_deque q;
+		one_at_a_time("mutex + std::deque", q);
+	}
+	{
+		ranges::ring_buffer<long> q{4096};
+		one_at_a_time("ring_buffer (spsc)", q);
+	}
+	{
+		ranges::ring_buffer<long> q{4096};
+		batched("ring_buffer (spsc) push_n/pop_n", q);
+	}
+	{
+		ranges::mpmc_ring_buffer<long> q{4096};
+		one_at_a_time("mpmc_ring_buffer", q);
+	}
+	{
+		ranges::mpmc_ring_buffer<long> q{4096};
+		batched("mpmc_ring_buffer push_n/pop_n", q);
+	}
+
+	latency<locked_deque>("mutex + std::deque");
+	latency<ranges::ring_buffer<long>>("ring_buffer (spsc)");
+	latency<ranges::mpmc_ring_buffer<long>>("mpmc_ring_buffer");
+}
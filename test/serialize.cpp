@@ -0,0 +1,188 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/serialize.hpp>
+#include <stl2/algorithm.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+struct memory_sink {
+	std::vector<unsigned char> bytes;
+
+	void write(const ranges::const_buffer* bufs, std::size_t n) {
+		for (auto i = 0u; i < n; ++i) {
+			auto p = static_cast<const unsigned char*>(bufs[i].data);
+			bytes.insert(bytes.end(), p, p + bufs[i].size);
+		}
+	}
+};
+
+struct memory_source {
+	const unsigned char* first;
+	const unsigned char* last;
+	int reads = 0;
+
+	explicit memory_source(const std::vector<unsigned char>& bytes)
+	: first{bytes.data()}, last{bytes.data() + bytes.size()} {}
+
+	std::size_t read(const ranges::mutable_buffer* bufs, std::size_t n) {
+		++reads;
+		std::size_t total = 0;
+		for (auto i = 0u; i < n; ++i) {
+			auto k = std::min(bufs[i].size, static_cast<std::size_t>(last - first));
+			std::memcpy(bufs[i].data, first, k);
+			first += k;
+			total += k;
+		}
+		return total;
+	}
+};
+
+static_assert(ranges::models::ByteSink<memory_sink>);
+static_assert(ranges::models::ByteSource<memory_source>);
+static_assert(ranges::models::ByteSink<ranges::fd_stream>);
+static_assert(ranges::models::ByteSource<ranges::fd_stream>);
+
+template <class T>
+void reverse_bytes(unsigned char* p) {
+	std::reverse(p, p + sizeof(T));
+}
+
+struct pair { int a; short b; };
+
+int main() {
+	{
+		ranges::vector<std::uint32_t> vec;
+		for (auto i = 0u; i < 1000; ++i) {
+			vec.push_back(i * 2654435761u);
+		}
+		memory_sink sink;
+		ranges::serialize(sink, vec);
+		CHECK(sink.bytes.size() == 24 + 4000);
+
+		memory_source source{sink.bytes};
+		ranges::vector<std::uint32_t> out;
+		out.push_back(42);
+		ranges::deserialize(source, out);
+		CHECK(ranges::equal(vec, out));
+		// One read for the header, one for the elements.
+		CHECK(source.reads == 2);
+
+		// The same bytes written on a machine of the other byte order.
+		auto foreign = sink.bytes;
+		reverse_bytes<std::uint16_t>(&foreign[4]);
+		reverse_bytes<std::uint16_t>(&foreign[6]);
+		reverse_bytes<std::uint32_t>(&foreign[12]);
+		reverse_bytes<std::uint64_t>(&foreign[16]);
+		for (auto i = 0u; i < 1000; ++i) {
+			reverse_bytes<std::uint32_t>(&foreign[24 + 4 * i]);
+		}
+		memory_source foreign_source{foreign};
+		ranges::vector<std::uint32_t> swapped;
+		ranges::deserialize(foreign_source, swapped);
+		CHECK(ranges::equal(vec, swapped));
+
+		// Corrupt input is rejected.
+		auto bad = sink.bytes;
+		bad[0] = 'X';
+		memory_source bad_source{bad};
+		try {
+			ranges::deserialize(bad_source, out);
+			CHECK(false);
+		} catch (ranges::serialization_error&) {}
+
+		auto truncated = sink.bytes;
+		truncated.resize(100);
+		memory_source truncated_source{truncated};
+		try {
+			ranges::deserialize(truncated_source, out);
+			CHECK(false);
+		} catch (ranges::serialization_error&) {}
+		CHECK(ranges::equal(vec, out));
+
+		// Structures cannot change byte order.
+		ranges::vector<pair> pairs;
+		pairs.push_back(pair{1, 2});
+		memory_sink pair_sink;
+		ranges::serialize(pair_sink, pairs);
+		ranges::vector<pair> pairs_out;
+		memory_source pair_source{pair_sink.bytes};
+		ranges::deserialize(pair_source, pairs_out);
+		CHECK(pairs_out.size() == 1 && pairs_out.front().b == 2);
+		reverse_bytes<std::uint16_t>(&pair_sink.bytes[6]);
+		memory_source swapped_pair_source{pair_sink.bytes};
+		try {
+			ranges::deserialize(swapped_pair_source, pairs_out);
+			CHECK(false);
+		} catch (ranges::serialization_error&) {}
+	}
+	{
+		ranges::forward_list<double> list;
+		for (auto i = 0; i < 100; ++i) {
+			list.push_front(i * 0.5);
+		}
+		memory_sink sink;
+		ranges::serialize(sink, list);
+		// Two chunks of 64 and 36 elements.
+		ranges::serialize_stream(sink, list, 64);
+		sink.bytes.push_back(0xff);
+
+		memory_source source{sink.bytes};
+		ranges::forward_list<double> out;
+		ranges::deserialize(source, out);
+		CHECK(ranges::equal(list, out));
+		ranges::deserialize(source, out);
+		CHECK(ranges::equal(list, out));
+		// The decoder never reads past the end of a stream.
+		CHECK(source.last - source.first == 1);
+
+		// Feeding the decoder one byte at a time.
+		ranges::stream_decoder<double> decoder;
+		std::vector<double> decoded;
+		std::size_t consumed = 0;
+		for (auto b : sink.bytes) {
+			consumed += decoder.feed(&b, 1, [&](double d) { decoded.push_back(d); });
+			if (decoder.done()) {
+				break;
+			}
+		}
+		CHECK(decoder.done());
+		CHECK(ranges::equal(list, decoded));
+		CHECK(consumed == 24 + 4 + 100 * sizeof(double) + 4);
+	}
+	{
+		// Round trip through a file descriptor.
+		auto file = std::tmpfile();
+		CHECK(file != nullptr);
+		ranges::fd_stream stream{::fileno(file)};
+		ranges::vector<int> vec;
+		for (auto i = 0; i < 100000; ++i) {
+			vec.push_back(i);
+		}
+		ranges::serialize(stream, vec);
+		ranges::serialize_stream(stream, vec);
+		::lseek(stream.fd(), 0, SEEK_SET);
+		ranges::vector<int> out;
+		ranges::deserialize(stream, out);
+		CHECK(ranges::equal(vec, out));
+		auto sum = 0L;
+		ranges::deserialize_stream<int>(stream, [&](int i) { sum += i; });
+		CHECK(sum == 100000L * 99999 / 2);
+		std::fclose(file);
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,189 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/simd_algorithm.hpp>
+#include <stl2/vector.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+namespace simd = ranges::__simd;
+
+constexpr simd::isa all_isas[] = {
+	simd::isa::scalar, simd::isa::sse42, simd::isa::avx2, simd::isa::avx512
+};
+
+// Checks every kernel at every instruction set this machine has against
+// the standard algorithms, over lengths that end mid-vector and starting
+// points off vector alignment.
+template <class T>
+void test_kernels() {
+	std::mt19937 gen{42};
+	std::vector<T> storage(300 + 8);
+	for (auto& t : storage) {
+		// A small alphabet, so that matches and ties are common.
+		t = static_cast<T>(gen() % 7);
+	}
+	auto other = storage;
+	auto ok = true;
+	for (auto i : all_isas) {
+		if (i > simd::level()) {
+			break;
+		}
+		for (auto offset = 0; offset < 8; ++offset) {
+			for (auto n = 0; n <= 300; n += (n < 70 ? 1 : 23)) {
+				const T* const first = storage.data() + offset;
+				const T* const last = first + n;
+				for (auto v = 0; v < 8; ++v) {
+					auto const value = static_cast<T>(v);
+					ok = ok && simd::run_with<simd::find_fn>(i, first, last, value) ==
+						std::find(first, last, value);
+					ok = ok && simd::run_with<simd::count_fn>(i, first, last, value) ==
+						std::count(first, last, value);
+					ok = ok && simd::run_with<simd::rank_fn<false>>(i, first, last, value) ==
+						std::count_if(first, last, [=](T t) { return t < value; });
+					ok = ok && simd::run_with<simd::rank_fn<true>>(i, first, last, value) ==
+						std::count_if(first, last, [=](T t) { return t <= value; });
+				}
+				ok = ok && simd::run_with<simd::extremum_fn<false>>(i, first, last) ==
+					std::min_element(first, last);
+				ok = ok && simd::run_with<simd::extremum_fn<true>>(i, first, last) ==
+					std::max_element(first, last);
+
+				const T* const second = other.data() + (8 - offset) % 8;
+				ok = ok && simd::run_with<simd::mismatch_fn>(i, first, second, n) ==
+					std::mismatch(first, last, second).first - first;
+				for (auto k = 0; k < n; k += 7) {
+					std::vector<T> copy(first, last);
+					copy[k] = static_cast<T>(copy[k] + 1);
+					ok = ok && simd::run_with<simd::mismatch_fn>(i, first, copy.data(), n) == k;
+				}
+
+				std::vector<T> out(n + 2, T(9));
+				simd::run_with<simd::fill_fn>(i, out.data() + 1, out.data() + 1 + n, T(3));
+				ok = ok && out.front() == T(9) && out.back() == T(9) &&
+					std::count(out.begin(), out.end(), T(3)) == n;
+			}
+		}
+	}
+	CHECK(ok);
+}
+
+template <class T>
+void test_floating() {
+	auto const nan = std::numeric_limits<T>::quiet_NaN();
+	std::vector<T> v(100);
+	for (auto i = 0; i < 100; ++i) {
+		v[i] = static_cast<T>(i % 10);
+	}
+	v[37] = T(-0.0);
+	v[38] = T(0.0);
+	auto ok = true;
+	for (auto i : all_isas) {
+		if (i > simd::level()) {
+			break;
+		}
+		auto const first = v.data();
+		auto const last = first + v.size();
+		// -0.0 == 0.0, so the first zero of either sign is found.
+		ok = ok && simd::run_with<simd::find_fn>(i, first, last, T(-0.0)) == first;
+		ok = ok && simd::run_with<simd::count_fn>(i, first, last, T(0.0)) == 12;
+		ok = ok && simd::run_with<simd::extremum_fn<false>>(i, first, last) == first;
+		ok = ok && simd::run_with<simd::extremum_fn<true>>(i, first, last) == first + 9;
+
+		auto w = v;
+		w[60] = nan;
+		auto const wf = w.data();
+		auto const wl = wf + w.size();
+		// NaN never compares equal, not even to itself.
+		ok = ok && simd::run_with<simd::find_fn>(i, wf, wl, nan) == wl;
+		ok = ok && simd::run_with<simd::count_fn>(i, wf, wl, nan) == 0;
+		ok = ok && simd::run_with<simd::mismatch_fn>(i, wf, wf, 100) == 60;
+		ok = ok && simd::run_with<simd::extremum_fn<false>>(i, wf, wl) ==
+			std::min_element(wf, wl);
+		ok = ok && simd::run_with<simd::extremum_fn<true>>(i, wf, wl) ==
+			std::max_element(wf, wl);
+		w[0] = nan;
+		ok = ok && simd::run_with<simd::extremum_fn<false>>(i, wf, wl) ==
+			std::min_element(wf, wl);
+		ok = ok && simd::run_with<simd::extremum_fn<true>>(i, wf, wl) ==
+			std::max_element(wf, wl);
+	}
+	CHECK(ok);
+}
+
+int main() {
+	test_kernels<char>();
+	test_kernels<signed char>();
+	test_kernels<unsigned char>();
+	test_kernels<short>();
+	test_kernels<unsigned short>();
+	test_kernels<int>();
+	test_kernels<unsigned>();
+	test_kernels<long>();
+	test_kernels<unsigned long long>();
+	test_kernels<float>();
+	test_kernels<double>();
+	test_floating<float>();
+	test_floating<double>();
+
+	{
+		// Byte counts run far past what one lane can hold.
+		std::vector<signed char> v(100000, 1);
+		v[5] = 2;
+		CHECK(ranges::count(v.data(), v.data() + v.size(), static_cast<signed char>(1)) == 99999);
+	}
+	{
+		// Extremes of the signed and unsigned ranges
+		std::vector<std::uint32_t> u(1000, 5);
+		u[700] = 0xffffffff;
+		u[800] = 0;
+		CHECK(ranges::max_element(u.data(), u.data() + u.size()) == u.data() + 700);
+		CHECK(ranges::min_element(u.data(), u.data() + u.size()) == u.data() + 800);
+		std::vector<std::int64_t> s(1000, 5);
+		s[300] = std::numeric_limits<std::int64_t>::min();
+		s[301] = std::numeric_limits<std::int64_t>::min();
+		CHECK(ranges::min_element(s.data(), s.data() + s.size()) == s.data() + 300);
+	}
+	{
+		// The overloads take vector's iterators, const or not.
+		ranges::vector<int> v;
+		for (auto i = 0; i < 1000; ++i) {
+			v.push_back(i % 100);
+		}
+		const auto& cv = v;
+		CHECK(ranges::find(v.begin(), v.end(), 42) == v.begin() + 42);
+		CHECK(ranges::find(cv.begin(), cv.end(), 100) == cv.end());
+		CHECK(ranges::count(cv.begin(), cv.end(), 42) == 10);
+		CHECK(*ranges::min_element(v.begin(), v.end()) == 0);
+		CHECK(ranges::max_element(cv.begin(), cv.end()) == cv.begin() + 99);
+
+		auto r = ranges::mismatch(v.begin(), v.end(), cv.begin(), cv.end() - 1);
+		CHECK(r.in1() == v.end() - 1);
+		CHECK(r.in2() == cv.end() - 1);
+		CHECK(ranges::equal(cv.begin(), cv.end(), v.begin(), v.end()));
+		CHECK(!ranges::equal(cv.begin(), cv.end(), v.begin(), v.end() - 1));
+
+		CHECK(ranges::fill(v.begin() + 1, v.end(), 7) == v.end());
+		CHECK(ranges::count(v.begin(), v.end(), 7) == 999);
+		CHECK(v.begin()[0] == 0);
+
+		// A value of a different type takes the generic algorithm.
+		CHECK(ranges::find(v.begin(), v.end(), 7L) == v.begin() + 1);
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,99 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+// Speed of each vectorized kernel at each instruction set this machine
+// supports, against the scalar loop, for bytes, ints, floats and
+// doubles. The range is sized to stay in cache so the kernels, not
+// memory bandwidth, are measured; pass a larger one to see the latter.
+//
+// usage: simd_algorithm_benchmark [elements]
+//
+#include <stl2/simd_algorithm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace ranges = std::experimental::ranges;
+namespace simd = ranges::__simd;
+
+namespace {
+	constexpr std::ptrdiff_t total = std::ptrdiff_t{1} << 28;
+
+	constexpr const char* isa_names[] = {"scalar", "sse4.2", "avx2", "avx512"};
+
+	volatile std::int64_t sink;
+
+	// Runs f over n elements until about total elements are visited and
+	// prints the time per element at each instruction set.
+	template <class F>
+	void measure(const char* name, std::ptrdiff_t n, F f) {
+		std::cout << "  " << name << ':';
+		auto const reps = total / n > 0 ? total / n : 1;
+		for (auto i = 0; i <= static_cast<int>(simd::level()); ++i) {
+			auto const isa = static_cast<simd::isa>(i);
+			auto const start = std::chrono::steady_clock::now();
+			std::int64_t x = 0;
+			for (auto r = std::ptrdiff_t{0}; r < reps; ++r) {
+				x += f(isa);
+			}
+			sink = x;
+			std::chrono::duration<double, std::nano> elapsed =
+				std::chrono::steady_clock::now() - start;
+			std::cout << ' ' << isa_names[i] << ' ' << elapsed.count() / (reps * n);
+		}
+		std::cout << " ns/element\n";
+	}
+
+	template <class T>
+	void run(const char* name, std::ptrdiff_t n) {
+		std::cout << name << ": " << n << " elements\n";
+		std::mt19937 gen{7};
+		std::vector<T> v(n);
+		for (auto& t : v) {
+			// Values other than 0 and 1 only
+			t = static_cast<T>(2 + gen() % 100);
+		}
+		auto w = v;
+		const T* const first = v.data();
+		const T* const last = first + n;
+		// The searches run to the end of the range.
+		measure("find", n, [&](simd::isa i) {
+			return simd::run_with<simd::find_fn>(i, first, last, T(1)) - first;
+		});
+		measure("count", n, [&](simd::isa i) {
+			return simd::run_with<simd::count_fn>(i, first, last, T(50));
+		});
+		measure("min_element", n, [&](simd::isa i) {
+			return simd::run_with<simd::extremum_fn<false>>(i, first, last) - first;
+		});
+		measure("max_element", n, [&](simd::isa i) {
+			return simd::run_with<simd::extremum_fn<true>>(i, first, last) - first;
+		});
+		measure("mismatch", n, [&](simd::isa i) {
+			return simd::run_with<simd::mismatch_fn>(i, first, w.data(), n);
+		});
+		measure("fill", n, [&](simd::isa i) {
+			simd::run_with<simd::fill_fn>(i, w.data(), w.data() + n, T(0));
+			return static_cast<std::int64_t>(w[n / 2]);
+		});
+	}
+}
+
+int main(int argc, char** argv) {
+	auto const n = argc > 1 ? std::atol(argv[1]) : 1L << 14;
+	run<std::uint8_t>("uint8_t", n);
+	run<std::int32_t>("int32_t", n);
+	run<float>("float", n);
+	run<double>("double", n);
+}
@@ -0,0 +1,81 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/slot_map.hpp>
+#include <stl2/algorithm.hpp>
+#include <memory>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+int main() {
+	{
+		using M = ranges::slot_map<int>;
+		static_assert(ranges::models::ContiguousIterator<M::iterator>);
+
+		M map;
+		auto a = map.insert(1);
+		auto b = map.insert(2);
+		auto c = map.insert(3);
+		CHECK(map.size() == 3);
+		CHECK(map[a] == 1 && map[b] == 2 && map[c] == 3);
+		CHECK(map.key_of(map.begin() + 1) == b);
+
+		CHECK(map.erase(a));
+		CHECK(!map.erase(a));
+		CHECK(!map.contains(a));
+		CHECK(map.find(a) == nullptr);
+		CHECK(map.size() == 2);
+		CHECK(map[b] == 2 && map[c] == 3);
+		// The last element filled the hole.
+		CHECK(*map.begin() == 3);
+		CHECK(map.key_of(map.begin()) == c);
+
+		// The freed slot is reused with a new generation.
+		auto d = map.insert(4);
+		CHECK(d.index == a.index);
+		CHECK(d != a);
+		CHECK(!map.contains(a));
+		CHECK(map[d] == 4);
+
+		auto sum = 0;
+		for (auto i : map) {
+			sum += i;
+		}
+		CHECK(sum == 9);
+
+		map.clear();
+		CHECK(map.empty());
+		CHECK(!map.contains(b) && !map.contains(c) && !map.contains(d));
+		auto e = map.insert(5);
+		CHECK(map[e] == 5);
+	}
+
+	{
+		ranges::slot_map<std::unique_ptr<int>> map;
+		decltype(map)::key_type keys[64];
+		for (auto i = 0; i < 64; ++i) {
+			keys[i] = map.emplace(std::make_unique<int>(i));
+		}
+		for (auto i = 0; i < 64; i += 2) {
+			CHECK(map.erase(keys[i]));
+		}
+		CHECK(map.size() == 32);
+		for (auto i = 1; i < 64; i += 2) {
+			CHECK(map.find(keys[i]) && **map.find(keys[i]) == i);
+		}
+		for (auto&& p : map) {
+			CHECK(*p % 2 == 1);
+		}
+	}
+
+	return ::test_result();
+}
@@ -0,0 +1,173 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/soa_vector.hpp>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+template <class T>
+bool is_aligned(const T* p) {
+	return reinterpret_cast<std::uintptr_t>(p) % ranges::__soa::column_alignment == 0;
+}
+
+// Copies throw once the budget runs out; moves may throw, so relocation
+// copies.
+struct fragile {
+	static int budget;
+	int value;
+	fragile(int v) : value{v} {}
+	fragile(const fragile& that) : value{that.value} {
+		if (budget-- == 0) {
+			throw std::runtime_error{"fragile"};
+		}
+	}
+	fragile(fragile&& that) : value{that.value} {}
+	fragile& operator=(const fragile&) = default;
+};
+int fragile::budget = -1;
+
+int main() {
+	{
+		using V = ranges::soa_vector<float, double, char>;
+		static_assert(ranges::models::RandomAccessIterator<V::iterator>);
+		static_assert(ranges::models::RandomAccessIterator<V::const_iterator>);
+
+		V v;
+		CHECK(v.empty());
+		for (auto i = 0; i < 100; ++i) {
+			v.emplace_back(float(i), 2.0 * i, char('a' + i % 26));
+		}
+		CHECK(v.size() == 100);
+		CHECK(v.capacity() >= 100);
+
+		// Every column is aligned, and all share one allocation.
+		CHECK(is_aligned(v.data<0>()));
+		CHECK(is_aligned(v.data<1>()));
+		CHECK(is_aligned(v.data<2>()));
+		CHECK(reinterpret_cast<const char*>(v.data<0>()) < reinterpret_cast<const char*>(v.data<1>()));
+		CHECK(reinterpret_cast<const char*>(v.data<1>()) < reinterpret_cast<const char*>(v.data<2>()));
+
+		auto xs = v.column<0>();
+		CHECK(xs.size() == 100);
+		auto sum = 0.0f;
+		for (auto x : xs) {
+			sum += x;
+		}
+		CHECK(sum == 4950.0f);
+
+		// Rows are tuples of references into the columns.
+		auto row = v[42];
+		CHECK(std::get<0>(row) == 42.0f);
+		CHECK(std::get<1>(row) == 84.0);
+		CHECK(std::get<2>(row) == 'a' + 42 % 26);
+		std::get<1>(row) = -1.0;
+		CHECK(v.column<1>()[42] == -1.0);
+
+		auto n = 0;
+		for (auto r : v) {
+			CHECK(std::get<0>(r) == float(n));
+			++n;
+		}
+		CHECK(n == 100);
+		CHECK(v.end() - v.begin() == 100);
+
+		v.push_back(V::value_type{1.5f, 3.0, 'z'});
+		CHECK(std::get<2>(v.back()) == 'z');
+		v.pop_back();
+		CHECK(v.size() == 100);
+
+		v.resize(10);
+		CHECK(v.size() == 10);
+		v.shrink_to_fit();
+		CHECK(v.capacity() == 10);
+		CHECK(std::get<0>(v[9]) == 9.0f);
+		v.resize(12);
+		CHECK(std::get<0>(v[11]) == 0.0f);
+
+		V w{std::move(v)};
+		CHECK(v.empty());
+		CHECK(w.size() == 12);
+	}
+	{
+		// Fields with non-trivial lifetimes are constructed and destroyed
+		// per column.
+		auto p = std::make_shared<int>(42);
+		{
+			ranges::soa_vector<std::shared_ptr<int>, std::string> v;
+			for (auto i = 0; i < 50; ++i) {
+				v.emplace_back(p, std::to_string(i));
+			}
+			CHECK(p.use_count() == 51);
+			CHECK(v.column<1>()[49] == "49");
+			v.pop_back();
+			CHECK(p.use_count() == 50);
+			v.clear();
+			CHECK(p.use_count() == 1);
+			v.emplace_back(p, "x");
+		}
+		CHECK(p.use_count() == 1);
+	}
+	{
+		// Arguments may refer to rows that growth relocates.
+		ranges::soa_vector<std::string, int> v;
+		v.emplace_back(std::string(40, 'x'), 1);
+		while (v.size() < v.capacity()) {
+			v.emplace_back("y", 2);
+		}
+		auto const row = v[0];
+		v.emplace_back(std::get<0>(row), std::get<1>(row));
+		CHECK(std::get<0>(v.back()) == std::string(40, 'x'));
+		CHECK(std::get<1>(v.back()) == 1);
+	}
+	{
+		// A field that throws while relocating leaves the vector as it was.
+		ranges::soa_vector<int, fragile> v;
+		for (auto i = 0; i < 16; ++i) {
+			v.emplace_back(i, i);
+		}
+		CHECK(v.size() == v.capacity());
+		auto const data = v.data<1>();
+		fragile::budget = 5;
+		auto threw = false;
+		try {
+			v.emplace_back(16, 16);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(v.size() == 16);
+		CHECK(v.data<1>() == data);
+		threw = false;
+		fragile::budget = 10;
+		try {
+			v.reserve(100);
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(v.capacity() == 16);
+		fragile::budget = -1;
+		auto ok = true;
+		for (auto i = 0; i < 16; ++i) {
+			ok = ok && std::get<0>(v[i]) == i && std::get<1>(v[i]).value == i;
+		}
+		CHECK(ok);
+		v.emplace_back(16, 16);
+		CHECK(std::get<1>(v.back()).value == 16);
+	}
+
+	return ::test_result();
+}
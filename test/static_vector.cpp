@@ -0,0 +1,127 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/static_vector.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+// A table of the primes below 100, built during constant evaluation.
+constexpr ranges::static_vector<int, 32> primes_below_100() {
+	ranges::static_vector<int, 32> primes;
+	for (auto n = 2; n < 100; ++n) {
+		auto prime = true;
+		for (auto p : primes) {
+			if (n % p == 0) {
+				prime = false;
+				break;
+			}
+		}
+		if (prime) {
+			primes.push_back(n);
+		}
+	}
+	return primes;
+}
+
+constexpr auto primes = primes_below_100();
+static_assert(primes.size() == 25);
+static_assert(primes.front() == 2 && primes.back() == 97);
+static_assert(primes[10] == 31);
+
+struct point { int x, y; };
+constexpr ranges::static_vector<point, 4> points() {
+	ranges::static_vector<point, 4> v;
+	v.push_back(point{1, 2});
+	v.emplace_back(point{3, 4});
+	v.pop_back();
+	v.resize(3);
+	return v;
+}
+static_assert(points().size() == 3);
+static_assert(points()[0].y == 2 && points()[2].x == 0);
+
+constexpr ranges::static_vector<char, 8> letters{'a', 'b', 'c'};
+static_assert(letters.size() == 3 && letters[2] == 'c');
+static_assert(letters.capacity() == 8);
+
+static_assert(ranges::models::ContiguousIterator<ranges::static_vector<int, 4>::iterator>);
+
+// Counts live instances; copying the third one made throws.
+struct fragile {
+	static int count;
+	static int copies;
+	fragile() { ++count; }
+	fragile(const fragile&) {
+		if (++copies == 3) {
+			throw std::runtime_error{"fragile"};
+		}
+		++count;
+	}
+	~fragile() { --count; }
+};
+int fragile::count = 0;
+int fragile::copies = 0;
+
+int main() {
+	{
+		ranges::static_vector<int, 8> v(3, 42);
+		CHECK(v.size() == 3);
+		for (auto i : v) {
+			CHECK(i == 42);
+		}
+		v.clear();
+		CHECK(v.empty());
+	}
+	{
+		// Non-trivial elements are constructed and destroyed in place.
+		auto p = std::make_shared<int>(42);
+		{
+			ranges::static_vector<std::shared_ptr<int>, 4> v;
+			v.push_back(p);
+			v.emplace_back(p);
+			CHECK(p.use_count() == 3);
+			auto w = v;
+			CHECK(p.use_count() == 5);
+			w.pop_back();
+			CHECK(p.use_count() == 4);
+			v = std::move(w);
+			CHECK(v.size() == 1);
+			CHECK(p.use_count() == 2);
+		}
+		CHECK(p.use_count() == 1);
+
+		ranges::static_vector<std::string, 3> s{"foo", "bar"};
+		s.resize(3);
+		CHECK(s[1] == "bar" && s[2].empty());
+		CHECK(*s.rbegin() == "");
+	}
+
+	{
+		// A copy that throws partway through destroys what it copied.
+		ranges::static_vector<fragile, 4> v(4);
+		CHECK(fragile::count == 4);
+		auto threw = false;
+		try {
+			auto w = v;
+		} catch (std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(fragile::count == 4);
+	}
+	CHECK(fragile::count == 0);
+
+	return ::test_result();
+}
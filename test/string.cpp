@@ -0,0 +1,367 @@
+// cmcstl2 - A concept-enabled C++ standard library
+//
+//  Copyright Casey Carter 2015
+//
+//  Use, modification and distribution is subject to the
+//  Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at
+//  http://www.boost.org/LICENSE_1_0.txt)
+//
+// Project home: https://github.com/caseycarter/cmcstl2
+//
+#include <stl2/string.hpp>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "../cmcstl2/test/simple_test.hpp"
+
+namespace ranges = std::experimental::ranges;
+
+namespace {
+	int allocations = 0;
+	int live = 0;
+
+	// Counts calls to allocate, and the buffers still outstanding.
+	template <class T>
+	struct counting_allocator : std::allocator<T> {
+		using std::allocator<T>::allocator;
+		template <class U>
+		struct rebind { using other = counting_allocator<U>; };
+
+		counting_allocator() = default;
+		template <class U>
+		counting_allocator(const counting_allocator<U>&) noexcept {}
+
+		T* allocate(std::size_t n) {
+			++allocations;
+			++live;
+			return std::allocator<T>::allocate(n);
+		}
+		void deallocate(T* p, std::size_t n) noexcept {
+			--live;
+			std::allocator<T>::deallocate(p, n);
+		}
+	};
+
+	using counted = ranges::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+	// A pointer class for allocators whose pointers are not raw.
+	template <class T>
+	struct fancy_ptr {
+		T* p_ = nullptr;
+
+		using element_type = T;
+		using value_type = std::remove_cv_t<T>;
+		using difference_type = std::ptrdiff_t;
+		using reference = T&;
+		using pointer = fancy_ptr;
+		using iterator_category = std::random_access_iterator_tag;
+
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		explicit fancy_ptr(T* p) noexcept : p_{p} {}
+		template <class U>
+		requires std::is_convertible<U*, T*>::value
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+
+		static fancy_ptr pointer_to(T& t) noexcept { return fancy_ptr{&t}; }
+
+		T& operator*() const noexcept { return *p_; }
+		T* operator->() const noexcept { return p_; }
+		T& operator[](difference_type n) const noexcept { return p_[n]; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+
+		fancy_ptr& operator++() noexcept { ++p_; return *this; }
+		fancy_ptr operator++(int) noexcept { return fancy_ptr{p_++}; }
+		fancy_ptr& operator--() noexcept { --p_; return *this; }
+		fancy_ptr operator--(int) noexcept { return fancy_ptr{p_--}; }
+		fancy_ptr& operator+=(difference_type n) noexcept { p_ += n; return *this; }
+		fancy_ptr& operator-=(difference_type n) noexcept { p_ -= n; return *this; }
+		friend fancy_ptr operator+(fancy_ptr p, difference_type n) noexcept { return p += n; }
+		friend fancy_ptr operator+(difference_type n, fancy_ptr p) noexcept { return p += n; }
+		friend fancy_ptr operator-(fancy_ptr p, difference_type n) noexcept { return p -= n; }
+		friend difference_type operator-(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ - b.p_; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+		friend bool operator<(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ < b.p_; }
+		friend bool operator>(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ > b.p_; }
+		friend bool operator<=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ <= b.p_; }
+		friend bool operator>=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ >= b.p_; }
+	};
+
+	template <class T>
+	struct fancy_allocator {
+		using value_type = T;
+		using pointer = fancy_ptr<T>;
+		using const_pointer = fancy_ptr<const T>;
+		using void_pointer = fancy_ptr<void>;
+		using const_void_pointer = fancy_ptr<const void>;
+
+		fancy_allocator() = default;
+		template <class U>
+		fancy_allocator(const fancy_allocator<U>&) noexcept {}
+
+		pointer allocate(std::size_t n) {
+			++live;
+			return pointer{std::allocator<T>{}.allocate(n)};
+		}
+		void deallocate(pointer p, std::size_t n) noexcept {
+			--live;
+			std::allocator<T>{}.deallocate(p.p_, n);
+		}
+
+		friend bool operator==(fancy_allocator, fancy_allocator) noexcept { return true; }
+		friend bool operator!=(fancy_allocator, fancy_allocator) noexcept { return false; }
+	};
+
+	template <>
+	struct fancy_ptr<void> {
+		void* p_ = nullptr;
+		using element_type = void;
+		using difference_type = std::ptrdiff_t;
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		template <class U>
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+		template <class U>
+		explicit operator fancy_ptr<U>() const noexcept { return fancy_ptr<U>{static_cast<U*>(p_)}; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+	};
+
+	template <>
+	struct fancy_ptr<const void> {
+		const void* p_ = nullptr;
+		using element_type = const void;
+		using difference_type = std::ptrdiff_t;
+		fancy_ptr() = default;
+		fancy_ptr(std::nullptr_t) noexcept {}
+		template <class U>
+		fancy_ptr(const fancy_ptr<U>& u) noexcept : p_{u.p_} {}
+		template <class U>
+		explicit operator fancy_ptr<U>() const noexcept { return fancy_ptr<U>{static_cast<U*>(p_)}; }
+		explicit operator bool() const noexcept { return p_ != nullptr; }
+		friend bool operator==(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ == b.p_; }
+		friend bool operator!=(fancy_ptr a, fancy_ptr b) noexcept { return a.p_ != b.p_; }
+	};
+
+	bool valid(const ranges::string& s, std::string_view expected) {
+		return s.size() == static_cast<std::ptrdiff_t>(expected.size()) &&
+			std::string_view{s} == expected && s.c_str()[s.size()] == '\0' &&
+			s.size() <= s.capacity() && s.is_inline() == (s.capacity() == s.sso_capacity);
+	}
+}
+
+int main() {
+	{
+		// Three words, all but one byte of them characters.
+		static_assert(sizeof(ranges::string) == 3 * sizeof(void*));
+		static_assert(ranges::string::sso_capacity == 3 * sizeof(void*) - 1);
+		static_assert(ranges::u16string::sso_capacity == 3 * sizeof(void*) / 2 - 1);
+		static_assert(ranges::u32string::sso_capacity == 3 * sizeof(void*) / 4 - 1);
+
+		ranges::string s;
+		CHECK(valid(s, ""));
+		CHECK(s.empty());
+		CHECK(s.is_inline());
+	}
+	{
+		// Up to sso_capacity characters stay inline, and one more does not.
+		auto const n = ranges::string::sso_capacity;
+		auto const full = std::string(n, 'x');
+		ranges::string s{full.c_str()};
+		CHECK(valid(s, full));
+		CHECK(s.is_inline());
+		s.push_back('y');
+		CHECK(valid(s, full + 'y'));
+		CHECK(!s.is_inline());
+		s.pop_back();
+		CHECK(valid(s, full));
+		s.shrink_to_fit();
+		CHECK(s.is_inline());
+		CHECK(valid(s, full));
+	}
+	{
+		ranges::string s{5, 'a'};
+		CHECK(valid(s, "aaaaa"));
+		ranges::string t{std::string_view{"hello"}};
+		CHECK(t == "hello");
+		CHECK("hello" == t);
+		CHECK(t != s);
+		CHECK(s < t);
+		CHECK(t.compare("hello") == 0);
+		auto const word = std::string{"characters"};
+		ranges::string u{word.begin(), word.end()};
+		CHECK(valid(u, word));
+		CHECK(u.front() == 'c');
+		CHECK(u.back() == 's');
+		CHECK(u[4] == 'a');
+		CHECK(std::string(u.rbegin(), u.rend()) == "sretcarahc");
+	}
+	{
+		// Each append allocates at most once, however much it adds.
+		allocations = 0;
+		{
+			counted s;
+			auto const chunk = std::string(100, 'c');
+			std::string expected;
+			for (auto i = 0; i < 10; ++i) {
+				auto const before = allocations;
+				s.append(chunk);
+				expected += chunk;
+				CHECK(allocations - before <= 1);
+			}
+			CHECK(std::string_view{s} == expected);
+			// Geometric growth: ten appends, fewer allocations.
+			CHECK(allocations < 10);
+
+			auto const before = allocations;
+			s.append(5000, 'z');
+			CHECK(allocations == before + 1);
+			CHECK(s.size() == 6000);
+			CHECK(s.c_str()[6000] == '\0');
+		}
+		CHECK(live == 0);
+	}
+	{
+		// Appending or assigning a string's own characters
+		ranges::string s{"abcdefghij"};
+		s.append(s);
+		CHECK(valid(s, "abcdefghijabcdefghij"));
+		s.append(s);
+		CHECK(valid(s, "abcdefghijabcdefghijabcdefghijabcdefghij"));
+		s.append(std::string_view{s}.substr(5, 10));
+		CHECK(valid(s, "abcdefghijabcdefghijabcdefghijabcdefghijfghijabcde"));
+		s.append(s.data(), 3);
+		CHECK(s.size() == 53);
+		s.assign(std::string_view{s}.substr(2, 5));
+		CHECK(valid(s, "cdefg"));
+		s = std::string_view{s}.substr(1);
+		CHECK(valid(s, "defg"));
+		s.append(s.begin(), s.end());
+		CHECK(valid(s, "defgdefg"));
+	}
+	{
+		// resize_and_overwrite writes straight into the buffer.
+		ranges::string s{"prefix:"};
+		s.resize_and_overwrite(100, [](char* p, std::ptrdiff_t n) {
+			CHECK(std::memcmp(p, "prefix:", 7) == 0);
+			for (auto i = 7; i < n; ++i) {
+				p[i] = static_cast<char>('0' + i % 10);
+			}
+			return std::ptrdiff_t{40};
+		});
+		CHECK(s.size() == 40);
+		CHECK(s.c_str()[40] == '\0');
+		CHECK(std::string_view{s}.substr(0, 10) == "prefix:789");
+		s.resize_and_overwrite(3, [](char*, std::ptrdiff_t) { return std::ptrdiff_t{3}; });
+		CHECK(valid(s, "pre"));
+
+		ranges::string t;
+		t.resize_and_overwrite(4, [](char* p, std::ptrdiff_t) {
+			std::memcpy(p, "abcd", 4);
+			return std::ptrdiff_t{2};
+		});
+		CHECK(valid(t, "ab"));
+		CHECK(t.is_inline());
+	}
+	{
+		ranges::string s;
+		s.resize(3, 'q');
+		CHECK(valid(s, "qqq"));
+		s.resize(40);
+		CHECK(s.size() == 40);
+		CHECK(s[39] == '\0');
+		s.resize(2);
+		CHECK(valid(s, "qq"));
+		s.reserve(1000);
+		CHECK(s.capacity() == 1000);
+		CHECK(valid(s, "qq"));
+		s.clear();
+		CHECK(valid(s, ""));
+		s.shrink_to_fit();
+		CHECK(s.is_inline());
+
+		ranges::string r{ranges::reserve_t{}, 200};
+		CHECK(r.empty());
+		CHECK(r.capacity() == 200);
+	}
+	{
+		// Copy, move and swap, for each combination of inline and heap
+		auto const short_text = std::string_view{"short"};
+		auto const long_text = std::string_view{"a string too long to keep inside the object"};
+		for (auto a : {short_text, long_text}) {
+			for (auto b : {short_text, long_text}) {
+				ranges::string x{a};
+				ranges::string y{b};
+				ranges::string copy{x};
+				CHECK(valid(copy, a));
+				CHECK(valid(x, a));
+				copy = y;
+				CHECK(valid(copy, b));
+
+				ranges::string moved{std::move(x)};
+				CHECK(valid(moved, a));
+				CHECK(valid(x, ""));
+				x = std::move(y);
+				CHECK(valid(x, b));
+				CHECK(valid(y, ""));
+
+				swap(x, moved);
+				CHECK(valid(x, a));
+				CHECK(valid(moved, b));
+				x.swap(x);
+				CHECK(valid(x, a));
+				x = x;
+				CHECK(valid(x, a));
+			}
+		}
+	}
+	{
+		ranges::u16string s{u"wide characters, more than fit inline"};
+		CHECK(s.size() == 37);
+		CHECK(!s.is_inline());
+		s.append(u"!");
+		CHECK(s == u"wide characters, more than fit inline!");
+		ranges::wstring w{L"w"};
+		w += L'x';
+		CHECK(w == L"wx");
+		CHECK(w.is_inline());
+	}
+	{
+		std::unordered_set<ranges::string> set;
+		set.insert(ranges::string{"one"});
+		set.insert(ranges::string{"a second string, on the heap"});
+		CHECK(set.count(ranges::string{"one"}) == 1);
+		CHECK(set.count(ranges::string{"a second string, on the heap"}) == 1);
+		CHECK(std::hash<ranges::string>{}(ranges::string{"one"}) ==
+			std::hash<std::string_view>{}("one"));
+	}
+	{
+		// Fancy pointers are stored as they are and never dereferenced
+		// past the buffer.
+		using fancy = ranges::basic_string<char, std::char_traits<char>, fancy_allocator<char>>;
+		live = 0;
+		{
+			fancy s{"short"};
+			CHECK(s.is_inline());
+			s.append(std::string_view{" and then much, much longer"});
+			CHECK(!s.is_inline());
+			CHECK(std::string_view{s} == "short and then much, much longer");
+			fancy t{std::move(s)};
+			CHECK(s.empty());
+			CHECK(t == "short and then much, much longer");
+			t.shrink_to_fit();
+			t.resize(4);
+			t.shrink_to_fit();
+			CHECK(t.is_inline());
+			CHECK(t == "shor");
+		}
+		CHECK(live == 0);
+	}
+
+	return ::test_result();
+}
@@ -12,7 +12,9 @@
 #include <stl2/algorithm.hpp>
 #include <stl2/vector.hpp>
 #include <stl2/view/repeat_n.hpp>
+#include <atomic>
 #include <iostream>
+#include <stdexcept>
 #include "../cmcstl2/test/simple_test.hpp"
 
 namespace ranges = std::experimental::ranges;
@@ -85,7 +87,124 @@ namespace incomplete {
 	}
 }
 
+struct counted {
+	static std::atomic<int> live;
+	static std::atomic<int> until_throw;
+	int value = 0;
+
+	counted() { check(); ++live; }
+	counted(int v) : value{v} { check(); ++live; }
+	counted(const counted& that) : value{that.value} { check(); ++live; }
+	counted& operator=(const counted&) & = default;
+	~counted() { --live; }
+
+	static void check() {
+		if (--until_throw == 0) {
+			throw std::runtime_error{"counted"};
+		}
+	}
+};
+std::atomic<int> counted::live{0};
+std::atomic<int> counted::until_throw{-1};
+
+template <class EP>
+void test_bulk(EP&& policy) {
+	constexpr int n = 1 << 20;
+	{
+		ranges::vector<int> vec{policy, n, 42};
+		CHECK(vec.size() == n);
+		CHECK(ranges::equal(vec, ranges::repeat_n_view<int>{42, n}));
+
+		vec.assign(policy, n / 2, 7);
+		CHECK(ranges::equal(vec, ranges::repeat_n_view<int>{7, n / 2}));
+		vec.assign(policy, 2 * n, 3);
+		CHECK(ranges::equal(vec, ranges::repeat_n_view<int>{3, 2 * n}));
+
+		vec.resize(policy, n);
+		CHECK(vec.size() == n);
+		vec.clear(policy);
+		CHECK(vec.empty());
+		vec.resize(policy, n);
+		CHECK(ranges::equal(vec, ranges::repeat_n_view<int>{0, n}));
+	}
+	{
+		ranges::vector<counted> vec{policy, n};
+		CHECK(counted::live == n);
+		// Aliasing an element while reallocating.
+		vec.back().value = 5;
+		vec.assign(policy, 2 * n, vec.back());
+		CHECK(counted::live == 2 * n);
+		CHECK(vec.front().value == 5);
+		// And in place, both shrinking and growing.
+		vec.begin()[n / 2].value = 9;
+		vec.assign(policy, n, vec.begin()[n / 2]);
+		CHECK(counted::live == n);
+		CHECK(vec.front().value == 9 && vec.back().value == 9);
+		vec.back().value = 4;
+		vec.assign(policy, n / 2, vec.back());
+		CHECK(counted::live == n / 2);
+		CHECK(vec.front().value == 4 && vec.back().value == 4);
+		vec.clear(policy);
+		CHECK(counted::live == 0);
+	}
+	{
+		// A throwing constructor leaves nothing behind.
+		counted::until_throw = n / 2;
+		try {
+			ranges::vector<counted> vec{policy, n, counted{1}};
+			CHECK(false);
+		} catch (std::runtime_error&) {}
+		CHECK(counted::live == 0);
+		counted::until_throw = -1;
+	}
+}
+
 int main() {
+	test_bulk(ranges::execution::seq);
+	test_bulk(ranges::execution::par);
+	test_bulk(ranges::execution::par_unseq);
+
+	{
+		ranges::__execution::thread_pool pool{4};
+		std::atomic<unsigned> mask{0};
+		auto f = [&](unsigned i) { mask |= 1u << i; };
+		pool.run(4, f);
+		CHECK(mask == 0xfu);
+		pool.run(2, f);
+	}
+	{
+		ranges::vector<int> vec(3, 5);
+		CHECK(ranges::equal(vec, ranges::repeat_n_view<int>{5, 3}));
+	}
+	{
+		// Adoption and release transfer the buffer without copying.
+		using V = ranges::vector<counted>;
+		auto a = V::allocator_type{};
+		auto p = a.allocate(8);
+		for (auto i = 0; i < 5; ++i) {
+			std::allocator_traits<V::allocator_type>::construct(a, p + i, i);
+		}
+		{
+			V vec{ranges::adopt_t{}, V::buffer{p, 5, 8}};
+			CHECK(vec.begin() == p);
+			CHECK(vec.size() == 5);
+			CHECK(vec.capacity() == 8);
+			CHECK(vec.back().value == 4);
+			vec.push_back(counted{5});
+			CHECK(vec.begin() == p);
+			CHECK(counted::live == 6);
+
+			auto b = vec.release();
+			CHECK(vec.empty());
+			CHECK(vec.capacity() == 0);
+			CHECK(b.data == p && b.size == 6 && b.capacity == 8);
+			CHECK(counted::live == 6);
+
+			V other{ranges::adopt_t{}, b};
+			CHECK(other.size() == 6);
+		}
+		CHECK(counted::live == 0);
+	}
 	{
 		ranges::vector<int> vec;
 		vec.push_back(42);